@@ -35,6 +35,8 @@ public class PanoramaCapture : ModuleRules
                 "D3D12RHI"
             });
 
+        AddEngineThirdPartyPrivateStaticDependencies(Target, "zlib");
+
         if (Target.Platform == UnrealTargetPlatform.Win64)
         {
             PublicDefinitions.Add("PANORAMA_CAPTURE_WITH_NVENC=1");
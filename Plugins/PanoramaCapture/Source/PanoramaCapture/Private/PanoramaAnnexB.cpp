@@ -0,0 +1,638 @@
+#include "PanoramaAnnexB.h"
+
+#include "Algo/StableSort.h"
+
+namespace
+{
+    enum class ENalRole : uint8
+    {
+        /** Slice data; belongs in the sample. */
+        Vcl,
+        /** Non-VCL unit that opens a new access unit (SEI, AUD, parameter sets). */
+        Prefix,
+        /** Anything else carried through unchanged. */
+        Other
+    };
+
+    struct FNalInfo
+    {
+        ENalRole Role = ENalRole::Other;
+        bool bKeyframe = false;
+        bool bFirstSliceOfPicture = false;
+        bool bParameterSet = false;
+        bool bDrop = false;
+    };
+
+    FNalInfo ClassifyNal(EPanoramaCaptureCodec Codec, const uint8* Nal, int32 Size)
+    {
+        FNalInfo Info;
+        if (Codec == EPanoramaCaptureCodec::H264)
+        {
+            const int32 Type = Nal[0] & 0x1F;
+            if (Type >= 1 && Type <= 5)
+            {
+                Info.Role = ENalRole::Vcl;
+                Info.bKeyframe = Type == 5;
+                // first_mb_in_slice is ue(v); it is zero exactly when its first bit is set.
+                Info.bFirstSliceOfPicture = Size > 1 && (Nal[1] & 0x80) != 0;
+            }
+            else if (Type == 6 || Type == 7 || Type == 8 || Type == 9 || (Type >= 14 && Type <= 18))
+            {
+                Info.Role = ENalRole::Prefix;
+            }
+            Info.bParameterSet = Type == 7 || Type == 8;
+            Info.bDrop = Info.bParameterSet || Type == 9 || Type == 12;
+        }
+        else
+        {
+            const int32 Type = (Nal[0] >> 1) & 0x3F;
+            if (Type <= 31)
+            {
+                Info.Role = ENalRole::Vcl;
+                Info.bKeyframe = Type >= 16 && Type <= 23;
+                Info.bFirstSliceOfPicture = Size > 2 && (Nal[2] & 0x80) != 0;
+            }
+            else if ((Type >= 32 && Type <= 35) || Type == 39 || (Type >= 41 && Type <= 44) || (Type >= 48 && Type <= 55))
+            {
+                Info.Role = ENalRole::Prefix;
+            }
+            Info.bParameterSet = Type >= 32 && Type <= 34;
+            Info.bDrop = Info.bParameterSet || Type == 35 || Type == 38;
+        }
+        return Info;
+    }
+
+    /** Exp-Golomb reader over a NAL payload with emulation prevention bytes removed. */
+    class FRbspReader
+    {
+    public:
+        FRbspReader(const uint8* Nal, int32 Size)
+        {
+            Rbsp.Reserve(Size);
+            int32 Zeros = 0;
+            for (int32 Index = 0; Index < Size; ++Index)
+            {
+                if (Zeros >= 2 && Nal[Index] == 0x03)
+                {
+                    Zeros = 0;
+                    continue;
+                }
+                Zeros = Nal[Index] == 0 ? Zeros + 1 : 0;
+                Rbsp.Add(Nal[Index]);
+            }
+        }
+
+        const TArray<uint8>& GetBytes() const { return Rbsp; }
+
+        void Seek(int32 Bit) { BitPosition = Bit; }
+
+        uint32 Bits(int32 Count)
+        {
+            uint32 Value = 0;
+            for (int32 Index = 0; Index < Count; ++Index)
+            {
+                const int32 Byte = BitPosition >> 3;
+                const uint32 Bit = Byte < Rbsp.Num() ? (Rbsp[Byte] >> (7 - (BitPosition & 7))) & 1 : 0;
+                Value = (Value << 1) | Bit;
+                ++BitPosition;
+            }
+            return Value;
+        }
+
+        uint32 UE()
+        {
+            int32 LeadingZeros = 0;
+            while (Bits(1) == 0 && LeadingZeros < 32)
+            {
+                ++LeadingZeros;
+            }
+            return LeadingZeros == 0 ? 0 : (1u << LeadingZeros) - 1 + Bits(LeadingZeros);
+        }
+
+        int32 SE()
+        {
+            const uint32 Code = UE();
+            return (Code & 1) ? static_cast<int32>((Code + 1) / 2) : -static_cast<int32>(Code / 2);
+        }
+
+    private:
+        TArray<uint8> Rbsp;
+        int32 BitPosition = 0;
+    };
+
+    /** Every slice header field up to pic_order_cnt_lsb fits in this many bytes; the rest of the slice is not copied. */
+    constexpr int32 kSliceHeaderBytes = 48;
+
+    struct FAvcSps
+    {
+        int32 Log2MaxFrameNum = 4;
+        int32 PocType = 0;
+        int32 Log2MaxPocLsb = 4;
+        bool bFrameMbsOnly = true;
+        bool bSeparateColourPlane = false;
+    };
+
+    void SkipAvcScalingLists(FRbspReader& Reader, int32 NumLists)
+    {
+        for (int32 List = 0; List < NumLists; ++List)
+        {
+            if (!Reader.Bits(1))
+            {
+                continue;
+            }
+            int32 LastScale = 8;
+            int32 NextScale = 8;
+            for (int32 Index = 0; Index < (List < 6 ? 16 : 64) && NextScale != 0; ++Index)
+            {
+                NextScale = (LastScale + Reader.SE() + 256) % 256;
+                LastScale = NextScale != 0 ? NextScale : LastScale;
+            }
+        }
+    }
+
+    FAvcSps ParseAvcSps(const TArray<uint8>& Sps)
+    {
+        FAvcSps Info;
+        FRbspReader Reader(Sps.GetData(), Sps.Num());
+        Reader.Seek(8);
+        const uint32 ProfileIdc = Reader.Bits(8);
+        Reader.Bits(16);
+        Reader.UE();
+
+        const uint32 HighProfiles[] = { 100, 110, 122, 244, 44, 83, 86, 118, 128, 138, 139, 134, 135 };
+        if (MakeArrayView(HighProfiles).Contains(ProfileIdc))
+        {
+            const uint32 ChromaFormat = Reader.UE();
+            if (ChromaFormat == 3)
+            {
+                Info.bSeparateColourPlane = Reader.Bits(1) != 0;
+            }
+            Reader.UE();
+            Reader.UE();
+            Reader.Bits(1);
+            if (Reader.Bits(1))
+            {
+                SkipAvcScalingLists(Reader, ChromaFormat != 3 ? 8 : 12);
+            }
+        }
+
+        Info.Log2MaxFrameNum = FMath::Min<int32>(Reader.UE() + 4, 16);
+        Info.PocType = static_cast<int32>(Reader.UE());
+        if (Info.PocType == 0)
+        {
+            Info.Log2MaxPocLsb = FMath::Min<int32>(Reader.UE() + 4, 16);
+        }
+        else if (Info.PocType == 1)
+        {
+            Reader.Bits(1);
+            Reader.SE();
+            Reader.SE();
+            const uint32 CycleLength = FMath::Min<uint32>(Reader.UE(), 255);
+            for (uint32 Index = 0; Index < CycleLength; ++Index)
+            {
+                Reader.SE();
+            }
+        }
+        Reader.UE();
+        Reader.Bits(1);
+        Reader.UE();
+        Reader.UE();
+        Info.bFrameMbsOnly = Reader.Bits(1) != 0;
+        return Info;
+    }
+
+    struct FHevcSps
+    {
+        uint32 MaxSubLayersMinus1 = 0;
+        uint32 TemporalIdNesting = 0;
+        uint32 ChromaFormat = 1;
+        bool bSeparateColourPlane = false;
+        uint32 BitDepthLumaMinus8 = 0;
+        uint32 BitDepthChromaMinus8 = 0;
+        int32 Log2MaxPocLsb = 4;
+    };
+
+    FHevcSps ParseHevcSps(FRbspReader& Reader)
+    {
+        FHevcSps Info;
+
+        // Two-byte NAL header, then vps_id(4) max_sub_layers_minus1(3) temporal_id_nesting(1), then the
+        // 12-byte general profile_tier_level that hvcC repeats verbatim.
+        Reader.Seek(16);
+        Reader.Bits(4);
+        Info.MaxSubLayersMinus1 = Reader.Bits(3);
+        Info.TemporalIdNesting = Reader.Bits(1);
+        Reader.Bits(96);
+
+        uint32 SubLayerProfilePresent = 0;
+        uint32 SubLayerLevelPresent = 0;
+        for (uint32 Layer = 0; Layer < Info.MaxSubLayersMinus1; ++Layer)
+        {
+            SubLayerProfilePresent |= Reader.Bits(1) << Layer;
+            SubLayerLevelPresent |= Reader.Bits(1) << Layer;
+        }
+        if (Info.MaxSubLayersMinus1 > 0)
+        {
+            Reader.Bits(2 * (8 - Info.MaxSubLayersMinus1));
+        }
+        for (uint32 Layer = 0; Layer < Info.MaxSubLayersMinus1; ++Layer)
+        {
+            Reader.Bits((SubLayerProfilePresent >> Layer) & 1 ? 88 : 0);
+            Reader.Bits((SubLayerLevelPresent >> Layer) & 1 ? 8 : 0);
+        }
+
+        Reader.UE();
+        Info.ChromaFormat = Reader.UE();
+        if (Info.ChromaFormat == 3)
+        {
+            Info.bSeparateColourPlane = Reader.Bits(1) != 0;
+        }
+        Reader.UE();
+        Reader.UE();
+        if (Reader.Bits(1))
+        {
+            Reader.UE();
+            Reader.UE();
+            Reader.UE();
+            Reader.UE();
+        }
+        Info.BitDepthLumaMinus8 = Reader.UE();
+        Info.BitDepthChromaMinus8 = Reader.UE();
+        Info.Log2MaxPocLsb = FMath::Min<int32>(Reader.UE() + 4, 16);
+        return Info;
+    }
+
+    void AppendLengthPrefixed(TArray<uint8>& Out, const uint8* Nal, int32 Size)
+    {
+        FPanoBigEndianWriter Writer(Out);
+        Writer.U32(static_cast<uint32>(Size));
+        Writer.Bytes(Nal, Size);
+    }
+
+    TArray<uint8> BuildAvcC(const TArray<uint8>& Sps, const TArray<uint8>& Pps)
+    {
+        TArray<uint8> Config;
+        FPanoBigEndianWriter Writer(Config);
+        Writer.U8(1);
+        Writer.U8(Sps[1]);
+        Writer.U8(Sps[2]);
+        Writer.U8(Sps[3]);
+        Writer.U8(0xFC | 3);
+        Writer.U8(0xE0 | 1);
+        Writer.U16(Sps.Num());
+        Writer.Bytes(Sps);
+        Writer.U8(1);
+        Writer.U16(Pps.Num());
+        Writer.Bytes(Pps);
+        return Config;
+    }
+
+    TArray<uint8> BuildHvcC(const TArray<uint8>& Vps, const TArray<uint8>& Sps, const TArray<uint8>& Pps)
+    {
+        FRbspReader Reader(Sps.GetData(), Sps.Num());
+        const TArray<uint8>& Rbsp = Reader.GetBytes();
+        const FHevcSps Info = ParseHevcSps(Reader);
+
+        TArray<uint8> Config;
+        FPanoBigEndianWriter Writer(Config);
+        Writer.U8(1);
+        Writer.Bytes(Rbsp.GetData() + 3, FMath::Clamp(Rbsp.Num() - 3, 0, 12));
+        Writer.Zeros(FMath::Max(0, 12 - (Rbsp.Num() - 3)));
+        Writer.U16(0xF000);
+        Writer.U8(0xFC);
+        Writer.U8(0xFC | (Info.ChromaFormat & 3));
+        Writer.U8(0xF8 | (Info.BitDepthLumaMinus8 & 7));
+        Writer.U8(0xF8 | (Info.BitDepthChromaMinus8 & 7));
+        Writer.U16(0);
+        Writer.U8(((Info.MaxSubLayersMinus1 + 1) << 3) | (Info.TemporalIdNesting << 2) | 3);
+
+        const TArray<uint8>* Arrays[] = { &Vps, &Sps, &Pps };
+        const uint8 ArrayTypes[] = { 32, 33, 34 };
+        Writer.U8(3);
+        for (int32 Index = 0; Index < 3; ++Index)
+        {
+            Writer.U8(0x80 | ArrayTypes[Index]);
+            Writer.U16(1);
+            Writer.U16(Arrays[Index]->Num());
+            Writer.Bytes(*Arrays[Index]);
+        }
+        return Config;
+    }
+}
+
+FPanoAnnexBParser::FPanoAnnexBParser(EPanoramaCaptureCodec InCodec)
+    : Codec(InCodec)
+    , NalStart(INDEX_NONE)
+    , ScanOffset(0)
+    , bCurrentHasVcl(false)
+    , ReadyHead(0)
+    , PrevPocMsb(0)
+    , PrevPocLsb(0)
+    , PicturesSinceIdr(0)
+{
+}
+
+void FPanoAnnexBParser::Push(const uint8* Data, int64 Num)
+{
+    Pending.Append(Data, static_cast<int32>(Num));
+
+    // Look for 00 00 01; the NAL before it ends at the last non-zero byte (a 4-byte start code's
+    // leading zero and any trailing_zero_8bits are dropped).
+    int32 Index = FMath::Max(ScanOffset, 0);
+    const int32 Limit = Pending.Num() - 2;
+    while (Index < Limit)
+    {
+        if (Pending[Index + 2] > 1)
+        {
+            Index += 3;
+            continue;
+        }
+        if (Pending[Index] == 0 && Pending[Index + 1] == 0 && Pending[Index + 2] == 1)
+        {
+            if (NalStart != INDEX_NONE)
+            {
+                int32 End = Index;
+                while (End > NalStart && Pending[End - 1] == 0)
+                {
+                    --End;
+                }
+                if (End > NalStart)
+                {
+                    ProcessNal(Pending.GetData() + NalStart, End - NalStart);
+                }
+            }
+            NalStart = Index + 3;
+            Index += 3;
+            continue;
+        }
+        ++Index;
+    }
+
+    // Drop consumed bytes so the buffer only ever holds the NAL in progress.
+    const int32 Consumed = NalStart != INDEX_NONE ? NalStart : FMath::Max(0, Pending.Num() - 3);
+    if (Consumed > 0)
+    {
+        Pending.RemoveAt(0, Consumed, EAllowShrinking::No);
+        if (NalStart != INDEX_NONE)
+        {
+            NalStart = 0;
+        }
+    }
+    ScanOffset = FMath::Max(NalStart != INDEX_NONE ? NalStart : 0, Pending.Num() - 3);
+}
+
+void FPanoAnnexBParser::Finish()
+{
+    if (NalStart != INDEX_NONE)
+    {
+        int32 End = Pending.Num();
+        while (End > NalStart && Pending[End - 1] == 0)
+        {
+            --End;
+        }
+        if (End > NalStart)
+        {
+            ProcessNal(Pending.GetData() + NalStart, End - NalStart);
+        }
+    }
+    Pending.Reset();
+    NalStart = INDEX_NONE;
+    ScanOffset = 0;
+    CompleteAccessUnit();
+}
+
+bool FPanoAnnexBParser::Pop(FPanoVideoSample& OutSample)
+{
+    if (ReadyHead >= Ready.Num())
+    {
+        return false;
+    }
+
+    OutSample = MoveTemp(Ready[ReadyHead++]);
+    if (ReadyHead == Ready.Num())
+    {
+        Ready.Reset();
+        ReadyHead = 0;
+    }
+    return true;
+}
+
+bool FPanoAnnexBParser::HasCodecConfig() const
+{
+    return Sps.Num() >= 4 && Pps.Num() > 0 && (Codec == EPanoramaCaptureCodec::H264 || Vps.Num() > 0);
+}
+
+TArray<uint8> FPanoAnnexBParser::BuildCodecConfig() const
+{
+    if (!HasCodecConfig())
+    {
+        return TArray<uint8>();
+    }
+    return Codec == EPanoramaCaptureCodec::H264 ? BuildAvcC(Sps, Pps) : BuildHvcC(Vps, Sps, Pps);
+}
+
+void FPanoAnnexBParser::ProcessNal(const uint8* Nal, int32 Size)
+{
+    const FNalInfo Info = ClassifyNal(Codec, Nal, Size);
+
+    if (bCurrentHasVcl && (Info.Role == ENalRole::Prefix || (Info.Role == ENalRole::Vcl && Info.bFirstSliceOfPicture)))
+    {
+        CompleteAccessUnit();
+    }
+
+    if (Info.bParameterSet)
+    {
+        const int32 Type = Codec == EPanoramaCaptureCodec::H264 ? Nal[0] & 0x1F : (Nal[0] >> 1) & 0x3F;
+        TArray<uint8>& Target = (Type == 7 || Type == 33) ? Sps : (Type == 8 || Type == 34) ? Pps : Vps;
+        if (Target.Num() == 0)
+        {
+            Target.Append(Nal, Size);
+            UpdateSliceHeaderLayout();
+        }
+    }
+
+    if (!Info.bDrop)
+    {
+        AppendLengthPrefixed(Current.Data, Nal, Size);
+    }
+
+    if (Info.Role == ENalRole::Vcl)
+    {
+        if (!bCurrentHasVcl)
+        {
+            Current.PicOrderCnt = ReadPicOrderCnt(Nal, Size);
+        }
+        bCurrentHasVcl = true;
+        Current.bKeyframe |= Info.bKeyframe;
+    }
+}
+
+void FPanoAnnexBParser::CompleteAccessUnit()
+{
+    if (bCurrentHasVcl)
+    {
+        Ready.Add(MoveTemp(Current));
+    }
+    Current = FPanoVideoSample();
+    bCurrentHasVcl = false;
+}
+
+void FPanoAnnexBParser::ResolvePresentationOrder(TArrayView<FPanoVideoSample> Gop)
+{
+    TArray<int32, TInlineAllocator<64>> DecodeOrder;
+    DecodeOrder.SetNumUninitialized(Gop.Num());
+    for (int32 Index = 0; Index < Gop.Num(); ++Index)
+    {
+        DecodeOrder[Index] = Index;
+    }
+    Algo::StableSortBy(DecodeOrder, [&Gop](int32 Index) { return Gop[Index].PicOrderCnt; });
+
+    for (int32 PresentationIndex = 0; PresentationIndex < DecodeOrder.Num(); ++PresentationIndex)
+    {
+        Gop[DecodeOrder[PresentationIndex]].CompositionOffset = PresentationIndex - DecodeOrder[PresentationIndex];
+    }
+}
+
+void FPanoAnnexBParser::UpdateSliceHeaderLayout()
+{
+    if (Codec == EPanoramaCaptureCodec::H264)
+    {
+        if (Sps.Num() > 4 && !SliceLayout.bHasSps)
+        {
+            const FAvcSps Info = ParseAvcSps(Sps);
+            SliceLayout.Log2MaxFrameNum = Info.Log2MaxFrameNum;
+            SliceLayout.PocType = Info.PocType;
+            SliceLayout.Log2MaxPocLsb = Info.Log2MaxPocLsb;
+            SliceLayout.bFrameMbsOnly = Info.bFrameMbsOnly;
+            SliceLayout.bSeparateColourPlane = Info.bSeparateColourPlane;
+            SliceLayout.bHasSps = true;
+        }
+        // The H.264 slice header reads nothing from the PPS before pic_order_cnt_lsb.
+        SliceLayout.bHasPps = true;
+        return;
+    }
+
+    if (Sps.Num() > 3 && !SliceLayout.bHasSps)
+    {
+        FRbspReader Reader(Sps.GetData(), Sps.Num());
+        const FHevcSps Info = ParseHevcSps(Reader);
+        SliceLayout.Log2MaxPocLsb = Info.Log2MaxPocLsb;
+        SliceLayout.bSeparateColourPlane = Info.bSeparateColourPlane;
+        SliceLayout.bHasSps = true;
+    }
+    if (Pps.Num() > 2 && !SliceLayout.bHasPps)
+    {
+        // pps_id, sps_id, dependent_slice_segments_enabled_flag, output_flag_present_flag, num_extra_slice_header_bits.
+        FRbspReader Reader(Pps.GetData(), Pps.Num());
+        Reader.Seek(16);
+        Reader.UE();
+        Reader.UE();
+        Reader.Bits(1);
+        SliceLayout.bOutputFlagPresent = Reader.Bits(1) != 0;
+        SliceLayout.NumExtraSliceHeaderBits = static_cast<int32>(Reader.Bits(3));
+        SliceLayout.bHasPps = true;
+    }
+}
+
+int32 FPanoAnnexBParser::ReadPicOrderCnt(const uint8* Nal, int32 Size)
+{
+    FRbspReader Reader(Nal, FMath::Min(Size, kSliceHeaderBytes));
+
+    if (Codec == EPanoramaCaptureCodec::H264)
+    {
+        const int32 Type = Nal[0] & 0x1F;
+        const bool bIdr = Type == 5;
+        const bool bReference = (Nal[0] & 0x60) != 0;
+        PicturesSinceIdr = bIdr ? 0 : PicturesSinceIdr + 1;
+
+        // NVENC only codes POC types 1 and 2 without B-frames, where display order is decode order.
+        if (!SliceLayout.bHasSps || SliceLayout.PocType != 0)
+        {
+            return PicturesSinceIdr * 2;
+        }
+
+        Reader.Seek(8);
+        Reader.UE();
+        Reader.UE();
+        Reader.UE();
+        if (SliceLayout.bSeparateColourPlane)
+        {
+            Reader.Bits(2);
+        }
+        Reader.Bits(SliceLayout.Log2MaxFrameNum);
+        if (!SliceLayout.bFrameMbsOnly && Reader.Bits(1))
+        {
+            Reader.Bits(1);
+        }
+        if (bIdr)
+        {
+            Reader.UE();
+        }
+        const int32 Lsb = static_cast<int32>(Reader.Bits(SliceLayout.Log2MaxPocLsb));
+        return DerivePicOrderCnt(Lsb, bIdr, bReference);
+    }
+
+    const int32 Type = (Nal[0] >> 1) & 0x3F;
+    const int32 TemporalId = Size > 1 ? (Nal[1] & 0x07) - 1 : 0;
+    const bool bIdr = Type == 19 || Type == 20;
+    const bool bIrap = Type >= 16 && Type <= 23;
+    PicturesSinceIdr = bIdr ? 0 : PicturesSinceIdr + 1;
+    if (bIdr)
+    {
+        return DerivePicOrderCnt(0, true, true);
+    }
+    if (!SliceLayout.bHasSps || !SliceLayout.bHasPps)
+    {
+        return PicturesSinceIdr * 2;
+    }
+
+    // first_slice_segment_in_pic_flag is set (this is the picture's first slice), so no segment address follows.
+    Reader.Seek(17);
+    if (bIrap)
+    {
+        Reader.Bits(1);
+    }
+    Reader.UE();
+    Reader.Bits(SliceLayout.NumExtraSliceHeaderBits);
+    Reader.UE();
+    if (SliceLayout.bOutputFlagPresent)
+    {
+        Reader.Bits(1);
+    }
+    if (SliceLayout.bSeparateColourPlane)
+    {
+        Reader.Bits(2);
+    }
+    const int32 Lsb = static_cast<int32>(Reader.Bits(SliceLayout.Log2MaxPocLsb));
+
+    // BLA pictures restart the MSB; RASL/RADL and sub-layer non-reference pictures never anchor it.
+    const bool bBla = Type >= 16 && Type <= 18;
+    const bool bLeading = Type >= 6 && Type <= 9;
+    const bool bSubLayerNonReference = Type <= 14 && (Type & 1) == 0;
+    return DerivePicOrderCnt(Lsb, bBla, TemporalId == 0 && !bLeading && !bSubLayerNonReference);
+}
+
+int32 FPanoAnnexBParser::DerivePicOrderCnt(int32 Lsb, bool bResetMsb, bool bUpdatePrevious)
+{
+    const int32 MaxLsb = 1 << SliceLayout.Log2MaxPocLsb;
+    int32 Msb = 0;
+    if (!bResetMsb)
+    {
+        Msb = PrevPocMsb;
+        if (Lsb < PrevPocLsb && PrevPocLsb - Lsb >= MaxLsb / 2)
+        {
+            Msb += MaxLsb;
+        }
+        else if (Lsb > PrevPocLsb && Lsb - PrevPocLsb > MaxLsb / 2)
+        {
+            Msb -= MaxLsb;
+        }
+    }
+
+    if (bUpdatePrevious)
+    {
+        PrevPocMsb = Msb;
+        PrevPocLsb = Lsb;
+    }
+    return Msb + Lsb;
+}
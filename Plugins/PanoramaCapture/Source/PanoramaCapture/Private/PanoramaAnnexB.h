@@ -0,0 +1,83 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PanoramaCaptureTypes.h"
+#include "PanoramaContainerWriter.h"
+
+/**
+ * Incremental Annex-B parser for the encoder's H.264 / HEVC elementary stream.
+ *
+ * Bytes are pushed in arbitrary chunks; complete access units come out in decode order, converted to
+ * length-prefixed samples with access unit delimiters and parameter sets removed. The first SPS/PPS
+ * (and VPS) seen are kept to build the avcC / hvcC decoder configuration record and to read each
+ * picture's order count from its slice header, since B-frames make display order differ from decode order.
+ */
+class FPanoAnnexBParser
+{
+public:
+    explicit FPanoAnnexBParser(EPanoramaCaptureCodec InCodec);
+
+    void Push(const uint8* Data, int64 Num);
+
+    /** Flushes the trailing NAL and access unit; call once after the last Push. */
+    void Finish();
+
+    /** Pops the oldest complete access unit. */
+    bool Pop(FPanoVideoSample& OutSample);
+
+    /** True once every parameter set required by the configuration record has been seen. */
+    bool HasCodecConfig() const;
+
+    /** avcC (H.264) or hvcC (HEVC) payload, without the box header. Empty until HasCodecConfig. */
+    TArray<uint8> BuildCodecConfig() const;
+
+    /**
+     * Sets CompositionOffset for one GOP in decode order so its pictures present in picture order count order.
+     * The muxers cut fragments at keyframes and the encoder's GOPs are closed, so a GOP presents exactly the
+     * pictures it decodes.
+     */
+    static void ResolvePresentationOrder(TArrayView<FPanoVideoSample> Gop);
+
+private:
+    /** Stored SPS/PPS fields that decide where pic_order_cnt_lsb sits in a slice header. */
+    struct FSliceHeaderLayout
+    {
+        bool bHasSps = false;
+        bool bHasPps = false;
+        int32 Log2MaxFrameNum = 4;
+        int32 PocType = 0;
+        int32 Log2MaxPocLsb = 4;
+        bool bFrameMbsOnly = true;
+        bool bSeparateColourPlane = false;
+        bool bOutputFlagPresent = false;
+        int32 NumExtraSliceHeaderBits = 0;
+    };
+
+    void ProcessNal(const uint8* Nal, int32 Size);
+    void CompleteAccessUnit();
+    void UpdateSliceHeaderLayout();
+    int32 ReadPicOrderCnt(const uint8* Nal, int32 Size);
+    int32 DerivePicOrderCnt(int32 Lsb, bool bResetMsb, bool bUpdatePrevious);
+
+    EPanoramaCaptureCodec Codec;
+    TArray<uint8> Pending;
+    /** Offset of the first payload byte after the start code of the NAL currently being collected, or INDEX_NONE. */
+    int32 NalStart;
+    int32 ScanOffset;
+
+    FPanoVideoSample Current;
+    bool bCurrentHasVcl;
+    TArray<FPanoVideoSample> Ready;
+    int32 ReadyHead;
+
+    TArray<uint8> Vps;
+    TArray<uint8> Sps;
+    TArray<uint8> Pps;
+
+    FSliceHeaderLayout SliceLayout;
+    /** Order count of the last picture that anchors the MSB wrap (reference picture for H.264, TemporalId 0 for HEVC). */
+    int32 PrevPocMsb;
+    int32 PrevPocLsb;
+    /** Pictures since the last IDR; the order count when the stream codes none (H.264 POC types 1 and 2). */
+    int32 PicturesSinceIdr;
+};
@@ -0,0 +1,43 @@
+#include "PanoramaAudioBlockRing.h"
+
+FPanoAudioBlockRing::FPanoAudioBlockRing(int32 InNumBlocks, int32 InBlockSamples)
+    : BlockSamples(FMath::Max(1, InBlockSamples))
+    , WriteCursor(0)
+    , ReadCursor(0)
+{
+    Blocks.SetNum(FMath::Max(2, InNumBlocks));
+    for (FBlock& Block : Blocks)
+    {
+        Block.Samples.SetNumZeroed(BlockSamples);
+    }
+}
+
+FPanoAudioBlockRing::FBlock* FPanoAudioBlockRing::BeginWrite()
+{
+    const uint64 Write = WriteCursor.load(std::memory_order_relaxed);
+    if (Write - ReadCursor.load(std::memory_order_acquire) >= static_cast<uint64>(Blocks.Num()))
+    {
+        return nullptr;
+    }
+    return &Blocks[Write % Blocks.Num()];
+}
+
+void FPanoAudioBlockRing::EndWrite()
+{
+    WriteCursor.store(WriteCursor.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+const FPanoAudioBlockRing::FBlock* FPanoAudioBlockRing::BeginRead()
+{
+    const uint64 Read = ReadCursor.load(std::memory_order_relaxed);
+    if (Read == WriteCursor.load(std::memory_order_acquire))
+    {
+        return nullptr;
+    }
+    return &Blocks[Read % Blocks.Num()];
+}
+
+void FPanoAudioBlockRing::EndRead()
+{
+    ReadCursor.store(ReadCursor.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
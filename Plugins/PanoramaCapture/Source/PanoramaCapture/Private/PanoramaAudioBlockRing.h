@@ -0,0 +1,45 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include <atomic>
+
+/**
+ * Single-producer/single-consumer ring of preallocated audio blocks.
+ *
+ * The audio render thread is the only producer and never blocks or allocates: BeginWrite returns null when the
+ * ring is full and the caller counts an overrun. The writer thread is the only consumer.
+ */
+class FPanoAudioBlockRing
+{
+public:
+    struct FBlock
+    {
+        TArray<float> Samples;
+        int32 NumSamples = 0;
+        /** Samples dropped on overrun just before this block; the writer fills them with silence. */
+        int64 GapSamples = 0;
+        /** AudioClock reported with the callback this block came from. */
+        double AudioClock = 0.0;
+    };
+
+    FPanoAudioBlockRing(int32 InNumBlocks, int32 InBlockSamples);
+
+    /** Producer: returns the next free block, or null if the consumer has fallen behind. */
+    FBlock* BeginWrite();
+    void EndWrite();
+
+    /** Consumer: returns the oldest filled block, or null if the ring is empty. */
+    const FBlock* BeginRead();
+    void EndRead();
+
+    int32 GetBlockSamples() const { return BlockSamples; }
+    int32 GetNumBlocks() const { return Blocks.Num(); }
+
+private:
+    TArray<FBlock> Blocks;
+    int32 BlockSamples;
+
+    alignas(PLATFORM_CACHE_LINE_SIZE) std::atomic<uint64> WriteCursor;
+    alignas(PLATFORM_CACHE_LINE_SIZE) std::atomic<uint64> ReadCursor;
+};
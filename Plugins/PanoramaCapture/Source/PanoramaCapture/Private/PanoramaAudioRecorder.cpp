@@ -2,53 +2,69 @@
 
 #include "AudioDevice.h"
 #include "AudioMixerDevice.h"
+#include "Async/Async.h"
 #include "Engine/Engine.h"
+#include "HAL/Event.h"
+#include "HAL/PlatformProcess.h"
 #include "Sound/SoundSubmix.h"
-#include "Misc/ScopeLock.h"
+#include "PanoramaAudioBlockRing.h"
+#include "PanoramaCaptureClock.h"
+#include "PanoramaWavWriter.h"
 
 namespace
 {
-    static void WriteWaveHeader(TArray<uint8>& Buffer, int32 InSampleRate, int32 InNumChannels, int32 InBitsPerSample, int32 DataSize)
-    {
-        const int32 ByteRate = InSampleRate * InNumChannels * InBitsPerSample / 8;
-        const int32 BlockAlign = InNumChannels * InBitsPerSample / 8;
-
-        Buffer.Reset();
-        Buffer.Append(reinterpret_cast<const uint8*>("RIFF"), 4);
-        const int32 ChunkSize = 36 + DataSize;
-        Buffer.Append(reinterpret_cast<const uint8*>(&ChunkSize), 4);
-        Buffer.Append(reinterpret_cast<const uint8*>("WAVE"), 4);
-        Buffer.Append(reinterpret_cast<const uint8*>("fmt "), 4);
-        const int32 Subchunk1Size = 16;
-        Buffer.Append(reinterpret_cast<const uint8*>(&Subchunk1Size), 4);
-        const uint16 AudioFormat = 1;
-        Buffer.Append(reinterpret_cast<const uint8*>(&AudioFormat), 2);
-        const uint16 NumChannels16 = static_cast<uint16>(InNumChannels);
-        Buffer.Append(reinterpret_cast<const uint8*>(&NumChannels16), 2);
-        Buffer.Append(reinterpret_cast<const uint8*>(&InSampleRate), 4);
-        Buffer.Append(reinterpret_cast<const uint8*>(&ByteRate), 4);
-        Buffer.Append(reinterpret_cast<const uint8*>(&BlockAlign), 2);
-        const uint16 BitsPerSample16 = static_cast<uint16>(InBitsPerSample);
-        Buffer.Append(reinterpret_cast<const uint8*>(&BitsPerSample16), 2);
-        Buffer.Append(reinterpret_cast<const uint8*>("data"), 4);
-        Buffer.Append(reinterpret_cast<const uint8*>(&DataSize), 4);
-    }
+    // The writer polls on a timer so the audio thread never has to signal it.
+    constexpr uint32 kWriterWakeMs = 20;
+    constexpr int32 kBlockFrames = 1024;
+    // Ring headroom; the writer would have to stall this long before the callback starts dropping.
+    constexpr double kRingSeconds = 2.0;
 }
 
 FPanoAudioRecorder::FPanoAudioRecorder()
-    : StartTime(0.0)
+    : WriterWakeEvent(FPlatformProcess::GetSynchEventFromPool(false))
+    , bStopWriter(false)
+    , bWriteFailed(false)
+    , SamplesWritten(0)
+    , OverrunCount(0)
+    , DroppedSamples(0)
+    , ChannelMismatchCount(0)
+    , MaxCallbackSeconds(0.0)
+    , PendingGapSamples(0)
+    , CaptureClock(nullptr)
     , SampleRate(48000)
     , NumChannels(2)
     , bRecording(false)
+    , bListening(false)
 {
 }
 
 FPanoAudioRecorder::~FPanoAudioRecorder()
 {
     StopRecording();
+    FPlatformProcess::ReturnSynchEventToPool(WriterWakeEvent);
+    WriterWakeEvent = nullptr;
+}
+
+bool FPanoAudioRecorder::StartRecording(USoundSubmixBase* Submix, int32 InSampleRate, int32 InNumChannels, const FString& WavFilePath, FPanoCaptureClock* InCaptureClock)
+{
+    if (bRecording)
+    {
+        return false;
+    }
+
+    FAudioDevice* AudioDevice = GEngine ? GEngine->GetMainAudioDevice() : nullptr;
+    Audio::FMixerDevice* MixerDevice = AudioDevice ? static_cast<Audio::FMixerDevice*>(AudioDevice->GetAudioMixerDevice()) : nullptr;
+    if (!MixerDevice || !StartStreaming(InSampleRate, InNumChannels, WavFilePath, InCaptureClock))
+    {
+        return false;
+    }
+
+    MixerDevice->RegisterSubmixBufferListener(this, Submix);
+    bListening = true;
+    return true;
 }
 
-bool FPanoAudioRecorder::StartRecording(USoundSubmixBase* Submix, int32 InSampleRate, int32 InNumChannels)
+bool FPanoAudioRecorder::StartStreaming(int32 InSampleRate, int32 InNumChannels, const FString& WavFilePath, FPanoCaptureClock* InCaptureClock)
 {
     if (bRecording)
     {
@@ -57,25 +73,43 @@ bool FPanoAudioRecorder::StartRecording(USoundSubmixBase* Submix, int32 InSample
 
     SampleRate = InSampleRate;
     NumChannels = InNumChannels;
-    AccumulatedPCM.Reset();
-    StartTime = FPlatformTime::Seconds();
+    WavPath = WavFilePath;
+    SamplesWritten = 0;
+    OverrunCount = 0;
+    DroppedSamples = 0;
+    ChannelMismatchCount = 0;
+    MaxCallbackSeconds = 0.0;
+    PendingGapSamples = 0;
+    CaptureClock = InCaptureClock;
 
-    if (FAudioDevice* AudioDevice = GEngine ? GEngine->GetMainAudioDevice() : nullptr)
+    const int32 NumBlocks = FMath::CeilToInt32(kRingSeconds * SampleRate / kBlockFrames);
+    BlockRing = MakeUnique<FPanoAudioBlockRing>(NumBlocks, kBlockFrames * FMath::Max(1, NumChannels));
+    DrainPCM.Reset();
+    DrainPCM.Reserve(BlockRing->GetBlockSamples() * 16);
+    SilencePCM.SetNumZeroed(BlockRing->GetBlockSamples());
+
+    WavWriter = MakeUnique<FPanoWavWriter>();
+    WavWriter->SetOnSamplesConverted(PcmListener);
+    if (!WavWriter->Open(WavPath, SampleRate, NumChannels))
     {
-        if (Audio::FMixerDevice* MixerDevice = static_cast<Audio::FMixerDevice*>(AudioDevice->GetAudioMixerDevice()))
-        {
-            MixerDevice->RegisterSubmixBufferListener(this, Submix);
-            bRecording = true;
-            return true;
-        }
+        WavWriter.Reset();
+        return false;
     }
 
-    return false;
+    bStopWriter = false;
+    bWriteFailed = false;
+    WriterThread = Async(EAsyncExecution::Thread, [this]()
+    {
+        WriterLoop();
+    });
+
+    bRecording = true;
+    return true;
 }
 
-void FPanoAudioRecorder::StopRecording()
+void FPanoAudioRecorder::DetachFromSubmix()
 {
-    if (!bRecording)
+    if (!bListening)
     {
         return;
     }
@@ -87,61 +121,192 @@ void FPanoAudioRecorder::StopRecording()
             MixerDevice->UnregisterSubmixBufferListener(this);
         }
     }
-
-    bRecording = false;
+    bListening = false;
 }
 
-void FPanoAudioRecorder::Reset()
+void FPanoAudioRecorder::StopRecording()
 {
-    FScopeLock Lock(&BufferGuard);
-    AccumulatedPCM.Reset();
-    WavDataCache.Reset();
-    StartTime = 0.0;
-}
+    if (!bRecording)
+    {
+        return;
+    }
 
-bool FPanoAudioRecorder::WriteToWav(const FString& FilePath, double& OutDurationSeconds)
-{
-    FScopeLock Lock(&BufferGuard);
+    DetachFromSubmix();
 
-    if (AccumulatedPCM.Num() == 0)
+    // The writer drains whatever is still queued before it exits.
+    bStopWriter = true;
+    WriterWakeEvent->Trigger();
+    if (WriterThread.IsValid())
     {
-        return false;
+        WriterThread.Wait();
+        WriterThread = TFuture<void>();
     }
 
-    const int32 BitsPerSample = 16;
-    TArray<int16> Converted;
-    Converted.Reserve(AccumulatedPCM.Num());
+    const double FinalizeStart = FPlatformTime::Seconds();
+    WavWriter->Close();
+    UE_LOG(LogTemp, Log, TEXT("Panorama audio: %.1f s written to %s, finalized in %.2f ms"),
+        GetRecordedDurationSeconds(), *WavPath, (FPlatformTime::Seconds() - FinalizeStart) * 1000.0);
 
-    for (float Sample : AccumulatedPCM)
+    const FPanoAudioCaptureStats Stats = GetCaptureStats();
+    UE_LOG(LogTemp, Log, TEXT("Panorama audio callback: %d overruns (%lld samples dropped), max %.3f ms in callback"),
+        Stats.OverrunCount, Stats.DroppedSamples, Stats.MaxCallbackMs);
+    if (ChannelMismatchCount.load() > 0)
     {
-        Converted.Add(static_cast<int16>(FMath::Clamp(Sample, -1.f, 1.f) * 32767.f));
+        UE_LOG(LogTemp, Warning, TEXT("Panorama audio: %d submix buffers did not have the recorded %d channels and were written as silence."),
+            ChannelMismatchCount.load(), NumChannels);
     }
+    if (CaptureClock && CaptureClock->GetAudioClockDiscontinuities() > 0)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Panorama audio: the device clock jumped %d times; the clock re-anchored instead of writing the jumps as silence."),
+            CaptureClock->GetAudioClockDiscontinuities());
+    }
+
+    bRecording = false;
+}
+
+void FPanoAudioRecorder::WriterLoop()
+{
+    for (;;)
+    {
+        const bool bStopping = bStopWriter;
+
+        while (const FPanoAudioBlockRing::FBlock* Block = BlockRing->BeginRead())
+        {
+            // Keep the file on the same sample timeline as the capture clock across overruns. The gap goes out after
+            // the samples before it, in chunks of preallocated silence, so a long gap never grows DrainPCM.
+            const bool bGapWritten = Block->GapSamples == 0 || (WriteDrainedSamples() && WriteSilence(Block->GapSamples));
+            if (bGapWritten)
+            {
+                DrainPCM.Append(Block->Samples.GetData(), Block->NumSamples);
+            }
+            BlockRing->EndRead();
+            if (!bGapWritten)
+            {
+                break;
+            }
+        }
 
-    const int32 DataSize = Converted.Num() * sizeof(int16);
-    WriteWaveHeader(WavDataCache, SampleRate, NumChannels, BitsPerSample, DataSize);
-    WavDataCache.Append(reinterpret_cast<const uint8*>(Converted.GetData()), DataSize);
+        if (bWriteFailed || !WriteDrainedSamples() || bStopping)
+        {
+            break;
+        }
+        WriterWakeEvent->Wait(kWriterWakeMs);
+    }
+}
 
-    if (FFileHelper::SaveArrayToFile(WavDataCache, *FilePath))
+bool FPanoAudioRecorder::WriteDrainedSamples()
+{
+    if (DrainPCM.Num() == 0)
     {
-        OutDurationSeconds = static_cast<double>(Converted.Num()) / static_cast<double>(SampleRate * NumChannels);
         return true;
     }
+    const bool bWritten = WriteToWav(DrainPCM.GetData(), DrainPCM.Num());
+    DrainPCM.Reset();
+    return bWritten;
+}
 
-    return false;
+bool FPanoAudioRecorder::WriteSilence(int64 NumSamples)
+{
+    for (int64 Offset = 0; Offset < NumSamples; Offset += SilencePCM.Num())
+    {
+        if (!WriteToWav(SilencePCM.GetData(), FMath::Min<int64>(SilencePCM.Num(), NumSamples - Offset)))
+        {
+            return false;
+        }
+    }
+    return true;
 }
 
-double FPanoAudioRecorder::GetCurrentTimestampSeconds() const
+bool FPanoAudioRecorder::WriteToWav(const float* Samples, int64 NumSamples)
 {
-    if (!bRecording)
+    if (!WavWriter->WriteSamples(Samples, NumSamples))
     {
-        return 0.0;
+        // Anything written after a hole would be off the capture clock's timeline, so the session's audio ends here.
+        UE_LOG(LogTemp, Error, TEXT("Panorama audio: writing %s failed after %.1f s; audio recording stopped."), *WavPath, GetRecordedDurationSeconds());
+        bWriteFailed = true;
+        return false;
     }
+    SamplesWritten += NumSamples;
+    return true;
+}
 
-    return FPlatformTime::Seconds() - StartTime;
+FString FPanoAudioRecorder::GetWavFilePath() const
+{
+    return SamplesWritten.load() > 0 ? WavPath : FString();
+}
+
+double FPanoAudioRecorder::GetRecordedDurationSeconds() const
+{
+    return static_cast<double>(SamplesWritten.load()) / (static_cast<double>(SampleRate) * FMath::Max(1, NumChannels));
+}
+
+FPanoAudioCaptureStats FPanoAudioRecorder::GetCaptureStats() const
+{
+    FPanoAudioCaptureStats Stats;
+    Stats.OverrunCount = OverrunCount.load();
+    Stats.DroppedSamples = DroppedSamples.load();
+    Stats.MaxCallbackMs = static_cast<float>(MaxCallbackSeconds.load() * 1000.0);
+    Stats.RecordedSeconds = static_cast<float>(GetRecordedDurationSeconds());
+    return Stats;
 }
 
 void FPanoAudioRecorder::OnNewSubmixBuffer(const USoundSubmix* OwningSubmix, float* AudioData, int32 NumSamples, int32 InNumChannels, const int32 InSampleRate, double AudioClock)
 {
-    FScopeLock Lock(&BufferGuard);
-    AccumulatedPCM.Append(AudioData, NumSamples);
+    // Audio render thread: no locks, no allocation, no signalling.
+    const double CallbackStart = FPlatformTime::Seconds();
+    if (CaptureClock)
+    {
+        // Audio the device rendered but never delivered is written as silence, like a ring overrun.
+        const int64 MissedFrames = CaptureClock->OnAudioCallback(AudioClock, NumSamples / FMath::Max(1, InNumChannels), CallbackStart);
+        if (MissedFrames > 0)
+        {
+            DroppedSamples.fetch_add(MissedFrames * NumChannels, std::memory_order_relaxed);
+            PendingGapSamples += MissedFrames * NumChannels;
+        }
+    }
+
+    // Nothing drains the ring once a write has failed.
+    if (bWriteFailed.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+
+    // The ring blocks and the WAV header are laid out for NumChannels; another layout would corrupt the file. The
+    // buffer is dropped as silence of the same length so the file stays on the capture clock's timeline.
+    if (InNumChannels != NumChannels)
+    {
+        const int64 Dropped = static_cast<int64>(NumSamples / FMath::Max(1, InNumChannels)) * NumChannels;
+        ChannelMismatchCount.fetch_add(1, std::memory_order_relaxed);
+        DroppedSamples.fetch_add(Dropped, std::memory_order_relaxed);
+        PendingGapSamples += Dropped;
+        return;
+    }
+
+    int32 Offset = 0;
+    while (Offset < NumSamples)
+    {
+        FPanoAudioBlockRing::FBlock* Block = BlockRing->BeginWrite();
+        if (!Block)
+        {
+            OverrunCount.fetch_add(1, std::memory_order_relaxed);
+            DroppedSamples.fetch_add(NumSamples - Offset, std::memory_order_relaxed);
+            PendingGapSamples += NumSamples - Offset;
+            break;
+        }
+
+        const int32 Count = FMath::Min(BlockRing->GetBlockSamples(), NumSamples - Offset);
+        FMemory::Memcpy(Block->Samples.GetData(), AudioData + Offset, Count * sizeof(float));
+        Block->NumSamples = Count;
+        Block->AudioClock = AudioClock;
+        Block->GapSamples = PendingGapSamples;
+        PendingGapSamples = 0;
+        BlockRing->EndWrite();
+        Offset += Count;
+    }
+
+    const double Elapsed = FPlatformTime::Seconds() - CallbackStart;
+    if (Elapsed > MaxCallbackSeconds.load(std::memory_order_relaxed))
+    {
+        MaxCallbackSeconds.store(Elapsed, std::memory_order_relaxed);
+    }
 }
@@ -0,0 +1,103 @@
+#include "PanoramaBatchedCapture.h"
+
+#include "CanvasTypes.h"
+#include "EngineModule.h"
+#include "Engine/TextureRenderTarget2D.h"
+#include "Engine/World.h"
+#include "LegacyScreenPercentageDriver.h"
+#include "PanoramaCaptureRegion.h"
+#include "RHI.h"
+#include "RendererInterface.h"
+#include "SceneView.h"
+
+namespace
+{
+    constexpr int32 kAtlasColumns = 3;
+    constexpr int32 kAtlasRowsPerEye = 2;
+}
+
+namespace PanoramaBatchedCapture
+{
+    FIntPoint GetAtlasSize(int32 EyeCount, int32 FaceSize)
+    {
+        return FIntPoint(kAtlasColumns * FaceSize, kAtlasRowsPerEye * FMath::Max(1, EyeCount) * FaceSize);
+    }
+
+    FIntPoint GetTileOrigin(int32 EyeIndex, int32 Face, int32 FaceSize)
+    {
+        return FIntPoint((Face % kAtlasColumns) * FaceSize, (EyeIndex * kAtlasRowsPerEye + Face / kAtlasColumns) * FaceSize);
+    }
+
+    int32 GetMaxFaceSize(int32 EyeCount)
+    {
+        return static_cast<int32>(GMaxTextureDimensions) / (kAtlasRowsPerEye * FMath::Max(1, EyeCount));
+    }
+
+    void Render(UWorld* World, const FEngineShowFlags& ShowFlags, TArrayView<const FVector> EyeLocations, uint8 FaceMask, UTextureRenderTarget2D* Atlas, int32 FaceSize)
+    {
+        // The same 90 degree projection the cube capture renders each face with.
+        const FMatrix Projection = FReversedZPerspectiveMatrix(UE_HALF_PI * 0.5f, 1.0f, 1.0f, GNearClippingPlane);
+
+        TArray<FPanoBatchedView, TInlineAllocator<12>> Views;
+        for (int32 EyeIndex = 0; EyeIndex < EyeLocations.Num(); ++EyeIndex)
+        {
+            for (int32 Face = 0; Face < PanoramaCaptureRegion::FaceCount; ++Face)
+            {
+                if (!(FaceMask & (1 << Face)))
+                {
+                    continue;
+                }
+
+                FPanoBatchedView& View = Views.AddDefaulted_GetRef();
+                View.Origin = EyeLocations[EyeIndex];
+                View.Rotation = PanoramaCaptureRegion::GetFaceRotation(Face);
+                View.Rect = FIntRect(GetTileOrigin(EyeIndex, Face, FaceSize), GetTileOrigin(EyeIndex, Face, FaceSize) + FIntPoint(FaceSize));
+                View.Projection = Projection;
+            }
+        }
+        RenderViews(World, ShowFlags, Views, Atlas);
+    }
+
+    void RenderViews(UWorld* World, const FEngineShowFlags& ShowFlags, TArrayView<const FPanoBatchedView> Views, UTextureRenderTarget2D* Atlas)
+    {
+        FTextureRenderTargetResource* Target = Atlas ? Atlas->GameThread_GetRenderTargetResource() : nullptr;
+        if (!World || !World->Scene || !Target || Views.Num() == 0)
+        {
+            return;
+        }
+
+        FSceneViewFamilyContext ViewFamily(FSceneViewFamily::ConstructionValues(Target, World->Scene, ShowFlags)
+            .SetTime(World->GetTime())
+            .SetRealtimeUpdate(true));
+        ViewFamily.SceneCaptureSource = ESceneCaptureSource::SCS_SceneColorHDR;
+        ViewFamily.SetScreenPercentageInterface(new FLegacyScreenPercentageDriver(ViewFamily, 1.0f));
+
+        // Scene-component axes (X forward, Y right, Z up) to view space (X right, Y up, Z forward).
+        const FMatrix ComponentToView(FPlane(0, 0, 1, 0), FPlane(1, 0, 0, 0), FPlane(0, 1, 0, 0), FPlane(0, 0, 0, 1));
+
+        for (const FPanoBatchedView& BatchedView : Views)
+        {
+            // Projection[0][0] is 1 / tan(half horizontal FOV).
+            const float Fov = FMath::RadiansToDegrees(2.0f * FMath::Atan(1.0f / BatchedView.Projection.M[0][0]));
+
+            FSceneViewInitOptions ViewInitOptions;
+            ViewInitOptions.SetViewRectangle(BatchedView.Rect);
+            ViewInitOptions.ViewFamily = &ViewFamily;
+            ViewInitOptions.ViewOrigin = BatchedView.Origin;
+            ViewInitOptions.ViewRotationMatrix = FInverseRotationMatrix(BatchedView.Rotation) * ComponentToView;
+            ViewInitOptions.ProjectionMatrix = BatchedView.Projection;
+            ViewInitOptions.BackgroundColor = FLinearColor::Black;
+            ViewInitOptions.FOV = Fov;
+            ViewInitOptions.DesiredFOV = Fov;
+            ViewInitOptions.bIsSceneCapture = true;
+
+            FSceneView* View = new FSceneView(ViewInitOptions);
+            View->StartFinalPostprocessSettings(ViewInitOptions.ViewOrigin);
+            View->EndFinalPostprocessSettings(ViewInitOptions);
+            ViewFamily.Views.Add(View);
+        }
+
+        FCanvas Canvas(Target, nullptr, World, World->GetFeatureLevel(), FCanvas::CDM_DeferDrawing, 1.0f);
+        GetRendererModule().BeginRenderingViewFamily(&Canvas, &ViewFamily);
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UTextureRenderTarget2D;
+class UWorld;
+class FEngineShowFlags;
+
+/** One view of a batch: where it renders from, which way it looks, and the atlas rectangle it lands in. */
+struct FPanoBatchedView
+{
+    FVector Origin = FVector::ZeroVector;
+    /** Scene-component orientation (X forward, Y right, Z up). */
+    FRotator Rotation = FRotator::ZeroRotator;
+    FIntRect Rect;
+    FMatrix Projection = FMatrix::Identity;
+};
+
+/**
+ * Renders the cube faces of several eye positions as the views of one view family, so the scene renderer runs its
+ * per-frame setup (GPU scene upload, visibility setup, view-independent shadow depths, Lumen scene update) once
+ * instead of once per eye. Faces land in tiles of a 2D atlas, three across and two down per eye, in ECubeFace order;
+ * the equirect dispatch copies them into the cube's slices.
+ */
+namespace PanoramaBatchedCapture
+{
+    FIntPoint GetAtlasSize(int32 EyeCount, int32 FaceSize);
+    FIntPoint GetTileOrigin(int32 EyeIndex, int32 Face, int32 FaceSize);
+
+    /** Largest face edge whose atlas fits the RHI's 2D texture limit. */
+    int32 GetMaxFaceSize(int32 EyeCount);
+
+    /**
+     * Game thread: renders scene color (HDR, no post-processing, like the cube capture) for each face in FaceMask at
+     * every eye location into Atlas. Face orientations are the cube capture's, world-aligned.
+     */
+    void Render(UWorld* World, const FEngineShowFlags& ShowFlags, TArrayView<const FVector> EyeLocations, uint8 FaceMask, UTextureRenderTarget2D* Atlas, int32 FaceSize);
+
+    /** Game thread: renders scene color for arbitrary views into their rectangles of Atlas, as one view family. */
+    void RenderViews(UWorld* World, const FEngineShowFlags& ShowFlags, TArrayView<const FPanoBatchedView> Views, UTextureRenderTarget2D* Atlas);
+}
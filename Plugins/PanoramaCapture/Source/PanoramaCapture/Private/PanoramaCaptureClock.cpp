@@ -0,0 +1,117 @@
+#include "PanoramaCaptureClock.h"
+
+namespace
+{
+    // A larger lead is a jump of the device clock (device switch or reset), not lost blocks. Filling it with silence
+    // would push the rest of the WAV off the video.
+    constexpr double kMaxMissedAudioSeconds = 1.0;
+}
+
+FPanoCaptureClock::FPanoCaptureClock(int32 InSampleRate)
+    : SampleRate(FMath::Max(1, InSampleRate))
+    , StartWallSeconds(0.0)
+    , LastSessionSeconds(0.0)
+    , Sequence(0)
+    , AnchorFramePosition(0)
+    , AnchorWallSeconds(0.0)
+    , AnchorBlockSeconds(0.0)
+    , FramesProduced(0)
+    , AudioClockBase(0.0)
+    , AudioClockDiscontinuities(0)
+    , bHasAudio(false)
+    , AudioStartSeconds(0.0)
+    , FirstAudioClock(0.0)
+{
+}
+
+void FPanoCaptureClock::Start(double WallSeconds)
+{
+    StartWallSeconds = WallSeconds;
+    LastSessionSeconds = 0.0;
+    FramesProduced = 0;
+    AudioClockDiscontinuities = 0;
+    bHasAudio = false;
+}
+
+int64 FPanoCaptureClock::OnAudioCallback(double AudioClock, int32 NumFrames, double WallSeconds)
+{
+    const double BlockSeconds = static_cast<double>(NumFrames) / SampleRate;
+    int64 MissedFrames = 0;
+    if (!bHasAudio.load(std::memory_order_relaxed))
+    {
+        // The first block was being produced for BlockSeconds before it was delivered.
+        FirstAudioClock.store(AudioClock, std::memory_order_relaxed);
+        AudioClockBase = AudioClock;
+        AudioStartSeconds.store(WallSeconds - StartWallSeconds - BlockSeconds, std::memory_order_relaxed);
+    }
+    else
+    {
+        // AudioClock is the device's render position at the start of this block. Beyond rounding (half a block), any
+        // lead over the frames counted so far was rendered without reaching this listener.
+        const int64 Lead = FMath::RoundToInt64((AudioClock - AudioClockBase) * SampleRate) - FramesProduced;
+        const int64 MaxMissedFrames = FMath::RoundToInt64(kMaxMissedAudioSeconds * SampleRate);
+        if (FMath::Abs(Lead) > MaxMissedFrames)
+        {
+            // Re-anchor so later callbacks measure their lead from this block instead.
+            AudioClockBase = AudioClock - static_cast<double>(FramesProduced) / SampleRate;
+            AudioClockDiscontinuities.fetch_add(1, std::memory_order_relaxed);
+        }
+        else if (Lead > NumFrames / 2)
+        {
+            MissedFrames = Lead;
+        }
+    }
+
+    FramesProduced += MissedFrames + NumFrames;
+
+    const uint32 Begin = Sequence.load(std::memory_order_relaxed);
+    Sequence.store(Begin + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    AnchorFramePosition.store(FramesProduced, std::memory_order_relaxed);
+    AnchorWallSeconds.store(WallSeconds, std::memory_order_relaxed);
+    AnchorBlockSeconds.store(BlockSeconds, std::memory_order_relaxed);
+    Sequence.store(Begin + 2, std::memory_order_release);
+
+    bHasAudio.store(true, std::memory_order_release);
+    return MissedFrames;
+}
+
+double FPanoCaptureClock::GetSessionSeconds(double WallSeconds)
+{
+    double SessionSeconds = WallSeconds - StartWallSeconds;
+
+    if (HasAudio())
+    {
+        int64 FramePosition = 0;
+        double AnchorWall = 0.0;
+        double BlockSeconds = 0.0;
+        for (;;)
+        {
+            const uint32 Begin = Sequence.load(std::memory_order_acquire);
+            if (Begin & 1)
+            {
+                continue;
+            }
+            FramePosition = AnchorFramePosition.load(std::memory_order_relaxed);
+            AnchorWall = AnchorWallSeconds.load(std::memory_order_relaxed);
+            BlockSeconds = AnchorBlockSeconds.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (Sequence.load(std::memory_order_relaxed) == Begin)
+            {
+                break;
+            }
+        }
+
+        // Extrapolate from the last callback by at most one block; if audio stalls, the clock holds.
+        const double SinceCallback = FMath::Clamp(WallSeconds - AnchorWall, 0.0, BlockSeconds);
+        SessionSeconds = GetAudioStartSeconds() + static_cast<double>(FramePosition) / SampleRate + SinceCallback;
+    }
+
+    LastSessionSeconds = FMath::Max(LastSessionSeconds, SessionSeconds);
+    return LastSessionSeconds;
+}
+
+int64 FPanoCaptureClock::SessionSecondsToAudioSample(double SessionSeconds) const
+{
+    return FMath::RoundToInt64((SessionSeconds - GetAudioStartSeconds()) * SampleRate);
+}
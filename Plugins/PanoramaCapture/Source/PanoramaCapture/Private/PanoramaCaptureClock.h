@@ -0,0 +1,71 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include <atomic>
+
+/**
+ * Session clock shared by the audio and video paths.
+ *
+ * Until the first submix callback arrives the clock runs on wall time since Start(). After that it is locked to the
+ * audio sample count: each callback publishes the position of the end of its block, and readers extrapolate from the
+ * latest callback by at most one block. The position follows the device's AudioClock rather than only the frames
+ * delivered, so blocks the device rendered but never handed to the listener still advance it. Video frames stamped
+ * with GetSessionSeconds() therefore map to exact sample positions in the recorded WAV, and wall-clock jitter on
+ * the game thread cannot accumulate into drift.
+ *
+ * OnAudioCallback is called from the audio render thread only; everything else from the game thread.
+ */
+class FPanoCaptureClock
+{
+public:
+    explicit FPanoCaptureClock(int32 InSampleRate);
+
+    void Start(double WallSeconds);
+
+    /**
+     * Audio render thread: NumFrames sample frames (dropped or not) were produced starting at AudioClock. Returns the
+     * frames the device rendered since the previous callback that no callback delivered; the recorder writes them as
+     * silence so the WAV stays on this clock's timeline. A lead of more than a second, or any large step backwards, is
+     * taken as a jump of the device clock: the clock re-anchors to AudioClock and reports no missed frames.
+     */
+    int64 OnAudioCallback(double AudioClock, int32 NumFrames, double WallSeconds);
+
+    /** Session time at WallSeconds. Never decreases between calls. */
+    double GetSessionSeconds(double WallSeconds);
+
+    /** Sample index in the recorded audio at the given session time (negative before the first audio sample). */
+    int64 SessionSecondsToAudioSample(double SessionSeconds) const;
+
+    bool HasAudio() const { return bHasAudio.load(std::memory_order_acquire); }
+
+    /** Session time of audio sample 0. */
+    double GetAudioStartSeconds() const { return AudioStartSeconds.load(std::memory_order_acquire); }
+
+    /** AudioClock reported with the first callback. */
+    double GetFirstAudioClock() const { return FirstAudioClock.load(std::memory_order_acquire); }
+
+    int32 GetSampleRate() const { return SampleRate; }
+
+    /** Device clock jumps OnAudioCallback re-anchored to instead of filling with silence. */
+    int32 GetAudioClockDiscontinuities() const { return AudioClockDiscontinuities.load(std::memory_order_relaxed); }
+
+private:
+    int32 SampleRate;
+    double StartWallSeconds;
+    double LastSessionSeconds;
+
+    // Written by the audio thread under a sequence lock.
+    std::atomic<uint32> Sequence;
+    std::atomic<int64> AnchorFramePosition;
+    std::atomic<double> AnchorWallSeconds;
+    std::atomic<double> AnchorBlockSeconds;
+    int64 FramesProduced;
+    /** Audio-thread only: AudioClock at frame 0, moved forward or back when the device clock jumps. */
+    double AudioClockBase;
+    std::atomic<int32> AudioClockDiscontinuities;
+
+    std::atomic<bool> bHasAudio;
+    std::atomic<double> AudioStartSeconds;
+    std::atomic<double> FirstAudioClock;
+};
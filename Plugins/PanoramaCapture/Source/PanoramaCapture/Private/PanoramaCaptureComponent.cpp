@@ -2,18 +2,38 @@
 
 #include "Camera/CameraComponent.h"
 #include "Components/SceneCaptureComponent2D.h"
+#include "Components/SceneCaptureComponentCube.h"
 #include "Engine/TextureRenderTarget2D.h"
+#include "Engine/TextureRenderTargetCube.h"
 #include "Engine/World.h"
 #include "Misc/FileHelper.h"
 #include "Misc/Paths.h"
 #include "Misc/Guid.h"
 #include "Misc/ScopeLock.h"
 #include "Misc/DateTime.h"
+#include "Misc/App.h"
+#include "Misc/ScopeExit.h"
 #include "HAL/FileManager.h"
 #include "HAL/PlatformProcess.h"
+#include "HAL/Event.h"
+#include "PanoramaBatchedCapture.h"
+#include "PanoramaCaptureCostTimer.h"
+#include "PanoramaCaptureRegion.h"
 #include "PanoramaCubemapToEquirectCS.h"
+#include "PanoramaFrameGraph.h"
+#include "PanoramaFrameRingBuffer.h"
+#include "PanoramaOdsProjection.h"
+#include "PanoramaOdsStitchCS.h"
+#include "PanoramaPackCS.h"
+#include "PanoramaPixelConvert.h"
+#include "PanoramaPixelPack.h"
+#include "PanoramaPreviewCS.h"
+#include "PanoramaLatencyHistogram.h"
+#include "PanoramaMuxer.h"
 #include "PanoramaPngWriter.h"
+#include "PanoramaReadbackPool.h"
 #include "PanoramaAudioRecorder.h"
+#include "PanoramaCaptureClock.h"
 #include "PanoramaNvencEncoder.h"
 #include "PanoramaCaptureModule.h"
 #include "PanoramaCaptureSettings.h"
@@ -21,6 +41,7 @@
 #include "RenderGraphBuilder.h"
 #include "RenderGraphUtils.h"
 #include "RendererInterface.h"
+#include "RHI.h"
 #include "RHICommandList.h"
 #include "RHIStaticStates.h"
 #include "RenderTargetPool.h"
@@ -32,11 +53,35 @@
 #include "SceneInterface.h"
 #include "SceneView.h"
 #include "SceneRendering.h"
+#include "ProfilingDebugging/RealtimeGPUProfiler.h"
 #include "Async/Async.h"
+#include "Async/ParallelFor.h"
+
+#include <atomic>
+
+DECLARE_GPU_STAT_NAMED(PanoramaEquirectAnalytic, TEXT("Panorama Equirect (analytic)"));
+DECLARE_GPU_STAT_NAMED(PanoramaEquirectLookup, TEXT("Panorama Equirect (lookup table)"));
+DECLARE_GPU_STAT_NAMED(PanoramaEquirectLutBuild, TEXT("Panorama Equirect LUT build"));
+DECLARE_GPU_STAT_NAMED(PanoramaEquirectBicubic, TEXT("Panorama Equirect (bicubic)"));
+DECLARE_GPU_STAT_NAMED(PanoramaEquirectLanczos, TEXT("Panorama Equirect (Lanczos-3)"));
+DECLARE_GPU_STAT_NAMED(PanoramaEquirectSupersampled, TEXT("Panorama Equirect (supersampled)"));
+DECLARE_GPU_STAT_NAMED(PanoramaOdsStitch, TEXT("Panorama ODS stitch"));
 
 namespace
 {
-    constexpr int32 kCubemapFaceCount = 6;
+    constexpr int32 kAudioSampleRate = 48000;
+    /** Overall progress at which each EPanoramaFinalizeStage begins; the last entry is Complete. */
+    constexpr float kFinalizeStageStart[] = { 0.f, 0.6f, 0.65f, 0.8f, 1.f };
+    constexpr float kProgressReportStep = 0.01f;
+    constexpr int32 kMinFaceSize = 256;
+    constexpr int32 kFaceSizeAlignment = 32;
+    constexpr float kFaceBudgetWindowSeconds = 1.f;
+    /** Face edge multiplier per over-budget window; 0.8 cuts scene-render pixels by about a third. */
+    constexpr float kFaceBudgetStep = 0.8f;
+    constexpr float kCaptureCostWindowSeconds = 5.f;
+    constexpr float kEyeSeparationCm = 6.4f;
+    /** A locked-timestep take gives up on a frame only if the encoder has not freed a slot for this long. */
+    constexpr double kLockedSlotTimeoutSeconds = 30.0;
 
     FIntPoint GetTargetResolution(const FPanoCaptureOutputSettings& Settings)
     {
@@ -47,6 +92,35 @@ namespace
         return FIntPoint(Settings.Resolution.Width, Settings.Resolution.Height);
     }
 
+    int32 AlignFaceSize(float Size, int32 MaxSize)
+    {
+        const int32 Aligned = FMath::FloorToInt(Size / kFaceSizeAlignment + 0.5f) * kFaceSizeAlignment;
+        return FMath::Clamp(Aligned, kMinFaceSize, FMath::Max(kMinFaceSize, MaxSize));
+    }
+
+    int32 GetMaxFaceSize(const FPanoCaptureOutputSettings& Settings)
+    {
+        const int32 RhiLimit = static_cast<int32>(GMaxCubeTextureDimensions);
+        return Settings.MaxFaceResolution > 0 ? FMath::Min(RhiLimit, Settings.MaxFaceResolution) : RhiLimit;
+    }
+
+    /** A quarter of the equirect width spans each face's 90 degrees; the scale trades scene-render cost for detail. */
+    int32 GetFaceSize(const FPanoCaptureOutputSettings& Settings)
+    {
+        const float Scale = FMath::Clamp(Settings.FaceResolutionScale, 0.25f, 4.f);
+        return AlignFaceSize(GetTargetResolution(Settings).X * 0.25f * Scale, GetMaxFaceSize(Settings));
+    }
+
+    void LogFaceDensity(int32 FaceSize, int32 EquirectWidth)
+    {
+        // Face texels per radian are FaceSize / 2 at a face centre and twice that across a seam; the equirect has
+        // Width / 2pi pixels per radian along the equator and along every meridian. Poles sit at the top and bottom
+        // face centres, where meridian density decides.
+        const float CentreRatio = UE_PI * FaceSize / EquirectWidth;
+        UE_LOG(LogTemp, Display, TEXT("PanoramaCapture: %d px cube faces (%.1f MPix per eye) for a %d px wide equirect. Face texels per equirect pixel: equator %.2f at face centres, %.2f at seams; poles %.2f."),
+            FaceSize, 6.0 * FaceSize * FaceSize / 1.0e6, EquirectWidth, CentreRatio, 2.f * CentreRatio, CentreRatio);
+    }
+
     FString SanitizeSessionName(const FString& InValue)
     {
         FString Sanitized = FPaths::MakeValidFileName(InValue);
@@ -95,16 +169,6 @@ namespace
         return SanitizeSessionName(TEXT("Panorama"));
     }
 
-    struct FPanoCaptureFrame
-    {
-        uint64 FrameIndex = 0;
-        double Timecode = 0.0;
-        FIntPoint Resolution;
-        bool bLinear = false;
-        bool b16Bit = false;
-        TArray<uint8> PixelData;
-    };
-
     FString LocateFfmpegExecutable()
     {
         TArray<FString> CandidatePaths;
@@ -145,12 +209,18 @@ namespace
         return ReturnCode == 0;
     }
 
-    void PackageSequenceToContainer(const FString& SequencePattern, const FString& AudioPath, float FrameRate, const FString& OutputPath, const FPanoNvencRateControl& RateControl, EPanoramaCaptureCodec Codec)
+    /** Delays whichever input starts later so frame 0 and audio sample 0 land where the capture clock put them. */
+    FString FormatInputOffset(double OffsetSeconds)
+    {
+        return OffsetSeconds > 0.0 ? FString::Printf(TEXT(" -itsoffset %.6f"), OffsetSeconds) : FString();
+    }
+
+    bool PackageSequenceToContainer(const FString& SequencePattern, const FString& AudioPath, float FrameRate, double VideoOffsetSeconds, const FString& OutputPath, const FPanoNvencRateControl& RateControl, EPanoramaCaptureCodec Codec)
     {
-        FString CommandLine = FString::Printf(TEXT(" -y -framerate %.3f -i \"%s\""), FrameRate, *SequencePattern);
+        FString CommandLine = FString::Printf(TEXT(" -y%s -framerate %.3f -i \"%s\""), *FormatInputOffset(VideoOffsetSeconds), FrameRate, *SequencePattern);
         if (!AudioPath.IsEmpty() && FPaths::FileExists(AudioPath))
         {
-            CommandLine += FString::Printf(TEXT(" -i \"%s\" -c:a aac"), *AudioPath);
+            CommandLine += FString::Printf(TEXT("%s -i \"%s\" -c:a aac"), *FormatInputOffset(-VideoOffsetSeconds), *AudioPath);
         }
         else
         {
@@ -171,26 +241,7 @@ namespace
         }
         CommandLine += FString::Printf(TEXT(" \"%s\""), *OutputPath);
 
-        RunFfmpeg(CommandLine);
-    }
-
-    void PackageBitstreamToContainer(const FString& BitstreamPath, const FString& AudioPath, float FrameRate, const FString& OutputPath, EPanoramaCaptureCodec Codec)
-    {
-        FString CommandLine = FString::Printf(TEXT(" -y -framerate %.3f -i \"%s\""), FrameRate, *BitstreamPath);
-        if (!AudioPath.IsEmpty() && FPaths::FileExists(AudioPath))
-        {
-            CommandLine += FString::Printf(TEXT(" -i \"%s\" -c:a aac"), *AudioPath);
-        }
-        else
-        {
-            CommandLine += TEXT(" -an");
-        }
-
-        const FString CodecFlag = Codec == EPanoramaCaptureCodec::H264 ? TEXT(" -c:v copy -bsf:v h264_mp4toannexb") : TEXT(" -c:v copy");
-        CommandLine += CodecFlag;
-        CommandLine += FString::Printf(TEXT(" \"%s\""), *OutputPath);
-
-        RunFfmpeg(CommandLine);
+        return RunFfmpeg(CommandLine);
     }
 
     FString MakeUniqueOutputPath(const FString& BasePath, bool bOverwrite)
@@ -215,78 +266,25 @@ namespace
         return Candidate;
     }
 
-    class FPanoFrameRingBuffer
-    {
-    public:
-        FPanoFrameRingBuffer(int32 InCapacity)
-            : Capacity(InCapacity)
-            , Head(0)
-            , Tail(0)
-            , Count(0)
-        {
-            Buffer.SetNum(Capacity);
-        }
-
-        bool Enqueue(FPanoCaptureFrame&& Frame)
-        {
-            FScopeLock Lock(&CriticalSection);
-            if (Count == Capacity)
-            {
-                return false;
-            }
-
-            Buffer[Head] = MoveTemp(Frame);
-            Head = (Head + 1) % Capacity;
-            ++Count;
-            return true;
-        }
-
-        bool Dequeue(FPanoCaptureFrame& OutFrame)
-        {
-            FScopeLock Lock(&CriticalSection);
-            if (Count == 0)
-            {
-                return false;
-            }
-
-            OutFrame = MoveTemp(Buffer[Tail]);
-            Tail = (Tail + 1) % Capacity;
-            --Count;
-            return true;
-        }
-
-        void Reset()
-        {
-            FScopeLock Lock(&CriticalSection);
-            Head = 0;
-            Tail = 0;
-            Count = 0;
-        }
-
-        int32 Num() const
-        {
-            return Count;
-        }
-
-    private:
-        TArray<FPanoCaptureFrame> Buffer;
-        int32 Capacity;
-        int32 Head;
-        int32 Tail;
-        int32 Count;
-        mutable FCriticalSection CriticalSection;
-    };
-
     class FPanoCaptureWorker
     {
     public:
-        FPanoCaptureWorker(FPanoFrameRingBuffer* InRingBuffer, FPanoPngWriter* InPngWriter)
+        FPanoCaptureWorker(FPanoFrameRingBuffer* InRingBuffer, FPanoPngWriter* InPngWriter, FPanoLatencyHistogram* InLatencyHistogram)
             : RingBuffer(InRingBuffer)
             , PngWriter(InPngWriter)
+            , LatencyHistogram(InLatencyHistogram)
+            , FrameAvailableEvent(FPlatformProcess::GetSynchEventFromPool(false))
             , bIsRunning(false)
         {
         }
 
+        ~FPanoCaptureWorker()
+        {
+            Stop();
+            FPlatformProcess::ReturnSynchEventToPool(FrameAvailableEvent);
+            FrameAvailableEvent = nullptr;
+        }
+
         void Start()
         {
             if (bIsRunning)
@@ -301,9 +299,17 @@ namespace
             });
         }
 
+        /** Called by the producer after committing a slot. */
+        void NotifyFrameAvailable()
+        {
+            FrameAvailableEvent->Trigger();
+        }
+
+        /** Stops the worker after every frame already committed to the ring has been handed to the writer. */
         void Stop()
         {
             bIsRunning = false;
+            FrameAvailableEvent->Trigger();
             if (WorkerThread.IsValid())
             {
                 WorkerThread.Wait();
@@ -313,50 +319,508 @@ namespace
 
         void Run()
         {
-            FPanoCaptureFrame Frame;
-            while (bIsRunning)
+            for (;;)
             {
-                if (!RingBuffer || !RingBuffer->Dequeue(Frame))
+                FPanoCaptureFrame* Frame = RingBuffer ? RingBuffer->AcquireReadSlot() : nullptr;
+                if (!Frame)
                 {
-                    FPlatformProcess::Sleep(0.001f);
+                    // Check the flag only once the ring is empty so Stop() drains instead of dropping.
+                    if (!bIsRunning)
+                    {
+                        break;
+                    }
+                    FrameAvailableEvent->Wait();
                     continue;
                 }
 
-                if (PngWriter)
+                if (LatencyHistogram)
+                {
+                    LatencyHistogram->Record(FPlatformTime::Seconds() - Frame->CommitTimeSeconds);
+                }
+
+                if (!PngWriter)
                 {
-                    FPanoPngFrame PngFrame;
-                    PngFrame.FrameIndex = Frame.FrameIndex;
-                    PngFrame.Timecode = Frame.Timecode;
-                    PngFrame.Resolution = Frame.Resolution;
-                    PngFrame.PixelData = MoveTemp(Frame.PixelData);
-                    PngFrame.b16Bit = Frame.b16Bit;
-                    PngWriter->EnqueueFrame(MoveTemp(PngFrame));
+                    RingBuffer->ReleaseSlot(Frame);
+                    continue;
                 }
+
+                FPanoPngFrame PngFrame;
+                PngFrame.FrameIndex = Frame->FrameIndex;
+                PngFrame.Timecode = Frame->Timecode;
+                PngFrame.Resolution = Frame->Resolution;
+                PngFrame.PixelData = TArrayView64<const uint8>(Frame->PixelData.GetData(), Frame->NumBytes);
+                PngFrame.b16Bit = Frame->b16Bit;
+                PngFrame.OnReleased = [RingBuffer = RingBuffer, Frame]()
+                {
+                    RingBuffer->ReleaseSlot(Frame);
+                };
+                PngWriter->EnqueueFrame(MoveTemp(PngFrame));
             }
         }
 
     private:
         FPanoFrameRingBuffer* RingBuffer;
         FPanoPngWriter* PngWriter;
+        FPanoLatencyHistogram* LatencyHistogram;
+        FEvent* FrameAvailableEvent;
         TFuture<void> WorkerThread;
         FThreadSafeBool bIsRunning;
     };
 }
 
+/**
+ * Everything a stopped session still has to do once the game thread lets go of it: drain the frame ring and the
+ * encoder, close the WAV, write the timing sidecar, recompress and package. The job owns the session's objects and
+ * a copy of its settings and never touches the component, so the next take can start while it runs.
+ */
+class FPanoFinalizeJob
+{
+public:
+    struct FSession
+    {
+        FString SessionName;
+        FString OutputDirectory;
+        EPanoramaCaptureMode CaptureMode = EPanoramaCaptureMode::Mono;
+        FPanoCaptureOutputSettings OutputSettings;
+        float CaptureFrameRate = 30.f;
+        bool bEmbedAudio = true;
+        bool bOverwriteExisting = false;
+        bool bGenerateMkv = true;
+        /** Projection bounds of the take's region, for the containers. */
+        FPanoEquirectCrop Crop;
+        /** Frames handed to the ring or the encoder; the denominator of drain progress. */
+        int64 CommittedFrames = 0;
+        TArray<double> FramePresentationSeconds;
+        double StopSeconds = 0.0;
+
+        // Declared so that everything holding a raw pointer into the clock or muxer is destroyed before them.
+        TUniquePtr<FPanoCaptureClock> CaptureClock;
+        TUniquePtr<FPanoLiveMuxer> LiveMuxer;
+        TUniquePtr<FPanoNvencEncoder> NvencEncoder;
+        TUniquePtr<FPanoAudioRecorder> AudioRecorder;
+        FPanoFrameRingBuffer* FrameRingBuffer = nullptr;
+        TUniquePtr<FPanoPngWriter> PngWriter;
+        TUniquePtr<FPanoLatencyHistogram> QueueLatencyHistogram;
+        TUniquePtr<FPanoCaptureWorker> CaptureWorker;
+    };
+
+    struct FSessionStats
+    {
+        FPanoEncodeThroughput PngThroughput;
+        FPanoLatencyStats PngEncodeLatency;
+        FPanoLatencyStats QueueLatency;
+        FPanoAudioCaptureStats AudioStats;
+    };
+
+    explicit FPanoFinalizeJob(FSession&& InSession)
+        : Session(MoveTemp(InSession))
+        , RenderCommandsDone(FPlatformProcess::GetSynchEventFromPool(true))
+        , Stage(EPanoramaFinalizeStage::Draining)
+        , StageProgress(0.f)
+        , bComplete(false)
+        , ReportedStage(EPanoramaFinalizeStage::Draining)
+        , ReportedProgress(-1.f)
+    {
+        Result.SessionName = Session.SessionName;
+        Result.OutputDirectory = Session.OutputDirectory;
+    }
+
+    ~FPanoFinalizeJob()
+    {
+        Wait();
+        FPlatformProcess::ReturnSynchEventToPool(RenderCommandsDone);
+        RenderCommandsDone = nullptr;
+    }
+
+    /** Game thread: fences the render commands already queued for the session and starts the finalize thread. */
+    void Launch()
+    {
+        ENQUEUE_RENDER_COMMAND(PanoramaCapture_FinalizeFence)(
+            [Event = RenderCommandsDone](FRHICommandListImmediate& RHICmdList)
+            {
+                Event->Trigger();
+            });
+
+        WorkerThread = Async(EAsyncExecution::Thread, [this]()
+        {
+            Run();
+        });
+    }
+
+    void Wait()
+    {
+        if (WorkerThread.IsValid())
+        {
+            WorkerThread.Wait();
+            WorkerThread = TFuture<void>();
+        }
+    }
+
+    bool IsComplete() const { return bComplete; }
+    EPanoramaFinalizeStage GetStage() const { return Stage.load(); }
+
+    /** Overall progress in [0, 1]; PNG sessions advance frame by frame while the encode queue drains. */
+    float GetProgress() const
+    {
+        const EPanoramaFinalizeStage CurrentStage = Stage.load();
+        if (CurrentStage == EPanoramaFinalizeStage::Complete)
+        {
+            return 1.f;
+        }
+
+        float StageFraction = StageProgress.load();
+        if (CurrentStage == EPanoramaFinalizeStage::Draining && Session.PngWriter && Session.CommittedFrames > 0)
+        {
+            // The writer stays alive until the job is destroyed, so reading its counters here is safe.
+            StageFraction = FMath::Clamp(static_cast<float>(Session.PngWriter->GetThroughput().FramesEncoded) / Session.CommittedFrames, 0.f, 1.f);
+        }
+
+        const float StageStart = kFinalizeStageStart[static_cast<int32>(CurrentStage)];
+        const float StageEnd = kFinalizeStageStart[static_cast<int32>(CurrentStage) + 1];
+        return FMath::Lerp(StageStart, StageEnd, StageFraction);
+    }
+
+    /** Game thread: true when stage or progress moved enough since the last call to be worth broadcasting. */
+    bool ShouldReportProgress(EPanoramaFinalizeStage& OutStage, float& OutProgress)
+    {
+        OutStage = GetStage();
+        OutProgress = GetProgress();
+        if (OutStage == ReportedStage && OutProgress - ReportedProgress < kProgressReportStep)
+        {
+            return false;
+        }
+        ReportedStage = OutStage;
+        ReportedProgress = OutProgress;
+        return true;
+    }
+
+    /** Valid once IsComplete returns true. */
+    const FPanoFinalizeResult& GetResult() const { return Result; }
+    const FSessionStats& GetStats() const { return Stats; }
+
+private:
+    void SetStage(EPanoramaFinalizeStage InStage)
+    {
+        StageProgress = 0.f;
+        Stage = InStage;
+    }
+
+    void Run()
+    {
+        // Encode, pack and copy commands queued before the stop still reference this session's objects.
+        RenderCommandsDone->Wait();
+
+        DrainFrames();
+
+        SetStage(EPanoramaFinalizeStage::Audio);
+        FString AudioPath;
+        if (Session.AudioRecorder)
+        {
+            // Samples were streamed to disk during capture; stopping only drains the tail and patches the header.
+            Session.AudioRecorder->StopRecording();
+            AudioPath = Session.AudioRecorder->GetWavFilePath();
+            Stats.AudioStats = Session.AudioRecorder->GetCaptureStats();
+            Session.AudioRecorder.Reset();
+        }
+
+        // Offset of video frame 0 from audio sample 0; also recorded, with every frame's PTS, in the timing sidecar.
+        const double VideoOffsetSeconds = WriteTimingSidecar(!AudioPath.IsEmpty());
+
+        Result.bSucceeded = PackageOutputs(Session.bEmbedAudio ? AudioPath : FString(), VideoOffsetSeconds);
+
+        if (Session.PngWriter)
+        {
+            Session.PngWriter->Shutdown();
+        }
+        if (Session.FrameRingBuffer)
+        {
+            delete Session.FrameRingBuffer;
+            Session.FrameRingBuffer = nullptr;
+        }
+
+        Result.FinalizeSeconds = static_cast<float>(FPlatformTime::Seconds() - Session.StopSeconds);
+        UE_LOG(LogTemp, Log, TEXT("Panorama capture finalized: %s in %.2f s%s"), *Session.SessionName, Result.FinalizeSeconds,
+            Result.bSucceeded ? TEXT("") : TEXT(" (packaging failed)"));
+
+        SetStage(EPanoramaFinalizeStage::Complete);
+        bComplete = true;
+    }
+
+    /** Waits until every captured frame has been encoded and written. */
+    void DrainFrames()
+    {
+        // Stop() drains every committed frame into the writer before the worker exits.
+        if (Session.CaptureWorker)
+        {
+            Session.CaptureWorker->Stop();
+            Session.CaptureWorker.Reset();
+        }
+
+        if (Session.PngWriter)
+        {
+            Session.PngWriter->Flush();
+
+            Stats.PngThroughput = Session.PngWriter->GetThroughput();
+            UE_LOG(LogTemp, Log, TEXT("Panorama PNG encode: %d frames on %d workers, %.2f fps, %.1f MB/s raw, %.1f MB/s compressed"),
+                Stats.PngThroughput.FramesEncoded, Stats.PngThroughput.WorkerCount, Stats.PngThroughput.FramesPerSecond,
+                Stats.PngThroughput.RawMegabytesPerSecond, Stats.PngThroughput.CompressedMegabytesPerSecond);
+
+            Stats.PngEncodeLatency = Session.PngWriter->GetEncodeLatency();
+            UE_LOG(LogTemp, Log, TEXT("Panorama PNG encode latency: mean %.1f ms, p50 %.1f ms, p95 %.1f ms, max %.1f ms"),
+                Stats.PngEncodeLatency.MeanMs, Stats.PngEncodeLatency.P50Ms, Stats.PngEncodeLatency.P95Ms, Stats.PngEncodeLatency.MaxMs);
+        }
+
+        if (Session.QueueLatencyHistogram)
+        {
+            Stats.QueueLatency = Session.QueueLatencyHistogram->Summarize();
+            UE_LOG(LogTemp, Log, TEXT("Panorama capture queue latency: %d frames, mean %.3f ms, p50 %.3f ms, p95 %.3f ms, p99 %.3f ms, max %.3f ms"),
+                Stats.QueueLatency.SampleCount, Stats.QueueLatency.MeanMs, Stats.QueueLatency.P50Ms, Stats.QueueLatency.P95Ms,
+                Stats.QueueLatency.P99Ms, Stats.QueueLatency.MaxMs);
+        }
+
+#if PANORAMA_CAPTURE_WITH_NVENC
+        if (Session.NvencEncoder)
+        {
+            Session.NvencEncoder->Flush(EncodedFrames);
+            EncoderBitstreamPath = Session.NvencEncoder->GetParams().OutputBitstreamPath;
+            EncodedResolution = Session.NvencEncoder->GetParams().Resolution;
+            Session.NvencEncoder->Shutdown();
+        }
+#endif
+    }
+
+    /** Writes <session>.timing.json and returns the offset of video frame 0 from audio sample 0. */
+    double WriteTimingSidecar(bool bHasAudioFile) const
+    {
+        const FPanoCaptureClock* CaptureClock = Session.CaptureClock.Get();
+        const TArray<double>& FramePresentationSeconds = Session.FramePresentationSeconds;
+        if (!CaptureClock || FramePresentationSeconds.Num() == 0)
+        {
+            return 0.0;
+        }
+
+        const bool bAudioLocked = bHasAudioFile && CaptureClock->HasAudio();
+        const double AudioStartSeconds = bAudioLocked ? CaptureClock->GetAudioStartSeconds() : 0.0;
+        const double VideoOffsetSeconds = bAudioLocked ? FramePresentationSeconds[0] - AudioStartSeconds : 0.0;
+
+        FString Json;
+        Json.Reserve(256 + FramePresentationSeconds.Num() * 40);
+        Json += TEXT("{\n");
+        Json += FString::Printf(TEXT("  \"session\": \"%s\",\n"), *Session.SessionName.ReplaceCharWithEscapedChar());
+        Json += FString::Printf(TEXT("  \"frameRate\": %.6f,\n"), Session.CaptureFrameRate);
+        Json += FString::Printf(TEXT("  \"audioSampleRate\": %d,\n"), CaptureClock->GetSampleRate());
+        Json += FString::Printf(TEXT("  \"audioLocked\": %s,\n"), bAudioLocked ? TEXT("true") : TEXT("false"));
+        Json += FString::Printf(TEXT("  \"audioStartSeconds\": %.9f,\n"), AudioStartSeconds);
+        Json += FString::Printf(TEXT("  \"firstAudioClock\": %.9f,\n"), bAudioLocked ? CaptureClock->GetFirstAudioClock() : 0.0);
+        Json += FString::Printf(TEXT("  \"videoOffsetSeconds\": %.9f,\n"), VideoOffsetSeconds);
+        Json += FString::Printf(TEXT("  \"videoOffsetSamples\": %lld,\n"), bAudioLocked ? CaptureClock->SessionSecondsToAudioSample(FramePresentationSeconds[0]) : 0ll);
+        Json += TEXT("  \"frameFields\": [\"frameIndex\", \"ptsSeconds\", \"audioSample\"],\n");
+        Json += TEXT("  \"frames\": [\n");
+        for (int32 Index = 0; Index < FramePresentationSeconds.Num(); ++Index)
+        {
+            const double Pts = FramePresentationSeconds[Index] - FramePresentationSeconds[0];
+            const int64 AudioSample = bAudioLocked ? CaptureClock->SessionSecondsToAudioSample(FramePresentationSeconds[Index]) : 0;
+            Json += FString::Printf(TEXT("    [%d, %.9f, %lld]%s\n"), Index, Pts, AudioSample, Index + 1 < FramePresentationSeconds.Num() ? TEXT(",") : TEXT(""));
+        }
+        Json += TEXT("  ]\n}\n");
+
+        const FString SidecarPath = FPaths::Combine(Session.OutputDirectory, FString::Printf(TEXT("%s.timing.json"), *Session.SessionName));
+        if (!FFileHelper::SaveStringToFile(Json, *SidecarPath))
+        {
+            UE_LOG(LogTemp, Warning, TEXT("Failed to write timing sidecar %s"), *SidecarPath);
+        }
+        else
+        {
+            UE_LOG(LogTemp, Log, TEXT("Panorama timing: %d frames, video offset %.3f ms (%s)"), FramePresentationSeconds.Num(),
+                VideoOffsetSeconds * 1000.0, bAudioLocked ? TEXT("audio-locked") : TEXT("wall clock"));
+        }
+
+        return VideoOffsetSeconds;
+    }
+
+    FString MakeSessionPath(const TCHAR* Extension) const
+    {
+        return MakeUniqueOutputPath(FPaths::Combine(Session.OutputDirectory, FString::Printf(TEXT("%s.%s"), *Session.SessionName, Extension)), Session.bOverwriteExisting);
+    }
+
+    /** Returns false when a requested container could not be written. */
+    bool PackageOutputs(const FString& AudioPath, double VideoOffsetSeconds)
+    {
+        const FPanoCaptureOutputSettings& OutputSettings = Session.OutputSettings;
+        bool bSucceeded = true;
+
+        if (OutputSettings.OutputMode == EPanoramaCaptureOutputMode::PNGSequence && Session.PngWriter)
+        {
+            if (OutputSettings.bRecompressPngAfterCapture && OutputSettings.PngCompression != EPanoramaPngCompression::Smallest)
+            {
+                SetStage(EPanoramaFinalizeStage::Recompressing);
+                Session.PngWriter->RecompressGeneratedFiles(FPanoPngEncodeOptions::FromPreset(EPanoramaPngCompression::Smallest));
+            }
+
+            SetStage(EPanoramaFinalizeStage::Packaging);
+            const FString SequencePattern = FPaths::Combine(Session.OutputDirectory, FString::Printf(TEXT("%s_%%06d.png"), *Session.SessionName));
+
+            TArray<FString, TInlineAllocator<2>> ContainerPaths;
+            ContainerPaths.Add(MakeSessionPath(TEXT("mp4")));
+            if (Session.bGenerateMkv)
+            {
+                ContainerPaths.Add(MakeSessionPath(TEXT("mkv")));
+            }
+            for (int32 Index = 0; Index < ContainerPaths.Num(); ++Index)
+            {
+                StageProgress = static_cast<float>(Index) / ContainerPaths.Num();
+                if (PackageSequenceToContainer(SequencePattern, AudioPath, Session.CaptureFrameRate, VideoOffsetSeconds, ContainerPaths[Index], OutputSettings.NvencRateControl, OutputSettings.Codec))
+                {
+                    Result.ContainerFiles.Add(ContainerPaths[Index]);
+                    UE_LOG(LogTemp, Log, TEXT("Panorama capture packaged to %s"), *ContainerPaths[Index]);
+                }
+                else
+                {
+                    bSucceeded = false;
+                }
+            }
+        }
+
+#if PANORAMA_CAPTURE_WITH_NVENC
+        if (OutputSettings.OutputMode == EPanoramaCaptureOutputMode::NVENC && Session.NvencEncoder)
+        {
+            SetStage(EPanoramaFinalizeStage::Packaging);
+            if (FPanoLiveMuxer* LiveMuxer = Session.LiveMuxer.Get())
+            {
+                // Every GOP but the last is already on disk; this writes the tail and patches the indexes.
+                const double MuxFinishStart = FPlatformTime::Seconds();
+                bSucceeded = LiveMuxer->Finish();
+                UE_LOG(LogTemp, Log, TEXT("Panorama live mux: %d fragments, finalized in %.2f ms%s"), LiveMuxer->GetFragmentsWritten(),
+                    (FPlatformTime::Seconds() - MuxFinishStart) * 1000.0, bSucceeded ? TEXT("") : TEXT(" (failed)"));
+                if (bSucceeded)
+                {
+                    Result.ContainerFiles.Append(LiveMuxer->GetOutputPaths());
+                }
+                Session.LiveMuxer.Reset();
+            }
+            else
+            {
+                FString BitstreamPath = EncoderBitstreamPath;
+                if (BitstreamPath.IsEmpty())
+                {
+                    BitstreamPath = FPaths::Combine(Session.OutputDirectory, FString::Printf(TEXT("%s.%s.annexb"), *Session.SessionName,
+                        OutputSettings.Codec == EPanoramaCaptureCodec::H264 ? TEXT("h264") : TEXT("hevc")));
+                }
+
+                if (!FPaths::FileExists(BitstreamPath) && EncodedFrames.Num() > 0)
+                {
+                    TArray<uint8> OutputData;
+                    for (const FPanoramaEncodedFrame& Frame : EncodedFrames)
+                    {
+                        OutputData.Append(Frame.EncodedBytes);
+                    }
+                    if (!FFileHelper::SaveArrayToFile(OutputData, *BitstreamPath))
+                    {
+                        UE_LOG(LogTemp, Warning, TEXT("Failed to persist NVENC bitstream to %s"), *BitstreamPath);
+                    }
+                }
+
+                if (FPaths::FileExists(BitstreamPath))
+                {
+                    // Already on the finalize thread, so the mux runs inline.
+                    FPanoMuxJob MuxJob;
+                    MuxJob.BitstreamPath = BitstreamPath;
+                    MuxJob.AudioWavPath = AudioPath;
+                    MuxJob.Codec = OutputSettings.Codec;
+                    MuxJob.Resolution = EncodedResolution;
+                    MuxJob.FrameRate = Session.CaptureFrameRate;
+                    MuxJob.bStereoTopBottom = Session.CaptureMode == EPanoramaCaptureMode::Stereo;
+                    MuxJob.Crop = Session.Crop;
+                    MuxJob.VideoOffsetSeconds = VideoOffsetSeconds;
+                    MuxJob.Mp4Path = MakeSessionPath(TEXT("mp4"));
+                    if (Session.bGenerateMkv)
+                    {
+                        MuxJob.MkvPath = MakeSessionPath(TEXT("mkv"));
+                    }
+                    bSucceeded = PanoramaMuxer::Run(MuxJob);
+                    if (bSucceeded)
+                    {
+                        Result.ContainerFiles.Add(MuxJob.Mp4Path);
+                        if (!MuxJob.MkvPath.IsEmpty())
+                        {
+                            Result.ContainerFiles.Add(MuxJob.MkvPath);
+                        }
+                    }
+                }
+                else
+                {
+                    UE_LOG(LogTemp, Warning, TEXT("NVENC bitstream not found for session %s."), *Session.SessionName);
+                    bSucceeded = false;
+                }
+            }
+        }
+#endif
+
+        return bSucceeded;
+    }
+
+    FSession Session;
+    FSessionStats Stats;
+    FPanoFinalizeResult Result;
+
+    TArray<FPanoramaEncodedFrame> EncodedFrames;
+    FString EncoderBitstreamPath;
+    FIntPoint EncodedResolution = FIntPoint::ZeroValue;
+
+    FEvent* RenderCommandsDone;
+    TFuture<void> WorkerThread;
+    std::atomic<EPanoramaFinalizeStage> Stage;
+    std::atomic<float> StageProgress;
+    std::atomic<bool> bComplete;
+
+    /** Game thread only. */
+    EPanoramaFinalizeStage ReportedStage;
+    float ReportedProgress;
+};
+
 UPanoramaCaptureComponent::UPanoramaCaptureComponent(const FObjectInitializer& ObjectInitializer)
     : Super(ObjectInitializer)
     , CaptureMode(EPanoramaCaptureMode::Mono)
     , CaptureFrameRate(30.f)
+    , CaptureTiming(EPanoramaCaptureTiming::RealTime)
     , bRecordOnBeginPlay(false)
     , bEnablePreview(true)
     , PreviewScale(0.25f)
+    , PreviewFrameRate(0.f)
     , RingBufferSize(4)
     , bUseLinearGammaForNVENC(false)
     , bUse16BitPng(true)
+    , bUseAsyncReadback(true)
+    , ReadbackPoolDepth(3)
+    , PipelineDepth(2)
+    , EquirectMapping(EPanoramaEquirectMapping::Analytic)
+    , ResampleFilter(EPanoramaResampleFilter::Bilinear)
+    , SupersampleCount(8)
+    , StereoRendering(EPanoramaStereoRendering::Serial)
+    , bLiveContainerWriting(true)
     , CaptureStatus(EPanoramaCaptureStatus::Idle)
-    , TimeSinceLastCapture(0.f)
+    , CaptureTimeAccumulator(0.0)
+    , bLockedTimestepActive(false)
+    , bPreviousUseFixedTimeStep(false)
+    , PreviousFixedDeltaTime(0.0)
     , RecordingStartTime(0.0)
+    , ActiveFaceSize(0)
+    , ActivePipelineDepth(1)
+    , PipelineSlot(0)
+    , bOdsNeedsCentre(false)
+    , ActiveSphereResolution(FIntPoint::ZeroValue)
+    , ActiveRegion(FIntPoint::ZeroValue, FIntPoint::ZeroValue)
+    , FaceBudgetGpuMs(0.0)
+    , FaceBudgetFrames(0)
+    , FaceBudgetElapsed(0.f)
+    , bEquirectLutBuilt(false)
+    , EquirectLutOffset(FIntPoint::ZeroValue)
     , FrameRingBuffer(nullptr)
+    , PackFormat(EPanoPackFormat::RGBA8)
+    , CaptureCostElapsed(0.f)
+    , CaptureCostWindowStart(0.0)
+    , CaptureCostWindowFrames(0)
+    , LastPreviewSeconds(0.0)
     , FrameIndex(0)
     , DroppedFrameCount(0)
 {
@@ -374,7 +838,7 @@ UPanoramaCaptureComponent::UPanoramaCaptureComponent(const FObjectInitializer& O
 void UPanoramaCaptureComponent::OnRegister()
 {
     Super::OnRegister();
-    InitializeCaptureFaces();
+    InitializeCubeCapture();
 }
 
 void UPanoramaCaptureComponent::BeginPlay()
@@ -390,6 +854,9 @@ void UPanoramaCaptureComponent::BeginPlay()
 void UPanoramaCaptureComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
     StopRecording();
+    // The files are finished either way; nobody is left to notify.
+    FinalizeJobs.Reset();
+    ReleaseEquirectLut();
 
     Super::EndPlay(EndPlayReason);
 }
@@ -398,155 +865,504 @@ void UPanoramaCaptureComponent::TickComponent(float DeltaTime, enum ELevelTick T
 {
     Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
 
-    if (CaptureStatus != EPanoramaCaptureStatus::Recording)
+    PollFinalizeJobs();
+
+    if (!IsCapturing())
     {
         return;
     }
 
-    TimeSinceLastCapture += DeltaTime;
-    const float FrameInterval = 1.f / FMath::Max(CaptureFrameRate, 0.001f);
-    if (TimeSinceLastCapture < FrameInterval)
+    if (ReadbackPool)
     {
-        return;
+        ReadbackPool->Poll();
+    }
+
+    UpdateFaceBudget(DeltaTime);
+    UpdateCaptureCost(DeltaTime);
+
+    if (!bLockedTimestepActive)
+    {
+        // The remainder is carried so the average rate is exactly CaptureFrameRate. A tick longer than two intervals
+        // cannot render the missed frames from one world state, so only its phase is kept.
+        CaptureTimeAccumulator += DeltaTime;
+        const double FrameInterval = 1.0 / FMath::Max(CaptureFrameRate, 0.001f);
+        if (CaptureTimeAccumulator < FrameInterval)
+        {
+            return;
+        }
+        CaptureTimeAccumulator = FMath::Fmod(CaptureTimeAccumulator - FrameInterval, FrameInterval);
     }
 
-    TimeSinceLastCapture = 0.f;
     EnqueueFrameCapture(DeltaTime);
-    ProcessPendingFrames();
 }
 
-void UPanoramaCaptureComponent::InitializeCaptureFaces()
+void UPanoramaCaptureComponent::InitializeCubeCapture()
 {
-    if (FaceCaptures.Num() == kCubemapFaceCount)
+    if (CubeCapture)
     {
         return;
     }
 
-    FaceCaptures.Reset();
-    FaceRenderTargets.Reset();
+    // Left at the default world alignment; the equirect pass applies the rig's rotation when sampling.
+    CubeCapture = NewObject<USceneCaptureComponentCube>(this, TEXT("PanoCaptureCube"));
+    CubeCapture->AttachToComponent(this, FAttachmentTransformRules::KeepRelativeTransform);
+    CubeCapture->RegisterComponent();
+    CubeCapture->bCaptureEveryFrame = false;
+    CubeCapture->bCaptureOnMovement = false;
 
-    const TArray<FRotator> Rotations = {
-        FRotator(0.f, 90.f, 0.f),
-        FRotator(0.f, -90.f, 0.f),
-        FRotator(-90.f, 0.f, 0.f),
-        FRotator(90.f, 0.f, 0.f),
-        FRotator(0.f, 0.f, 0.f),
-        FRotator(0.f, 180.f, 0.f)
-    };
+    AllocateRenderTargets();
+}
 
-    for (int32 FaceIndex = 0; FaceIndex < kCubemapFaceCount; ++FaceIndex)
+void UPanoramaCaptureComponent::InitializeFaceCaptures()
+{
+    if (FaceCaptures.Num() == PanoramaCaptureRegion::FaceCount || !CubeCapture)
     {
-        const FString Name = FString::Printf(TEXT("PanoCaptureFace_%d"), FaceIndex);
-        USceneCaptureComponent2D* Capture = NewObject<USceneCaptureComponent2D>(this, *Name);
-        Capture->AttachToComponent(this, FAttachmentTransformRules::KeepRelativeTransform);
-        Capture->RegisterComponent();
-        Capture->FOVAngle = 90.f;
-        Capture->bCaptureEveryFrame = false;
-        Capture->bCaptureOnMovement = false;
-        Capture->CaptureSource = ESceneCaptureSource::SCS_SceneColorHDR;
-        Capture->SetRelativeRotation(Rotations[FaceIndex]);
-        FaceCaptures.Add(Capture);
+        return;
     }
 
-    AllocateRenderTargets();
+    // Attached to the cube capture so the stereo eye offset moves them too; the rotation stays world-aligned like the
+    // cube's, so each renders exactly the face the cube capture would.
+    for (int32 Face = 0; Face < PanoramaCaptureRegion::FaceCount; ++Face)
+    {
+        USceneCaptureComponent2D* FaceCapture = NewObject<USceneCaptureComponent2D>(this, *FString::Printf(TEXT("PanoCaptureFace%d"), Face));
+        FaceCapture->AttachToComponent(CubeCapture, FAttachmentTransformRules::KeepRelativeTransform);
+        FaceCapture->SetUsingAbsoluteRotation(true);
+        FaceCapture->SetWorldRotation(PanoramaCaptureRegion::GetFaceRotation(Face));
+        FaceCapture->RegisterComponent();
+        FaceCapture->FOVAngle = 90.f;
+        FaceCapture->CaptureSource = ESceneCaptureSource::SCS_SceneColorHDR;
+        FaceCapture->bCaptureEveryFrame = false;
+        FaceCapture->bCaptureOnMovement = false;
+        FaceCaptures.Add(FaceCapture);
+    }
 }
 
 void UPanoramaCaptureComponent::AllocateRenderTargets()
 {
     DestroyRenderTargets();
 
-    const FIntPoint FaceResolution(OutputSettings.bUse8k ? 4096 : 2048, OutputSettings.bUse8k ? 4096 : 2048);
-    const FIntPoint BaseEquirectResolution = GetTargetResolution(OutputSettings);
+    const FPanoRegionBounds Bounds = PanoramaCaptureRegion::Resolve(OutputSettings.Region, GetTargetResolution(OutputSettings));
+    ActiveSphereResolution = Bounds.SphereResolution;
+    ActiveRegion = Bounds.Rect;
+
+    const FIntPoint BaseEquirectResolution = Bounds.GetSize();
     const int32 EyeCount = CaptureMode == EPanoramaCaptureMode::Stereo ? 2 : 1;
     const FIntPoint EquirectResolution(BaseEquirectResolution.X, BaseEquirectResolution.Y * EyeCount);
+    // The table is per eye and rebuilt lazily on the first frame at a new resolution or region.
+    if (EquirectLut && (EquirectLut->GetResolution() != BaseEquirectResolution || EquirectLutOffset != ActiveRegion.Min))
+    {
+        ReleaseEquirectLut();
+    }
     const ETextureRenderTargetFormat TargetFormat = (OutputSettings.OutputMode == EPanoramaCaptureOutputMode::PNGSequence && bUse16BitPng)
         ? ETextureRenderTargetFormat::RTF_RGBA16f
         : ETextureRenderTargetFormat::RTF_RGBA8;
 
-    for (int32 FaceIndex = 0; FaceIndex < FaceCaptures.Num(); ++FaceIndex)
+    ActivePipelineDepth = FMath::Clamp(PipelineDepth, 1, 3);
+    PipelineSlot = 0;
+    AllocateCubeTarget(GetFaceSize(OutputSettings));
+
+    for (int32 Slot = 0; Slot < ActivePipelineDepth; ++Slot)
     {
-        UTextureRenderTarget2D* RenderTarget = NewObject<UTextureRenderTarget2D>(this);
-        RenderTarget->RenderTargetFormat = TargetFormat;
-        RenderTarget->InitAutoFormat(FaceResolution.X, FaceResolution.Y);
-        RenderTarget->bAutoGenerateMips = false;
-        RenderTarget->ClearColor = FLinearColor::Black;
-        RenderTarget->UpdateResourceImmediate(true);
-        FaceRenderTargets.Add(RenderTarget);
-        FaceCaptures[FaceIndex]->TextureTarget = RenderTarget;
+        UTextureRenderTarget2D* EquirectTarget = NewObject<UTextureRenderTarget2D>(this);
+        EquirectTarget->RenderTargetFormat = TargetFormat;
+        EquirectTarget->InitAutoFormat(EquirectResolution.X, EquirectResolution.Y);
+        EquirectTarget->bAutoGenerateMips = false;
+        EquirectTarget->ClearColor = FLinearColor::Black;
+        EquirectTarget->UpdateResourceImmediate(true);
+        EquirectTargets.Add(EquirectTarget);
+        EquirectTextureCaches.Add(MakeShared<FPanoEquirectTextureCache, ESPMode::ThreadSafe>());
+    }
+    EquirectRenderTarget = EquirectTargets[0];
+    EquirectTextureCache = EquirectTextureCaches[0];
+    if (ActivePipelineDepth > 1)
+    {
+        const int64 BytesPerPixel = TargetFormat == ETextureRenderTargetFormat::RTF_RGBA16f ? 8 : 4;
+        const int64 CubesPerSlot = RightEyeCubeTargets.Num() > 0 ? 2 : 1;
+        const int64 SlotBytes = BytesPerPixel * (CubesPerSlot * 6ll * ActiveFaceSize * ActiveFaceSize + static_cast<int64>(EquirectResolution.X) * EquirectResolution.Y);
+        UE_LOG(LogTemp, Display, TEXT("PanoramaCapture: pipeline depth %d; each extra frame in flight holds %.0f MB of cube and equirect targets."),
+            ActivePipelineDepth, SlotBytes / (1024.0 * 1024.0));
     }
-
-    EquirectRenderTarget = NewObject<UTextureRenderTarget2D>(this);
-    EquirectRenderTarget->RenderTargetFormat = TargetFormat;
-    EquirectRenderTarget->InitAutoFormat(EquirectResolution.X, EquirectResolution.Y);
-    EquirectRenderTarget->bAutoGenerateMips = false;
-    EquirectRenderTarget->ClearColor = FLinearColor::Black;
-    EquirectRenderTarget->UpdateResourceImmediate(true);
 
     if (bEnablePreview && OutputSettings.bWritePreviewTexture)
     {
-        const FIntPoint PreviewRes(EquirectResolution.X, EquirectResolution.Y);
+        const float Scale = FMath::Clamp(PreviewScale, 0.05f, 1.f);
+        const FIntPoint PreviewRes(FMath::Max(1, FMath::RoundToInt(EquirectResolution.X * Scale)), FMath::Max(1, FMath::RoundToInt(EquirectResolution.Y * Scale)));
         PreviewRenderTarget = NewObject<UTextureRenderTarget2D>(this);
         PreviewRenderTarget->RenderTargetFormat = ETextureRenderTargetFormat::RTF_RGBA8;
+        // Written by the downsample pass as stored in the equirect, like the raw copy it replaces.
+        PreviewRenderTarget->bCanCreateUAV = true;
+        PreviewRenderTarget->bForceLinearGamma = true;
         PreviewRenderTarget->InitAutoFormat(PreviewRes.X, PreviewRes.Y);
         PreviewRenderTarget->UpdateResourceImmediate(true);
+        LastPreviewSeconds = 0.0;
     }
 }
 
-void UPanoramaCaptureComponent::DestroyRenderTargets()
+void UPanoramaCaptureComponent::AllocateCubeTarget(int32 FaceSize)
 {
-    for (UTextureRenderTarget2D* Target : FaceRenderTargets)
+    for (UTextureRenderTargetCube* CubeTarget : CubeTargets)
     {
-        if (Target)
-        {
-            Target->ReleaseResource();
-        }
+        CubeTarget->ReleaseResource();
     }
-    FaceRenderTargets.Reset();
-
-    if (EquirectRenderTarget)
+    CubeTargets.Reset();
+    for (UTextureRenderTargetCube* CubeTarget : RightEyeCubeTargets)
     {
-        EquirectRenderTarget->ReleaseResource();
-        EquirectRenderTarget = nullptr;
+        CubeTarget->ReleaseResource();
     }
+    RightEyeCubeTargets.Reset();
+    CubeRenderTarget = nullptr;
 
-    if (PreviewRenderTarget)
+    if (UsesBatchedStereo())
     {
-        PreviewRenderTarget->ReleaseResource();
-        PreviewRenderTarget = nullptr;
+        const int32 MaxBatchedSize = PanoramaBatchedCapture::GetMaxFaceSize(2) / kFaceSizeAlignment * kFaceSizeAlignment;
+        FaceSize = FMath::Min(FaceSize, MaxBatchedSize);
     }
-}
-
-void UPanoramaCaptureComponent::StartRecording()
-{
-    if (CaptureStatus == EPanoramaCaptureStatus::Recording)
+    ActiveFaceSize = FaceSize;
+    if (!CubeCapture)
     {
         return;
     }
 
-    if (!ResolveOutputDirectory(ActiveOutputDirectory))
+    const bool bHalfFloat = OutputSettings.OutputMode == EPanoramaCaptureOutputMode::PNGSequence && bUse16BitPng;
+    auto MakeCubeTargets = [this, FaceSize, bHalfFloat](TArray<TObjectPtr<UTextureRenderTargetCube>>& OutTargets)
     {
-        UE_LOG(LogTemp, Warning, TEXT("Failed to resolve output directory."));
-        return;
-    }
-
-    ActiveSessionName = ResolveSessionLabel(RecordingLabel);
+        for (int32 Slot = 0; Slot < ActivePipelineDepth; ++Slot)
+        {
+            UTextureRenderTargetCube* CubeTarget = NewObject<UTextureRenderTargetCube>(this);
+            CubeTarget->Init(FaceSize, bHalfFloat ? PF_FloatRGBA : PF_B8G8R8A8);
+            CubeTarget->ClearColor = FLinearColor::Black;
+            CubeTarget->UpdateResourceImmediate(true);
+            OutTargets.Add(CubeTarget);
+        }
+    };
+    MakeCubeTargets(CubeTargets);
+    CubeRenderTarget = CubeTargets[PipelineSlot];
+
+    ReleaseFaceTargets();
+    if (UsesOds())
+    {
+        AllocateOdsTargets(FaceSize, bHalfFloat);
+        // The cube only holds the centred capture the pole merge fades into.
+        CubeCapture->TextureTarget = bOdsNeedsCentre ? CubeRenderTarget : nullptr;
+        return;
+    }
+    if (UsesBatchedStereo())
+    {
+        // Both eyes render into one atlas in a single scene-renderer pass; the cube only receives copies.
+        CubeCapture->TextureTarget = nullptr;
+        const FIntPoint AtlasSize = PanoramaBatchedCapture::GetAtlasSize(2, FaceSize);
+        StereoAtlasTarget = NewObject<UTextureRenderTarget2D>(this);
+        StereoAtlasTarget->InitCustomFormat(AtlasSize.X, AtlasSize.Y, bHalfFloat ? PF_FloatRGBA : PF_B8G8R8A8, false);
+        StereoAtlasTarget->ClearColor = FLinearColor::Black;
+        StereoAtlasTarget->UpdateResourceImmediate(true);
+        return;
+    }
+    if (GetRegionBounds().IsFullSphere())
+    {
+        CubeCapture->TextureTarget = CubeRenderTarget;
+        if (UsesSerialStereo())
+        {
+            // Each eye renders into its own cube, so neither waits for the other's conversion.
+            MakeCubeTargets(RightEyeCubeTargets);
+        }
+        return;
+    }
+
+    // Partial region: the faces render separately and the cube only receives copies, so the formats must match. The
+    // copies run inside the frame graph, so the eyes can share the cube but not the faces.
+    CubeCapture->TextureTarget = nullptr;
+    InitializeFaceCaptures();
+    const int32 FaceTargetCount = FaceCaptures.Num() * (UsesSerialStereo() ? 2 : 1);
+    for (int32 Index = 0; Index < FaceTargetCount; ++Index)
+    {
+        UTextureRenderTarget2D* FaceTarget = NewObject<UTextureRenderTarget2D>(this);
+        FaceTarget->InitCustomFormat(FaceSize, FaceSize, bHalfFloat ? PF_FloatRGBA : PF_B8G8R8A8, false);
+        FaceTarget->ClearColor = FLinearColor::Black;
+        FaceTarget->UpdateResourceImmediate(true);
+        FaceRenderTargets.Add(FaceTarget);
+    }
+    for (int32 Face = 0; Face < FaceCaptures.Num(); ++Face)
+    {
+        FaceCaptures[Face]->TextureTarget = FaceRenderTargets[Face];
+    }
+}
+
+void UPanoramaCaptureComponent::AllocateOdsTargets(int32 FaceSize, bool bHalfFloat)
+{
+    // A cube face has FaceSize / 2 texels per radian at its centre; the slice views match it, so the face size
+    // settings and the GPU budget drive ODS density too.
+    OdsLayout = MakeUnique<FPanoOdsLayout>(PanoramaOds::MakeLayout(OdsSettings, FaceSize * 0.5f, kEyeSeparationCm * 0.5f, static_cast<int32>(GMaxTextureDimensions)));
+    bOdsNeedsCentre = PanoramaOds::GetVisibleViews(*OdsLayout, GetRegionBounds(), OdsVisibleSlices, OdsVisiblePitches);
+
+    const FIntPoint AtlasSize = OdsLayout->GetAtlasSize();
+    OdsAtlasTarget = NewObject<UTextureRenderTarget2D>(this);
+    OdsAtlasTarget->InitCustomFormat(AtlasSize.X, AtlasSize.Y, bHalfFloat ? PF_FloatRGBA : PF_B8G8R8A8, false);
+    OdsAtlasTarget->ClearColor = FLinearColor::Black;
+    OdsAtlasTarget->UpdateResourceImmediate(true);
+
+    UE_LOG(LogTemp, Display, TEXT("PanoramaCapture: ODS %d slices x %d pitch steps of %dx%d px per eye (%d views per frame), %dx%d atlas."),
+        OdsLayout->SliceCount, OdsLayout->PitchSteps, OdsLayout->TileSize.X, OdsLayout->TileSize.Y,
+        2 * OdsVisibleSlices.CountSetBits() * OdsVisiblePitches.CountSetBits(), AtlasSize.X, AtlasSize.Y);
+}
+
+void UPanoramaCaptureComponent::ReleaseFaceTargets()
+{
+    for (USceneCaptureComponent2D* FaceCapture : FaceCaptures)
+    {
+        FaceCapture->TextureTarget = nullptr;
+    }
+    for (UTextureRenderTarget2D* FaceTarget : FaceRenderTargets)
+    {
+        FaceTarget->ReleaseResource();
+    }
+    FaceRenderTargets.Reset();
+
+    if (StereoAtlasTarget)
+    {
+        StereoAtlasTarget->ReleaseResource();
+        StereoAtlasTarget = nullptr;
+    }
+
+    if (OdsAtlasTarget)
+    {
+        OdsAtlasTarget->ReleaseResource();
+        OdsAtlasTarget = nullptr;
+    }
+    OdsLayout.Reset();
+    bOdsNeedsCentre = false;
+}
+
+FPanoRegionBounds UPanoramaCaptureComponent::GetRegionBounds() const
+{
+    FPanoRegionBounds Bounds;
+    Bounds.SphereResolution = ActiveSphereResolution;
+    Bounds.Rect = ActiveRegion;
+    return Bounds;
+}
+
+void UPanoramaCaptureComponent::UpdateFaceBudget(float DeltaTime)
+{
+    if (OutputSettings.CaptureGpuBudgetMs <= 0.f || !CubeRenderTarget)
+    {
+        return;
+    }
+
+    FaceBudgetGpuMs += FPlatformTime::ToMilliseconds(RHIGetGPUFrameCycles());
+    ++FaceBudgetFrames;
+    FaceBudgetElapsed += DeltaTime;
+    if (FaceBudgetElapsed < kFaceBudgetWindowSeconds)
+    {
+        return;
+    }
+
+    const double AverageMs = FaceBudgetGpuMs / FMath::Max(FaceBudgetFrames, 1);
+    FaceBudgetGpuMs = 0.0;
+    FaceBudgetFrames = 0;
+    FaceBudgetElapsed = 0.f;
+    if (AverageMs <= OutputSettings.CaptureGpuBudgetMs || ActiveFaceSize <= kMinFaceSize)
+    {
+        return;
+    }
+
+    // Only ever shrinks within a take, so the size cannot oscillate; StartRecording begins from the full size again.
+    const int32 FaceSize = AlignFaceSize(ActiveFaceSize * kFaceBudgetStep, ActiveFaceSize);
+    UE_LOG(LogTemp, Warning, TEXT("PanoramaCapture: GPU frame %.1f ms is over the %.1f ms budget; cube faces %d -> %d px."),
+        AverageMs, OutputSettings.CaptureGpuBudgetMs, ActiveFaceSize, FaceSize);
+    AllocateCubeTarget(FaceSize);
+    LogFaceDensity(FaceSize, ActiveSphereResolution.X);
+}
+
+void UPanoramaCaptureComponent::UpdateCaptureCost(float DeltaTime)
+{
+    CaptureCostElapsed += DeltaTime;
+    if (!CaptureCostTimer || CaptureCostElapsed < kCaptureCostWindowSeconds)
+    {
+        return;
+    }
+    CaptureCostElapsed = 0.f;
+
+    const double Now = FPlatformTime::Seconds();
+    FPanoCaptureRenderCost Cost = CaptureCostTimer->Consume();
+    Cost.ThroughputFps = Now > CaptureCostWindowStart ? static_cast<float>(CaptureCostWindowFrames / (Now - CaptureCostWindowStart)) : 0.f;
+    CaptureCostWindowStart = Now;
+    CaptureCostWindowFrames = 0;
+    if (Cost.SampledFrames == 0)
+    {
+        return;
+    }
+    LastCaptureRenderCost = Cost;
+
+    const TCHAR* CapturePath = OdsAtlasTarget ? TEXT("ODS stereo") : StereoAtlasTarget ? TEXT("batched stereo") : (CaptureMode == EPanoramaCaptureMode::Stereo ? TEXT("serial stereo") : TEXT("mono"));
+    UE_LOG(LogTemp, Display, TEXT("PanoramaCapture: %s capture cost %.2f ms render thread, %.2f ms GPU per frame (%d frames); %.1f fps at pipeline depth %d."),
+        CapturePath, Cost.RenderThreadMs, Cost.GpuMs, Cost.SampledFrames, Cost.ThroughputFps, ActivePipelineDepth);
+    UE_LOG(LogTemp, Display, TEXT("PanoramaCapture:   scene %.2f / %.2f ms, convert %.2f / %.2f ms, output %.2f / %.2f ms (render thread / GPU)."),
+        Cost.SceneRenderThreadMs, Cost.SceneGpuMs, Cost.ConvertRenderThreadMs, Cost.ConvertGpuMs, Cost.OutputRenderThreadMs, Cost.OutputGpuMs);
+}
+
+void UPanoramaCaptureComponent::AdvancePipelineSlot()
+{
+    if (ActivePipelineDepth <= 1 || CubeTargets.Num() != ActivePipelineDepth || EquirectTargets.Num() != ActivePipelineDepth)
+    {
+        return;
+    }
+
+    PipelineSlot = (PipelineSlot + 1) % ActivePipelineDepth;
+    // A cube capture left unbound (faces or an atlas feed the cube) stays unbound.
+    if (CubeCapture && CubeCapture->TextureTarget)
+    {
+        CubeCapture->TextureTarget = CubeTargets[PipelineSlot];
+    }
+    CubeRenderTarget = CubeTargets[PipelineSlot];
+    EquirectRenderTarget = EquirectTargets[PipelineSlot];
+    EquirectTextureCache = EquirectTextureCaches[PipelineSlot];
+}
+
+void UPanoramaCaptureComponent::DestroyRenderTargets()
+{
+    // Render commands already queued keep their own reference to the cache.
+    EquirectTextureCache.Reset();
+    EquirectTextureCaches.Reset();
+
+    if (CubeCapture)
+    {
+        CubeCapture->TextureTarget = nullptr;
+    }
+    for (UTextureRenderTargetCube* CubeTarget : CubeTargets)
+    {
+        CubeTarget->ReleaseResource();
+    }
+    CubeTargets.Reset();
+    for (UTextureRenderTargetCube* CubeTarget : RightEyeCubeTargets)
+    {
+        CubeTarget->ReleaseResource();
+    }
+    RightEyeCubeTargets.Reset();
+    CubeRenderTarget = nullptr;
+    ReleaseFaceTargets();
+
+    for (UTextureRenderTarget2D* EquirectTarget : EquirectTargets)
+    {
+        EquirectTarget->ReleaseResource();
+    }
+    EquirectTargets.Reset();
+    EquirectRenderTarget = nullptr;
+
+    if (PreviewRenderTarget)
+    {
+        PreviewRenderTarget->ReleaseResource();
+        PreviewRenderTarget = nullptr;
+    }
+}
+
+void UPanoramaCaptureComponent::ReleaseEquirectLut()
+{
+    if (EquirectLut)
+    {
+        // Released behind any equirect passes still queued against it.
+        BeginReleaseResource(EquirectLut.Get());
+        ENQUEUE_RENDER_COMMAND(PanoramaCapture_DeleteEquirectLut)(
+            [Lut = EquirectLut.Release()](FRHICommandListImmediate& RHICmdList)
+            {
+                delete Lut;
+            });
+    }
+    bEquirectLutBuilt = false;
+}
+
+void UPanoramaCaptureComponent::StartRecording()
+{
+    if (IsCapturing())
+    {
+        return;
+    }
 
-    InitializeCaptureFaces();
+    if (!ResolveOutputDirectory(ActiveOutputDirectory))
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Failed to resolve output directory."));
+        return;
+    }
+
+    ActiveSessionName = ResolveSessionLabel(RecordingLabel);
+
+    InitializeCubeCapture();
+    // The previous take released its targets on stop, and the output settings may have changed since.
+    AllocateRenderTargets();
+    LogFaceDensity(ActiveFaceSize, ActiveSphereResolution.X);
+    const FPanoRegionBounds RegionBounds = GetRegionBounds();
+    if (!RegionBounds.IsFullSphere())
+    {
+        UE_LOG(LogTemp, Display, TEXT("PanoramaCapture: region %dx%d at (%d, %d) of the %dx%d sphere."),
+            ActiveRegion.Width(), ActiveRegion.Height(), ActiveRegion.Min.X, ActiveRegion.Min.Y, ActiveSphereResolution.X, ActiveSphereResolution.Y);
+    }
+    FaceBudgetGpuMs = 0.0;
+    FaceBudgetFrames = 0;
+    FaceBudgetElapsed = 0.f;
+    CaptureCostTimer = MakeUnique<FPanoCaptureCostTimer>();
+    FrameGraph = MakeUnique<FPanoFrameGraph>();
+    CaptureCostElapsed = 0.f;
+    CaptureCostWindowStart = FPlatformTime::Seconds();
+    CaptureCostWindowFrames = 0;
+    LastCaptureRenderCost = FPanoCaptureRenderCost();
+
+    // Created up front so the live muxer can align against it; the epoch is set once capture starts below.
+    CaptureClock = MakeUnique<FPanoCaptureClock>(kAudioSampleRate);
+
+    USoundSubmixBase* TargetSubmix = OverrideAudioSubmix;
+    if (!TargetSubmix)
+    {
+        TargetSubmix = GetDefault<UPanoramaCaptureSettings>()->TargetSubmix;
+    }
+    if (TargetSubmix && UsesLockedTimestep())
+    {
+        // The audio mixer renders in real time and cannot follow a world stepped at any other rate.
+        UE_LOG(LogTemp, Warning, TEXT("PanoramaCapture: locked timestep takes record no audio."));
+        TargetSubmix = nullptr;
+    }
 
     if (OutputSettings.OutputMode == EPanoramaCaptureOutputMode::PNGSequence)
     {
-        FrameRingBuffer = new FPanoFrameRingBuffer(FMath::Max(1, RingBufferSize));
+        // Slabs are sized once for the full equirect so the game thread never allocates per frame.
+        const FIntPoint BaseResolution = RegionBounds.GetSize();
+        const int32 EyeCount = CaptureMode == EPanoramaCaptureMode::Stereo ? 2 : 1;
+        const FIntPoint EquirectResolution(BaseResolution.X, BaseResolution.Y * EyeCount);
+        PackFormat = bUse16BitPng ? EPanoPackFormat::RGBA16 : EPanoPackFormat::RGBA8;
+        const int64 SlabBytes = PanoramaPixelPack::GetPackedBytes(PackFormat, EquirectResolution);
+        // In-flight readbacks hold reserved slots, so they get their own headroom on top of the encode queue.
+        const int32 ReadbackSlots = bUseAsyncReadback ? FMath::Clamp(ReadbackPoolDepth, 1, 8) : 0;
+        FrameRingBuffer = new FPanoFrameRingBuffer(FMath::Max(1, RingBufferSize) + ReadbackSlots, SlabBytes);
         PngWriter = MakeUnique<FPanoPngWriter>();
+        LastPngThroughput = FPanoEncodeThroughput();
+        LastPngEncodeLatency = FPanoLatencyStats();
 
         FPanoPngWriteParams PngParams;
         PngParams.OutputDirectory = ActiveOutputDirectory;
         PngParams.BaseFileName = ActiveSessionName;
         PngParams.bUse16Bit = bUse16BitPng;
         PngParams.bLinear = OutputSettings.bLinearColorSpace;
+        PngParams.NumWorkers = OutputSettings.PngEncoderThreads;
+        PngParams.ReservedCoreCount = OutputSettings.PngReservedCores;
+        PngParams.MaxBytesInFlight = static_cast<int64>(FMath::Max(64, OutputSettings.PngMaxInFlightMB)) * 1024 * 1024;
+        PngParams.EncodeOptions = FPanoPngEncodeOptions::FromPreset(OutputSettings.PngCompression);
 
         PngWriter->Configure(PngParams);
-        CaptureWorker = MakeUnique<FPanoCaptureWorker>(FrameRingBuffer, PngWriter.Get());
+        QueueLatencyHistogram = MakeUnique<FPanoLatencyHistogram>();
+        CaptureWorker = MakeUnique<FPanoCaptureWorker>(FrameRingBuffer, PngWriter.Get(), QueueLatencyHistogram.Get());
         CaptureWorker->Start();
+
+        ReadbackStallHistogram = MakeUnique<FPanoLatencyHistogram>();
+        if (bUseAsyncReadback)
+        {
+            for (int32 Slot = 0; Slot < ActivePipelineDepth; ++Slot)
+            {
+                TUniquePtr<FPanoPackTarget>& PackTarget = PackTargets.Add_GetRef(MakeUnique<FPanoPackTarget>(PackFormat, EquirectResolution));
+                BeginInitResource(PackTarget.Get());
+            }
+            ReadbackPool = MakeUnique<FPanoReadbackPool>(ReadbackSlots, FrameRingBuffer,
+                [Worker = CaptureWorker.Get()]()
+                {
+                    Worker->NotifyFrameAvailable();
+                });
+        }
         CaptureStatus = EPanoramaCaptureStatus::Recording;
     }
     else
@@ -556,7 +1372,7 @@ void UPanoramaCaptureComponent::StartRecording()
         CaptureWorker.Reset();
 #if PANORAMA_CAPTURE_WITH_NVENC
         NvencEncoder = MakeUnique<FPanoNvencEncoder>();
-        const FIntPoint BaseResolution = GetTargetResolution(OutputSettings);
+        const FIntPoint BaseResolution = RegionBounds.GetSize();
         const int32 EyeCount = CaptureMode == EPanoramaCaptureMode::Stereo ? 2 : 1;
 
         FPanoramaNvencEncodeParams EncodeParams;
@@ -565,12 +1381,43 @@ void UPanoramaCaptureComponent::StartRecording()
         EncodeParams.RateControl = OutputSettings.NvencRateControl;
         EncodeParams.bUseLinear = bUseLinearGammaForNVENC;
         EncodeParams.FrameRate = CaptureFrameRate;
-        const FString BitstreamExtension = OutputSettings.Codec == EPanoramaCaptureCodec::H264 ? TEXT("h264") : TEXT("hevc");
-        EncodeParams.OutputBitstreamPath = FPaths::Combine(ActiveOutputDirectory, FString::Printf(TEXT("%s.%s.annexb"), *ActiveSessionName, *BitstreamExtension));
+        if (bLiveContainerWriting)
+        {
+            // Containers are written fragment by fragment as the encoder produces GOPs; no raw bitstream is kept.
+            const UPanoramaCaptureSettings* Settings = GetDefault<UPanoramaCaptureSettings>();
+            const bool bOverwriteExisting = Settings ? Settings->bOverwriteExisting : false;
+            const bool bEmbedAudio = Settings ? Settings->bEmbedAudioInContainer : true;
+
+            FPanoLiveMuxParams MuxParams;
+            MuxParams.Codec = OutputSettings.Codec;
+            MuxParams.Resolution = EncodeParams.Resolution;
+            MuxParams.FrameRate = CaptureFrameRate;
+            MuxParams.bStereoTopBottom = CaptureMode == EPanoramaCaptureMode::Stereo;
+            MuxParams.Crop = RegionBounds.GetCrop();
+            MuxParams.AudioSampleRate = TargetSubmix && bEmbedAudio ? kAudioSampleRate : 0;
+            MuxParams.AudioChannels = TargetSubmix && bEmbedAudio ? 2 : 0;
+            MuxParams.CaptureClock = CaptureClock.Get();
+            MuxParams.Mp4Path = MakeUniqueOutputPath(FPaths::Combine(ActiveOutputDirectory, FString::Printf(TEXT("%s.mp4"), *ActiveSessionName)), bOverwriteExisting);
+            if (!Settings || Settings->bGenerateMKV)
+            {
+                MuxParams.MkvPath = MakeUniqueOutputPath(FPaths::Combine(ActiveOutputDirectory, FString::Printf(TEXT("%s.mkv"), *ActiveSessionName)), bOverwriteExisting);
+            }
+            LiveMuxer = MakeUnique<FPanoLiveMuxer>(MuxParams);
+            EncodeParams.OnBitstream = [Muxer = LiveMuxer.Get()](const uint8* Data, int64 NumBytes)
+            {
+                Muxer->AppendVideo(Data, NumBytes);
+            };
+        }
+        else
+        {
+            const FString BitstreamExtension = OutputSettings.Codec == EPanoramaCaptureCodec::H264 ? TEXT("h264") : TEXT("hevc");
+            EncodeParams.OutputBitstreamPath = FPaths::Combine(ActiveOutputDirectory, FString::Printf(TEXT("%s.%s.annexb"), *ActiveSessionName, *BitstreamExtension));
+        }
 
         if (!NvencEncoder->Initialize(EncodeParams))
         {
             NvencEncoder.Reset();
+            LiveMuxer.Reset();
             UE_LOG(LogTemp, Error, TEXT("Failed to initialize NVENC encoder."));
             return;
         }
@@ -581,21 +1428,30 @@ void UPanoramaCaptureComponent::StartRecording()
 #endif
     }
 
-    AudioRecorder = MakeUnique<FPanoAudioRecorder>();
-
-    USoundSubmixBase* TargetSubmix = OverrideAudioSubmix;
-    if (!TargetSubmix)
+    RecordingStartTime = FPlatformTime::Seconds();
+    CaptureClock->Start(RecordingStartTime);
+    if (UsesLockedTimestep())
     {
-        TargetSubmix = GetDefault<UPanoramaCaptureSettings>()->TargetSubmix;
+        BeginLockedTimestep();
     }
+    FramePresentationSeconds.Reset();
+
+    AudioRecorder = MakeUnique<FPanoAudioRecorder>();
 
     if (TargetSubmix)
     {
-        AudioRecorder->StartRecording(TargetSubmix, 48000, 2);
+        if (LiveMuxer)
+        {
+            AudioRecorder->SetPcmListener([Muxer = LiveMuxer.Get()](const int16* Samples, int32 NumSamples)
+            {
+                Muxer->AppendAudio(Samples, NumSamples);
+            });
+        }
+        const FString AudioPath = FPaths::Combine(ActiveOutputDirectory, FString::Printf(TEXT("%s.wav"), *ActiveSessionName));
+        AudioRecorder->StartRecording(TargetSubmix, kAudioSampleRate, 2, AudioPath, CaptureClock.Get());
     }
 
-    TimeSinceLastCapture = 0.f;
-    RecordingStartTime = FPlatformTime::Seconds();
+    CaptureTimeAccumulator = 0.0;
     FrameIndex = 0;
     DroppedFrameCount = 0;
 
@@ -604,108 +1460,288 @@ void UPanoramaCaptureComponent::StartRecording()
 
 void UPanoramaCaptureComponent::StopRecording()
 {
-    if (CaptureStatus != EPanoramaCaptureStatus::Recording)
+    if (!IsCapturing())
     {
         return;
     }
 
-    CaptureStatus = EPanoramaCaptureStatus::Finalizing;
+    EndLockedTimestep();
 
-    FlushRingBuffer();
-    FinalizeRecording();
-}
+    // Only what needs the game thread happens here: GPU readbacks, render resources and the audio device.
+    if (ReadbackPool)
+    {
+        // Lands every in-flight readback in the ring; bounded by the pool depth.
+        ReadbackPool->Drain();
+        ReadbackPool.Reset();
+    }
 
-void UPanoramaCaptureComponent::TogglePreview(bool bEnableIn)
-{
-    bEnablePreview = bEnableIn;
-    UpdatePreview();
-}
+    for (TUniquePtr<FPanoPackTarget>& PackTarget : PackTargets)
+    {
+        // Released behind the pack passes already queued rather than flushing the render thread.
+        BeginReleaseResource(PackTarget.Get());
+        ENQUEUE_RENDER_COMMAND(PanoramaCapture_DeletePackTarget)(
+            [Target = PackTarget.Release()](FRHICommandListImmediate& RHICmdList)
+            {
+                delete Target;
+            });
+    }
+    PackTargets.Reset();
 
-void UPanoramaCaptureComponent::ReleaseResources()
-{
-    if (CaptureWorker)
+    if (AudioRecorder)
     {
-        CaptureWorker->Stop();
-        CaptureWorker.Reset();
+        AudioRecorder->DetachFromSubmix();
     }
 
-    if (FrameRingBuffer)
+    if (ReadbackStallHistogram)
     {
-        delete FrameRingBuffer;
-        FrameRingBuffer = nullptr;
+        const FPanoLatencyStats Stats = ReadbackStallHistogram->Summarize();
+        UE_LOG(LogTemp, Log, TEXT("Panorama readback stall (%s): %d frames, mean %.3f ms, p50 %.3f ms, p95 %.3f ms, p99 %.3f ms, max %.3f ms"),
+            bUseAsyncReadback ? TEXT("async") : TEXT("sync"), Stats.SampleCount, Stats.MeanMs, Stats.P50Ms, Stats.P95Ms, Stats.P99Ms, Stats.MaxMs);
     }
 
-    if (PngWriter)
+    const UPanoramaCaptureSettings* Settings = GetDefault<UPanoramaCaptureSettings>();
+
+    FPanoFinalizeJob::FSession Session;
+    Session.SessionName = ActiveSessionName;
+    Session.OutputDirectory = ActiveOutputDirectory;
+    Session.CaptureMode = CaptureMode;
+    Session.OutputSettings = OutputSettings;
+    Session.CaptureFrameRate = CaptureFrameRate;
+    Session.bEmbedAudio = Settings ? Settings->bEmbedAudioInContainer : true;
+    Session.bOverwriteExisting = Settings ? Settings->bOverwriteExisting : false;
+    Session.bGenerateMkv = Settings ? Settings->bGenerateMKV : true;
+    Session.Crop = GetRegionBounds().GetCrop();
+    Session.CommittedFrames = static_cast<int64>(FrameIndex) - DroppedFrameCount;
+    Session.FramePresentationSeconds = MoveTemp(FramePresentationSeconds);
+    Session.StopSeconds = FPlatformTime::Seconds();
+    Session.CaptureClock = MoveTemp(CaptureClock);
+    Session.LiveMuxer = MoveTemp(LiveMuxer);
+    Session.NvencEncoder = MoveTemp(NvencEncoder);
+    Session.AudioRecorder = MoveTemp(AudioRecorder);
+    Session.FrameRingBuffer = FrameRingBuffer;
+    Session.PngWriter = MoveTemp(PngWriter);
+    Session.QueueLatencyHistogram = MoveTemp(QueueLatencyHistogram);
+    Session.CaptureWorker = MoveTemp(CaptureWorker);
+    FrameRingBuffer = nullptr;
+
+    TUniquePtr<FPanoFinalizeJob> Job = MakeUnique<FPanoFinalizeJob>(MoveTemp(Session));
+    Job->Launch();
+    FinalizeJobs.Add(MoveTemp(Job));
+
+    DestroyRenderTargets();
+    CaptureStatus = EPanoramaCaptureStatus::Idle;
+
+    UE_LOG(LogTemp, Log, TEXT("Panorama capture stopped: %s (%d session(s) finalizing)"), *ActiveSessionName, FinalizeJobs.Num());
+}
+
+void UPanoramaCaptureComponent::WaitForPendingFinalize()
+{
+    for (const TUniquePtr<FPanoFinalizeJob>& Job : FinalizeJobs)
     {
-        PngWriter->Flush();
-        PngWriter->Shutdown();
-        PngWriter.Reset();
+        Job->Wait();
     }
+    PollFinalizeJobs();
+}
 
-    if (AudioRecorder)
+void UPanoramaCaptureComponent::PollFinalizeJobs()
+{
+    struct FProgressReport
+    {
+        FString SessionName;
+        EPanoramaFinalizeStage Stage;
+        float Progress;
+    };
+    TArray<FProgressReport, TInlineAllocator<4>> ProgressReports;
+    TArray<FPanoFinalizeResult, TInlineAllocator<4>> CompletedResults;
+
+    for (int32 Index = 0; Index < FinalizeJobs.Num();)
     {
-        AudioRecorder->StopRecording();
-        AudioRecorder.Reset();
+        FPanoFinalizeJob& Job = *FinalizeJobs[Index];
+        const bool bComplete = Job.IsComplete();
+
+        FProgressReport Report;
+        if (Job.ShouldReportProgress(Report.Stage, Report.Progress))
+        {
+            Report.SessionName = Job.GetResult().SessionName;
+            ProgressReports.Add(MoveTemp(Report));
+        }
+
+        if (!bComplete)
+        {
+            ++Index;
+            continue;
+        }
+
+        const FPanoFinalizeJob::FSessionStats& Stats = Job.GetStats();
+        LastPngThroughput = Stats.PngThroughput;
+        LastPngEncodeLatency = Stats.PngEncodeLatency;
+        LastQueueLatency = Stats.QueueLatency;
+        LastAudioStats = Stats.AudioStats;
+        CompletedResults.Add(Job.GetResult());
+        FinalizeJobs.RemoveAt(Index);
     }
 
-#if PANORAMA_CAPTURE_WITH_NVENC
-    if (NvencEncoder)
+    // Broadcast after the sweep; listeners are free to start or stop a take.
+    for (const FProgressReport& Report : ProgressReports)
     {
-        NvencEncoder->Shutdown();
-        NvencEncoder.Reset();
+        OnFinalizeProgress.Broadcast(Report.SessionName, Report.Stage, Report.Progress);
     }
-#endif
+    for (const FPanoFinalizeResult& Result : CompletedResults)
+    {
+        OnFinalizeComplete.Broadcast(Result);
+    }
+}
 
-    DestroyRenderTargets();
+void UPanoramaCaptureComponent::TogglePreview(bool bEnableIn)
+{
+    bEnablePreview = bEnableIn;
+    // The next captured frame refreshes the preview regardless of PreviewFrameRate.
+    LastPreviewSeconds = 0.0;
 }
 
 void UPanoramaCaptureComponent::EnqueueFrameCapture(float DeltaTime)
 {
-    if (FaceCaptures.Num() != kCubemapFaceCount)
+    if (!CubeCapture)
     {
-        InitializeCaptureFaces();
+        InitializeCubeCapture();
     }
+    // This frame renders into targets no earlier frame still in flight reads from.
+    AdvancePipelineSlot();
+    ++CaptureCostWindowFrames;
+
     const int32 EyeCount = CaptureMode == EPanoramaCaptureMode::Stereo ? 2 : 1;
-    const float EyeOffsetCm = 6.4f;
-    const FVector EyeOffsets[2] = { FVector(-EyeOffsetCm * 0.5f, 0.f, 0.f), FVector(EyeOffsetCm * 0.5f, 0.f, 0.f) };
+    const FVector EyeOffsets[2] = { FVector(-kEyeSeparationCm * 0.5f, 0.f, 0.f), FVector(kEyeSeparationCm * 0.5f, 0.f, 0.f) };
 
-    for (int32 EyeIndex = 0; EyeIndex < EyeCount; ++EyeIndex)
+    // A partial region renders only the faces it can see with the rig's current orientation.
+    uint8 FaceMask = 0;
+    if (FaceRenderTargets.Num() > 0 || StereoAtlasTarget)
     {
-        if (EyeCount == 2)
+        FaceMask = PanoramaCaptureRegion::GetVisibleFaces(GetRegionBounds(), GetComponentQuat());
+    }
+
+    FPanoCaptureCostTimer* CostTimer = CaptureCostTimer.Get();
+    auto BeginStage = [CostTimer](EPanoCaptureStage Stage)
+    {
+        if (CostTimer)
+        {
+            CostTimer->BeginStage(Stage);
+        }
+    };
+    auto EndStage = [CostTimer]()
+    {
+        if (CostTimer)
+        {
+            CostTimer->EndStage();
+        }
+    };
+
+    if (CostTimer)
+    {
+        CostTimer->BeginFrame();
+    }
+
+    // Conversion, preview and pack are recorded into the frame graph; submitting it is the frame's Convert stage.
+    auto SubmitFrameGraph = [this, &BeginStage, &EndStage]()
+    {
+        if (FrameGraph && !FrameGraph->IsEmpty())
+        {
+            BeginStage(EPanoCaptureStage::Convert);
+            FrameGraph->Submit();
+            EndStage();
+        }
+    };
+
+    if (OdsAtlasTarget && EyeCount == 2)
+    {
+        // The centred capture is taken from the rig origin; the eyes only exist as slice view origins.
+        BeginStage(EPanoCaptureStage::SceneRender);
+        if (CubeCapture->TextureTarget)
         {
-            for (USceneCaptureComponent2D* Capture : FaceCaptures)
+            CubeCapture->CaptureScene();
+        }
+        RenderOdsSlices();
+        EndStage();
+        DispatchOdsStitch(0);
+        DispatchOdsStitch(1);
+    }
+    else if (StereoAtlasTarget && EyeCount == 2)
+    {
+        // Both eyes in one scene render; each dispatch copies its eye's tiles into the cube first.
+        const FVector EyeLocations[2] = { GetComponentTransform().TransformPosition(EyeOffsets[0]), GetComponentTransform().TransformPosition(EyeOffsets[1]) };
+        BeginStage(EPanoCaptureStage::SceneRender);
+        PanoramaBatchedCapture::Render(GetWorld(), CubeCapture->ShowFlags, EyeLocations, FaceMask, StereoAtlasTarget, ActiveFaceSize);
+        EndStage();
+        DispatchCubemapToEquirect(0, EyeCount, FaceMask);
+        DispatchCubemapToEquirect(1, EyeCount, FaceMask);
+    }
+    else if (!StereoAtlasTarget && !OdsAtlasTarget)
+    {
+        // Each eye renders into its own cube or face targets, so both scene renders go first and a single graph then
+        // converts both eyes along with the preview and pack.
+        BeginStage(EPanoCaptureStage::SceneRender);
+        for (int32 EyeIndex = 0; EyeIndex < EyeCount; ++EyeIndex)
+        {
+            if (EyeCount == 2)
+            {
+                CubeCapture->SetRelativeLocation(EyeOffsets[EyeIndex]);
+            }
+            if (CubeCapture->TextureTarget)
             {
-                if (Capture)
+                CubeCapture->TextureTarget = GetEyeCubeTarget(EyeIndex);
+                CubeCapture->CaptureScene();
+            }
+            for (int32 Face = 0; Face < FaceCaptures.Num(); ++Face)
+            {
+                if (FaceMask & (1 << Face))
                 {
-                    Capture->SetRelativeLocation(EyeOffsets[EyeIndex]);
+                    FaceCaptures[Face]->TextureTarget = FaceRenderTargets[EyeIndex * FaceCaptures.Num() + Face];
+                    FaceCaptures[Face]->CaptureScene();
                 }
             }
         }
+        EndStage();
 
-        for (USceneCaptureComponent2D* Capture : FaceCaptures)
+        if (EyeCount == 2)
         {
-            if (Capture && Capture->TextureTarget)
+            CubeCapture->SetRelativeLocation(FVector::ZeroVector);
+            if (CubeCapture->TextureTarget)
             {
-                Capture->CaptureScene();
+                CubeCapture->TextureTarget = CubeRenderTarget;
             }
         }
-
-        DispatchCubemapToEquirect(EyeIndex, EyeCount);
+        for (int32 EyeIndex = 0; EyeIndex < EyeCount; ++EyeIndex)
+        {
+            DispatchCubemapToEquirect(EyeIndex, EyeCount, FaceMask);
+        }
     }
 
-    if (EyeCount == 2)
+    UpdatePreview();
+
+    // Every path below submits the graph and ends the frame, including the ones that drop it.
+    ON_SCOPE_EXIT
     {
-        for (USceneCaptureComponent2D* Capture : FaceCaptures)
+        SubmitFrameGraph();
+        if (CostTimer)
         {
-            if (Capture)
-            {
-                Capture->SetRelativeLocation(FVector::ZeroVector);
-            }
+            CostTimer->EndFrame();
         }
-    }
-    UpdatePreview();
+    };
 
-    const double Timecode = FPlatformTime::Seconds() - RecordingStartTime;
+    // A locked take is stamped in world steps; otherwise locked to the recorded audio sample count once the submix is delivering.
+    double Timecode = 0.0;
+    if (bLockedTimestepActive)
+    {
+        Timecode = FrameIndex / static_cast<double>(FMath::Max(CaptureFrameRate, 0.001f));
+    }
+    else
+    {
+        Timecode = CaptureClock ? CaptureClock->GetSessionSeconds(FPlatformTime::Seconds()) : FPlatformTime::Seconds() - RecordingStartTime;
+    }
+    FramePresentationSeconds.Add(Timecode);
+    if (LiveMuxer && FramePresentationSeconds.Num() == 1)
+    {
+        LiveMuxer->SetVideoStartSeconds(Timecode);
+    }
 
     if (OutputSettings.OutputMode == EPanoramaCaptureOutputMode::PNGSequence)
     {
@@ -715,37 +1751,113 @@ void UPanoramaCaptureComponent::EnqueueFrameCapture(float DeltaTime)
             return;
         }
 
+        const double StallStartSeconds = FPlatformTime::Seconds();
+
+        // Skip the readback entirely when the ring is full; the frame would be dropped anyway.
+        FPanoCaptureFrame* Frame = AcquireFrameSlot();
+        if (!Frame)
+        {
+            HandleDroppedFrame();
+            ++FrameIndex;
+            return;
+        }
+
         const FIntPoint Resolution = FIntPoint(EquirectRenderTarget->SizeX, EquirectRenderTarget->SizeY);
+        const int64 PixelCount = static_cast<int64>(Resolution.X) * Resolution.Y;
+        const int64 RequiredBytes = PanoramaPixelPack::GetPackedBytes(PackFormat, Resolution);
+        if (RequiredBytes > Frame->PixelData.Num())
+        {
+            UE_LOG(LogTemp, Error, TEXT("Panorama frame (%lld bytes) exceeds ring slab size (%lld bytes)."), RequiredBytes, Frame->PixelData.Num());
+            FrameRingBuffer->CancelWriteSlot(Frame);
+            HandleDroppedFrame();
+            ++FrameIndex;
+            return;
+        }
 
-        FPanoCaptureFrame Frame;
-        Frame.FrameIndex = FrameIndex;
-        Frame.Timecode = Timecode;
-        Frame.Resolution = Resolution;
-        Frame.b16Bit = bUse16BitPng;
-        Frame.bLinear = OutputSettings.bLinearColorSpace;
+        Frame->FrameIndex = FrameIndex;
+        Frame->Timecode = Timecode;
+        Frame->Resolution = Resolution;
+        Frame->b16Bit = bUse16BitPng;
+        Frame->bLinear = OutputSettings.bLinearColorSpace;
+        Frame->NumBytes = RequiredBytes;
 
-        if (bUse16BitPng)
+        bool bReadSucceeded = false;
+        FPanoPackTarget* PackTarget = GetPackTarget();
+        if (ReadbackPool && PackTarget && FrameGraph && EquirectTextureCache && PackTarget->GetSourceResolution() == Resolution)
+        {
+            // The GPU writes the final byte layout; the pool commits the slot and wakes the worker once the copy lands.
+            const int32 BytesPerTexel = PanoramaPixelPack::GetBytesPerTexel(PackFormat);
+            FPanoReadbackPool::FGraphCopy ReadbackCopy = ReadbackPool->Enqueue(Frame, PackTarget->GetTexelExtent(), BytesPerTexel);
+            if (!ReadbackCopy && bLockedTimestepActive)
+            {
+                // Every readback is in flight; a locked take lands them instead of dropping this frame.
+                ReadbackPool->Drain();
+                ReadbackCopy = ReadbackPool->Enqueue(Frame, PackTarget->GetTexelExtent(), BytesPerTexel);
+            }
+            if (ReadbackCopy)
+            {
+                // Pack and staging copy go into the graph after the conversion that writes their source.
+                DispatchPack();
+                FrameGraph->AddPass(
+                    [Cache = EquirectTextureCache, Target = PackTarget, ReadbackCopy = MoveTemp(ReadbackCopy)](FRDGBuilder& GraphBuilder) mutable
+                    {
+                        ReadbackCopy(GraphBuilder, Cache->RegisterPacked(GraphBuilder, Target->GetTextureRHI()));
+                    });
+                ReadbackStallHistogram->Record(FPlatformTime::Seconds() - StallStartSeconds);
+                ++FrameIndex;
+                return;
+            }
+        }
+        else if (bUse16BitPng)
         {
-            TArray<FLinearColor> LinearPixels;
-            Resource->ReadLinearColorPixels(LinearPixels);
-            Frame.PixelData.SetNum(LinearPixels.Num() * sizeof(FFloat16Color));
-            FFloat16Color* Dest = reinterpret_cast<FFloat16Color*>(Frame.PixelData.GetData());
-            for (int32 Index = 0; Index < LinearPixels.Num(); ++Index)
+            // The synchronous read flushes the render thread, so the graph that writes the equirect goes first.
+            SubmitFrameGraph();
+            BeginStage(EPanoCaptureStage::Output);
+            // The scratch array keeps its allocation between frames.
+            bReadSucceeded = Resource->ReadLinearColorPixels(ReadbackScratch) && ReadbackScratch.Num() == PixelCount;
+            if (bReadSucceeded)
             {
-                Dest[Index] = FFloat16Color(LinearPixels[Index]);
+                // Same result as the RGBA16 pack pass, vectorized and split by rows.
+                PanoramaPixelConvert::ConvertRows(EPanoConvertKernel::Unorm16, reinterpret_cast<const float*>(ReadbackScratch.GetData()),
+                    Frame->PixelData.GetData(), static_cast<int64>(Resolution.X) * 4, Resolution.Y);
             }
         }
         else
         {
-            TArray<FColor> Pixels;
-            Resource->ReadPixels(Pixels);
-            Frame.PixelData.SetNum(Pixels.Num() * sizeof(FColor));
-            FMemory::Memcpy(Frame.PixelData.GetData(), Pixels.GetData(), Pixels.Num() * sizeof(FColor));
+            SubmitFrameGraph();
+            BeginStage(EPanoCaptureStage::Output);
+            // ReadPixels returns BGRA; the writer expects the RGBA8 pack layout.
+            FColor* Pixels = reinterpret_cast<FColor*>(Frame->PixelData.GetData());
+            bReadSucceeded = Resource->ReadPixelsPtr(Pixels);
+            if (bReadSucceeded)
+            {
+                ParallelFor(Resolution.Y, [Pixels, Width = Resolution.X](int32 Row)
+                {
+                    FColor* RowPixels = Pixels + static_cast<int64>(Row) * Width;
+                    for (int32 X = 0; X < Width; ++X)
+                    {
+                        Swap(RowPixels[X].R, RowPixels[X].B);
+                    }
+                });
+            }
         }
 
-        if (!FrameRingBuffer || !FrameRingBuffer->Enqueue(MoveTemp(Frame)))
+        if (!bReadSucceeded)
         {
+            FrameRingBuffer->CancelWriteSlot(Frame);
             HandleDroppedFrame();
+            ++FrameIndex;
+            return;
+        }
+
+        FrameRingBuffer->CommitWriteSlot(Frame);
+        if (CaptureWorker)
+        {
+            CaptureWorker->NotifyFrameAvailable();
+        }
+        if (ReadbackStallHistogram)
+        {
+            ReadbackStallHistogram->Record(FPlatformTime::Seconds() - StallStartSeconds);
         }
     }
     else
@@ -753,6 +1865,9 @@ void UPanoramaCaptureComponent::EnqueueFrameCapture(float DeltaTime)
 #if PANORAMA_CAPTURE_WITH_NVENC
         if (NvencEncoder)
         {
+            // The encoder copies the equirect on the render thread once the graph that writes it has executed.
+            SubmitFrameGraph();
+            BeginStage(EPanoCaptureStage::Output);
             FTextureRHIRef Texture = EquirectRenderTarget->GetRenderTargetResource()->GetTextureRHI();
             NvencEncoder->EnqueueResource(Texture, FrameIndex, Timecode);
         }
@@ -762,224 +1877,393 @@ void UPanoramaCaptureComponent::EnqueueFrameCapture(float DeltaTime)
     ++FrameIndex;
 }
 
-void UPanoramaCaptureComponent::ProcessPendingFrames()
+void UPanoramaCaptureComponent::DispatchCubemapToEquirect(int32 EyeIndex, int32 EyeCount, uint8 FaceMask)
 {
-    if (CaptureWorker)
-    {
-        // Worker consumes frames asynchronously.
-    }
-}
-
-void UPanoramaCaptureComponent::DispatchCubemapToEquirect(int32 EyeIndex, int32 EyeCount)
-{
-    if (!EquirectRenderTarget)
+    UTextureRenderTargetCube* EyeCubeTarget = GetEyeCubeTarget(EyeIndex);
+    if (!EquirectRenderTarget || !EyeCubeTarget || !EquirectTextureCache || !FrameGraph)
     {
         return;
     }
 
     FRHITexture* OutputTexture = EquirectRenderTarget->GetRenderTargetResource()->GetRenderTargetTexture();
-    if (!OutputTexture)
+    FRHITexture* CubeTexture = EyeCubeTarget->GetRenderTargetResource()->GetTextureRHI();
+    if (!OutputTexture || !CubeTexture)
     {
         return;
     }
 
-    const int32 FullWidth = EquirectRenderTarget->SizeX;
-    const int32 BaseHeight = EquirectRenderTarget->SizeY / FMath::Max(1, EyeCount);
-
-    TArray<FMatrix44f> ViewMatrices;
-    ViewMatrices.SetNum(kCubemapFaceCount);
-    for (int32 Index = 0; Index < kCubemapFaceCount; ++Index)
+    // Faces rendered outside the cube capture, and where in their texture each one sits.
+    TStaticArray<FRHITexture*, PanoramaCaptureRegion::FaceCount> FaceTextures(InPlace, nullptr);
+    TStaticArray<FIntPoint, PanoramaCaptureRegion::FaceCount> FaceOrigins(InPlace, FIntPoint::ZeroValue);
+    FRHITexture* AtlasTexture = StereoAtlasTarget ? StereoAtlasTarget->GetRenderTargetResource()->GetRenderTargetTexture() : nullptr;
+    // Serial stereo gives each eye its own cube (full sphere) or face targets (partial region); other paths share them.
+    const int32 CubeEye = RightEyeCubeTargets.Num() > 0 ? EyeIndex : 0;
+    const int32 FaceTargetOffset = FaceRenderTargets.Num() > PanoramaCaptureRegion::FaceCount ? EyeIndex * PanoramaCaptureRegion::FaceCount : 0;
+    for (int32 Face = 0; Face < PanoramaCaptureRegion::FaceCount; ++Face)
     {
-        if (FaceCaptures.IsValidIndex(Index) && FaceCaptures[Index])
+        if (!(FaceMask & (1 << Face)))
         {
-            const FMatrix ViewMatrix = FaceCaptures[Index]->GetComponentTransform().ToInverseMatrixWithScale();
-            ViewMatrices[Index] = FMatrix44f(ViewMatrix);
+            continue;
         }
-        else
+        if (AtlasTexture)
         {
-            ViewMatrices[Index] = FMatrix44f(FMatrix::Identity);
+            FaceTextures[Face] = AtlasTexture;
+            FaceOrigins[Face] = PanoramaBatchedCapture::GetTileOrigin(EyeIndex, Face, ActiveFaceSize);
+        }
+        else if (FaceRenderTargets.IsValidIndex(FaceTargetOffset + Face))
+        {
+            FaceTextures[Face] = FaceRenderTargets[FaceTargetOffset + Face]->GetRenderTargetResource()->GetRenderTargetTexture();
         }
     }
 
+    const int32 OutputWidth = EquirectRenderTarget->SizeX;
+    const int32 BaseHeight = EquirectRenderTarget->SizeY / FMath::Max(1, EyeCount);
+    const FVector2f InvSphereResolution(1.0f / ActiveSphereResolution.X, 1.0f / ActiveSphereResolution.Y);
+    const FVector2f SphereOffset(ActiveRegion.Min);
+
+    // Only the rig's orientation matters; its position and the stereo eye offset are baked into the cube capture.
+    const FMatrix44f RigToWorld(FRotationMatrix(GetComponentRotation()));
+
     const bool bLinearOutput = (OutputSettings.OutputMode == EPanoramaCaptureOutputMode::NVENC) ? bUseLinearGammaForNVENC : OutputSettings.bLinearColorSpace;
+    const EPanoramaResampleFilter Filter = ResampleFilter;
+    const float FaceSize = EyeCubeTarget->SizeX;
+    // Rounded up to whole mirrored pairs.
+    const uint32 Supersamples = static_cast<uint32>(FMath::Clamp(SupersampleCount + (SupersampleCount & 1), 2, 64));
+
+    FPanoEquirectLutTexture* Lut = nullptr;
+    bool bBuildLut = false;
+    // Supersampling derives its own sub-pixel directions, so it has no use for the table.
+    if (EquirectMapping == EPanoramaEquirectMapping::LookupTable && Filter != EPanoramaResampleFilter::Supersampled)
+    {
+        const FIntPoint LutResolution(OutputWidth, BaseHeight);
+        if (!EquirectLut || EquirectLut->GetResolution() != LutResolution || EquirectLutOffset != ActiveRegion.Min)
+        {
+            ReleaseEquirectLut();
+            EquirectLut = MakeUnique<FPanoEquirectLutTexture>(LutResolution);
+            BeginInitResource(EquirectLut.Get());
+            EquirectLutOffset = ActiveRegion.Min;
+        }
+        bBuildLut = !bEquirectLutBuilt;
+        bEquirectLutBuilt = true;
+        Lut = EquirectLut.Get();
+    }
 
-    ENQUEUE_RENDER_COMMAND(PanoramaCapture_DispatchRDG)(
-        [FaceRenderTargets = FaceRenderTargets, ViewMatrices, OutputTexture, bLinearOutput, EyeIndex, EyeCount, FullWidth, BaseHeight](FRHICommandListImmediate& RHICmdList)
+    FrameGraph->AddPass(
+        [Cache = EquirectTextureCache, CubeTexture, FaceTextures, FaceOrigins, RigToWorld, OutputTexture, Lut, bBuildLut, bLinearOutput, Filter, FaceSize, Supersamples, EyeIndex, CubeEye, EyeCount, OutputWidth, BaseHeight, InvSphereResolution, SphereOffset](FRDGBuilder& GraphBuilder)
         {
-            FRDGBuilder GraphBuilder(RHICmdList);
+            FGlobalShaderMap* ShaderMap = GetGlobalShaderMap(GMaxRHIFeatureLevel);
+            // Only the region's pixels are dispatched.
+            const FIntVector GroupCount(
+                FMath::DivideAndRoundUp(OutputWidth, 8),
+                FMath::DivideAndRoundUp(BaseHeight, 8),
+                1);
+
+            FRDGTextureRef LutTexture = Lut ? Cache->RegisterLut(GraphBuilder, Lut->GetTextureRHI()) : nullptr;
+            if (LutTexture && bBuildLut)
+            {
+                RDG_GPU_STAT_SCOPE(GraphBuilder, PanoramaEquirectLutBuild);
+
+                FPanoCubemapToEquirectCS::FParameters* BuildParameters = GraphBuilder.AllocParameters<FPanoCubemapToEquirectCS::FParameters>();
+                BuildParameters->OutputResolution = FVector2f(OutputWidth, BaseHeight);
+                BuildParameters->InvSphereResolution = InvSphereResolution;
+                BuildParameters->SphereOffset = SphereOffset;
+                BuildParameters->LutOutput = GraphBuilder.CreateUAV(LutTexture);
+
+                FPanoCubemapToEquirectCS::FPermutationDomain BuildPermutation;
+                BuildPermutation.Set<FPanoCubemapToEquirectCS::FPassDim>(static_cast<int32>(EPanoEquirectPass::BuildLut));
+                BuildPermutation.Set<FPanoCubemapToEquirectCS::FFilterDim>(static_cast<int32>(EPanoramaResampleFilter::Bilinear));
+                TShaderMapRef<FPanoCubemapToEquirectCS> BuildShader(ShaderMap, BuildPermutation);
+                FComputeShaderUtils::AddPass(GraphBuilder, RDG_EVENT_NAME("PanoramaEquirectLutBuild"), BuildShader, BuildParameters, GroupCount);
+            }
+
+            FRDGTextureRef Cube = Cache->RegisterCube(GraphBuilder, CubeEye, CubeTexture);
+            const int32 CubeFaceSize = static_cast<int32>(FaceSize);
+            FRDGTextureRef FaceSources[PanoramaCaptureRegion::FaceCount] = {};
+            for (int32 Face = 0; Face < PanoramaCaptureRegion::FaceCount; ++Face)
+            {
+                if (!FaceTextures[Face])
+                {
+                    continue;
+                }
+                // The atlas backs every face; it is registered once so RDG tracks a single resource.
+                for (int32 Previous = 0; Previous < Face && !FaceSources[Face]; ++Previous)
+                {
+                    FaceSources[Face] = FaceTextures[Previous] == FaceTextures[Face] ? FaceSources[Previous] : nullptr;
+                }
+                if (!FaceSources[Face])
+                {
+                    FaceSources[Face] = Cache->RegisterFace(GraphBuilder, EyeIndex, Face, FaceTextures[Face]);
+                }
+
+                FRHICopyTextureInfo CopyInfo;
+                CopyInfo.SourcePosition = FIntVector(FaceOrigins[Face].X, FaceOrigins[Face].Y, 0);
+                CopyInfo.Size = FIntVector(CubeFaceSize, CubeFaceSize, 1);
+                CopyInfo.DestSliceIndex = Face;
+                AddCopyTexturePass(GraphBuilder, FaceSources[Face], Cube, CopyInfo);
+            }
 
             FPanoCubemapToEquirectCS::FParameters* Parameters = GraphBuilder.AllocParameters<FPanoCubemapToEquirectCS::FParameters>();
-            Parameters->OutputResolution = FVector2f(FullWidth, BaseHeight);
-            Parameters->InvOutputResolution = FVector2f(1.0f / FullWidth, 1.0f / BaseHeight);
-            Parameters->FullResolution = FVector2f(FullWidth, BaseHeight * EyeCount);
+            Parameters->RigToWorld = RigToWorld;
+            Parameters->OutputResolution = FVector2f(OutputWidth, BaseHeight);
+            Parameters->InvSphereResolution = InvSphereResolution;
+            Parameters->SphereOffset = SphereOffset;
+            Parameters->FullResolution = FVector2f(OutputWidth, BaseHeight * EyeCount);
             Parameters->OutputOffset = FVector2f(0.f, EyeIndex * BaseHeight);
             Parameters->bLinearColorSpace = bLinearOutput ? 1.0f : 0.0f;
-
-            for (int32 Index = 0; Index < ViewMatrices.Num(); ++Index)
+            Parameters->FaceSize = FaceSize;
+            Parameters->SupersampleCount = Supersamples;
+            // One hardware cube sample per pixel: no per-pixel face selection, and seamless filtering across face edges.
+            Parameters->FaceCube = Cube;
+            Parameters->FaceSampler = TStaticSamplerState<SF_Bilinear, AM_Clamp, AM_Clamp, AM_Clamp>::GetRHI();
+            Parameters->OutputTexture = GraphBuilder.CreateUAV(Cache->RegisterOutput(GraphBuilder, OutputTexture));
+            Parameters->DirectionLut = LutTexture;
+
+            const EPanoEquirectPass Pass = LutTexture ? EPanoEquirectPass::Lookup : EPanoEquirectPass::Analytic;
+            FPanoCubemapToEquirectCS::FPermutationDomain PermutationVector;
+            PermutationVector.Set<FPanoCubemapToEquirectCS::FPassDim>(static_cast<int32>(Pass));
+            PermutationVector.Set<FPanoCubemapToEquirectCS::FFilterDim>(static_cast<int32>(Filter));
+            TShaderMapRef<FPanoCubemapToEquirectCS> ComputeShader(ShaderMap, PermutationVector);
+
+            // Separate stats so "stat gpu" compares the filters, and the two mappings on the bilinear fast path, directly.
+            switch (Filter)
             {
-                Parameters->ViewMatrices[Index] = ViewMatrices[Index];
+            case EPanoramaResampleFilter::Bicubic:
+            {
+                RDG_GPU_STAT_SCOPE(GraphBuilder, PanoramaEquirectBicubic);
+                FComputeShaderUtils::AddPass(GraphBuilder, RDG_EVENT_NAME("PanoramaCubemapToEquirect"), ComputeShader, Parameters, GroupCount);
+                break;
             }
-
-            for (int32 Index = 0; Index < FaceRenderTargets.Num(); ++Index)
+            case EPanoramaResampleFilter::Lanczos3:
             {
-                FRDGTextureRef FaceTexture = GraphBuilder.RegisterExternalTexture(CreateRenderTarget(FaceRenderTargets[Index]->GetRenderTargetResource()->GetRenderTargetTexture(), TEXT("PanoramaFace")));
-                Parameters->FaceTextures[Index] = GraphBuilder.CreateSRV(FRDGTextureSRVDesc::Create(FaceTexture));
+                RDG_GPU_STAT_SCOPE(GraphBuilder, PanoramaEquirectLanczos);
+                FComputeShaderUtils::AddPass(GraphBuilder, RDG_EVENT_NAME("PanoramaCubemapToEquirect"), ComputeShader, Parameters, GroupCount);
+                break;
+            }
+            case EPanoramaResampleFilter::Supersampled:
+            {
+                RDG_GPU_STAT_SCOPE(GraphBuilder, PanoramaEquirectSupersampled);
+                FComputeShaderUtils::AddPass(GraphBuilder, RDG_EVENT_NAME("PanoramaCubemapToEquirect"), ComputeShader, Parameters, GroupCount);
+                break;
+            }
+            default:
+                if (Pass == EPanoEquirectPass::Lookup)
+                {
+                    RDG_GPU_STAT_SCOPE(GraphBuilder, PanoramaEquirectLookup);
+                    FComputeShaderUtils::AddPass(GraphBuilder, RDG_EVENT_NAME("PanoramaCubemapToEquirect"), ComputeShader, Parameters, GroupCount);
+                }
+                else
+                {
+                    RDG_GPU_STAT_SCOPE(GraphBuilder, PanoramaEquirectAnalytic);
+                    FComputeShaderUtils::AddPass(GraphBuilder, RDG_EVENT_NAME("PanoramaCubemapToEquirect"), ComputeShader, Parameters, GroupCount);
+                }
+                break;
             }
+        });
+}
 
-            Parameters->FaceSampler = TStaticSamplerState<SF_Bilinear>::GetRHI();
-            FRDGTextureRef Output = GraphBuilder.RegisterExternalTexture(CreateRenderTarget(OutputTexture, TEXT("PanoramaEquirect")));
-            Parameters->OutputTexture = GraphBuilder.CreateUAV(Output);
+void UPanoramaCaptureComponent::RenderOdsSlices()
+{
+    if (!OdsLayout || !OdsAtlasTarget)
+    {
+        return;
+    }
 
-            TShaderMapRef<FPanoCubemapToEquirectCS> ComputeShader(GetGlobalShaderMap(GMaxRHIFeatureLevel));
-            const FIntVector GroupCount(
-                FMath::DivideAndRoundUp(FullWidth, 8),
-                FMath::DivideAndRoundUp(BaseHeight, 8),
-                1);
+    const FPanoOdsLayout& Layout = *OdsLayout;
+    const FTransform& RigTransform = GetComponentTransform();
+    // Every view shares one symmetric frustum; only its origin on the eye circle and its orientation change.
+    const FMatrix Projection = FReversedZPerspectiveMatrix(FMath::Atan(Layout.TanHalfHorizontal), FMath::Atan(Layout.TanHalfVertical), 1.f, 1.f, GNearClippingPlane, GNearClippingPlane);
+    const int32 SlicesPerPass = FMath::Clamp(OdsSettings.SlicesPerPass, 1, Layout.SliceCount);
 
-            FComputeShaderUtils::AddPass(GraphBuilder, RDG_EVENT_NAME("PanoramaCubemapToEquirect"), ComputeShader, Parameters, GroupCount);
-            GraphBuilder.Execute();
-        });
+    TArray<FPanoBatchedView> Views;
+    for (int32 FirstSlice = 0; FirstSlice < Layout.SliceCount; FirstSlice += SlicesPerPass)
+    {
+        Views.Reset();
+        const int32 EndSlice = FMath::Min(FirstSlice + SlicesPerPass, Layout.SliceCount);
+        for (int32 Slice = FirstSlice; Slice < EndSlice; ++Slice)
+        {
+            if (!OdsVisibleSlices[Slice])
+            {
+                continue;
+            }
+            for (int32 EyeIndex = 0; EyeIndex < 2; ++EyeIndex)
+            {
+                const FVector Origin = RigTransform.TransformPosition(FVector(PanoramaOds::GetViewOrigin(Layout, EyeIndex, Slice)));
+                for (int32 Pitch = 0; Pitch < Layout.PitchSteps; ++Pitch)
+                {
+                    if (!OdsVisiblePitches[Pitch])
+                    {
+                        continue;
+                    }
+
+                    const FIntPoint TileOrigin = Layout.GetTileOrigin(EyeIndex, Slice, Pitch);
+                    FPanoBatchedView& View = Views.AddDefaulted_GetRef();
+                    View.Origin = Origin;
+                    View.Rotation = (RigTransform.GetRotation() * FQuat(PanoramaOds::GetViewRotation(Layout, Slice, Pitch))).Rotator();
+                    View.Rect = FIntRect(TileOrigin, TileOrigin + Layout.TileSize);
+                    View.Projection = Projection;
+                }
+            }
+        }
+        PanoramaBatchedCapture::RenderViews(GetWorld(), CubeCapture->ShowFlags, Views, OdsAtlasTarget);
+    }
 }
 
-void UPanoramaCaptureComponent::UpdatePreview()
+void UPanoramaCaptureComponent::DispatchOdsStitch(int32 EyeIndex)
 {
-    if (!bEnablePreview || !PreviewRenderTarget || !EquirectRenderTarget)
+    if (!EquirectRenderTarget || !CubeRenderTarget || !OdsAtlasTarget || !OdsLayout || !EquirectTextureCache || !FrameGraph)
     {
         return;
     }
 
-    FRHITexture* SourceTexture = EquirectRenderTarget->GetRenderTargetResource()->GetRenderTargetTexture();
-    FRHITexture* DestTexture = PreviewRenderTarget->GetRenderTargetResource()->GetRenderTargetTexture();
-    if (!SourceTexture || !DestTexture)
+    FRHITexture* OutputTexture = EquirectRenderTarget->GetRenderTargetResource()->GetRenderTargetTexture();
+    FRHITexture* CubeTexture = CubeRenderTarget->GetRenderTargetResource()->GetTextureRHI();
+    FRHITexture* AtlasTexture = OdsAtlasTarget->GetRenderTargetResource()->GetRenderTargetTexture();
+    if (!OutputTexture || !CubeTexture || !AtlasTexture)
     {
         return;
     }
 
-    ENQUEUE_RENDER_COMMAND(PanoramaCapture_UpdatePreview)(
-        [SourceTexture, DestTexture](FRHICommandListImmediate& RHICmdList)
+    // Slice views already carry the rig's transform; only the world-aligned centre cube needs the rotation.
+    const FMatrix44f RigToWorld(FRotationMatrix(GetComponentRotation()));
+    const bool bLinearOutput = (OutputSettings.OutputMode == EPanoramaCaptureOutputMode::NVENC) ? bUseLinearGammaForNVENC : OutputSettings.bLinearColorSpace;
+
+    FrameGraph->AddPass(
+        [Cache = EquirectTextureCache, Layout = *OdsLayout, AtlasTexture, CubeTexture, OutputTexture, RigToWorld, SphereResolution = ActiveSphereResolution, Region = ActiveRegion, EyeIndex, bLinearOutput](FRDGBuilder& GraphBuilder)
         {
-            FRHICopyTextureInfo CopyInfo;
-            CopyInfo.Size = FIntVector(DestTexture->GetDesc().Extent.X, DestTexture->GetDesc().Extent.Y, 1);
-            RHICmdList.CopyTexture(SourceTexture, DestTexture, CopyInfo);
+            FPanoOdsStitchInputs Inputs;
+            Inputs.Atlas = Cache->RegisterOdsAtlas(GraphBuilder, AtlasTexture);
+            Inputs.CentreCube = Cache->RegisterCube(GraphBuilder, 0, CubeTexture);
+            Inputs.Output = Cache->RegisterOutput(GraphBuilder, OutputTexture);
+            Inputs.RigToWorld = RigToWorld;
+            Inputs.SphereResolution = SphereResolution;
+            Inputs.Region = Region;
+            Inputs.EyeIndex = EyeIndex;
+            Inputs.bLinearColorSpace = bLinearOutput;
+            {
+                RDG_GPU_STAT_SCOPE(GraphBuilder, PanoramaOdsStitch);
+                AddPanoOdsStitchPass(GraphBuilder, Layout, Inputs);
+            }
         });
 }
 
-void UPanoramaCaptureComponent::HandleDroppedFrame()
+void UPanoramaCaptureComponent::DispatchPack()
 {
-    ++DroppedFrameCount;
-    CaptureStatus = EPanoramaCaptureStatus::DroppedFrames;
-    UE_LOG(LogTemp, Warning, TEXT("Panorama capture dropped frame %u"), DroppedFrameCount);
+    FRHITexture* SourceTexture = EquirectRenderTarget ? EquirectRenderTarget->GetRenderTargetResource()->GetRenderTargetTexture() : nullptr;
+    FPanoPackTarget* PackTarget = GetPackTarget();
+    if (!SourceTexture || !PackTarget || !EquirectTextureCache || !FrameGraph)
+    {
+        return;
+    }
+
+    FrameGraph->AddPass(
+        [Cache = EquirectTextureCache, SourceTexture, Target = PackTarget](FRDGBuilder& GraphBuilder)
+        {
+            AddPanoPackPass(GraphBuilder, Target->GetFormat(), Cache->RegisterOutput(GraphBuilder, SourceTexture), Cache->RegisterPacked(GraphBuilder, Target->GetTextureRHI()));
+        });
 }
 
-void UPanoramaCaptureComponent::FlushRingBuffer()
+void UPanoramaCaptureComponent::UpdatePreview()
 {
-    if (CaptureWorker)
+    if (!bEnablePreview || !PreviewRenderTarget || !EquirectRenderTarget || !EquirectTextureCache || !FrameGraph)
     {
-        CaptureWorker->Stop();
+        return;
     }
 
-    if (FrameRingBuffer)
+    const double NowSeconds = FPlatformTime::Seconds();
+    if (PreviewFrameRate > 0.f && LastPreviewSeconds > 0.0 && NowSeconds - LastPreviewSeconds < 1.0 / PreviewFrameRate)
     {
-        FPanoCaptureFrame Frame;
-        while (FrameRingBuffer->Dequeue(Frame))
-        {
-        }
+        return;
     }
 
-    if (PngWriter)
+    FRHITexture* SourceTexture = EquirectRenderTarget->GetRenderTargetResource()->GetRenderTargetTexture();
+    FRHITexture* DestTexture = PreviewRenderTarget->GetRenderTargetResource()->GetRenderTargetTexture();
+    if (!SourceTexture || !DestTexture)
     {
-        PngWriter->Flush();
+        return;
     }
+    LastPreviewSeconds = NowSeconds;
+
+    FrameGraph->AddPass(
+        [Cache = EquirectTextureCache, SourceTexture, DestTexture](FRDGBuilder& GraphBuilder)
+        {
+            AddPanoPreviewPass(GraphBuilder, Cache->RegisterOutput(GraphBuilder, SourceTexture), Cache->RegisterPreview(GraphBuilder, DestTexture));
+        });
 }
 
-void UPanoramaCaptureComponent::FinalizeRecording()
+void UPanoramaCaptureComponent::BeginLockedTimestep()
 {
-    FlushRenderingCommands();
+    bPreviousUseFixedTimeStep = FApp::UseFixedTimeStep();
+    PreviousFixedDeltaTime = FApp::GetFixedDeltaTime();
+    // The same switch -benchmark uses: the engine advances time by exactly this much per frame and stops waiting for
+    // the wall clock, so the world runs as fast or as slow as capture allows.
+    FApp::SetUseFixedTimeStep(true);
+    FApp::SetFixedDeltaTime(1.0 / FMath::Max(CaptureFrameRate, 0.001f));
+    bLockedTimestepActive = true;
+    UE_LOG(LogTemp, Display, TEXT("PanoramaCapture: locked timestep, world steps %.6f s per frame."), FApp::GetFixedDeltaTime());
+}
 
-    FString AudioPath;
-    if (AudioRecorder)
+void UPanoramaCaptureComponent::EndLockedTimestep()
+{
+    if (!bLockedTimestepActive)
     {
-        double AudioDuration = 0.0;
-        AudioPath = FPaths::Combine(ActiveOutputDirectory, FString::Printf(TEXT("%s.wav"), *ActiveSessionName));
-        AudioRecorder->StopRecording();
-        AudioRecorder->WriteToWav(AudioPath, AudioDuration);
-        AudioRecorder.Reset();
+        return;
     }
+    FApp::SetUseFixedTimeStep(bPreviousUseFixedTimeStep);
+    FApp::SetFixedDeltaTime(PreviousFixedDeltaTime);
+    bLockedTimestepActive = false;
+}
 
-    const UPanoramaCaptureSettings* Settings = GetDefault<UPanoramaCaptureSettings>();
-    const bool bEmbedAudio = Settings ? Settings->bEmbedAudioInContainer : true;
-    const bool bOverwriteExisting = Settings ? Settings->bOverwriteExisting : false;
-    const bool bGenerateMkv = Settings ? Settings->bGenerateMKV : true;
-
-    if (OutputSettings.OutputMode == EPanoramaCaptureOutputMode::PNGSequence && PngWriter)
+FPanoCaptureFrame* UPanoramaCaptureComponent::AcquireFrameSlot()
+{
+    FPanoCaptureFrame* Frame = FrameRingBuffer ? FrameRingBuffer->AcquireWriteSlot() : nullptr;
+    if (Frame || !FrameRingBuffer || !bLockedTimestepActive)
     {
-        PngWriter->Flush();
-        const FString SequencePattern = FPaths::Combine(ActiveOutputDirectory, FString::Printf(TEXT("%s_%%06d.png"), *ActiveSessionName));
-
-        const FString Mp4Path = MakeUniqueOutputPath(FPaths::Combine(ActiveOutputDirectory, FString::Printf(TEXT("%s.mp4"), *ActiveSessionName)), bOverwriteExisting);
-        PackageSequenceToContainer(SequencePattern, bEmbedAudio ? AudioPath : FString(), CaptureFrameRate, Mp4Path, OutputSettings.NvencRateControl, OutputSettings.Codec);
-        UE_LOG(LogTemp, Log, TEXT("Panorama capture packaged to %s"), *Mp4Path);
-
-        if (bGenerateMkv)
-        {
-            const FString MkvPath = MakeUniqueOutputPath(FPaths::Combine(ActiveOutputDirectory, FString::Printf(TEXT("%s.mkv"), *ActiveSessionName)), bOverwriteExisting);
-            PackageSequenceToContainer(SequencePattern, bEmbedAudio ? AudioPath : FString(), CaptureFrameRate, MkvPath, OutputSettings.NvencRateControl, OutputSettings.Codec);
-            UE_LOG(LogTemp, Log, TEXT("Panorama capture packaged to %s"), *MkvPath);
-        }
+        return Frame;
     }
 
-#if PANORAMA_CAPTURE_WITH_NVENC
-    if (OutputSettings.OutputMode == EPanoramaCaptureOutputMode::NVENC && NvencEncoder)
+    // Slots reserved by in-flight readbacks only commit when polled, so land those before waiting on the encoder.
+    if (ReadbackPool)
     {
-        TArray<FPanoramaEncodedFrame> EncodedFrames;
-        NvencEncoder->Flush(EncodedFrames);
-        const FString EncoderBitstreamPath = NvencEncoder->GetParams().OutputBitstreamPath;
-        NvencEncoder->Shutdown();
+        ReadbackPool->Drain();
+    }
+    const double Deadline = FPlatformTime::Seconds() + kLockedSlotTimeoutSeconds;
+    while (!(Frame = FrameRingBuffer->AcquireWriteSlot()) && FPlatformTime::Seconds() < Deadline)
+    {
+        FPlatformProcess::Sleep(0.001f);
+    }
+    return Frame;
+}
 
-        FString BitstreamPath = EncoderBitstreamPath;
-        if (BitstreamPath.IsEmpty())
-        {
-            const FString Extension = OutputSettings.Codec == EPanoramaCaptureCodec::H264 ? TEXT("h264") : TEXT("hevc");
-            BitstreamPath = FPaths::Combine(ActiveOutputDirectory, FString::Printf(TEXT("%s.%s.annexb"), *ActiveSessionName, *Extension));
-        }
+void UPanoramaCaptureComponent::HandleDroppedFrame()
+{
+    ++DroppedFrameCount;
+    CaptureStatus = EPanoramaCaptureStatus::DroppedFrames;
+    UE_LOG(LogTemp, Warning, TEXT("Panorama capture dropped frame %u"), DroppedFrameCount);
+}
 
-        if (!BitstreamPath.IsEmpty() && !FPaths::FileExists(BitstreamPath) && EncodedFrames.Num() > 0)
-        {
-            TArray<uint8> OutputData;
-            for (const FPanoramaEncodedFrame& Frame : EncodedFrames)
-            {
-                OutputData.Append(Frame.EncodedBytes);
-            }
-            if (!FFileHelper::SaveArrayToFile(OutputData, *BitstreamPath))
-            {
-                UE_LOG(LogTemp, Warning, TEXT("Failed to persist NVENC bitstream to %s"), *BitstreamPath);
-            }
-        }
+FPanoEncodeThroughput UPanoramaCaptureComponent::GetPngEncodeThroughput() const
+{
+    return PngWriter ? PngWriter->GetThroughput() : LastPngThroughput;
+}
 
-        if (!BitstreamPath.IsEmpty() && FPaths::FileExists(BitstreamPath))
-        {
-            const FString Mp4Path = MakeUniqueOutputPath(FPaths::Combine(ActiveOutputDirectory, FString::Printf(TEXT("%s.mp4"), *ActiveSessionName)), bOverwriteExisting);
-            PackageBitstreamToContainer(BitstreamPath, bEmbedAudio ? AudioPath : FString(), CaptureFrameRate, Mp4Path, OutputSettings.Codec);
-            UE_LOG(LogTemp, Log, TEXT("NVENC bitstream packaged to %s"), *Mp4Path);
+FPanoLatencyStats UPanoramaCaptureComponent::GetPngEncodeLatencyStats() const
+{
+    return PngWriter ? PngWriter->GetEncodeLatency() : LastPngEncodeLatency;
+}
 
-            if (bGenerateMkv)
-            {
-                const FString MkvPath = MakeUniqueOutputPath(FPaths::Combine(ActiveOutputDirectory, FString::Printf(TEXT("%s.mkv"), *ActiveSessionName)), bOverwriteExisting);
-                PackageBitstreamToContainer(BitstreamPath, bEmbedAudio ? AudioPath : FString(), CaptureFrameRate, MkvPath, OutputSettings.Codec);
-                UE_LOG(LogTemp, Log, TEXT("NVENC bitstream packaged to %s"), *MkvPath);
-            }
-        }
-        else
-        {
-            UE_LOG(LogTemp, Warning, TEXT("NVENC bitstream not found for session %s."), *ActiveSessionName);
-        }
-    }
-#endif
+FPanoLatencyStats UPanoramaCaptureComponent::GetQueueLatencyStats() const
+{
+    return QueueLatencyHistogram ? QueueLatencyHistogram->Summarize() : LastQueueLatency;
+}
 
-    CaptureStatus = EPanoramaCaptureStatus::Idle;
-    ReleaseResources();
+FPanoLatencyStats UPanoramaCaptureComponent::GetReadbackStallStats() const
+{
+    return ReadbackStallHistogram ? ReadbackStallHistogram->Summarize() : FPanoLatencyStats();
+}
 
-    UE_LOG(LogTemp, Log, TEXT("Panorama capture finalized: %s"), *ActiveSessionName);
+FPanoAudioCaptureStats UPanoramaCaptureComponent::GetAudioCaptureStats() const
+{
+    return AudioRecorder ? AudioRecorder->GetCaptureStats() : LastAudioStats;
 }
 
 bool UPanoramaCaptureComponent::ResolveOutputDirectory(FString& OutDirectory) const
@@ -1006,22 +2290,6 @@ FString UPanoramaCaptureComponent::GenerateOutputFileName(const FString& Extensi
     return FPaths::Combine(ActiveOutputDirectory, FileName);
 }
 
-void UPanoramaCaptureComponent::BuildStereoViewMatrices(TArray<FMatrix>& OutLeft, TArray<FMatrix>& OutRight) const
-{
-    OutLeft.Reset();
-    OutRight.Reset();
-
-    const float EyeSeparation = 6.4f; // centimeters
-    const FVector EyeOffset = FVector(EyeSeparation * 0.5f, 0.f, 0.f);
-
-    for (int32 FaceIndex = 0; FaceIndex < FaceCaptures.Num(); ++FaceIndex)
-    {
-        const FTransform FaceTransform = FaceCaptures[FaceIndex]->GetComponentTransform();
-        OutLeft.Add(FMatrix(FTranslationMatrix(-EyeOffset) * FaceTransform.ToMatrixNoScale()));
-        OutRight.Add(FMatrix(FTranslationMatrix(EyeOffset) * FaceTransform.ToMatrixNoScale()));
-    }
-}
-
 void UPanoramaCaptureComponent::OnCaptureComplete()
 {
     CaptureStatus = EPanoramaCaptureStatus::Idle;
@@ -0,0 +1,240 @@
+#include "PanoramaCaptureCostTimer.h"
+
+#include "Misc/ScopeLock.h"
+#include "RHI.h"
+#include "RHICommandList.h"
+#include "RenderingThread.h"
+
+namespace
+{
+    /** Frames whose timestamps may be in flight at once; covers the usual two or three frames of GPU latency. */
+    constexpr int32 kCostTimerDepth = 8;
+    /** Stage spans recorded per frame; serial stereo uses four, the rest fewer. Further spans are not timed. */
+    constexpr int32 kCostTimerMaxSpans = 8;
+    constexpr int32 kCostStageCount = static_cast<int32>(EPanoCaptureStage::Count);
+}
+
+struct FPanoCaptureCostTimer::FState
+{
+    /** A pair of timestamps, on the render thread's clock and on the GPU. */
+    struct FSpan
+    {
+        FRenderQueryRHIRef BeginQuery;
+        FRenderQueryRHIRef EndQuery;
+        uint64 BeginCycles = 0;
+        double RenderThreadMs = 0.0;
+        EPanoCaptureStage Stage = EPanoCaptureStage::SceneRender;
+
+        void Begin(FRHICommandListImmediate& RHICmdList, bool bUseQueries)
+        {
+            if (bUseQueries)
+            {
+                if (!BeginQuery)
+                {
+                    BeginQuery = RHICreateRenderQuery(RQT_AbsoluteTime);
+                    EndQuery = RHICreateRenderQuery(RQT_AbsoluteTime);
+                }
+                RHICmdList.EndRenderQuery(BeginQuery);
+            }
+            BeginCycles = FPlatformTime::Cycles64();
+        }
+
+        void End(FRHICommandListImmediate& RHICmdList, bool bUseQueries)
+        {
+            RenderThreadMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - BeginCycles);
+            if (bUseQueries)
+            {
+                RHICmdList.EndRenderQuery(EndQuery);
+            }
+        }
+
+        /** False while the GPU has not written both timestamps yet. */
+        bool Resolve(bool bUseQueries, double& OutGpuMs) const
+        {
+            uint64 BeginMicroseconds = 0;
+            uint64 EndMicroseconds = 0;
+            if (bUseQueries
+                && (!RHIGetRenderQueryResult(BeginQuery, BeginMicroseconds, false)
+                    || !RHIGetRenderQueryResult(EndQuery, EndMicroseconds, false)))
+            {
+                return false;
+            }
+            OutGpuMs = EndMicroseconds > BeginMicroseconds ? (EndMicroseconds - BeginMicroseconds) / 1000.0 : 0.0;
+            return true;
+        }
+    };
+
+    struct FFrame
+    {
+        FSpan Total;
+        FSpan Stages[kCostTimerMaxSpans];
+        int32 NumStages = 0;
+        bool bStageOpen = false;
+        bool bPending = false;
+    };
+
+    // Render thread only.
+    FFrame Frames[kCostTimerDepth];
+    int32 NextFrame = 0;
+    bool bFrameOpen = false;
+    bool bUseQueries = false;
+
+    // Written on the render thread, drained on the game thread.
+    FCriticalSection Guard;
+    double RenderThreadMsSum = 0.0;
+    double GpuMsSum = 0.0;
+    double StageRenderThreadMsSum[kCostStageCount] = {};
+    double StageGpuMsSum[kCostStageCount] = {};
+    int32 ResolvedFrames = 0;
+
+    void ResolveFinished()
+    {
+        for (FFrame& Frame : Frames)
+        {
+            if (!Frame.bPending)
+            {
+                continue;
+            }
+
+            double GpuMs = 0.0;
+            double StageGpuMs[kCostTimerMaxSpans] = {};
+            bool bResolved = Frame.Total.Resolve(bUseQueries, GpuMs);
+            for (int32 Index = 0; Index < Frame.NumStages && bResolved; ++Index)
+            {
+                bResolved = Frame.Stages[Index].Resolve(bUseQueries, StageGpuMs[Index]);
+            }
+            if (!bResolved)
+            {
+                continue;
+            }
+
+            Frame.bPending = false;
+            FScopeLock Lock(&Guard);
+            RenderThreadMsSum += Frame.Total.RenderThreadMs;
+            GpuMsSum += GpuMs;
+            for (int32 Index = 0; Index < Frame.NumStages; ++Index)
+            {
+                const int32 Stage = static_cast<int32>(Frame.Stages[Index].Stage);
+                StageRenderThreadMsSum[Stage] += Frame.Stages[Index].RenderThreadMs;
+                StageGpuMsSum[Stage] += StageGpuMs[Index];
+            }
+            ++ResolvedFrames;
+        }
+    }
+};
+
+FPanoCaptureCostTimer::FPanoCaptureCostTimer()
+    : State(MakeShared<FState, ESPMode::ThreadSafe>())
+{
+    State->bUseQueries = !GUsingNullRHI && GSupportsTimestampRenderQueries;
+}
+
+FPanoCaptureCostTimer::~FPanoCaptureCostTimer()
+{
+    // The queries are released on the render thread, after any command still using them.
+    ENQUEUE_RENDER_COMMAND(PanoramaCapture_ReleaseCostTimer)(
+        [State = MoveTemp(State)](FRHICommandListImmediate& RHICmdList) mutable
+        {
+            State.Reset();
+        });
+}
+
+void FPanoCaptureCostTimer::BeginFrame()
+{
+    ENQUEUE_RENDER_COMMAND(PanoramaCapture_CostTimerBegin)(
+        [State = State](FRHICommandListImmediate& RHICmdList)
+        {
+            State->ResolveFinished();
+            FState::FFrame& Frame = State->Frames[State->NextFrame];
+            State->bFrameOpen = !Frame.bPending;
+            if (!State->bFrameOpen)
+            {
+                return;
+            }
+
+            Frame.NumStages = 0;
+            Frame.bStageOpen = false;
+            Frame.Total.Begin(RHICmdList, State->bUseQueries);
+        });
+}
+
+void FPanoCaptureCostTimer::EndFrame()
+{
+    ENQUEUE_RENDER_COMMAND(PanoramaCapture_CostTimerEnd)(
+        [State = State](FRHICommandListImmediate& RHICmdList)
+        {
+            if (!State->bFrameOpen)
+            {
+                return;
+            }
+
+            FState::FFrame& Frame = State->Frames[State->NextFrame];
+            if (Frame.bStageOpen)
+            {
+                Frame.Stages[Frame.NumStages++].End(RHICmdList, State->bUseQueries);
+                Frame.bStageOpen = false;
+            }
+            Frame.Total.End(RHICmdList, State->bUseQueries);
+            Frame.bPending = true;
+            State->NextFrame = (State->NextFrame + 1) % kCostTimerDepth;
+            State->bFrameOpen = false;
+        });
+}
+
+void FPanoCaptureCostTimer::BeginStage(EPanoCaptureStage Stage)
+{
+    ENQUEUE_RENDER_COMMAND(PanoramaCapture_CostTimerBeginStage)(
+        [State = State, Stage](FRHICommandListImmediate& RHICmdList)
+        {
+            FState::FFrame& Frame = State->Frames[State->NextFrame];
+            if (!State->bFrameOpen || Frame.bStageOpen || Frame.NumStages == kCostTimerMaxSpans)
+            {
+                return;
+            }
+
+            FState::FSpan& Span = Frame.Stages[Frame.NumStages];
+            Span.Stage = Stage;
+            Span.Begin(RHICmdList, State->bUseQueries);
+            Frame.bStageOpen = true;
+        });
+}
+
+void FPanoCaptureCostTimer::EndStage()
+{
+    ENQUEUE_RENDER_COMMAND(PanoramaCapture_CostTimerEndStage)(
+        [State = State](FRHICommandListImmediate& RHICmdList)
+        {
+            FState::FFrame& Frame = State->Frames[State->NextFrame];
+            if (!State->bFrameOpen || !Frame.bStageOpen)
+            {
+                return;
+            }
+
+            Frame.Stages[Frame.NumStages++].End(RHICmdList, State->bUseQueries);
+            Frame.bStageOpen = false;
+        });
+}
+
+FPanoCaptureRenderCost FPanoCaptureCostTimer::Consume()
+{
+    FPanoCaptureRenderCost Cost;
+    FScopeLock Lock(&State->Guard);
+    if (State->ResolvedFrames > 0)
+    {
+        Cost.RenderThreadMs = static_cast<float>(State->RenderThreadMsSum / State->ResolvedFrames);
+        Cost.GpuMs = static_cast<float>(State->GpuMsSum / State->ResolvedFrames);
+        Cost.SceneRenderThreadMs = static_cast<float>(State->StageRenderThreadMsSum[static_cast<int32>(EPanoCaptureStage::SceneRender)] / State->ResolvedFrames);
+        Cost.SceneGpuMs = static_cast<float>(State->StageGpuMsSum[static_cast<int32>(EPanoCaptureStage::SceneRender)] / State->ResolvedFrames);
+        Cost.ConvertRenderThreadMs = static_cast<float>(State->StageRenderThreadMsSum[static_cast<int32>(EPanoCaptureStage::Convert)] / State->ResolvedFrames);
+        Cost.ConvertGpuMs = static_cast<float>(State->StageGpuMsSum[static_cast<int32>(EPanoCaptureStage::Convert)] / State->ResolvedFrames);
+        Cost.OutputRenderThreadMs = static_cast<float>(State->StageRenderThreadMsSum[static_cast<int32>(EPanoCaptureStage::Output)] / State->ResolvedFrames);
+        Cost.OutputGpuMs = static_cast<float>(State->StageGpuMsSum[static_cast<int32>(EPanoCaptureStage::Output)] / State->ResolvedFrames);
+        Cost.SampledFrames = State->ResolvedFrames;
+    }
+    State->RenderThreadMsSum = 0.0;
+    State->GpuMsSum = 0.0;
+    FMemory::Memzero(State->StageRenderThreadMsSum);
+    FMemory::Memzero(State->StageGpuMsSum);
+    State->ResolvedFrames = 0;
+    return Cost;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PanoramaCaptureTypes.h"
+
+/** Parts of a captured frame the cost timer reports separately. */
+enum class EPanoCaptureStage : uint8
+{
+    /** Scene captures of the cube, faces, atlas or ODS slices. */
+    SceneRender,
+    /** The frame's render graph: face copies, equirect or ODS stitch, preview downsample, pack pass and readback copy. */
+    Convert,
+    /** Encoder submission, or the synchronous readback when there is no pack target. */
+    Output,
+    Count
+};
+
+/**
+ * Render-thread and GPU time of one frame's capture work. BeginFrame and EndFrame each enqueue a render command
+ * that reads the CPU clock and writes a GPU timestamp, so everything the game thread enqueues in between (scene
+ * captures, copies, the equirect pass) is measured. BeginStage and EndStage bracket parts of the frame the same way;
+ * a stage may be entered several times per frame (once per eye on the serial stereo path) and its spans are summed.
+ * Timestamps are read back without waiting, a few frames later; when every query is still in flight the frame is
+ * skipped.
+ */
+class FPanoCaptureCostTimer
+{
+public:
+    FPanoCaptureCostTimer();
+    ~FPanoCaptureCostTimer();
+
+    /** Game thread. */
+    void BeginFrame();
+    void EndFrame();
+    void BeginStage(EPanoCaptureStage Stage);
+    void EndStage();
+
+    /**
+     * Game thread: averages of the frames resolved since the last call; SampledFrames is zero when there were none.
+     * ThroughputFps is left to the caller, which owns the wall-clock window.
+     */
+    FPanoCaptureRenderCost Consume();
+
+private:
+    struct FState;
+    TSharedPtr<FState, ESPMode::ThreadSafe> State;
+};
@@ -0,0 +1,154 @@
+#include "PanoramaCaptureRegion.h"
+
+namespace
+{
+    constexpr double kRegionFaceMarginDegrees = 2.0;
+    /** Spacing of the probes along the region's outline; well under the margin, so no face corner slips between two. */
+    constexpr double kRegionProbeStepDegrees = 1.0;
+
+    int32 GetFaceIndex(const FVector& Direction)
+    {
+        const FVector AbsDirection = Direction.GetAbs();
+        if (AbsDirection.X >= AbsDirection.Y && AbsDirection.X >= AbsDirection.Z)
+        {
+            return Direction.X >= 0.0 ? 0 : 1;
+        }
+        if (AbsDirection.Y >= AbsDirection.Z)
+        {
+            return Direction.Y >= 0.0 ? 2 : 3;
+        }
+        return Direction.Z >= 0.0 ? 4 : 5;
+    }
+}
+
+FPanoEquirectCrop FPanoRegionBounds::GetCrop() const
+{
+    FPanoEquirectCrop Crop;
+    if (SphereResolution.X > 0 && SphereResolution.Y > 0)
+    {
+        Crop.Top = static_cast<double>(Rect.Min.Y) / SphereResolution.Y;
+        Crop.Bottom = static_cast<double>(SphereResolution.Y - Rect.Max.Y) / SphereResolution.Y;
+        Crop.Left = static_cast<double>(Rect.Min.X) / SphereResolution.X;
+        Crop.Right = static_cast<double>(SphereResolution.X - Rect.Max.X) / SphereResolution.X;
+    }
+    return Crop;
+}
+
+namespace PanoramaCaptureRegion
+{
+    FPanoRegionBounds Resolve(const FPanoCaptureRegion& Region, FIntPoint SphereResolution)
+    {
+        float HorizontalFov = 360.f;
+        float MinLatitude = -90.f;
+        float MaxLatitude = 90.f;
+        switch (Region.Preset)
+        {
+        case EPanoramaCaptureRegionPreset::VR180:
+            HorizontalFov = 180.f;
+            break;
+        case EPanoramaCaptureRegionPreset::Custom:
+            HorizontalFov = FMath::Clamp(Region.HorizontalFovDegrees, 1.f, 360.f);
+            MinLatitude = FMath::Clamp(FMath::Min(Region.MinLatitudeDegrees, Region.MaxLatitudeDegrees), -90.f, 90.f);
+            MaxLatitude = FMath::Clamp(FMath::Max(Region.MinLatitudeDegrees, Region.MaxLatitudeDegrees), -90.f, 90.f);
+            break;
+        default:
+            break;
+        }
+
+        FPanoRegionBounds Bounds;
+        Bounds.SphereResolution = SphereResolution;
+
+        // Symmetric about the centre column, so the width keeps the sphere width's parity.
+        const int32 Left = FMath::Clamp(FMath::RoundToInt(SphereResolution.X * (0.5f - HorizontalFov / 720.f)), 0, SphereResolution.X / 2 - 1);
+        Bounds.Rect.Min.X = Left;
+        Bounds.Rect.Max.X = SphereResolution.X - Left;
+
+        const int32 Top = FMath::Clamp(FMath::RoundToInt(SphereResolution.Y * (90.f - MaxLatitude) / 180.f), 0, SphereResolution.Y - 2);
+        int32 Bottom = FMath::Clamp(FMath::RoundToInt(SphereResolution.Y * (90.f - MinLatitude) / 180.f), Top + 2, SphereResolution.Y);
+        if ((Bottom - Top) & 1)
+        {
+            Bottom += Bottom < SphereResolution.Y ? 1 : -1;
+        }
+        Bounds.Rect.Min.Y = Top;
+        Bounds.Rect.Max.Y = Bottom;
+        return Bounds;
+    }
+
+    uint8 GetVisibleFaces(const FPanoRegionBounds& Bounds, const FQuat& RigRotation)
+    {
+        constexpr uint8 AllFaces = (1 << FaceCount) - 1;
+        if (Bounds.IsFullSphere())
+        {
+            return AllFaces;
+        }
+
+        // Region edges as angles in the rig's frame, same convention as GetDirection in the equirect shader.
+        const double DegreesPerPixelX = 360.0 / Bounds.SphereResolution.X;
+        const double DegreesPerPixelY = 180.0 / Bounds.SphereResolution.Y;
+        const double MaxLongitude = (Bounds.Rect.Max.X - 0.5 * Bounds.SphereResolution.X) * DegreesPerPixelX + kRegionFaceMarginDegrees;
+        const double MaxLatitude = FMath::Min(90.0, 90.0 - Bounds.Rect.Min.Y * DegreesPerPixelY + kRegionFaceMarginDegrees);
+        const double MinLatitude = FMath::Max(-90.0, 90.0 - Bounds.Rect.Max.Y * DegreesPerPixelY - kRegionFaceMarginDegrees);
+        if (MaxLongitude >= 180.0 && MinLatitude <= -90.0 && MaxLatitude >= 90.0)
+        {
+            return AllFaces;
+        }
+
+        auto GetRigDirection = [&RigRotation](double LongitudeDegrees, double LatitudeDegrees)
+        {
+            const double Longitude = FMath::DegreesToRadians(LongitudeDegrees);
+            const double Latitude = FMath::DegreesToRadians(LatitudeDegrees);
+            return RigRotation.RotateVector(FVector(FMath::Cos(Latitude) * FMath::Cos(Longitude), FMath::Cos(Latitude) * FMath::Sin(Longitude), FMath::Sin(Latitude)));
+        };
+
+        // A face overlaps the region when the region's outline crosses it, or when it lies wholly inside the region,
+        // in which case its centre does. Walking the outline is far cheaper than probing the interior every frame.
+        uint8 Mask = 0;
+        const int32 ColumnSteps = FMath::CeilToInt32(2.0 * MaxLongitude / kRegionProbeStepDegrees);
+        const int32 RowSteps = FMath::CeilToInt32((MaxLatitude - MinLatitude) / kRegionProbeStepDegrees);
+        for (int32 Step = 0; Step <= ColumnSteps; ++Step)
+        {
+            const double Longitude = FMath::Lerp(-MaxLongitude, MaxLongitude, static_cast<double>(Step) / FMath::Max(ColumnSteps, 1));
+            Mask |= 1 << GetFaceIndex(GetRigDirection(Longitude, MinLatitude));
+            Mask |= 1 << GetFaceIndex(GetRigDirection(Longitude, MaxLatitude));
+        }
+        for (int32 Step = 0; Step <= RowSteps; ++Step)
+        {
+            const double Latitude = FMath::Lerp(MinLatitude, MaxLatitude, static_cast<double>(Step) / FMath::Max(RowSteps, 1));
+            Mask |= 1 << GetFaceIndex(GetRigDirection(-MaxLongitude, Latitude));
+            Mask |= 1 << GetFaceIndex(GetRigDirection(MaxLongitude, Latitude));
+        }
+
+        for (int32 Face = 0; Face < FaceCount; ++Face)
+        {
+            FVector Axis = FVector::ZeroVector;
+            Axis[Face / 2] = (Face & 1) ? -1.0 : 1.0;
+            const FVector Local = RigRotation.UnrotateVector(Axis);
+            const double Latitude = FMath::RadiansToDegrees(FMath::Asin(FMath::Clamp(Local.Z, -1.0, 1.0)));
+            const double Longitude = FMath::RadiansToDegrees(FMath::Atan2(Local.Y, Local.X));
+            const bool bAtPole = FMath::Abs(Latitude) > 89.9;
+            if (Latitude >= MinLatitude && Latitude <= MaxLatitude && (bAtPole || FMath::Abs(Longitude) <= MaxLongitude))
+            {
+                Mask |= 1 << Face;
+            }
+        }
+        return Mask;
+    }
+
+    FRotator GetFaceRotation(int32 Face)
+    {
+        // Forward and up of each face view in CalcCubeFaceViewRotationMatrix, which the cube capture renders with.
+        static const FVector Forward[FaceCount] = {
+            FVector(1.0, 0.0, 0.0), FVector(-1.0, 0.0, 0.0),
+            FVector(0.0, 1.0, 0.0), FVector(0.0, -1.0, 0.0),
+            FVector(0.0, 0.0, 1.0), FVector(0.0, 0.0, -1.0)
+        };
+        static const FVector Up[FaceCount] = {
+            FVector(0.0, 1.0, 0.0), FVector(0.0, 1.0, 0.0),
+            FVector(0.0, 0.0, -1.0), FVector(0.0, 0.0, 1.0),
+            FVector(0.0, 1.0, 0.0), FVector(0.0, 1.0, 0.0)
+        };
+        check(Face >= 0 && Face < FaceCount);
+        // A scene capture views along its X axis with Z up and Y to the right, and the cube view's right is Up x Forward.
+        return FRotationMatrix::MakeFromXZ(Forward[Face], Up[Face]).Rotator();
+    }
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PanoramaCaptureTypes.h"
+#include "PanoramaContainerWriter.h"
+
+/** A capture region snapped to whole pixels of the full-sphere equirect. */
+struct FPanoRegionBounds
+{
+    FIntPoint SphereResolution = FIntPoint::ZeroValue;
+    /** Crop of the full-sphere equirect the take outputs; Max is exclusive. */
+    FIntRect Rect;
+
+    bool IsFullSphere() const { return Rect.Min == FIntPoint::ZeroValue && Rect.Max == SphereResolution; }
+    FIntPoint GetSize() const { return Rect.Size(); }
+    FPanoEquirectCrop GetCrop() const;
+};
+
+namespace PanoramaCaptureRegion
+{
+    constexpr int32 FaceCount = 6;
+
+    /** Crop rectangle of Region in a SphereResolution equirect, centred on the rig's forward axis, with even sides for 4:2:0 encoders. */
+    FPanoRegionBounds Resolve(const FPanoCaptureRegion& Region, FIntPoint SphereResolution);
+
+    /**
+     * Bit N is set when cube face N (ECubeFace order: +X, -X, +Y, -Y, +Z, -Z of the world-aligned cube) is seen from
+     * inside Bounds with the rig at RigRotation. The region is widened by a small margin so filter taps and seamless
+     * filtering at a face edge find their neighbour rendered.
+     */
+    uint8 GetVisibleFaces(const FPanoRegionBounds& Bounds, const FQuat& RigRotation);
+
+    /** World rotation that makes a 90 degree SceneCapture2D render exactly what the cube capture renders into Face. */
+    FRotator GetFaceRotation(int32 Face);
+}
@@ -128,7 +128,12 @@ void APanoramaCaptureRigActor::UpdateStatusText()
         return;
     }
 
-    const EPanoramaCaptureStatus Status = CaptureComponent ? CaptureComponent->GetCaptureStatus() : EPanoramaCaptureStatus::Idle;
+    EPanoramaCaptureStatus Status = CaptureComponent ? CaptureComponent->GetCaptureStatus() : EPanoramaCaptureStatus::Idle;
+    // Stopped takes finalize in the background; show that while the component is otherwise idle.
+    if (Status == EPanoramaCaptureStatus::Idle && CaptureComponent && CaptureComponent->GetFinalizingSessionCount() > 0)
+    {
+        Status = EPanoramaCaptureStatus::Finalizing;
+    }
     FLinearColor Color = FLinearColor::Green;
     FString StatusLabel = TEXT("Idle");
 
@@ -0,0 +1,108 @@
+#include "PanoramaClockSimulation.h"
+
+#include "HAL/IConsoleManager.h"
+#include "Math/RandomStream.h"
+#include "PanoramaCaptureClock.h"
+
+FPanoClockSimulationResult PanoramaClockSimulation::Run(const FPanoClockSimulationParams& Params)
+{
+    constexpr int32 SampleRate = 48000;
+    constexpr int32 BlockFrames = 1024;
+    constexpr double CallbackJitterSeconds = 0.0005;
+    const double BlockSeconds = static_cast<double>(BlockFrames) / SampleRate;
+    const double DurationSeconds = Params.Minutes * 60.0;
+    const int64 TotalFrames = static_cast<int64>(DurationSeconds * Params.FrameRate);
+
+    FRandomStream Random(Params.Seed);
+    FPanoCaptureClock Clock(SampleRate);
+    Clock.Start(0.0);
+
+    FPanoClockSimulationResult Result;
+    Result.BlockFrames = BlockFrames;
+
+    // The device starts producing audio a little after recording starts.
+    const double AudioStartWall = 0.035;
+    int64 NextBlock = 0;
+    double NextFrameWall = 0.0;
+    double LastSessionSeconds = 0.0;
+    double SumErrorSamples = 0.0;
+    double FirstWindowError = 0.0;
+    double LastWindowError = 0.0;
+    int64 WindowFrames = 0;
+
+    while (NextFrameWall < DurationSeconds)
+    {
+        // Deliver every callback whose block finished rendering before this frame.
+        for (;;)
+        {
+            const double BlockEndWall = AudioStartWall + (NextBlock + 1) * BlockSeconds;
+            const double DeliveryWall = BlockEndWall + Random.FRandRange(0.0, CallbackJitterSeconds);
+            if (DeliveryWall > NextFrameWall)
+            {
+                break;
+            }
+            // The first block always arrives; it anchors the clock.
+            if (NextBlock == 0 || Random.FRand() >= Params.MissedBlockChance)
+            {
+                Clock.OnAudioCallback(AudioStartWall + NextBlock * BlockSeconds, BlockFrames, DeliveryWall);
+            }
+            ++NextBlock;
+        }
+
+        const double SessionSeconds = Clock.GetSessionSeconds(NextFrameWall);
+        Result.bMonotonic &= SessionSeconds >= LastSessionSeconds;
+        LastSessionSeconds = SessionSeconds;
+        if (Clock.HasAudio())
+        {
+            const double TrueSample = (NextFrameWall - AudioStartWall) * SampleRate;
+            const double Error = Clock.SessionSecondsToAudioSample(SessionSeconds) - TrueSample;
+            Result.MaxErrorSamples = FMath::Max(Result.MaxErrorSamples, FMath::Abs(Error));
+            SumErrorSamples += Error;
+            ++Result.LockedFrames;
+
+            if (Result.LockedFrames <= 1000)
+            {
+                FirstWindowError += Error / 1000.0;
+            }
+            if (Result.FrameCount >= TotalFrames - 1000)
+            {
+                LastWindowError += Error;
+                ++WindowFrames;
+            }
+        }
+
+        ++Result.FrameCount;
+        const bool bHitch = Random.FRand() < 0.002f;
+        NextFrameWall += 1.0 / Params.FrameRate + Random.FRandRange(-Params.JitterMs, Params.JitterMs) * 0.001 + (bHitch ? 0.1 : 0.0);
+    }
+
+    LastWindowError = WindowFrames > 0 ? LastWindowError / WindowFrames : 0.0;
+    Result.DriftSamples = LastWindowError - FirstWindowError;
+    Result.MeanErrorSamples = Result.LockedFrames > 0 ? SumErrorSamples / Result.LockedFrames : 0.0;
+    return Result;
+}
+
+namespace
+{
+    void RunClockSimulation(const TArray<FString>& Args)
+    {
+        FPanoClockSimulationParams Params;
+        Params.Minutes = Args.Num() > 0 ? FMath::Max(0.1, FCString::Atod(*Args[0])) : Params.Minutes;
+        Params.JitterMs = Args.Num() > 1 ? FMath::Max(0.0, FCString::Atod(*Args[1])) : Params.JitterMs;
+        Params.FrameRate = Args.Num() > 2 ? FMath::Max(1.0, FCString::Atod(*Args[2])) : Params.FrameRate;
+        Params.MissedBlockChance = Args.Num() > 3 ? FMath::Clamp(FCString::Atod(*Args[3]), 0.0, 0.5) : Params.MissedBlockChance;
+
+        const FPanoClockSimulationResult Result = PanoramaClockSimulation::Run(Params);
+        const bool bPass = Result.bMonotonic && FMath::Abs(Result.DriftSamples) < Result.BlockFrames && Result.MaxErrorSamples < Result.BlockFrames;
+
+        UE_LOG(LogTemp, Display, TEXT("Panorama clock simulation: %.1f min, %.0f fps, +/-%.1f ms frame jitter, %.1f%% missed blocks, %lld frames"),
+            Params.Minutes, Params.FrameRate, Params.JitterMs, Params.MissedBlockChance * 100.0, Result.FrameCount);
+        UE_LOG(LogTemp, Display, TEXT("  mean error %.1f samples, max |error| %.1f samples, drift %.1f samples (block %d) -> %s"),
+            Result.MeanErrorSamples, Result.MaxErrorSamples, Result.DriftSamples, Result.BlockFrames, bPass ? TEXT("PASS") : TEXT("FAIL"));
+    }
+
+    FAutoConsoleCommand GPanoramaClockSimulationCommand(
+        TEXT("Panorama.ClockSimulation"),
+        TEXT("Simulates jittery frame delivery against a steady audio clock and reports A/V error and drift in samples. Usage: Panorama.ClockSimulation [Minutes] [JitterMs] [FrameRate] [MissedBlockChance]"),
+        FConsoleCommandWithArgsDelegate::CreateStatic(&RunClockSimulation));
+}
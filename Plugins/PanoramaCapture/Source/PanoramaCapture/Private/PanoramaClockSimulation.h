@@ -0,0 +1,34 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** A simulated capture: steady audio device, jittery and occasionally hitching frame delivery. */
+struct FPanoClockSimulationParams
+{
+    double Minutes = 60.0;
+    double JitterMs = 8.0;
+    double FrameRate = 30.0;
+    /** Share of audio blocks the device renders without delivering a callback for them. */
+    double MissedBlockChance = 0.0;
+    uint32 Seed = 0x50414E4F;
+};
+
+/** Errors are in audio samples: the clock's sample position for a frame minus the true one. */
+struct FPanoClockSimulationResult
+{
+    int32 BlockFrames = 0;
+    int64 FrameCount = 0;
+    int64 LockedFrames = 0;
+    double MeanErrorSamples = 0.0;
+    double MaxErrorSamples = 0.0;
+    /** Mean error over the last 1000 frames minus the mean over the first 1000. */
+    double DriftSamples = 0.0;
+    /** Session time never went backwards between frames. */
+    bool bMonotonic = true;
+};
+
+namespace PanoramaClockSimulation
+{
+    /** Drives FPanoCaptureClock with the simulated devices and compares every frame against the true audio position. */
+    FPanoClockSimulationResult Run(const FPanoClockSimulationParams& Params);
+}
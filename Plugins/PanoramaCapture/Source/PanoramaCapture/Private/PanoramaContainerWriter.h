@@ -0,0 +1,120 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PanoramaCaptureTypes.h"
+
+/**
+ * Fractions of the full equirect cut from each side of the coded picture (of each eye when stereo). Written as the
+ * Spherical Video V2 projection bounds so players place a partial sphere correctly.
+ */
+struct FPanoEquirectCrop
+{
+    double Top = 0.0;
+    double Bottom = 0.0;
+    double Left = 0.0;
+    double Right = 0.0;
+
+    /** 0.32 fixed point, as the equi box and ProjectionPrivate store them. */
+    static uint32 ToFixed(double Fraction) { return static_cast<uint32>(FMath::Clamp(FMath::RoundToDouble(Fraction * 4294967296.0), 0.0, 4294967295.0)); }
+};
+
+/** Stream layout shared by the MP4 and Matroska writers. */
+struct FPanoContainerConfig
+{
+    EPanoramaCaptureCodec Codec = EPanoramaCaptureCodec::H264;
+    FIntPoint Resolution = FIntPoint::ZeroValue;
+    float FrameRate = 30.f;
+    /** Eyes stacked vertically, left eye on top. */
+    bool bStereoTopBottom = false;
+    FPanoEquirectCrop Crop;
+    /** avcC / hvcC record built from the stream's parameter sets. */
+    TArray<uint8> CodecConfig;
+
+    /** Zero disables the audio track. Audio is interleaved 16-bit little-endian PCM. */
+    int32 AudioSampleRate = 0;
+    int32 AudioChannels = 0;
+
+    /** Presentation delay of the first video frame / first audio sample; at most one of them is non-zero. */
+    double VideoDelaySeconds = 0.0;
+    double AudioDelaySeconds = 0.0;
+
+    bool HasAudio() const { return AudioSampleRate > 0 && AudioChannels > 0; }
+};
+
+/** One coded picture in decode order with 4-byte big-endian NAL length prefixes (parameter sets stripped). */
+struct FPanoVideoSample
+{
+    TArray<uint8> Data;
+    bool bKeyframe = false;
+    /** Picture order count from the first slice header; orders the pictures of a GOP for display. */
+    int32 PicOrderCnt = 0;
+    /** Presentation index minus decode index, in frames. Set by FPanoAnnexBParser::ResolvePresentationOrder. */
+    int32 CompositionOffset = 0;
+};
+
+/**
+ * Streaming container writer. Media arrives one fragment at a time: a run of video samples starting at
+ * FirstFrameIndex (normally one GOP) plus the audio sample frames that play alongside them.
+ */
+class IPanoContainerWriter
+{
+public:
+    virtual ~IPanoContainerWriter() = default;
+
+    virtual bool Open(const FString& Path, const FPanoContainerConfig& Config) = 0;
+    virtual bool WriteFragment(TArrayView<const FPanoVideoSample> Video, int64 FirstFrameIndex, TArrayView<const int16> Audio, int64 FirstAudioFrame) = 0;
+    /** Patches durations and indexes. Returns false if any write failed. */
+    virtual bool Close() = 0;
+    virtual const FString& GetPath() const = 0;
+};
+
+/** Big-endian appender used to build boxes and EBML elements in memory. */
+struct FPanoBigEndianWriter
+{
+    explicit FPanoBigEndianWriter(TArray<uint8>& InBuffer)
+        : Buffer(InBuffer)
+    {
+    }
+
+    void U8(uint32 Value) { Buffer.Add(static_cast<uint8>(Value)); }
+    void U16(uint32 Value) { U8(Value >> 8); U8(Value); }
+    void U24(uint32 Value) { U8(Value >> 16); U16(Value); }
+    void U32(uint32 Value) { U16(Value >> 16); U16(Value); }
+    void U64(uint64 Value) { U32(static_cast<uint32>(Value >> 32)); U32(static_cast<uint32>(Value)); }
+    void Zeros(int32 Count) { Buffer.AddZeroed(Count); }
+    void Bytes(const void* Data, int32 Count) { Buffer.Append(static_cast<const uint8*>(Data), Count); }
+    void Bytes(TArrayView<const uint8> Data) { Buffer.Append(Data.GetData(), Data.Num()); }
+    void Tag(const char* FourCC) { Bytes(FourCC, 4); }
+
+    /** Starts a size-prefixed ISO-BMFF box; pair with EndBox. */
+    int32 BeginBox(const char* FourCC)
+    {
+        const int32 Start = Buffer.Num();
+        U32(0);
+        Tag(FourCC);
+        return Start;
+    }
+
+    int32 BeginFullBox(const char* FourCC, uint8 Version, uint32 Flags)
+    {
+        const int32 Start = BeginBox(FourCC);
+        U8(Version);
+        U24(Flags);
+        return Start;
+    }
+
+    void EndBox(int32 Start)
+    {
+        PatchU32(Start, static_cast<uint32>(Buffer.Num() - Start));
+    }
+
+    void PatchU32(int32 Offset, uint32 Value)
+    {
+        Buffer[Offset + 0] = static_cast<uint8>(Value >> 24);
+        Buffer[Offset + 1] = static_cast<uint8>(Value >> 16);
+        Buffer[Offset + 2] = static_cast<uint8>(Value >> 8);
+        Buffer[Offset + 3] = static_cast<uint8>(Value);
+    }
+
+    TArray<uint8>& Buffer;
+};
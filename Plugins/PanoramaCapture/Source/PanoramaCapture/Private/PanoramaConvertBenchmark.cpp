@@ -0,0 +1,110 @@
+#include "CoreMinimal.h"
+#include "HAL/IConsoleManager.h"
+#include "Math/RandomStream.h"
+#include "PanoramaPixelConvert.h"
+
+namespace
+{
+    const TCHAR* GetKernelName(EPanoConvertKernel Kernel)
+    {
+        switch (Kernel)
+        {
+        case EPanoConvertKernel::Half: return TEXT("Half");
+        case EPanoConvertKernel::Unorm16: return TEXT("Unorm16");
+        case EPanoConvertKernel::Unorm16SRGB: return TEXT("Unorm16 sRGB");
+        case EPanoConvertKernel::Unorm8: return TEXT("Unorm8");
+        }
+        return TEXT("?");
+    }
+
+    /** Best of a few runs, in seconds. */
+    double TimeBest(const TFunctionRef<void()>& Body)
+    {
+        double Best = TNumericLimits<double>::Max();
+        for (int32 Run = 0; Run < 3; ++Run)
+        {
+            const double Start = FPlatformTime::Seconds();
+            Body();
+            Best = FMath::Min(Best, FPlatformTime::Seconds() - Start);
+        }
+        return Best;
+    }
+
+    /** Largest per-channel difference in code values between two converted buffers. For Half, compares raw encodings. */
+    int32 MaxCodeDifference(EPanoConvertKernel Kernel, const TArray64<uint8>& A, const TArray64<uint8>& B, int64 Count)
+    {
+        int32 MaxDifference = 0;
+        for (int64 Index = 0; Index < Count; ++Index)
+        {
+            int32 ValueA;
+            int32 ValueB;
+            if (PanoramaPixelConvert::GetDestBytesPerChannel(Kernel) == 2)
+            {
+                ValueA = reinterpret_cast<const uint16*>(A.GetData())[Index];
+                ValueB = reinterpret_cast<const uint16*>(B.GetData())[Index];
+            }
+            else
+            {
+                ValueA = A[Index];
+                ValueB = B[Index];
+            }
+            MaxDifference = FMath::Max(MaxDifference, FMath::Abs(ValueA - ValueB));
+        }
+        return MaxDifference;
+    }
+
+    void RunConvertBenchmark(const TArray<FString>& Args)
+    {
+        const int32 Width = Args.Num() > 0 ? FMath::Max(4, FCString::Atoi(*Args[0])) : 7680;
+        const int32 Height = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 7680;
+        const int64 FloatsPerRow = static_cast<int64>(Width) * 4;
+        const int64 Count = FloatsPerRow * Height;
+
+        // Slightly out of [0, 1] so the clamps are exercised.
+        TArray64<float> Source;
+        Source.SetNumUninitialized(Count);
+        FRandomStream Random(0x50414E4F);
+        for (float& Value : Source)
+        {
+            Value = Random.FRandRange(-0.05f, 1.05f);
+        }
+
+        TArray64<uint8> Reference;
+        TArray64<uint8> Output;
+        Reference.SetNumUninitialized(Count * 2);
+        Output.SetNumUninitialized(Count * 2);
+
+        constexpr double BytesPerGigabyte = 1024.0 * 1024.0 * 1024.0;
+        const double SourceGigabytes = Count * sizeof(float) / BytesPerGigabyte;
+        UE_LOG(LogTemp, Display, TEXT("Panorama convert benchmark: %dx%d RGBA float (%.2f GB), SIMD %s"),
+            Width, Height, SourceGigabytes, PanoramaPixelConvert::HasSimd() ? TEXT("SSE4.1") : TEXT("unavailable (scalar fallback)"));
+
+        const EPanoConvertKernel Kernels[] = { EPanoConvertKernel::Half, EPanoConvertKernel::Unorm16, EPanoConvertKernel::Unorm16SRGB, EPanoConvertKernel::Unorm8 };
+        for (EPanoConvertKernel Kernel : Kernels)
+        {
+            const double ScalarSeconds = TimeBest([&]()
+            {
+                PanoramaPixelConvert::Convert(Kernel, Source.GetData(), Reference.GetData(), Count, false);
+            });
+            const double SimdSeconds = TimeBest([&]()
+            {
+                PanoramaPixelConvert::Convert(Kernel, Source.GetData(), Output.GetData(), Count, true);
+            });
+            const int32 SimdDifference = MaxCodeDifference(Kernel, Reference, Output, Count);
+            const double ParallelSeconds = TimeBest([&]()
+            {
+                PanoramaPixelConvert::ConvertRows(Kernel, Source.GetData(), Output.GetData(), FloatsPerRow, Height, true);
+            });
+            const int32 ParallelDifference = MaxCodeDifference(Kernel, Reference, Output, Count);
+
+            UE_LOG(LogTemp, Display, TEXT("  %-13s scalar %6.2f GB/s  simd %6.2f GB/s  simd+rows %6.2f GB/s  max diff vs scalar %d / %d"),
+                GetKernelName(Kernel), SourceGigabytes / ScalarSeconds, SourceGigabytes / SimdSeconds, SourceGigabytes / ParallelSeconds,
+                SimdDifference, ParallelDifference);
+        }
+    }
+
+    FAutoConsoleCommand GPanoramaConvertBenchmarkCommand(
+        TEXT("Panorama.ConvertBenchmark"),
+        TEXT("Times the scalar and SIMD float pixel conversion kernels, single-threaded and row-parallel, and checks SIMD output against scalar. Usage: Panorama.ConvertBenchmark [Width] [Height]"),
+        FConsoleCommandWithArgsDelegate::CreateStatic(&RunConvertBenchmark));
+}
@@ -1,6 +1,31 @@
 #include "PanoramaCubemapToEquirectCS.h"
 
 #include "RenderGraph.h"
+#include "RenderGraphBuilder.h"
+#include "RenderTargetPool.h"
 #include "ShaderCompilerCore.h"
+#include "PanoramaEquirectLut.h"
 
 IMPLEMENT_GLOBAL_SHADER(FPanoCubemapToEquirectCS, "/PanoramaCapture/PanoramaCubemapToEquirect.usf", "Main", SF_Compute);
+
+FPanoEquirectLutTexture::FPanoEquirectLutTexture(FIntPoint InResolution)
+    : Resolution(InResolution)
+{
+}
+
+void FPanoEquirectLutTexture::InitRHI(FRHICommandListBase& RHICmdList)
+{
+    const FRHITextureCreateDesc Desc = FRHITextureCreateDesc::Create2D(TEXT("PanoramaEquirectLut"), Resolution.X, Resolution.Y, PanoramaEquirectLut::GetPixelFormat())
+        .SetFlags(ETextureCreateFlags::UAV | ETextureCreateFlags::ShaderResource)
+        .SetInitialState(ERHIAccess::SRVCompute);
+    TextureRHI = RHICreateTexture(Desc);
+}
+
+FRDGTextureRef FPanoEquirectTextureCache::Register(FRDGBuilder& GraphBuilder, TRefCountPtr<IPooledRenderTarget>& Slot, FRHITexture* Texture, const TCHAR* Name)
+{
+    if (!Slot.IsValid() || Slot->GetRHI() != Texture)
+    {
+        Slot = CreateRenderTarget(Texture, Name);
+    }
+    return GraphBuilder.RegisterExternalTexture(Slot);
+}
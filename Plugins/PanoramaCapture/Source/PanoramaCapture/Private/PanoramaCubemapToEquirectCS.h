@@ -2,28 +2,114 @@
 
 #include "CoreMinimal.h"
 #include "GlobalShader.h"
+#include "RenderResource.h"
 #include "ShaderParameterStruct.h"
+#include "RenderGraphResources.h"
+#include "PanoramaCaptureTypes.h"
 
+class FRDGBuilder;
+
+/** Variants of the equirect pass. Values match EQUIRECT_PASS in PanoramaCubemapToEquirect.usf. */
+enum class EPanoEquirectPass : uint8
+{
+    /** Computes the direction of every pixel with trig. */
+    Analytic = 0,
+    /** Reads the direction from a lookup table built by BuildLut. */
+    Lookup = 1,
+    /** Writes the analytic directions into the lookup table instead of sampling the cube. */
+    BuildLut = 2,
+};
+
+/** Samples the world-aligned capture cube along each equirect pixel's direction, turned by the rig's rotation. */
 class FPanoCubemapToEquirectCS : public FGlobalShader
 {
     DECLARE_GLOBAL_SHADER(FPanoCubemapToEquirectCS);
     SHADER_USE_PARAMETER_STRUCT(FPanoCubemapToEquirectCS, FGlobalShader);
 
+    class FPassDim : SHADER_PERMUTATION_INT("EQUIRECT_PASS", 3);
+    /** EPanoramaResampleFilter; bilinear keeps the single-fetch fast path. */
+    class FFilterDim : SHADER_PERMUTATION_INT("RESAMPLE_FILTER", 4);
+    using FPermutationDomain = TShaderPermutationDomain<FPassDim, FFilterDim>;
+
     BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
-        SHADER_PARAMETER_ARRAY(FMatrix44f, ViewMatrices, [6])
+        SHADER_PARAMETER(FMatrix44f, RigToWorld)
         SHADER_PARAMETER(FVector2f, OutputResolution)
-        SHADER_PARAMETER(FVector2f, InvOutputResolution)
+        SHADER_PARAMETER(FVector2f, InvSphereResolution)
+        SHADER_PARAMETER(FVector2f, SphereOffset)
         SHADER_PARAMETER(FVector2f, FullResolution)
         SHADER_PARAMETER(FVector2f, OutputOffset)
         SHADER_PARAMETER(float, bLinearColorSpace)
-        SHADER_PARAMETER_RDG_TEXTURE_SRV_ARRAY(Texture2D<float4>, FaceTextures, [6])
+        SHADER_PARAMETER(float, FaceSize)
+        SHADER_PARAMETER(uint32, SupersampleCount)
+        SHADER_PARAMETER_RDG_TEXTURE(TextureCube, FaceCube)
         SHADER_PARAMETER_SAMPLER(SamplerState, FaceSampler)
         SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D<float4>, OutputTexture)
+        SHADER_PARAMETER_RDG_TEXTURE(Texture2D<uint4>, DirectionLut)
+        SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D<uint4>, LutOutput)
     END_SHADER_PARAMETER_STRUCT()
 
 public:
     static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
     {
-        return Parameters.Platform == SP_PCD3D_SM5 || Parameters.Platform == SP_PCD3D_SM6;
+        if (Parameters.Platform != SP_PCD3D_SM5 && Parameters.Platform != SP_PCD3D_SM6)
+        {
+            return false;
+        }
+        // The table build never samples, and supersampling computes its sub-pixel directions instead of reading the table.
+        const FPermutationDomain PermutationVector(Parameters.PermutationId);
+        const EPanoEquirectPass Pass = static_cast<EPanoEquirectPass>(PermutationVector.Get<FPassDim>());
+        const EPanoramaResampleFilter Filter = static_cast<EPanoramaResampleFilter>(PermutationVector.Get<FFilterDim>());
+        if (Pass == EPanoEquirectPass::BuildLut)
+        {
+            return Filter == EPanoramaResampleFilter::Bilinear;
+        }
+        return !(Pass == EPanoEquirectPass::Lookup && Filter == EPanoramaResampleFilter::Supersampled);
     }
 };
+
+/** Per-eye equirect lookup table (rig-local direction per pixel), written by the BuildLut pass. */
+class FPanoEquirectLutTexture : public FTexture
+{
+public:
+    explicit FPanoEquirectLutTexture(FIntPoint InResolution);
+
+    virtual void InitRHI(FRHICommandListBase& RHICmdList) override;
+    virtual uint32 GetSizeX() const override { return Resolution.X; }
+    virtual uint32 GetSizeY() const override { return Resolution.Y; }
+
+    FIntPoint GetResolution() const { return Resolution; }
+
+private:
+    FIntPoint Resolution;
+};
+
+/**
+ * Render thread: pooled-target wrappers of the persistent textures the frame graph reads and writes. RDG needs one
+ * to register an external texture; keeping them across frames avoids re-creating them on every frame. Registering
+ * the same texture twice in one graph returns the same RDG texture. Dropped together with the render targets they wrap.
+ */
+struct FPanoEquirectTextureCache
+{
+    /** Serial stereo renders each eye into its own cube; every other path only uses eye 0's. */
+    FRDGTextureRef RegisterCube(FRDGBuilder& GraphBuilder, int32 EyeIndex, FRHITexture* Texture) { return Register(GraphBuilder, Cubes[EyeIndex], Texture, TEXT("PanoramaCube")); }
+    FRDGTextureRef RegisterOutput(FRDGBuilder& GraphBuilder, FRHITexture* Texture) { return Register(GraphBuilder, Output, Texture, TEXT("PanoramaEquirect")); }
+    FRDGTextureRef RegisterLut(FRDGBuilder& GraphBuilder, FRHITexture* Texture) { return Register(GraphBuilder, Lut, Texture, TEXT("PanoramaEquirectLut")); }
+    /** Face rendered on its own for a partial region, copied into the cube before sampling. */
+    FRDGTextureRef RegisterFace(FRDGBuilder& GraphBuilder, int32 EyeIndex, int32 Face, FRHITexture* Texture) { return Register(GraphBuilder, Faces[EyeIndex][Face], Texture, TEXT("PanoramaCubeFace")); }
+    /** ODS slice atlas the stitch pass reads. */
+    FRDGTextureRef RegisterOdsAtlas(FRDGBuilder& GraphBuilder, FRHITexture* Texture) { return Register(GraphBuilder, OdsAtlas, Texture, TEXT("PanoramaOdsAtlas")); }
+    /** Targets of the frame's output steps: the preview downsample and the pack pass. */
+    FRDGTextureRef RegisterPreview(FRDGBuilder& GraphBuilder, FRHITexture* Texture) { return Register(GraphBuilder, Preview, Texture, TEXT("PanoramaPreview")); }
+    FRDGTextureRef RegisterPacked(FRDGBuilder& GraphBuilder, FRHITexture* Texture) { return Register(GraphBuilder, Packed, Texture, TEXT("PanoramaPacked")); }
+
+private:
+    static FRDGTextureRef Register(FRDGBuilder& GraphBuilder, TRefCountPtr<IPooledRenderTarget>& Slot, FRHITexture* Texture, const TCHAR* Name);
+
+    TRefCountPtr<IPooledRenderTarget> Cubes[2];
+    TRefCountPtr<IPooledRenderTarget> Output;
+    TRefCountPtr<IPooledRenderTarget> Lut;
+    TRefCountPtr<IPooledRenderTarget> Faces[2][6];
+    TRefCountPtr<IPooledRenderTarget> OdsAtlas;
+    TRefCountPtr<IPooledRenderTarget> Preview;
+    TRefCountPtr<IPooledRenderTarget> Packed;
+};
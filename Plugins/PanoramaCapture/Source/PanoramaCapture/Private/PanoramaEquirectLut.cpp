@@ -0,0 +1,84 @@
+#include "PanoramaEquirectLut.h"
+
+#include "Async/ParallelFor.h"
+
+namespace
+{
+    // Keep in sync with LUT_SCALE in PanoramaCubemapToEquirect.usf.
+    constexpr float kLutDirectionScale = 65535.0f;
+
+    uint16 EncodeComponent(float Value)
+    {
+        return static_cast<uint16>(FMath::Clamp(Value * 0.5f + 0.5f, 0.0f, 1.0f) * kLutDirectionScale + 0.5f);
+    }
+}
+
+namespace PanoramaEquirectLut
+{
+    EPixelFormat GetPixelFormat()
+    {
+        return PF_R16G16B16A16_UINT;
+    }
+
+    FVector3f GetPixelDirection(FIntPoint Pixel, FIntPoint Resolution)
+    {
+        const float U = (Pixel.X + 0.5f) * (1.0f / Resolution.X);
+        const float V = (Pixel.Y + 0.5f) * (1.0f / Resolution.Y);
+        const float Phi = (U - 0.5f) * (2.0f * UE_PI);
+        const float Theta = (0.5f - V) * UE_PI;
+        return FVector3f(FMath::Cos(Theta) * FMath::Cos(Phi), FMath::Cos(Theta) * FMath::Sin(Phi), FMath::Sin(Theta));
+    }
+
+    void EncodeTexel(const FVector3f& Direction, uint16* OutTexel)
+    {
+        OutTexel[0] = EncodeComponent(Direction.X);
+        OutTexel[1] = EncodeComponent(Direction.Y);
+        OutTexel[2] = EncodeComponent(Direction.Z);
+        OutTexel[3] = 0;
+    }
+
+    FVector3f DecodeTexel(const uint16* Texel)
+    {
+        return FVector3f(
+            Texel[0] * (2.0f / kLutDirectionScale) - 1.0f,
+            Texel[1] * (2.0f / kLutDirectionScale) - 1.0f,
+            Texel[2] * (2.0f / kLutDirectionScale) - 1.0f);
+    }
+
+    void BuildReference(FIntPoint Resolution, uint16* OutTexels)
+    {
+        ParallelFor(Resolution.Y, [Resolution, OutTexels](int32 Row)
+        {
+            uint16* RowTexels = OutTexels + static_cast<int64>(Row) * Resolution.X * kTexelChannels;
+            for (int32 X = 0; X < Resolution.X; ++X)
+            {
+                EncodeTexel(GetPixelDirection(FIntPoint(X, Row), Resolution), RowTexels + static_cast<int64>(X) * kTexelChannels);
+            }
+        });
+    }
+
+    double GetMaxDecodeError(FIntPoint Resolution, const uint16* Texels)
+    {
+        TArray<double> RowMaxAngle;
+        RowMaxAngle.SetNumZeroed(Resolution.Y);
+        ParallelFor(Resolution.Y, [Resolution, Texels, &RowMaxAngle](int32 Row)
+        {
+            const uint16* RowTexels = Texels + static_cast<int64>(Row) * Resolution.X * kTexelChannels;
+            for (int32 X = 0; X < Resolution.X; ++X)
+            {
+                const FVector3d Exact(GetPixelDirection(FIntPoint(X, Row), Resolution));
+                const FVector3d Decoded(DecodeTexel(RowTexels + static_cast<int64>(X) * kTexelChannels));
+                // The errors are a few 1e-5 rad, where acos of a float dot product only resolves steps of about 3e-4.
+                const double Angle = FMath::Atan2(FVector3d::CrossProduct(Exact, Decoded).Size(), FVector3d::DotProduct(Exact, Decoded));
+                RowMaxAngle[Row] = FMath::Max(RowMaxAngle[Row], Angle);
+            }
+        });
+
+        double MaxAngle = 0.0;
+        for (double Angle : RowMaxAngle)
+        {
+            MaxAngle = FMath::Max(MaxAngle, Angle);
+        }
+        return MaxAngle;
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PixelFormat.h"
+
+/**
+ * CPU reference of the equirect pixel directions in PanoramaCubemapToEquirect.usf and of the lookup table its
+ * BuildLut pass writes.
+ *
+ * Each texel holds four uint16: the rig-local direction's X, Y and Z as (d * 0.5 + 0.5) in steps of 1/65535, and
+ * zero. The table depends only on the output resolution; the rig's rotation is applied when sampling. The math follows
+ * the shader operation for operation, so results differ from the GPU only by the trig implementation, which is far
+ * below one step of the table. Lets the table be built, decoded and checked on machines without a GPU.
+ */
+namespace PanoramaEquirectLut
+{
+    constexpr int32 kTexelChannels = 4;
+
+    EPixelFormat GetPixelFormat();
+
+    /** Rig-local direction through the centre of Pixel in a Resolution-sized equirect: +X at the image centre, +Y right, +Z up. */
+    FVector3f GetPixelDirection(FIntPoint Pixel, FIntPoint Resolution);
+
+    void EncodeTexel(const FVector3f& Direction, uint16* OutTexel);
+
+    /** Not renormalized, like the shader's lookup pass. */
+    FVector3f DecodeTexel(const uint16* Texel);
+
+    /** Fills Resolution.X * Resolution.Y * kTexelChannels values, split into row bands on the task graph. */
+    void BuildReference(FIntPoint Resolution, uint16* OutTexels);
+
+    /** Largest angle, in radians, between a decoded texel of a Resolution-sized table and its pixel's exact direction. */
+    double GetMaxDecodeError(FIntPoint Resolution, const uint16* Texels);
+}
@@ -0,0 +1,82 @@
+#include "CoreMinimal.h"
+#include "HAL/IConsoleManager.h"
+#include "Async/ParallelFor.h"
+#include "PanoramaEquirectLut.h"
+
+namespace
+{
+    /** Best of a few runs, in seconds. */
+    double TimeBestLutRun(const TFunctionRef<void()>& Body)
+    {
+        double Best = TNumericLimits<double>::Max();
+        for (int32 Run = 0; Run < 3; ++Run)
+        {
+            const double Start = FPlatformTime::Seconds();
+            Body();
+            Best = FMath::Min(Best, FPlatformTime::Seconds() - Start);
+        }
+        return Best;
+    }
+
+    /**
+     * Builds the equirect lookup table on the CPU, times it against computing every pixel's direction, and measures the
+     * angle between each decoded direction and the exact one. GPU timings of both modes are in "stat gpu".
+     */
+    void RunEquirectLutCheck(const TArray<FString>& Args)
+    {
+        const int32 Width = Args.Num() > 0 ? FMath::Max(8, FCString::Atoi(*Args[0])) : 7680;
+        const int32 Height = Args.Num() > 1 ? FMath::Max(4, FCString::Atoi(*Args[1])) : 3840;
+        const int32 FaceSize = Args.Num() > 2 ? FMath::Max(1, FCString::Atoi(*Args[2])) : 4096;
+        const FIntPoint Resolution(Width, Height);
+
+        const int64 PixelCount = static_cast<int64>(Width) * Height;
+        TArray64<uint16> Texels;
+        Texels.SetNumUninitialized(PixelCount * PanoramaEquirectLut::kTexelChannels);
+        TArray64<FVector3f> Directions;
+        Directions.SetNumUninitialized(PixelCount);
+
+        const double AnalyticSeconds = TimeBestLutRun([&]()
+        {
+            ParallelFor(Height, [&](int32 Row)
+            {
+                for (int32 X = 0; X < Width; ++X)
+                {
+                    Directions[static_cast<int64>(Row) * Width + X] = PanoramaEquirectLut::GetPixelDirection(FIntPoint(X, Row), Resolution);
+                }
+            });
+        });
+        const double BuildSeconds = TimeBestLutRun([&]()
+        {
+            PanoramaEquirectLut::BuildReference(Resolution, Texels.GetData());
+        });
+        const double LookupSeconds = TimeBestLutRun([&]()
+        {
+            ParallelFor(Height, [&](int32 Row)
+            {
+                for (int32 X = 0; X < Width; ++X)
+                {
+                    const int64 Index = static_cast<int64>(Row) * Width + X;
+                    Directions[Index] = PanoramaEquirectLut::DecodeTexel(Texels.GetData() + Index * PanoramaEquirectLut::kTexelChannels);
+                }
+            });
+        });
+
+        const float MaxAngle = static_cast<float>(PanoramaEquirectLut::GetMaxDecodeError(Resolution, Texels.GetData()));
+
+        // One output pixel spans 2*pi/Width at the equator; one face texel spans at most (pi/2)/FaceSize.
+        const float OutputPixels = MaxAngle * Width / (2.0f * UE_PI);
+        const float FaceTexels = MaxAngle * FaceSize / (0.5f * UE_PI);
+
+        UE_LOG(LogTemp, Display, TEXT("Panorama equirect LUT check: %dx%d, %d px faces, table %.1f MB"),
+            Width, Height, FaceSize, Texels.Num() * sizeof(uint16) / (1024.0 * 1024.0));
+        UE_LOG(LogTemp, Display, TEXT("  CPU analytic %.2f ms  build %.2f ms  lookup %.2f ms"),
+            AnalyticSeconds * 1000.0, BuildSeconds * 1000.0, LookupSeconds * 1000.0);
+        UE_LOG(LogTemp, Display, TEXT("  max direction error %.3g rad = %.4f output pixels = %.4f face texels"),
+            MaxAngle, OutputPixels, FaceTexels);
+    }
+
+    FAutoConsoleCommand GPanoramaEquirectLutCheckCommand(
+        TEXT("Panorama.EquirectLutCheck"),
+        TEXT("Builds the equirect lookup table on the CPU, times it against the analytic mapping and measures the decoded directions against it. Usage: Panorama.EquirectLutCheck [Width] [Height] [FaceSize]"),
+        FConsoleCommandWithArgsDelegate::CreateStatic(&RunEquirectLutCheck));
+}
@@ -0,0 +1,26 @@
+#include "PanoramaFrameGraph.h"
+
+#include "RenderGraphBuilder.h"
+#include "RenderGraphEvent.h"
+#include "RenderingThread.h"
+
+void FPanoFrameGraph::Submit()
+{
+    if (Passes.Num() == 0)
+    {
+        return;
+    }
+
+    ENQUEUE_RENDER_COMMAND(PanoramaCapture_FrameGraph)(
+        [Passes = MoveTemp(Passes)](FRHICommandListImmediate& RHICmdList) mutable
+        {
+            // Named so the whole frame shows up as one graph in an RDG insights trace.
+            FRDGBuilder GraphBuilder(RHICmdList, RDG_EVENT_NAME("PanoramaFrame"));
+            for (FPass& Pass : Passes)
+            {
+                Pass(GraphBuilder);
+            }
+            GraphBuilder.Execute();
+        });
+    Passes.Reset();
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FRDGBuilder;
+
+/**
+ * Game thread: collects the GPU work of one captured frame (face copies, equirect or ODS stitch, preview downsample,
+ * pack and readback copy) and submits it as a single render graph. One builder per frame means the persistent textures are
+ * registered once and RDG places the barriers between the steps, instead of every step paying for its own graph.
+ * Scene captures are not part of it: every eye renders into its own targets before the frame's single submit.
+ */
+class FPanoFrameGraph
+{
+public:
+    /** Render thread: adds its passes to the frame's builder. */
+    using FPass = TUniqueFunction<void(FRDGBuilder& GraphBuilder)>;
+
+    void AddPass(FPass&& Pass) { Passes.Add(MoveTemp(Pass)); }
+    bool IsEmpty() const { return Passes.Num() == 0; }
+
+    /** Enqueues one render command that builds every pass recorded since the last submit into one graph and executes it. */
+    void Submit();
+
+private:
+    TArray<FPass> Passes;
+};
@@ -0,0 +1,88 @@
+#include "PanoramaFrameRingBuffer.h"
+
+FPanoFrameRingBuffer::FPanoFrameRingBuffer(int32 InCapacity, int64 InSlabBytes)
+    : Capacity(FMath::Max(1, InCapacity))
+    , SlabBytes(FMath::Max<int64>(0, InSlabBytes))
+    , WriteCursor(0)
+    , ReadCursor(0)
+    , QueuedCount(0)
+{
+    Slots = MakeUnique<FSlot[]>(Capacity);
+    for (int32 Index = 0; Index < Capacity; ++Index)
+    {
+        FPanoCaptureFrame& Frame = Slots[Index].Frame;
+        Frame.SlotIndex = Index;
+        Frame.PixelData.SetNumUninitialized(SlabBytes);
+    }
+}
+
+FPanoFrameRingBuffer::FSlot& FPanoFrameRingBuffer::GetSlot(const FPanoCaptureFrame* Frame) const
+{
+    check(Frame && Frame->SlotIndex >= 0 && Frame->SlotIndex < Capacity);
+    return Slots[Frame->SlotIndex];
+}
+
+FPanoCaptureFrame* FPanoFrameRingBuffer::AcquireWriteSlot()
+{
+    FSlot& Slot = Slots[WriteCursor % Capacity];
+    if (Slot.State.load(std::memory_order_acquire) != ESlotState::Free)
+    {
+        return nullptr;
+    }
+
+    Slot.State.store(ESlotState::Writing, std::memory_order_relaxed);
+    ++WriteCursor;
+    return &Slot.Frame;
+}
+
+void FPanoFrameRingBuffer::CommitWriteSlot(FPanoCaptureFrame* Frame)
+{
+    FSlot& Slot = GetSlot(Frame);
+    check(Slot.State.load(std::memory_order_relaxed) == ESlotState::Writing);
+
+    Frame->CommitTimeSeconds = FPlatformTime::Seconds();
+    QueuedCount.fetch_add(1, std::memory_order_relaxed);
+    Slot.State.store(ESlotState::Committed, std::memory_order_release);
+}
+
+void FPanoFrameRingBuffer::CancelWriteSlot(FPanoCaptureFrame* Frame)
+{
+    FSlot& Slot = GetSlot(Frame);
+    check(Slot.State.load(std::memory_order_relaxed) == ESlotState::Writing);
+    Slot.State.store(ESlotState::Cancelled, std::memory_order_release);
+}
+
+FPanoCaptureFrame* FPanoFrameRingBuffer::AcquireReadSlot()
+{
+    FSlot* SlotPtr = &Slots[ReadCursor % Capacity];
+    ESlotState State = SlotPtr->State.load(std::memory_order_acquire);
+
+    // Cancelled reservations are recycled here so they cannot stall the slots behind them.
+    while (State == ESlotState::Cancelled)
+    {
+        SlotPtr->Frame.NumBytes = 0;
+        SlotPtr->State.store(ESlotState::Free, std::memory_order_release);
+        ++ReadCursor;
+        SlotPtr = &Slots[ReadCursor % Capacity];
+        State = SlotPtr->State.load(std::memory_order_acquire);
+    }
+
+    if (State != ESlotState::Committed)
+    {
+        return nullptr;
+    }
+
+    FSlot& Slot = *SlotPtr;
+    Slot.State.store(ESlotState::Reading, std::memory_order_relaxed);
+    ++ReadCursor;
+    QueuedCount.fetch_sub(1, std::memory_order_relaxed);
+    return &Slot.Frame;
+}
+
+void FPanoFrameRingBuffer::ReleaseSlot(FPanoCaptureFrame* Frame)
+{
+    FSlot& Slot = GetSlot(Frame);
+    check(Slot.State.load(std::memory_order_relaxed) == ESlotState::Reading);
+    Frame->NumBytes = 0;
+    Slot.State.store(ESlotState::Free, std::memory_order_release);
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include <atomic>
+
+/** A captured equirect frame. PixelData is a slab owned by the ring and reused for every frame written to the slot. */
+struct FPanoCaptureFrame
+{
+    uint64 FrameIndex = 0;
+    double Timecode = 0.0;
+    /** FPlatformTime::Seconds() when the producer committed the slot. */
+    double CommitTimeSeconds = 0.0;
+    FIntPoint Resolution = FIntPoint::ZeroValue;
+    bool bLinear = false;
+    bool b16Bit = false;
+
+    /** Number of valid bytes at the start of PixelData. */
+    int64 NumBytes = 0;
+    TArray64<uint8> PixelData;
+
+    /** Index of the owning ring slot. */
+    int32 SlotIndex = INDEX_NONE;
+};
+
+/**
+ * Lock-free single-producer/single-consumer ring of preallocated frame slots.
+ *
+ * The game thread acquires (reserves) free slots in order. Readback data is written straight into a
+ * reserved slab and the slot is committed, possibly later and from another thread such as the render
+ * thread completing an async readback. The capture worker reads slots in reservation order and
+ * releases each one once its pixels are no longer referenced. Release may happen on any thread; the
+ * producer only reuses a slot after it has been released, so a slow encoder applies backpressure
+ * instead of forcing new allocations.
+ */
+class FPanoFrameRingBuffer
+{
+public:
+    FPanoFrameRingBuffer(int32 InCapacity, int64 InSlabBytes);
+
+    /** Producer: reserves the next free slot, or returns nullptr when every slot is still in use. */
+    FPanoCaptureFrame* AcquireWriteSlot();
+
+    /** Publishes a reserved slot to the consumer. Safe to call from any thread. */
+    void CommitWriteSlot(FPanoCaptureFrame* Frame);
+
+    /** Abandons a reserved slot; the consumer skips it. Safe to call from any thread. */
+    void CancelWriteSlot(FPanoCaptureFrame* Frame);
+
+    /** Consumer: returns the oldest committed slot, or nullptr when nothing is queued. */
+    FPanoCaptureFrame* AcquireReadSlot();
+
+    /** Hands a slot obtained from AcquireReadSlot back to the producer. Safe to call from any thread. */
+    void ReleaseSlot(FPanoCaptureFrame* Frame);
+
+    /** Number of committed slots the consumer has not picked up yet. */
+    int32 Num() const { return QueuedCount.load(std::memory_order_acquire); }
+
+    int32 GetCapacity() const { return Capacity; }
+    int64 GetSlabBytes() const { return SlabBytes; }
+
+private:
+    enum class ESlotState : uint8
+    {
+        Free,
+        Writing,
+        Committed,
+        Cancelled,
+        Reading
+    };
+
+    struct FSlot
+    {
+        FPanoCaptureFrame Frame;
+        std::atomic<ESlotState> State{ESlotState::Free};
+    };
+
+    FSlot& GetSlot(const FPanoCaptureFrame* Frame) const;
+
+    TUniquePtr<FSlot[]> Slots;
+    int32 Capacity;
+    int64 SlabBytes;
+
+    alignas(PLATFORM_CACHE_LINE_SIZE) uint64 WriteCursor;
+    alignas(PLATFORM_CACHE_LINE_SIZE) uint64 ReadCursor;
+    alignas(PLATFORM_CACHE_LINE_SIZE) std::atomic<int32> QueuedCount;
+};
@@ -0,0 +1,89 @@
+#include "PanoramaLatencyHistogram.h"
+
+FPanoLatencyHistogram::FPanoLatencyHistogram()
+{
+    Reset();
+}
+
+void FPanoLatencyHistogram::Reset()
+{
+    for (std::atomic<uint64>& Bucket : Buckets)
+    {
+        Bucket.store(0, std::memory_order_relaxed);
+    }
+    SampleCount.store(0, std::memory_order_relaxed);
+    TotalMicroseconds.store(0, std::memory_order_relaxed);
+    MaxMicroseconds.store(0, std::memory_order_relaxed);
+}
+
+int32 FPanoLatencyHistogram::BucketForMicroseconds(uint64 Microseconds)
+{
+    if (Microseconds <= 1)
+    {
+        return 0;
+    }
+
+    const double Octaves = FMath::Log2(static_cast<double>(Microseconds));
+    return FMath::Clamp(FMath::CeilToInt32(Octaves * kBucketsPerOctave), 0, kBucketCount - 1);
+}
+
+double FPanoLatencyHistogram::BucketUpperBoundMs(int32 Bucket)
+{
+    return FMath::Pow(2.0, static_cast<double>(Bucket) / kBucketsPerOctave) / 1000.0;
+}
+
+void FPanoLatencyHistogram::Record(double Seconds)
+{
+    const uint64 Microseconds = static_cast<uint64>(FMath::Max(0.0, Seconds) * 1000000.0);
+
+    Buckets[BucketForMicroseconds(Microseconds)].fetch_add(1, std::memory_order_relaxed);
+    TotalMicroseconds.fetch_add(Microseconds, std::memory_order_relaxed);
+    SampleCount.fetch_add(1, std::memory_order_relaxed);
+
+    uint64 PreviousMax = MaxMicroseconds.load(std::memory_order_relaxed);
+    while (Microseconds > PreviousMax && !MaxMicroseconds.compare_exchange_weak(PreviousMax, Microseconds, std::memory_order_relaxed))
+    {
+    }
+}
+
+FPanoLatencyStats FPanoLatencyHistogram::Summarize() const
+{
+    FPanoLatencyStats Stats;
+
+    uint64 Counts[kBucketCount];
+    uint64 Total = 0;
+    for (int32 Bucket = 0; Bucket < kBucketCount; ++Bucket)
+    {
+        Counts[Bucket] = Buckets[Bucket].load(std::memory_order_relaxed);
+        Total += Counts[Bucket];
+    }
+
+    if (Total == 0)
+    {
+        return Stats;
+    }
+
+    const double MaxMs = MaxMicroseconds.load(std::memory_order_relaxed) / 1000.0;
+    auto Percentile = [&Counts, Total, MaxMs](double Fraction)
+    {
+        const uint64 Target = FMath::Max<uint64>(1, static_cast<uint64>(FMath::CeilToDouble(Fraction * Total)));
+        uint64 Accumulated = 0;
+        for (int32 Bucket = 0; Bucket < kBucketCount; ++Bucket)
+        {
+            Accumulated += Counts[Bucket];
+            if (Accumulated >= Target)
+            {
+                return static_cast<float>(FMath::Min(BucketUpperBoundMs(Bucket), MaxMs));
+            }
+        }
+        return static_cast<float>(MaxMs);
+    };
+
+    Stats.SampleCount = static_cast<int32>(FMath::Min<uint64>(Total, MAX_int32));
+    Stats.MeanMs = static_cast<float>(TotalMicroseconds.load(std::memory_order_relaxed) / 1000.0 / Total);
+    Stats.P50Ms = Percentile(0.50);
+    Stats.P95Ms = Percentile(0.95);
+    Stats.P99Ms = Percentile(0.99);
+    Stats.MaxMs = static_cast<float>(MaxMs);
+    return Stats;
+}
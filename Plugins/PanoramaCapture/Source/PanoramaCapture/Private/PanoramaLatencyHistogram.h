@@ -0,0 +1,33 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PanoramaCaptureTypes.h"
+
+#include <atomic>
+
+/**
+ * Lock-free latency histogram with logarithmic buckets (four per octave, 1 us to ~16 s).
+ * Samples may be recorded from one thread while another thread summarizes.
+ */
+class FPanoLatencyHistogram
+{
+public:
+    FPanoLatencyHistogram();
+
+    void Record(double Seconds);
+    void Reset();
+
+    FPanoLatencyStats Summarize() const;
+
+private:
+    static constexpr int32 kBucketsPerOctave = 4;
+    static constexpr int32 kBucketCount = 24 * kBucketsPerOctave;
+
+    static int32 BucketForMicroseconds(uint64 Microseconds);
+    static double BucketUpperBoundMs(int32 Bucket);
+
+    std::atomic<uint64> Buckets[kBucketCount];
+    std::atomic<uint64> SampleCount;
+    std::atomic<uint64> TotalMicroseconds;
+    std::atomic<uint64> MaxMicroseconds;
+};
@@ -0,0 +1,480 @@
+#include "PanoramaMkvWriter.h"
+
+#include "Algo/StableSort.h"
+#include "HAL/PlatformFileManager.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+
+namespace
+{
+    constexpr uint32 kEbml = 0x1A45DFA3;
+    constexpr uint32 kSegment = 0x18538067;
+    constexpr uint32 kSeekHead = 0x114D9B74;
+    constexpr uint32 kSeek = 0x4DBB;
+    constexpr uint32 kSeekId = 0x53AB;
+    constexpr uint32 kSeekPosition = 0x53AC;
+    constexpr uint32 kInfo = 0x1549A966;
+    constexpr uint32 kTracks = 0x1654AE6B;
+    constexpr uint32 kCluster = 0x1F43B675;
+    constexpr uint32 kCues = 0x1C53BB6B;
+    constexpr uint32 kVoid = 0xEC;
+
+    constexpr uint64 kTimestampScaleNs = 1000000;
+    /** Bytes reserved after the segment header for the SeekHead written at Close. */
+    constexpr int32 kSeekHeadReserve = 128;
+    /** SimpleBlock timestamps are int16 offsets from the cluster timestamp. */
+    constexpr int64 kMaxClusterSpanMs = 30000;
+    /** Audio sample frames per PCM block. */
+    constexpr int64 kAudioBlockFrames = 1024;
+
+    int32 GetUIntLength(uint64 Value)
+    {
+        int32 Length = 1;
+        while (Length < 8 && (Value >> (Length * 8)) != 0)
+        {
+            ++Length;
+        }
+        return Length;
+    }
+
+    /** Element writer; master elements are built in a child buffer and appended with their size. */
+    struct FEbmlWriter
+    {
+        explicit FEbmlWriter(TArray<uint8>& InBuffer)
+            : Writer(InBuffer)
+        {
+        }
+
+        void Id(uint32 ElementId)
+        {
+            for (int32 Shift = 24; Shift >= 0; Shift -= 8)
+            {
+                if ((ElementId >> Shift) != 0)
+                {
+                    Writer.U8(ElementId >> Shift);
+                }
+            }
+        }
+
+        void Size(uint64 Value)
+        {
+            int32 Length = 1;
+            while (Length < 8 && Value >= (1ull << (7 * Length)) - 1)
+            {
+                ++Length;
+            }
+            SizeFixed(Value, Length);
+        }
+
+        void SizeFixed(uint64 Value, int32 Length)
+        {
+            const uint64 Marked = Value | (1ull << (7 * Length));
+            for (int32 Index = Length - 1; Index >= 0; --Index)
+            {
+                Writer.U8(static_cast<uint32>(Marked >> (Index * 8)));
+            }
+        }
+
+        void UInt(uint32 ElementId, uint64 Value)
+        {
+            const int32 Length = GetUIntLength(Value);
+            Id(ElementId);
+            Size(Length);
+            for (int32 Index = Length - 1; Index >= 0; --Index)
+            {
+                Writer.U8(static_cast<uint32>(Value >> (Index * 8)));
+            }
+        }
+
+        void UInt64Fixed(uint32 ElementId, uint64 Value)
+        {
+            Id(ElementId);
+            Size(8);
+            Writer.U64(Value);
+        }
+
+        void Float(uint32 ElementId, double Value)
+        {
+            Id(ElementId);
+            Size(8);
+            uint64 Bits;
+            FMemory::Memcpy(&Bits, &Value, sizeof(Bits));
+            Writer.U64(Bits);
+        }
+
+        void String(uint32 ElementId, const char* Value)
+        {
+            const int32 Length = FCStringAnsi::Strlen(Value);
+            Id(ElementId);
+            Size(Length);
+            Writer.Bytes(Value, Length);
+        }
+
+        void Binary(uint32 ElementId, TArrayView<const uint8> Value)
+        {
+            Id(ElementId);
+            Size(Value.Num());
+            Writer.Bytes(Value);
+        }
+
+        void Master(uint32 ElementId, const TArray<uint8>& Payload)
+        {
+            Binary(ElementId, Payload);
+        }
+
+        FPanoBigEndianWriter Writer;
+    };
+
+    struct FBlockRef
+    {
+        /** Blocks are stored in decode order; TimestampMs is the presentation time the block is stamped with. */
+        int64 DecodeMs;
+        int64 TimestampMs;
+        uint8 Track;
+        bool bKeyframe;
+        const uint8* Data;
+        int64 Size;
+    };
+
+    int64 GetSimpleBlockElementBytes(int64 DataSize)
+    {
+        const int64 PayloadBytes = 4 + DataSize;
+        TArray<uint8> Scratch;
+        FEbmlWriter(Scratch).Size(PayloadBytes);
+        return 1 + Scratch.Num() + PayloadBytes;
+    }
+}
+
+FPanoMkvWriter::FPanoMkvWriter()
+    : SegmentDataStart(0)
+    , SeekHeadPosition(0)
+    , InfoPosition(0)
+    , TracksPosition(0)
+    , DurationOffset(0)
+    , EndTimestampMs(0)
+    , bFailed(false)
+{
+}
+
+FPanoMkvWriter::~FPanoMkvWriter()
+{
+    Close();
+}
+
+bool FPanoMkvWriter::Open(const FString& Path, const FPanoContainerConfig& InConfig)
+{
+    Close();
+
+    Config = InConfig;
+    FilePath = Path;
+    EndTimestampMs = 0;
+    CuePoints.Reset();
+    bFailed = false;
+
+    FileHandle.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*FilePath));
+    if (!FileHandle)
+    {
+        UE_LOG(LogTemp, Error, TEXT("Failed to open MKV file for writing: %s"), *FilePath);
+        return false;
+    }
+
+    TArray<uint8> Header;
+    FEbmlWriter Writer(Header);
+    {
+        TArray<uint8> Ebml;
+        FEbmlWriter Child(Ebml);
+        Child.UInt(0x4286, 1);
+        Child.UInt(0x42F7, 1);
+        Child.UInt(0x42F2, 4);
+        Child.UInt(0x42F3, 8);
+        Child.String(0x4282, "matroska");
+        Child.UInt(0x4287, 4);
+        Child.UInt(0x4285, 2);
+        Writer.Master(kEbml, Ebml);
+    }
+
+    // Unknown-size segment; the real size is patched into the same 8 bytes at Close.
+    Writer.Id(kSegment);
+    Writer.Writer.U64(0x01FFFFFFFFFFFFFFull);
+    SegmentDataStart = Header.Num();
+
+    SeekHeadPosition = Header.Num() - SegmentDataStart;
+    Writer.Id(kVoid);
+    Writer.SizeFixed(kSeekHeadReserve - 9, 8);
+    Writer.Writer.Zeros(kSeekHeadReserve - 9);
+
+    InfoPosition = Header.Num() - SegmentDataStart;
+    {
+        TArray<uint8> Info;
+        FEbmlWriter Child(Info);
+        Child.UInt(0x2AD7B1, kTimestampScaleNs);
+        Child.String(0x4D80, "PanoramaCapture");
+        Child.String(0x5741, "PanoramaCapture");
+        const int32 DurationStart = Info.Num();
+        Child.Float(0x4489, 0.0);
+        Writer.Id(kInfo);
+        Writer.Size(Info.Num());
+        DurationOffset = Header.Num() + DurationStart + 3;
+        Writer.Writer.Bytes(Info);
+    }
+
+    TracksPosition = Header.Num() - SegmentDataStart;
+    WriteTracks(Header);
+    return WriteBytes(Header);
+}
+
+void FPanoMkvWriter::WriteTracks(TArray<uint8>& Out) const
+{
+    TArray<uint8> Tracks;
+    FEbmlWriter TracksWriter(Tracks);
+    {
+        TArray<uint8> Video;
+        FEbmlWriter Child(Video);
+        Child.UInt(0xB0, Config.Resolution.X);
+        Child.UInt(0xBA, Config.Resolution.Y);
+        if (Config.bStereoTopBottom)
+        {
+            // 3 = top-bottom, left eye first.
+            Child.UInt(0x53B8, 3);
+        }
+
+        TArray<uint8> Projection;
+        FEbmlWriter ProjectionWriter(Projection);
+        ProjectionWriter.UInt(0x7671, 1);
+        // Equirectangular ProjectionPrivate: version/flags followed by the top, bottom, left and right bounds.
+        TArray<uint8> EquiPrivate;
+        FPanoBigEndianWriter EquiWriter(EquiPrivate);
+        EquiWriter.U32(0);
+        EquiWriter.U32(FPanoEquirectCrop::ToFixed(Config.Crop.Top));
+        EquiWriter.U32(FPanoEquirectCrop::ToFixed(Config.Crop.Bottom));
+        EquiWriter.U32(FPanoEquirectCrop::ToFixed(Config.Crop.Left));
+        EquiWriter.U32(FPanoEquirectCrop::ToFixed(Config.Crop.Right));
+        ProjectionWriter.Binary(0x7672, EquiPrivate);
+        ProjectionWriter.Float(0x7673, 0.0);
+        ProjectionWriter.Float(0x7674, 0.0);
+        ProjectionWriter.Float(0x7675, 0.0);
+        Child.Master(0x7670, Projection);
+
+        TArray<uint8> Entry;
+        FEbmlWriter EntryWriter(Entry);
+        EntryWriter.UInt(0xD7, 1);
+        EntryWriter.UInt(0x73C5, 1);
+        EntryWriter.UInt(0x83, 1);
+        EntryWriter.UInt(0x9C, 0);
+        EntryWriter.String(0x86, Config.Codec == EPanoramaCaptureCodec::H264 ? "V_MPEG4/ISO/AVC" : "V_MPEGH/ISO/HEVC");
+        EntryWriter.Binary(0x63A2, Config.CodecConfig);
+        EntryWriter.UInt(0x23E383, static_cast<uint64>(FMath::RoundToInt64(1.0e9 / FMath::Max(1.f, Config.FrameRate))));
+        EntryWriter.Master(0xE0, Video);
+        TracksWriter.Master(0xAE, Entry);
+    }
+
+    if (Config.HasAudio())
+    {
+        TArray<uint8> Audio;
+        FEbmlWriter Child(Audio);
+        Child.Float(0xB5, Config.AudioSampleRate);
+        Child.UInt(0x9F, Config.AudioChannels);
+        Child.UInt(0x6264, 16);
+
+        TArray<uint8> Entry;
+        FEbmlWriter EntryWriter(Entry);
+        EntryWriter.UInt(0xD7, 2);
+        EntryWriter.UInt(0x73C5, 2);
+        EntryWriter.UInt(0x83, 2);
+        EntryWriter.UInt(0x9C, 0);
+        EntryWriter.String(0x86, "A_PCM/INT/LIT");
+        EntryWriter.Master(0xE1, Audio);
+        TracksWriter.Master(0xAE, Entry);
+    }
+
+    FEbmlWriter(Out).Master(kTracks, Tracks);
+}
+
+bool FPanoMkvWriter::WriteFragment(TArrayView<const FPanoVideoSample> Video, int64 FirstFrameIndex, TArrayView<const int16> Audio, int64 FirstAudioFrame)
+{
+    if (!FileHandle || bFailed)
+    {
+        return false;
+    }
+
+    TArray<FBlockRef> Blocks;
+    const double FrameRate = FMath::Max(1.f, Config.FrameRate);
+    for (int32 Index = 0; Index < Video.Num(); ++Index)
+    {
+        const double DecodeSeconds = Config.VideoDelaySeconds + (FirstFrameIndex + Index) / FrameRate;
+        const double Seconds = Config.VideoDelaySeconds + (FirstFrameIndex + Index + Video[Index].CompositionOffset) / FrameRate;
+        Blocks.Add({ FMath::RoundToInt64(DecodeSeconds * 1000.0), FMath::RoundToInt64(Seconds * 1000.0), 1, Video[Index].bKeyframe, Video[Index].Data.GetData(), Video[Index].Data.Num() });
+    }
+    if (Config.HasAudio())
+    {
+        const int64 AudioFrames = Audio.Num() / Config.AudioChannels;
+        for (int64 Frame = 0; Frame < AudioFrames; Frame += kAudioBlockFrames)
+        {
+            const int64 BlockFrames = FMath::Min(kAudioBlockFrames, AudioFrames - Frame);
+            const double Seconds = Config.AudioDelaySeconds + static_cast<double>(FirstAudioFrame + Frame) / Config.AudioSampleRate;
+            const int64 TimestampMs = FMath::RoundToInt64(Seconds * 1000.0);
+            Blocks.Add({ TimestampMs, TimestampMs, 2, true,
+                reinterpret_cast<const uint8*>(Audio.GetData() + Frame * Config.AudioChannels), BlockFrames * Config.AudioChannels * static_cast<int64>(sizeof(int16)) });
+        }
+    }
+    if (Blocks.Num() == 0)
+    {
+        return true;
+    }
+
+    // Interleave in decode order; a B-frame's presentation time can precede the blocks stored before it.
+    Algo::StableSortBy(Blocks, &FBlockRef::DecodeMs);
+
+    bool bWritten = true;
+    for (int32 ClusterStart = 0; ClusterStart < Blocks.Num() && bWritten;)
+    {
+        int64 ClusterTimestamp = Blocks[ClusterStart].TimestampMs;
+        int32 ClusterEnd = ClusterStart;
+        int64 PayloadBytes = 0;
+        while (ClusterEnd < Blocks.Num() && Blocks[ClusterEnd].DecodeMs - Blocks[ClusterStart].DecodeMs <= kMaxClusterSpanMs)
+        {
+            ClusterTimestamp = FMath::Min(ClusterTimestamp, Blocks[ClusterEnd].TimestampMs);
+            PayloadBytes += GetSimpleBlockElementBytes(Blocks[ClusterEnd].Size);
+            ++ClusterEnd;
+        }
+
+        TArray<uint8> Header;
+        FEbmlWriter Writer(Header);
+        TArray<uint8> TimestampElement;
+        FEbmlWriter(TimestampElement).UInt(0xE7, static_cast<uint64>(ClusterTimestamp));
+        Writer.Id(kCluster);
+        Writer.Size(PayloadBytes + TimestampElement.Num());
+        Writer.Writer.Bytes(TimestampElement);
+
+        const int64 ClusterPosition = FileHandle->Tell() - SegmentDataStart;
+        for (int32 Index = ClusterStart; Index < ClusterEnd; ++Index)
+        {
+            if (Blocks[Index].Track == 1 && Blocks[Index].bKeyframe)
+            {
+                CuePoints.Add({ Blocks[Index].TimestampMs, ClusterPosition });
+                break;
+            }
+        }
+
+        bWritten = WriteBytes(Header);
+        for (int32 Index = ClusterStart; Index < ClusterEnd && bWritten; ++Index)
+        {
+            const FBlockRef& Block = Blocks[Index];
+            TArray<uint8> BlockHeader;
+            FEbmlWriter BlockWriter(BlockHeader);
+            BlockWriter.Id(0xA3);
+            BlockWriter.Size(4 + Block.Size);
+            BlockWriter.Writer.U8(0x80 | Block.Track);
+            BlockWriter.Writer.U16(static_cast<uint16>(static_cast<int16>(Block.TimestampMs - ClusterTimestamp)));
+            BlockWriter.Writer.U8(Block.bKeyframe ? 0x80 : 0x00);
+            bWritten = WriteBytes(BlockHeader) && FileHandle->Write(Block.Data, Block.Size);
+        }
+
+        ClusterStart = ClusterEnd;
+    }
+
+    const double FragmentEndSeconds = FMath::Max(
+        Video.Num() > 0 ? Config.VideoDelaySeconds + (FirstFrameIndex + Video.Num()) / FrameRate : 0.0,
+        Config.HasAudio() ? Config.AudioDelaySeconds + static_cast<double>(FirstAudioFrame + Audio.Num() / Config.AudioChannels) / Config.AudioSampleRate : 0.0);
+    EndTimestampMs = FMath::Max(EndTimestampMs, FMath::RoundToInt64(FragmentEndSeconds * 1000.0));
+
+    bFailed = !bWritten;
+    if (bFailed)
+    {
+        UE_LOG(LogTemp, Error, TEXT("Failed to write MKV cluster to %s"), *FilePath);
+    }
+    return bWritten;
+}
+
+bool FPanoMkvWriter::WriteBytes(const TArray<uint8>& Bytes)
+{
+    return FileHandle->Write(Bytes.GetData(), Bytes.Num());
+}
+
+bool FPanoMkvWriter::Close()
+{
+    if (!FileHandle)
+    {
+        return false;
+    }
+
+    bool bPatched = !bFailed;
+
+    const int64 CuesPosition = FileHandle->Tell() - SegmentDataStart;
+    if (bPatched && CuePoints.Num() > 0)
+    {
+        TArray<uint8> Cues;
+        FEbmlWriter CuesWriter(Cues);
+        for (const FCuePoint& Cue : CuePoints)
+        {
+            TArray<uint8> Positions;
+            FEbmlWriter PositionsWriter(Positions);
+            PositionsWriter.UInt(0xF7, 1);
+            PositionsWriter.UInt(0xF1, static_cast<uint64>(Cue.ClusterPosition));
+
+            TArray<uint8> Point;
+            FEbmlWriter PointWriter(Point);
+            PointWriter.UInt(0xB3, static_cast<uint64>(Cue.TimestampMs));
+            PointWriter.Master(0xB7, Positions);
+            CuesWriter.Master(0xBB, Point);
+        }
+
+        TArray<uint8> Element;
+        FEbmlWriter(Element).Master(kCues, Cues);
+        bPatched = WriteBytes(Element);
+    }
+    const int64 SegmentSize = FileHandle->Tell() - SegmentDataStart;
+
+    if (bPatched)
+    {
+        TArray<uint8> SeekHead;
+        FEbmlWriter SeekWriter(SeekHead);
+        const TPair<uint32, int64> Entries[] = {
+            { kInfo, InfoPosition },
+            { kTracks, TracksPosition },
+            { kCues, CuePoints.Num() > 0 ? CuesPosition : INDEX_NONE }
+        };
+        for (const TPair<uint32, int64>& Entry : Entries)
+        {
+            if (Entry.Value == INDEX_NONE)
+            {
+                continue;
+            }
+            TArray<uint8> Seek;
+            FEbmlWriter Child(Seek);
+            const uint8 IdBytes[4] = { static_cast<uint8>(Entry.Key >> 24), static_cast<uint8>(Entry.Key >> 16), static_cast<uint8>(Entry.Key >> 8), static_cast<uint8>(Entry.Key) };
+            Child.Binary(kSeekId, MakeArrayView(IdBytes));
+            Child.UInt64Fixed(kSeekPosition, static_cast<uint64>(Entry.Value));
+            SeekWriter.Master(kSeek, Seek);
+        }
+
+        TArray<uint8> Reserved;
+        FEbmlWriter ReservedWriter(Reserved);
+        ReservedWriter.Master(kSeekHead, SeekHead);
+        const int32 VoidPayload = kSeekHeadReserve - Reserved.Num() - 9;
+        check(VoidPayload >= 0);
+        ReservedWriter.Id(kVoid);
+        ReservedWriter.SizeFixed(VoidPayload, 8);
+        ReservedWriter.Writer.Zeros(VoidPayload);
+
+        TArray<uint8> SegmentSizeBytes;
+        FEbmlWriter(SegmentSizeBytes).SizeFixed(static_cast<uint64>(SegmentSize), 8);
+
+        TArray<uint8> DurationBytes;
+        const double DurationMs = static_cast<double>(EndTimestampMs);
+        uint64 DurationBits;
+        FMemory::Memcpy(&DurationBits, &DurationMs, sizeof(DurationBits));
+        FPanoBigEndianWriter(DurationBytes).U64(DurationBits);
+
+        bPatched = FileHandle->Seek(SegmentDataStart - 8) && WriteBytes(SegmentSizeBytes)
+            && FileHandle->Seek(SegmentDataStart + SeekHeadPosition) && WriteBytes(Reserved)
+            && FileHandle->Seek(DurationOffset) && WriteBytes(DurationBytes)
+            && FileHandle->Flush();
+    }
+
+    FileHandle.Reset();
+    if (!bPatched)
+    {
+        UE_LOG(LogTemp, Error, TEXT("Failed to finalize MKV file: %s"), *FilePath);
+    }
+    return bPatched;
+}
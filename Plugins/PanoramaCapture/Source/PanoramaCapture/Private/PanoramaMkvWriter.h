@@ -0,0 +1,49 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PanoramaContainerWriter.h"
+
+class IFileHandle;
+
+/**
+ * Streaming Matroska writer.
+ *
+ * Open writes the EBML header, a reserved SeekHead, Info and Tracks (video Projection element for
+ * equirectangular output, StereoMode for top-bottom stereo, A_PCM/INT/LIT audio). Each WriteFragment
+ * appends one or more Clusters of SimpleBlocks interleaved by timestamp. Close appends Cues and patches
+ * the segment size, duration and SeekHead.
+ */
+class FPanoMkvWriter : public IPanoContainerWriter
+{
+public:
+    FPanoMkvWriter();
+    virtual ~FPanoMkvWriter() override;
+
+    virtual bool Open(const FString& Path, const FPanoContainerConfig& Config) override;
+    virtual bool WriteFragment(TArrayView<const FPanoVideoSample> Video, int64 FirstFrameIndex, TArrayView<const int16> Audio, int64 FirstAudioFrame) override;
+    virtual bool Close() override;
+    virtual const FString& GetPath() const override { return FilePath; }
+
+private:
+    struct FCuePoint
+    {
+        int64 TimestampMs;
+        int64 ClusterPosition;
+    };
+
+    void WriteTracks(TArray<uint8>& Out) const;
+    bool WriteBytes(const TArray<uint8>& Bytes);
+
+    FPanoContainerConfig Config;
+    FString FilePath;
+    TUniquePtr<IFileHandle> FileHandle;
+
+    int64 SegmentDataStart;
+    int64 SeekHeadPosition;
+    int64 InfoPosition;
+    int64 TracksPosition;
+    int64 DurationOffset;
+    int64 EndTimestampMs;
+    TArray<FCuePoint> CuePoints;
+    bool bFailed;
+};
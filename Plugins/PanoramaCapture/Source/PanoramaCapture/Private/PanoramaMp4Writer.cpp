@@ -0,0 +1,489 @@
+#include "PanoramaMp4Writer.h"
+
+#include "HAL/PlatformFileManager.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+
+namespace
+{
+    constexpr uint32 kMovieTimescale = 1000;
+    constexpr uint32 kVideoTrackId = 1;
+    constexpr uint32 kAudioTrackId = 2;
+    constexpr uint32 kTrunDataOffset = 0x000001;
+    constexpr uint32 kTrunSampleDuration = 0x000100;
+    constexpr uint32 kTrunSampleSize = 0x000200;
+    constexpr uint32 kTrunSampleFlags = 0x000400;
+    constexpr uint32 kTrunSampleCompositionOffset = 0x000800;
+    constexpr uint32 kTfhdDefaultDuration = 0x000008;
+    constexpr uint32 kTfhdDefaultSize = 0x000010;
+    constexpr uint32 kTfhdDefaultBaseIsMoof = 0x020000;
+    /** sample_depends_on = 2 (I picture). */
+    constexpr uint32 kSyncSampleFlags = 0x02000000;
+    /** sample_depends_on = 1, sample_is_non_sync_sample = 1. */
+    constexpr uint32 kNonSyncSampleFlags = 0x01010000;
+
+    void WriteMatrix(FPanoBigEndianWriter& Writer)
+    {
+        const uint32 Matrix[9] = { 0x00010000, 0, 0, 0, 0x00010000, 0, 0, 0, 0x40000000 };
+        for (uint32 Value : Matrix)
+        {
+            Writer.U32(Value);
+        }
+    }
+
+    void WriteTkhd(FPanoBigEndianWriter& Writer, uint32 TrackId, bool bAudio, FIntPoint Resolution)
+    {
+        const int32 Tkhd = Writer.BeginFullBox("tkhd", 0, 0x000003);
+        Writer.U32(0);
+        Writer.U32(0);
+        Writer.U32(TrackId);
+        Writer.U32(0);
+        Writer.U32(0);
+        Writer.Zeros(8);
+        Writer.U16(0);
+        Writer.U16(0);
+        Writer.U16(bAudio ? 0x0100 : 0);
+        Writer.U16(0);
+        WriteMatrix(Writer);
+        Writer.U32(static_cast<uint32>(Resolution.X) << 16);
+        Writer.U32(static_cast<uint32>(Resolution.Y) << 16);
+        Writer.EndBox(Tkhd);
+    }
+
+    void WriteMdhdHdlr(FPanoBigEndianWriter& Writer, uint32 Timescale, const char* HandlerType, const char* HandlerName)
+    {
+        const int32 Mdhd = Writer.BeginFullBox("mdhd", 0, 0);
+        Writer.U32(0);
+        Writer.U32(0);
+        Writer.U32(Timescale);
+        Writer.U32(0);
+        // Packed ISO-639-2 "und".
+        Writer.U16(0x55C4);
+        Writer.U16(0);
+        Writer.EndBox(Mdhd);
+
+        const int32 Hdlr = Writer.BeginFullBox("hdlr", 0, 0);
+        Writer.U32(0);
+        Writer.Tag(HandlerType);
+        Writer.Zeros(12);
+        Writer.Bytes(HandlerName, FCStringAnsi::Strlen(HandlerName) + 1);
+        Writer.EndBox(Hdlr);
+    }
+
+    void WriteDinf(FPanoBigEndianWriter& Writer)
+    {
+        const int32 Dinf = Writer.BeginBox("dinf");
+        const int32 Dref = Writer.BeginFullBox("dref", 0, 0);
+        Writer.U32(1);
+        Writer.EndBox(Writer.BeginFullBox("url ", 0, 0x000001));
+        Writer.EndBox(Dref);
+        Writer.EndBox(Dinf);
+    }
+
+    /** Empty sample tables; every sample lives in a fragment. */
+    void WriteEmptySampleTables(FPanoBigEndianWriter& Writer)
+    {
+        const int32 Stts = Writer.BeginFullBox("stts", 0, 0);
+        Writer.U32(0);
+        Writer.EndBox(Stts);
+        const int32 Stsc = Writer.BeginFullBox("stsc", 0, 0);
+        Writer.U32(0);
+        Writer.EndBox(Stsc);
+        const int32 Stsz = Writer.BeginFullBox("stsz", 0, 0);
+        Writer.U32(0);
+        Writer.U32(0);
+        Writer.EndBox(Stsz);
+        const int32 Stco = Writer.BeginFullBox("stco", 0, 0);
+        Writer.U32(0);
+        Writer.EndBox(Stco);
+    }
+
+    /** Spherical Video V2: st3d stereo layout and an sv3d equirectangular projection with the region's bounds. */
+    void WriteSphericalBoxes(FPanoBigEndianWriter& Writer, bool bStereoTopBottom, const FPanoEquirectCrop& Crop)
+    {
+        const int32 St3d = Writer.BeginFullBox("st3d", 0, 0);
+        Writer.U8(bStereoTopBottom ? 1 : 0);
+        Writer.EndBox(St3d);
+
+        const int32 Sv3d = Writer.BeginBox("sv3d");
+        const int32 Svhd = Writer.BeginFullBox("svhd", 0, 0);
+        const char MetadataSource[] = "PanoramaCapture";
+        Writer.Bytes(MetadataSource, sizeof(MetadataSource));
+        Writer.EndBox(Svhd);
+
+        const int32 Proj = Writer.BeginBox("proj");
+        const int32 Prhd = Writer.BeginFullBox("prhd", 0, 0);
+        Writer.U32(0);
+        Writer.U32(0);
+        Writer.U32(0);
+        Writer.EndBox(Prhd);
+        const int32 Equi = Writer.BeginFullBox("equi", 0, 0);
+        Writer.U32(FPanoEquirectCrop::ToFixed(Crop.Top));
+        Writer.U32(FPanoEquirectCrop::ToFixed(Crop.Bottom));
+        Writer.U32(FPanoEquirectCrop::ToFixed(Crop.Left));
+        Writer.U32(FPanoEquirectCrop::ToFixed(Crop.Right));
+        Writer.EndBox(Equi);
+        Writer.EndBox(Proj);
+        Writer.EndBox(Sv3d);
+    }
+}
+
+FPanoMp4Writer::FPanoMp4Writer()
+    : VideoTimescale(30000)
+    , FrameDuration(1000)
+    , SequenceNumber(0)
+    , MehdDurationOffset(0)
+    , VideoEndTicks(0)
+    , AudioEndTicks(0)
+    , bFailed(false)
+{
+}
+
+FPanoMp4Writer::~FPanoMp4Writer()
+{
+    Close();
+}
+
+bool FPanoMp4Writer::Open(const FString& Path, const FPanoContainerConfig& InConfig)
+{
+    Close();
+
+    Config = InConfig;
+    FilePath = Path;
+    SequenceNumber = 0;
+    VideoEndTicks = 0;
+    AudioEndTicks = 0;
+    bFailed = false;
+
+    // Millisecond-exact frame durations for integer and NTSC-style (x/1.001) rates alike.
+    VideoTimescale = static_cast<uint32>(FMath::Max(1, FMath::RoundToInt(Config.FrameRate * 1000.f)));
+    FrameDuration = 1000;
+
+    FileHandle.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*FilePath));
+    if (!FileHandle)
+    {
+        UE_LOG(LogTemp, Error, TEXT("Failed to open MP4 file for writing: %s"), *FilePath);
+        return false;
+    }
+
+    TArray<uint8> Header;
+    FPanoBigEndianWriter Writer(Header);
+    const int32 Ftyp = Writer.BeginBox("ftyp");
+    Writer.Tag("iso6");
+    Writer.U32(0);
+    Writer.Tag("iso6");
+    Writer.Tag("iso5");
+    Writer.Tag("isom");
+    Writer.Tag("mp41");
+    Writer.EndBox(Ftyp);
+
+    WriteMoov(Header);
+    return WriteBytes(Header);
+}
+
+void FPanoMp4Writer::WriteMoov(TArray<uint8>& Out)
+{
+    FPanoBigEndianWriter Writer(Out);
+    const int32 Moov = Writer.BeginBox("moov");
+
+    const int32 Mvhd = Writer.BeginFullBox("mvhd", 0, 0);
+    Writer.U32(0);
+    Writer.U32(0);
+    Writer.U32(kMovieTimescale);
+    Writer.U32(0);
+    Writer.U32(0x00010000);
+    Writer.U16(0x0100);
+    Writer.Zeros(10);
+    WriteMatrix(Writer);
+    Writer.Zeros(24);
+    Writer.U32(Config.HasAudio() ? kAudioTrackId + 1 : kVideoTrackId + 1);
+    Writer.EndBox(Mvhd);
+
+    WriteVideoTrak(Writer);
+    if (Config.HasAudio())
+    {
+        WriteAudioTrak(Writer);
+    }
+
+    const int32 Mvex = Writer.BeginBox("mvex");
+    const int32 Mehd = Writer.BeginFullBox("mehd", 1, 0);
+    MehdDurationOffset = FileHandle->Tell() + Out.Num();
+    Writer.U64(0);
+    Writer.EndBox(Mehd);
+    for (uint32 TrackId : { kVideoTrackId, kAudioTrackId })
+    {
+        if (TrackId == kAudioTrackId && !Config.HasAudio())
+        {
+            continue;
+        }
+        const int32 Trex = Writer.BeginFullBox("trex", 0, 0);
+        Writer.U32(TrackId);
+        Writer.U32(1);
+        Writer.U32(0);
+        Writer.U32(0);
+        Writer.U32(0);
+        Writer.EndBox(Trex);
+    }
+    Writer.EndBox(Mvex);
+
+    Writer.EndBox(Moov);
+}
+
+void FPanoMp4Writer::WriteEditList(FPanoBigEndianWriter& Writer, double DelaySeconds)
+{
+    if (DelaySeconds <= 0.0)
+    {
+        return;
+    }
+
+    // An empty edit delays the track; the second edit (duration 0) plays the media to the end of the fragments.
+    const int32 Edts = Writer.BeginBox("edts");
+    const int32 Elst = Writer.BeginFullBox("elst", 0, 0);
+    Writer.U32(2);
+    Writer.U32(static_cast<uint32>(FMath::RoundToInt64(DelaySeconds * kMovieTimescale)));
+    Writer.U32(0xFFFFFFFFu);
+    Writer.U32(0x00010000);
+    Writer.U32(0);
+    Writer.U32(0);
+    Writer.U32(0x00010000);
+    Writer.EndBox(Elst);
+    Writer.EndBox(Edts);
+}
+
+void FPanoMp4Writer::WriteVideoTrak(FPanoBigEndianWriter& Writer)
+{
+    const int32 Trak = Writer.BeginBox("trak");
+    WriteTkhd(Writer, kVideoTrackId, false, Config.Resolution);
+    WriteEditList(Writer, Config.VideoDelaySeconds);
+
+    const int32 Mdia = Writer.BeginBox("mdia");
+    WriteMdhdHdlr(Writer, VideoTimescale, "vide", "VideoHandler");
+    const int32 Minf = Writer.BeginBox("minf");
+    const int32 Vmhd = Writer.BeginFullBox("vmhd", 0, 0x000001);
+    Writer.Zeros(8);
+    Writer.EndBox(Vmhd);
+    WriteDinf(Writer);
+
+    const int32 Stbl = Writer.BeginBox("stbl");
+    const int32 Stsd = Writer.BeginFullBox("stsd", 0, 0);
+    Writer.U32(1);
+
+    const bool bH264 = Config.Codec == EPanoramaCaptureCodec::H264;
+    const int32 Entry = Writer.BeginBox(bH264 ? "avc1" : "hvc1");
+    Writer.Zeros(6);
+    Writer.U16(1);
+    Writer.Zeros(16);
+    Writer.U16(Config.Resolution.X);
+    Writer.U16(Config.Resolution.Y);
+    Writer.U32(0x00480000);
+    Writer.U32(0x00480000);
+    Writer.U32(0);
+    Writer.U16(1);
+    Writer.Zeros(32);
+    Writer.U16(0x0018);
+    Writer.U16(0xFFFF);
+
+    const int32 CodecBox = Writer.BeginBox(bH264 ? "avcC" : "hvcC");
+    Writer.Bytes(Config.CodecConfig);
+    Writer.EndBox(CodecBox);
+    WriteSphericalBoxes(Writer, Config.bStereoTopBottom, Config.Crop);
+    Writer.EndBox(Entry);
+
+    Writer.EndBox(Stsd);
+    WriteEmptySampleTables(Writer);
+    Writer.EndBox(Stbl);
+    Writer.EndBox(Minf);
+    Writer.EndBox(Mdia);
+    Writer.EndBox(Trak);
+}
+
+void FPanoMp4Writer::WriteAudioTrak(FPanoBigEndianWriter& Writer)
+{
+    const int32 Trak = Writer.BeginBox("trak");
+    WriteTkhd(Writer, kAudioTrackId, true, FIntPoint::ZeroValue);
+    WriteEditList(Writer, Config.AudioDelaySeconds);
+
+    const int32 Mdia = Writer.BeginBox("mdia");
+    WriteMdhdHdlr(Writer, static_cast<uint32>(Config.AudioSampleRate), "soun", "SoundHandler");
+    const int32 Minf = Writer.BeginBox("minf");
+    const int32 Smhd = Writer.BeginFullBox("smhd", 0, 0);
+    Writer.U32(0);
+    Writer.EndBox(Smhd);
+    WriteDinf(Writer);
+
+    const int32 Stbl = Writer.BeginBox("stbl");
+    const int32 Stsd = Writer.BeginFullBox("stsd", 0, 0);
+    Writer.U32(1);
+
+    // Little-endian 16-bit PCM, one sample per audio frame.
+    const int32 Entry = Writer.BeginBox("sowt");
+    Writer.Zeros(6);
+    Writer.U16(1);
+    Writer.Zeros(8);
+    Writer.U16(Config.AudioChannels);
+    Writer.U16(16);
+    Writer.U16(0);
+    Writer.U16(0);
+    Writer.U32(static_cast<uint32>(Config.AudioSampleRate) << 16);
+    Writer.EndBox(Entry);
+
+    Writer.EndBox(Stsd);
+    WriteEmptySampleTables(Writer);
+    Writer.EndBox(Stbl);
+    Writer.EndBox(Minf);
+    Writer.EndBox(Mdia);
+    Writer.EndBox(Trak);
+}
+
+bool FPanoMp4Writer::WriteFragment(TArrayView<const FPanoVideoSample> Video, int64 FirstFrameIndex, TArrayView<const int16> Audio, int64 FirstAudioFrame)
+{
+    if (!FileHandle || bFailed)
+    {
+        return false;
+    }
+
+    const bool bHasAudio = Config.HasAudio() && Audio.Num() >= Config.AudioChannels;
+    const int64 AudioFrames = bHasAudio ? Audio.Num() / Config.AudioChannels : 0;
+    const int64 AudioBytes = AudioFrames * Config.AudioChannels * sizeof(int16);
+    if (Video.Num() == 0 && AudioFrames == 0)
+    {
+        return true;
+    }
+
+    int64 VideoBytes = 0;
+    for (const FPanoVideoSample& Sample : Video)
+    {
+        VideoBytes += Sample.Data.Num();
+    }
+
+    const int64 PayloadBytes = VideoBytes + AudioBytes;
+    const bool bLargeMdat = PayloadBytes + 8 > 0xFFFFFFFFll;
+    const int64 MdatHeaderBytes = bLargeMdat ? 16 : 8;
+
+    TArray<uint8> Moof;
+    FPanoBigEndianWriter Writer(Moof);
+    const int32 MoofStart = Writer.BeginBox("moof");
+    const int32 Mfhd = Writer.BeginFullBox("mfhd", 0, 0);
+    Writer.U32(++SequenceNumber);
+    Writer.EndBox(Mfhd);
+
+    int32 VideoDataOffsetField = INDEX_NONE;
+    if (Video.Num() > 0)
+    {
+        const int32 Traf = Writer.BeginBox("traf");
+        const int32 Tfhd = Writer.BeginFullBox("tfhd", 0, kTfhdDefaultBaseIsMoof);
+        Writer.U32(kVideoTrackId);
+        Writer.EndBox(Tfhd);
+        const int32 Tfdt = Writer.BeginFullBox("tfdt", 1, 0);
+        Writer.U64(static_cast<uint64>(FirstFrameIndex) * FrameDuration);
+        Writer.EndBox(Tfdt);
+
+        // Version 1 makes the composition offsets signed: with B-frames a picture can present before it decodes,
+        // and keeping presentation time equal to FrameIndex * FrameDuration keeps the audio alignment unchanged.
+        const int32 Trun = Writer.BeginFullBox("trun", 1, kTrunDataOffset | kTrunSampleDuration | kTrunSampleSize | kTrunSampleFlags | kTrunSampleCompositionOffset);
+        Writer.U32(Video.Num());
+        VideoDataOffsetField = Moof.Num();
+        Writer.U32(0);
+        for (const FPanoVideoSample& Sample : Video)
+        {
+            Writer.U32(FrameDuration);
+            Writer.U32(Sample.Data.Num());
+            Writer.U32(Sample.bKeyframe ? kSyncSampleFlags : kNonSyncSampleFlags);
+            Writer.U32(static_cast<uint32>(Sample.CompositionOffset * static_cast<int32>(FrameDuration)));
+        }
+        Writer.EndBox(Trun);
+        Writer.EndBox(Traf);
+    }
+
+    int32 AudioDataOffsetField = INDEX_NONE;
+    if (AudioFrames > 0)
+    {
+        const int32 Traf = Writer.BeginBox("traf");
+        const int32 Tfhd = Writer.BeginFullBox("tfhd", 0, kTfhdDefaultBaseIsMoof | kTfhdDefaultDuration | kTfhdDefaultSize);
+        Writer.U32(kAudioTrackId);
+        Writer.U32(1);
+        Writer.U32(Config.AudioChannels * sizeof(int16));
+        Writer.EndBox(Tfhd);
+        const int32 Tfdt = Writer.BeginFullBox("tfdt", 1, 0);
+        Writer.U64(static_cast<uint64>(FirstAudioFrame));
+        Writer.EndBox(Tfdt);
+
+        const int32 Trun = Writer.BeginFullBox("trun", 0, kTrunDataOffset);
+        Writer.U32(static_cast<uint32>(AudioFrames));
+        AudioDataOffsetField = Moof.Num();
+        Writer.U32(0);
+        Writer.EndBox(Trun);
+        Writer.EndBox(Traf);
+    }
+    Writer.EndBox(MoofStart);
+
+    // Data offsets are relative to the start of the moof (default-base-is-moof).
+    const int64 MdatPayloadOffset = Moof.Num() + MdatHeaderBytes;
+    if (VideoDataOffsetField != INDEX_NONE)
+    {
+        Writer.PatchU32(VideoDataOffsetField, static_cast<uint32>(MdatPayloadOffset));
+    }
+    if (AudioDataOffsetField != INDEX_NONE)
+    {
+        Writer.PatchU32(AudioDataOffsetField, static_cast<uint32>(MdatPayloadOffset + VideoBytes));
+    }
+
+    if (bLargeMdat)
+    {
+        Writer.U32(1);
+        Writer.Tag("mdat");
+        Writer.U64(static_cast<uint64>(PayloadBytes + 16));
+    }
+    else
+    {
+        Writer.U32(static_cast<uint32>(PayloadBytes + 8));
+        Writer.Tag("mdat");
+    }
+
+    bool bWritten = WriteBytes(Moof);
+    for (const FPanoVideoSample& Sample : Video)
+    {
+        bWritten = bWritten && WriteBytes(Sample.Data);
+    }
+    if (AudioFrames > 0)
+    {
+        // WAV and 'sowt' are both little-endian; the interleaved samples are written as-is.
+        bWritten = bWritten && FileHandle->Write(reinterpret_cast<const uint8*>(Audio.GetData()), AudioBytes);
+        AudioEndTicks = FMath::Max<uint64>(AudioEndTicks, FMath::RoundToInt64(
+            (Config.AudioDelaySeconds + static_cast<double>(FirstAudioFrame + AudioFrames) / Config.AudioSampleRate) * kMovieTimescale));
+    }
+    if (Video.Num() > 0)
+    {
+        VideoEndTicks = FMath::Max<uint64>(VideoEndTicks, FMath::RoundToInt64(
+            (Config.VideoDelaySeconds + static_cast<double>((FirstFrameIndex + Video.Num()) * FrameDuration) / VideoTimescale) * kMovieTimescale));
+    }
+
+    bFailed = !bWritten;
+    if (bFailed)
+    {
+        UE_LOG(LogTemp, Error, TEXT("Failed to write MP4 fragment %u to %s"), SequenceNumber, *FilePath);
+    }
+    return bWritten;
+}
+
+bool FPanoMp4Writer::WriteBytes(const TArray<uint8>& Bytes)
+{
+    return FileHandle->Write(Bytes.GetData(), Bytes.Num());
+}
+
+bool FPanoMp4Writer::Close()
+{
+    if (!FileHandle)
+    {
+        return false;
+    }
+
+    TArray<uint8> Duration;
+    FPanoBigEndianWriter(Duration).U64(FMath::Max(VideoEndTicks, AudioEndTicks));
+    const bool bPatched = !bFailed && FileHandle->Seek(MehdDurationOffset) && WriteBytes(Duration) && FileHandle->Flush();
+    FileHandle.Reset();
+    if (!bPatched)
+    {
+        UE_LOG(LogTemp, Error, TEXT("Failed to finalize MP4 file: %s"), *FilePath);
+    }
+    return bPatched;
+}
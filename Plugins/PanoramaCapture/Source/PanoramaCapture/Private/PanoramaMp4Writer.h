@@ -0,0 +1,46 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PanoramaContainerWriter.h"
+
+class IFileHandle;
+
+/**
+ * Fragmented MP4 (ISO-BMFF) writer.
+ *
+ * Open writes ftyp + moov with empty sample tables (avc1/hvc1 entry carrying st3d and the sv3d
+ * equirectangular projection, plus a 'sowt' PCM entry); every WriteFragment appends one moof + mdat.
+ * The file is playable up to the last complete fragment; Close only patches the mehd duration.
+ */
+class FPanoMp4Writer : public IPanoContainerWriter
+{
+public:
+    FPanoMp4Writer();
+    virtual ~FPanoMp4Writer() override;
+
+    virtual bool Open(const FString& Path, const FPanoContainerConfig& Config) override;
+    virtual bool WriteFragment(TArrayView<const FPanoVideoSample> Video, int64 FirstFrameIndex, TArrayView<const int16> Audio, int64 FirstAudioFrame) override;
+    virtual bool Close() override;
+    virtual const FString& GetPath() const override { return FilePath; }
+
+private:
+    void WriteMoov(TArray<uint8>& Out);
+    void WriteVideoTrak(FPanoBigEndianWriter& Writer);
+    void WriteAudioTrak(FPanoBigEndianWriter& Writer);
+    void WriteEditList(FPanoBigEndianWriter& Writer, double DelaySeconds);
+    bool WriteBytes(const TArray<uint8>& Bytes);
+
+    FPanoContainerConfig Config;
+    FString FilePath;
+    TUniquePtr<IFileHandle> FileHandle;
+
+    uint32 VideoTimescale;
+    uint32 FrameDuration;
+    uint32 SequenceNumber;
+    /** File offset of the mehd fragment_duration field. */
+    int64 MehdDurationOffset;
+    /** End of the media written so far, in movie timescale units. */
+    uint64 VideoEndTicks;
+    uint64 AudioEndTicks;
+    bool bFailed;
+};
@@ -0,0 +1,500 @@
+#include "PanoramaMuxer.h"
+
+#include "Async/Async.h"
+#include "HAL/PlatformFileManager.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+#include "Misc/ScopeLock.h"
+#include "PanoramaCaptureClock.h"
+#include "PanoramaAnnexB.h"
+#include "PanoramaContainerWriter.h"
+#include "PanoramaMkvWriter.h"
+#include "PanoramaMp4Writer.h"
+
+namespace
+{
+    /** Bytes of elementary stream read per parser push. */
+    constexpr int64 kBitstreamChunkBytes = 4 * 1024 * 1024;
+    /** Audio held before the first keyframe arrives; older samples are discarded. */
+    constexpr double kMaxPendingAudioSeconds = 30.0;
+
+    /** Sequential reader for the 16-bit PCM RIFF/RF64 files written by FPanoWavWriter. */
+    class FWavReader
+    {
+    public:
+        bool Open(const FString& Path)
+        {
+            FileHandle.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenRead(*Path));
+            if (!FileHandle)
+            {
+                return false;
+            }
+
+            uint8 Riff[12];
+            if (!FileHandle->Read(Riff, sizeof(Riff)) || (FMemory::Memcmp(Riff, "RIFF", 4) != 0 && FMemory::Memcmp(Riff, "RF64", 4) != 0)
+                || FMemory::Memcmp(Riff + 8, "WAVE", 4) != 0)
+            {
+                return false;
+            }
+
+            const int64 FileSize = FileHandle->Size();
+            int64 Ds64DataBytes = -1;
+            int32 BitsPerSample = 0;
+            while (FileHandle->Tell() + 8 <= FileSize)
+            {
+                uint8 ChunkHeader[8];
+                if (!FileHandle->Read(ChunkHeader, sizeof(ChunkHeader)))
+                {
+                    return false;
+                }
+                const uint32 ChunkBytes = ReadLE32(ChunkHeader + 4);
+                const int64 PayloadStart = FileHandle->Tell();
+
+                if (FMemory::Memcmp(ChunkHeader, "ds64", 4) == 0 && ChunkBytes >= 16)
+                {
+                    uint8 Ds64[16];
+                    FileHandle->Read(Ds64, sizeof(Ds64));
+                    Ds64DataBytes = static_cast<int64>(ReadLE32(Ds64 + 8)) | (static_cast<int64>(ReadLE32(Ds64 + 12)) << 32);
+                }
+                else if (FMemory::Memcmp(ChunkHeader, "fmt ", 4) == 0 && ChunkBytes >= 16)
+                {
+                    uint8 Format[16];
+                    FileHandle->Read(Format, sizeof(Format));
+                    NumChannels = Format[2] | (Format[3] << 8);
+                    SampleRate = static_cast<int32>(ReadLE32(Format + 4));
+                    BitsPerSample = Format[14] | (Format[15] << 8);
+                }
+                else if (FMemory::Memcmp(ChunkHeader, "data", 4) == 0)
+                {
+                    // A zero size means the header was never patched (the session did not stop cleanly); use what is on disk.
+                    int64 DataBytes = ChunkBytes == 0xFFFFFFFFu && Ds64DataBytes >= 0 ? Ds64DataBytes : static_cast<int64>(ChunkBytes);
+                    if (DataBytes == 0 || PayloadStart + DataBytes > FileSize)
+                    {
+                        DataBytes = FileSize - PayloadStart;
+                    }
+                    if (BitsPerSample != 16 || NumChannels <= 0 || SampleRate <= 0)
+                    {
+                        return false;
+                    }
+                    TotalFrames = DataBytes / (NumChannels * sizeof(int16));
+                    return true;
+                }
+
+                FileHandle->Seek(PayloadStart + ChunkBytes + (ChunkBytes & 1));
+            }
+            return false;
+        }
+
+        /** Appends up to NumFrames interleaved sample frames to Out. */
+        int64 Read(int64 NumFrames, TArray<int16>& Out)
+        {
+            const int64 Frames = FMath::Clamp<int64>(NumFrames, 0, TotalFrames - FramesRead);
+            if (Frames == 0)
+            {
+                return 0;
+            }
+
+            const int32 Start = Out.Num();
+            Out.AddUninitialized(static_cast<int32>(Frames * NumChannels));
+            if (!FileHandle->Read(reinterpret_cast<uint8*>(Out.GetData() + Start), Frames * NumChannels * sizeof(int16)))
+            {
+                Out.SetNum(Start);
+                TotalFrames = FramesRead;
+                return 0;
+            }
+            FramesRead += Frames;
+            return Frames;
+        }
+
+        int32 GetSampleRate() const { return SampleRate; }
+        int32 GetNumChannels() const { return NumChannels; }
+        int64 GetTotalFrames() const { return TotalFrames; }
+        int64 GetFramesRead() const { return FramesRead; }
+
+    private:
+        static uint32 ReadLE32(const uint8* Data)
+        {
+            return Data[0] | (Data[1] << 8) | (Data[2] << 16) | (static_cast<uint32>(Data[3]) << 24);
+        }
+
+        TUniquePtr<IFileHandle> FileHandle;
+        int32 SampleRate = 0;
+        int32 NumChannels = 0;
+        int64 TotalFrames = 0;
+        int64 FramesRead = 0;
+    };
+
+    bool OpenContainerWriters(const FString& Mp4Path, const FString& MkvPath, const FPanoContainerConfig& Config, TArray<TUniquePtr<IPanoContainerWriter>>& OutWriters)
+    {
+        bool bOpened = true;
+        if (!Mp4Path.IsEmpty())
+        {
+            TUniquePtr<IPanoContainerWriter> Writer = MakeUnique<FPanoMp4Writer>();
+            bOpened &= Writer->Open(Mp4Path, Config);
+            OutWriters.Add(MoveTemp(Writer));
+        }
+        if (!MkvPath.IsEmpty())
+        {
+            TUniquePtr<IPanoContainerWriter> Writer = MakeUnique<FPanoMkvWriter>();
+            bOpened &= Writer->Open(MkvPath, Config);
+            OutWriters.Add(MoveTemp(Writer));
+        }
+        return bOpened;
+    }
+
+    /** First audio sample frame past the end of the video in [0, VideoEndFrame). */
+    int64 GetAudioEndFrame(const FPanoContainerConfig& Config, int64 VideoEndFrame)
+    {
+        const double VideoEndSeconds = Config.VideoDelaySeconds + VideoEndFrame / static_cast<double>(Config.FrameRate);
+        return FMath::RoundToInt64((VideoEndSeconds - Config.AudioDelaySeconds) * Config.AudioSampleRate);
+    }
+}
+
+namespace PanoramaMuxer
+{
+    bool Run(const FPanoMuxJob& Job)
+    {
+        const double StartSeconds = FPlatformTime::Seconds();
+
+        TUniquePtr<IFileHandle> Bitstream(FPlatformFileManager::Get().GetPlatformFile().OpenRead(*Job.BitstreamPath));
+        if (!Bitstream)
+        {
+            UE_LOG(LogTemp, Error, TEXT("Panorama mux: cannot open bitstream %s"), *Job.BitstreamPath);
+            return false;
+        }
+
+        FWavReader Wav;
+        const bool bHasAudio = !Job.AudioWavPath.IsEmpty() && Wav.Open(Job.AudioWavPath);
+        if (!Job.AudioWavPath.IsEmpty() && !bHasAudio)
+        {
+            UE_LOG(LogTemp, Warning, TEXT("Panorama mux: %s is not a 16-bit PCM WAV; writing video only."), *Job.AudioWavPath);
+        }
+
+        FPanoContainerConfig Config;
+        Config.Codec = Job.Codec;
+        Config.Resolution = Job.Resolution;
+        Config.FrameRate = FMath::Max(1.f, Job.FrameRate);
+        Config.bStereoTopBottom = Job.bStereoTopBottom;
+        Config.Crop = Job.Crop;
+        Config.AudioSampleRate = bHasAudio ? Wav.GetSampleRate() : 0;
+        Config.AudioChannels = bHasAudio ? Wav.GetNumChannels() : 0;
+        Config.VideoDelaySeconds = bHasAudio ? FMath::Max(0.0, Job.VideoOffsetSeconds) : 0.0;
+        Config.AudioDelaySeconds = bHasAudio ? FMath::Max(0.0, -Job.VideoOffsetSeconds) : 0.0;
+
+        FPanoAnnexBParser Parser(Job.Codec);
+        TArray<TUniquePtr<IPanoContainerWriter>> Writers;
+        TArray<FPanoVideoSample> Gop;
+        TArray<int16> GopAudio;
+        TArray<uint8> Chunk;
+        int64 NextFrameIndex = 0;
+        int64 GopFirstFrame = 0;
+        int64 SkippedFrames = 0;
+        bool bOpened = false;
+        bool bSucceeded = true;
+
+        // Writes the buffered GOP together with the audio that plays alongside it.
+        auto FlushGop = [&](bool bFinal)
+        {
+            if (Gop.Num() == 0 && !bFinal)
+            {
+                return;
+            }
+
+            GopAudio.Reset();
+            const int64 AudioFirstFrame = Wav.GetFramesRead();
+            if (bHasAudio)
+            {
+                const int64 AudioEnd = bFinal ? Wav.GetTotalFrames() : GetAudioEndFrame(Config, GopFirstFrame + Gop.Num());
+                Wav.Read(AudioEnd - AudioFirstFrame, GopAudio);
+            }
+
+            FPanoAnnexBParser::ResolvePresentationOrder(Gop);
+            for (TUniquePtr<IPanoContainerWriter>& Writer : Writers)
+            {
+                bSucceeded &= Writer->WriteFragment(Gop, GopFirstFrame, GopAudio, AudioFirstFrame);
+            }
+            GopFirstFrame += Gop.Num();
+            Gop.Reset();
+        };
+
+        auto ConsumeSamples = [&]()
+        {
+            FPanoVideoSample Sample;
+            while (bSucceeded && Parser.Pop(Sample))
+            {
+                const int64 SampleIndex = NextFrameIndex++;
+                if (!bOpened)
+                {
+                    // Decoding can only start at a keyframe once the parameter sets are known.
+                    if (!Sample.bKeyframe || !Parser.HasCodecConfig())
+                    {
+                        ++SkippedFrames;
+                        continue;
+                    }
+
+                    Config.CodecConfig = Parser.BuildCodecConfig();
+                    bSucceeded &= OpenContainerWriters(Job.Mp4Path, Job.MkvPath, Config, Writers);
+                    bOpened = true;
+                    GopFirstFrame = SampleIndex;
+                }
+                else if (Sample.bKeyframe)
+                {
+                    FlushGop(false);
+                }
+                Gop.Add(MoveTemp(Sample));
+            }
+        };
+
+        Chunk.SetNumUninitialized(kBitstreamChunkBytes);
+        const int64 BitstreamBytes = Bitstream->Size();
+        for (int64 Offset = 0; Offset < BitstreamBytes && bSucceeded; Offset += kBitstreamChunkBytes)
+        {
+            const int64 ChunkBytes = FMath::Min(kBitstreamChunkBytes, BitstreamBytes - Offset);
+            if (!Bitstream->Read(Chunk.GetData(), ChunkBytes))
+            {
+                UE_LOG(LogTemp, Error, TEXT("Panorama mux: read error in %s"), *Job.BitstreamPath);
+                bSucceeded = false;
+                break;
+            }
+            Parser.Push(Chunk.GetData(), ChunkBytes);
+            ConsumeSamples();
+        }
+        Parser.Finish();
+        ConsumeSamples();
+
+        if (!bOpened)
+        {
+            UE_LOG(LogTemp, Error, TEXT("Panorama mux: no decodable keyframe in %s"), *Job.BitstreamPath);
+            return false;
+        }
+
+        FlushGop(true);
+        for (TUniquePtr<IPanoContainerWriter>& Writer : Writers)
+        {
+            const bool bClosed = Writer->Close();
+            bSucceeded &= bClosed;
+            if (bClosed)
+            {
+                UE_LOG(LogTemp, Log, TEXT("NVENC bitstream packaged to %s"), *Writer->GetPath());
+            }
+        }
+
+        if (SkippedFrames > 0)
+        {
+            UE_LOG(LogTemp, Warning, TEXT("Panorama mux: skipped %lld frames before the first keyframe."), SkippedFrames);
+        }
+        UE_LOG(LogTemp, Log, TEXT("Panorama mux: %lld frames, %.2f s of audio, %d container(s) in %.2f s"),
+            GopFirstFrame, bHasAudio ? Wav.GetFramesRead() / static_cast<double>(Config.AudioSampleRate) : 0.0,
+            Writers.Num(), FPlatformTime::Seconds() - StartSeconds);
+        return bSucceeded;
+    }
+
+    TFuture<bool> Launch(const FPanoMuxJob& Job)
+    {
+        return Async(EAsyncExecution::Thread, [Job]()
+        {
+            return Run(Job);
+        });
+    }
+}
+
+FPanoLiveMuxer::FPanoLiveMuxer(const FPanoLiveMuxParams& InParams)
+    : Params(InParams)
+    , Parser(InParams.Codec)
+    , GopFirstFrame(0)
+    , NextFrameIndex(0)
+    , SkippedFrames(0)
+    , PendingAudioFirstFrame(0)
+    , VideoStartSeconds(0.0)
+    , bHasVideoStart(false)
+    , bOpened(false)
+    , bFailed(false)
+    , bFinished(false)
+    , FragmentsWritten(0)
+{
+    Config.Codec = Params.Codec;
+    Config.Resolution = Params.Resolution;
+    Config.FrameRate = FMath::Max(1.f, Params.FrameRate);
+    Config.bStereoTopBottom = Params.bStereoTopBottom;
+    Config.Crop = Params.Crop;
+    Config.AudioSampleRate = Params.AudioChannels > 0 ? Params.AudioSampleRate : 0;
+    Config.AudioChannels = Params.AudioSampleRate > 0 ? Params.AudioChannels : 0;
+}
+
+FPanoLiveMuxer::~FPanoLiveMuxer()
+{
+    Finish();
+}
+
+void FPanoLiveMuxer::SetVideoStartSeconds(double SessionSeconds)
+{
+    FScopeLock Lock(&Guard);
+    VideoStartSeconds = SessionSeconds;
+    bHasVideoStart = true;
+}
+
+void FPanoLiveMuxer::AppendVideo(const uint8* Data, int64 Num)
+{
+    FScopeLock Lock(&Guard);
+    if (bFinished || bFailed)
+    {
+        return;
+    }
+    Parser.Push(Data, Num);
+    ConsumeSamples();
+}
+
+void FPanoLiveMuxer::AppendAudio(const int16* Samples, int64 NumSamples)
+{
+    FScopeLock Lock(&Guard);
+    if (bFinished || !Config.HasAudio())
+    {
+        return;
+    }
+
+    PendingAudio.Append(Samples, static_cast<int32>(NumSamples));
+    if (!bOpened)
+    {
+        const int32 MaxSamples = FMath::RoundToInt32(kMaxPendingAudioSeconds * Config.AudioSampleRate) * Config.AudioChannels;
+        const int32 Excess = PendingAudio.Num() - MaxSamples;
+        if (Excess > 0)
+        {
+            const int32 ExcessFrames = FMath::DivideAndRoundUp(Excess, Config.AudioChannels);
+            PendingAudio.RemoveAt(0, ExcessFrames * Config.AudioChannels, EAllowShrinking::No);
+            PendingAudioFirstFrame += ExcessFrames;
+        }
+    }
+}
+
+void FPanoLiveMuxer::ConsumeSamples()
+{
+    FPanoVideoSample Sample;
+    while (!bFailed && Parser.Pop(Sample))
+    {
+        const int64 SampleIndex = NextFrameIndex++;
+        if (Gop.Num() == 0 && !bOpened)
+        {
+            if (!Sample.bKeyframe || !Parser.HasCodecConfig())
+            {
+                ++SkippedFrames;
+                continue;
+            }
+            GopFirstFrame = SampleIndex;
+        }
+        else if (Sample.bKeyframe)
+        {
+            FlushGop(false);
+        }
+        Gop.Add(MoveTemp(Sample));
+    }
+}
+
+bool FPanoLiveMuxer::OpenWriters()
+{
+    // Same alignment as the timing sidecar: frame 0 against the first recorded audio sample.
+    if (Config.HasAudio())
+    {
+        const bool bAudioLocked = Params.CaptureClock && Params.CaptureClock->HasAudio() && bHasVideoStart;
+        const double VideoOffsetSeconds = bAudioLocked ? VideoStartSeconds - Params.CaptureClock->GetAudioStartSeconds() : 0.0;
+        if (!bAudioLocked)
+        {
+            UE_LOG(LogTemp, Warning, TEXT("Panorama live mux: audio clock not running at the first fragment; assuming no A/V offset."));
+        }
+        Config.VideoDelaySeconds = FMath::Max(0.0, VideoOffsetSeconds);
+        Config.AudioDelaySeconds = FMath::Max(0.0, -VideoOffsetSeconds);
+    }
+
+    Config.CodecConfig = Parser.BuildCodecConfig();
+    bOpened = true;
+    return OpenContainerWriters(Params.Mp4Path, Params.MkvPath, Config, Writers);
+}
+
+void FPanoLiveMuxer::FlushGop(bool bFinal)
+{
+    if (bFailed || (Gop.Num() == 0 && !bFinal))
+    {
+        return;
+    }
+    if (!bOpened)
+    {
+        if (Gop.Num() == 0)
+        {
+            return;
+        }
+        bFailed = !OpenWriters();
+    }
+
+    int32 AudioSamples = 0;
+    if (Config.HasAudio())
+    {
+        // Audio still in flight from the writer thread simply lands in the next fragment.
+        const int64 AvailableFrames = PendingAudio.Num() / Config.AudioChannels;
+        const int64 AudioEnd = bFinal ? PendingAudioFirstFrame + AvailableFrames : GetAudioEndFrame(Config, GopFirstFrame + Gop.Num());
+        AudioSamples = static_cast<int32>(FMath::Clamp<int64>(AudioEnd - PendingAudioFirstFrame, 0, AvailableFrames) * Config.AudioChannels);
+    }
+
+    const TArrayView<const int16> Audio(PendingAudio.GetData(), AudioSamples);
+    FPanoAnnexBParser::ResolvePresentationOrder(Gop);
+    for (TUniquePtr<IPanoContainerWriter>& Writer : Writers)
+    {
+        bFailed |= !Writer->WriteFragment(Gop, GopFirstFrame, Audio, PendingAudioFirstFrame);
+    }
+    ++FragmentsWritten;
+
+    GopFirstFrame += Gop.Num();
+    Gop.Reset();
+    PendingAudio.RemoveAt(0, AudioSamples, EAllowShrinking::No);
+    PendingAudioFirstFrame += AudioSamples / FMath::Max(1, Config.AudioChannels);
+}
+
+bool FPanoLiveMuxer::Finish()
+{
+    FScopeLock Lock(&Guard);
+    if (bFinished)
+    {
+        return !bFailed;
+    }
+    bFinished = true;
+
+    Parser.Finish();
+    ConsumeSamples();
+    FlushGop(true);
+
+    bool bClosed = bOpened && !bFailed;
+    for (TUniquePtr<IPanoContainerWriter>& Writer : Writers)
+    {
+        bClosed &= Writer->Close();
+    }
+    Writers.Reset();
+    PendingAudio.Empty();
+
+    if (SkippedFrames > 0)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Panorama live mux: skipped %lld frames before the first keyframe."), SkippedFrames);
+    }
+    if (!bOpened)
+    {
+        UE_LOG(LogTemp, Error, TEXT("Panorama live mux: no decodable keyframe was produced; no container written."));
+    }
+    bFailed |= !bClosed;
+    return bClosed;
+}
+
+int32 FPanoLiveMuxer::GetFragmentsWritten() const
+{
+    FScopeLock Lock(&Guard);
+    return FragmentsWritten;
+}
+
+TArray<FString> FPanoLiveMuxer::GetOutputPaths() const
+{
+    TArray<FString> Paths;
+    if (!Params.Mp4Path.IsEmpty())
+    {
+        Paths.Add(Params.Mp4Path);
+    }
+    if (!Params.MkvPath.IsEmpty())
+    {
+        Paths.Add(Params.MkvPath);
+    }
+    return Paths;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PanoramaCaptureTypes.h"
+#include "Async/Future.h"
+#include "HAL/CriticalSection.h"
+#include "PanoramaAnnexB.h"
+#include "PanoramaContainerWriter.h"
+
+class FPanoCaptureClock;
+
+/** Inputs and outputs of one container packaging pass. An empty output path skips that container. */
+struct FPanoMuxJob
+{
+    FString BitstreamPath;
+    /** 16-bit PCM WAV from the audio recorder; empty for a video-only container. */
+    FString AudioWavPath;
+    EPanoramaCaptureCodec Codec = EPanoramaCaptureCodec::H264;
+    FIntPoint Resolution = FIntPoint::ZeroValue;
+    float FrameRate = 30.f;
+    bool bStereoTopBottom = false;
+    FPanoEquirectCrop Crop;
+    /** Offset of video frame 0 from audio sample 0, as returned by the timing sidecar. */
+    double VideoOffsetSeconds = 0.0;
+    FString Mp4Path;
+    FString MkvPath;
+};
+
+/**
+ * Native replacement for the ffmpeg stream-copy step of the NVENC path. Reads the Annex-B elementary
+ * stream and the WAV once, GOP by GOP, and writes fragmented MP4 and Matroska side by side with
+ * spherical metadata. Audio stays PCM; nothing is re-encoded.
+ */
+namespace PanoramaMuxer
+{
+    /** Blocking; returns true when every requested container was written. */
+    bool Run(const FPanoMuxJob& Job);
+
+    /** Runs the job on its own thread. */
+    TFuture<bool> Launch(const FPanoMuxJob& Job);
+}
+
+struct FPanoLiveMuxParams
+{
+    EPanoramaCaptureCodec Codec = EPanoramaCaptureCodec::H264;
+    FIntPoint Resolution = FIntPoint::ZeroValue;
+    float FrameRate = 30.f;
+    bool bStereoTopBottom = false;
+    FPanoEquirectCrop Crop;
+    /** Zero channels for a video-only session. */
+    int32 AudioSampleRate = 0;
+    int32 AudioChannels = 0;
+    /** Supplies the audio start time that aligns the tracks; required when audio is enabled. */
+    const FPanoCaptureClock* CaptureClock = nullptr;
+    FString Mp4Path;
+    FString MkvPath;
+};
+
+/**
+ * Writes the containers while the session is recording. The encoder callback appends its Annex-B output and
+ * the audio writer appends PCM; every time a new GOP starts, the previous one is written out with its audio
+ * as one MP4 fragment and one Matroska cluster. The containers are opened on the first fragment, once the
+ * audio/video offset is known. A session that dies mid-capture leaves both files playable up to the last
+ * complete GOP, and Finish only writes the last fragment and patches the indexes.
+ */
+class FPanoLiveMuxer
+{
+public:
+    explicit FPanoLiveMuxer(const FPanoLiveMuxParams& InParams);
+    ~FPanoLiveMuxer();
+
+    /** Game thread: capture-clock time of video frame 0. */
+    void SetVideoStartSeconds(double SessionSeconds);
+
+    /** Encoder callback thread: encoded bytes in output order. */
+    void AppendVideo(const uint8* Data, int64 Num);
+
+    /** Audio writer thread: interleaved 16-bit samples, contiguous from sample frame 0. */
+    void AppendAudio(const int16* Samples, int64 NumSamples);
+
+    /** Writes the trailing GOP and every remaining audio sample, then closes the containers. */
+    bool Finish();
+
+    int32 GetFragmentsWritten() const;
+
+    /** Containers this muxer writes; empty paths are skipped. */
+    TArray<FString> GetOutputPaths() const;
+
+private:
+    void ConsumeSamples();
+    bool OpenWriters();
+    void FlushGop(bool bFinal);
+
+    FPanoLiveMuxParams Params;
+    FPanoContainerConfig Config;
+    mutable FCriticalSection Guard;
+
+    FPanoAnnexBParser Parser;
+    TArray<TUniquePtr<IPanoContainerWriter>> Writers;
+    TArray<FPanoVideoSample> Gop;
+    int64 GopFirstFrame;
+    int64 NextFrameIndex;
+    int64 SkippedFrames;
+
+    /** Audio not yet written to a fragment; PendingAudio[0] is sample frame PendingAudioFirstFrame. */
+    TArray<int16> PendingAudio;
+    int64 PendingAudioFirstFrame;
+
+    double VideoStartSeconds;
+    bool bHasVideoStart;
+    bool bOpened;
+    bool bFailed;
+    bool bFinished;
+    int32 FragmentsWritten;
+};
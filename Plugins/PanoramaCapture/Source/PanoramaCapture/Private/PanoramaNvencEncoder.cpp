@@ -53,17 +53,20 @@ bool FPanoNvencEncoder::Initialize(const FPanoramaNvencEncodeParams& Params)
         return false;
     }
 
-    if (Params.OutputBitstreamPath.IsEmpty())
+    if (Params.OutputBitstreamPath.IsEmpty() && !Params.OnBitstream)
     {
         return false;
     }
 
-    IFileManager::Get().Delete(*Params.OutputBitstreamPath);
-
-    BitstreamWriter.Reset(IFileManager::Get().CreateFileWriter(*Params.OutputBitstreamPath));
-    if (!BitstreamWriter)
+    if (!Params.OutputBitstreamPath.IsEmpty())
     {
-        UE_LOG(LogTemp, Warning, TEXT("Failed to create NVENC bitstream output '%s'. Falling back to in-memory buffering."), *Params.OutputBitstreamPath);
+        IFileManager::Get().Delete(*Params.OutputBitstreamPath);
+
+        BitstreamWriter.Reset(IFileManager::Get().CreateFileWriter(*Params.OutputBitstreamPath));
+        if (!BitstreamWriter)
+        {
+            UE_LOG(LogTemp, Warning, TEXT("Failed to create NVENC bitstream output '%s'. Falling back to in-memory buffering."), *Params.OutputBitstreamPath);
+        }
     }
 
     bInitialized = true;
@@ -196,12 +199,21 @@ bool FPanoNvencEncoder::EncodeFrame_RenderThread(FTextureRHIRef Texture, uint64
             this
         ](const FVideoEncoder::FEncodedImage& EncodedImage)
         {
-            FPanoramaEncodedFrame EncodedFrame;
-            EncodedFrame.FrameIndex = EncodedImage.FrameId;
-            EncodedFrame.Timecode = EncodedImage.Timestamp;
-            EncodedFrame.EncodedBytes = EncodedImage.Data;
+            if (ActiveParams.OnBitstream && EncodedImage.Data.Num() > 0)
+            {
+                ActiveParams.OnBitstream(EncodedImage.Data.GetData(), EncodedImage.Data.Num());
+            }
+
             FScopeLock Lock(&PendingFramesGuard);
-            PendingFrames.Add(MoveTemp(EncodedFrame));
+            // Frames are only kept in memory when nothing else persists them.
+            if (!BitstreamWriter && !ActiveParams.OnBitstream)
+            {
+                FPanoramaEncodedFrame EncodedFrame;
+                EncodedFrame.FrameIndex = EncodedImage.FrameId;
+                EncodedFrame.Timecode = EncodedImage.Timestamp;
+                EncodedFrame.EncodedBytes = EncodedImage.Data;
+                PendingFrames.Add(MoveTemp(EncodedFrame));
+            }
             if (BitstreamWriter && EncodedImage.Data.Num() > 0)
             {
                 FScopeLock WriterLock(&BitstreamWriterGuard);
@@ -0,0 +1,118 @@
+#include "PanoramaOdsBenchmark.h"
+
+#include "HAL/IConsoleManager.h"
+#include "PanoramaOdsProjection.h"
+
+namespace
+{
+    double AngleBetween(const FVector3d& A, const FVector3d& B)
+    {
+        return FMath::Atan2((A ^ B).Size(), A | B);
+    }
+
+    /** Rig-frame right of a viewing direction, level with the horizon. */
+    FVector3d GetHorizontalRight(const FVector3d& Direction)
+    {
+        return (FVector3d::UpVector ^ FVector3d(Direction.X, Direction.Y, 0.0)).GetSafeNormal();
+    }
+}
+
+FPanoOdsCheckResult PanoramaOdsBenchmark::Check(const FPanoOdsLayout& Layout, FIntPoint Resolution)
+{
+    const FVector2d HalfTexel(0.5 / Layout.TileSize.X, 0.5 / Layout.TileSize.Y);
+    const double EyeRadius = Layout.EyeRadius;
+
+    FPanoOdsCheckResult Result;
+    Result.MinStitchedRayDistance = TNumericLimits<double>::Max();
+    for (int32 EyeIndex = 0; EyeIndex < 2; ++EyeIndex)
+    {
+        // Eye 0 is the left eye; its rays start on the left of the direction they look along.
+        const double Side = EyeIndex == 0 ? -1.0 : 1.0;
+        for (int32 Y = 0; Y < Resolution.Y; ++Y)
+        {
+            const float Latitude = (0.5f - (Y + 0.5f) / Resolution.Y) * UE_PI;
+            if (PanoramaOds::GetPoleMergeWeight(Layout, Latitude) >= 1.f)
+            {
+                continue;
+            }
+            for (int32 X = 0; X < Resolution.X; ++X)
+            {
+                const float Longitude = ((X + 0.5f) / Resolution.X - 0.5f) * UE_TWO_PI;
+                const FPanoOdsSample Sample = PanoramaOds::Project(Layout, Longitude, Latitude);
+                ++Result.Pixels;
+                if (Sample.TileUv.X < HalfTexel.X || Sample.TileUv.X > 1.0 - HalfTexel.X || Sample.TileUv.Y < HalfTexel.Y || Sample.TileUv.Y > 1.0 - HalfTexel.Y)
+                {
+                    ++Result.OutsideTile;
+                }
+
+                FVector3f RayOrigin;
+                FVector3f RayDirection;
+                PanoramaOds::GetRay(Longitude, Latitude, EyeIndex, Layout.EyeRadius, RayOrigin, RayDirection);
+                const FVector3d Origin(RayOrigin);
+                const FVector3d Direction(RayDirection);
+                Result.MaxRayOriginError = FMath::Max(Result.MaxRayOriginError, (Origin - GetHorizontalRight(Direction) * (Side * EyeRadius)).Size());
+
+                const FVector3d SampledDirection(PanoramaOds::Unproject(Layout, Sample.Slice, Sample.Pitch, Sample.TileUv));
+                Result.MaxRoundTrip = FMath::Max(Result.MaxRoundTrip, AngleBetween(SampledDirection, Direction));
+
+                // The line from the view origin along the sampled direction, measured against the rig axis.
+                const FVector3d ViewOrigin(PanoramaOds::GetViewOrigin(Layout, EyeIndex, Sample.Slice));
+                const FVector3d SampledRight = GetHorizontalRight(SampledDirection);
+                const double AxisDistance = ViewOrigin | SampledRight;
+                Result.WrongSideRays += AxisDistance * Side <= 0.0 ? 1 : 0;
+                Result.MinStitchedRayDistance = FMath::Min(Result.MinStitchedRayDistance, FMath::Abs(AxisDistance));
+                Result.MaxStitchedRayDistance = FMath::Max(Result.MaxStitchedRayDistance, FMath::Abs(AxisDistance));
+
+                for (int32 Depth = 0; Depth < UE_ARRAY_COUNT(kPanoOdsCheckDepthsCm); ++Depth)
+                {
+                    const FVector3d ScenePoint = Origin + Direction * kPanoOdsCheckDepthsCm[Depth];
+                    Result.MaxSlitScan[Depth] = FMath::Max(Result.MaxSlitScan[Depth], AngleBetween(ScenePoint - ViewOrigin, Direction));
+                }
+            }
+        }
+    }
+    if (Result.Pixels == 0)
+    {
+        Result.MinStitchedRayDistance = 0.0;
+    }
+    return Result;
+}
+
+namespace
+{
+    /**
+     * Logs PanoramaOdsBenchmark::Check for a Width x Width/2 equirect: tile bounds, the Project/Unproject round trip,
+     * the exact and stitched ray geometry, and the slit-scan error in output pixels.
+     */
+    void RunOdsCheck(const TArray<FString>& Args)
+    {
+        FPanoOdsSettings Settings;
+        Settings.SliceCount = Args.Num() > 0 ? FMath::Clamp(FCString::Atoi(*Args[0]), 8, 720) : Settings.SliceCount;
+        const int32 Width = Args.Num() > 1 ? FMath::Max(64, FCString::Atoi(*Args[1])) : 4096;
+        Settings.bPoleMerge = Args.Num() > 2 ? FCString::Atoi(*Args[2]) != 0 : Settings.bPoleMerge;
+        const FIntPoint Resolution(Width, Width / 2);
+        const float EyeRadius = 3.2f;
+
+        // The component sizes the views from the cube face density; faces are a quarter of the equirect width.
+        const FPanoOdsLayout Layout = PanoramaOds::MakeLayout(Settings, Width * 0.125f, EyeRadius, 16384);
+        const double PixelsPerRadian = Width / UE_DOUBLE_TWO_PI;
+        const FPanoOdsCheckResult Result = PanoramaOdsBenchmark::Check(Layout, Resolution);
+
+        UE_LOG(LogTemp, Display, TEXT("Panorama ODS check: %d slices x %d pitch steps, %dx%d px views, %dx%d equirect, pole merge %s"),
+            Layout.SliceCount, Layout.PitchSteps, Layout.TileSize.X, Layout.TileSize.Y, Resolution.X, Resolution.Y, Layout.HasPoleMerge() ? TEXT("on") : TEXT("off"));
+        UE_LOG(LogTemp, Display, TEXT("  %lld slice pixels, %lld outside their tile; round trip max %.4f deg"),
+            Result.Pixels, Result.OutsideTile, FMath::RadiansToDegrees(Result.MaxRoundTrip));
+        UE_LOG(LogTemp, Display, TEXT("  exact rays: max origin error %.2e cm; stitched rays: %.4f to %.4f cm from the axis (eye radius %.4f), %lld on the wrong side"),
+            Result.MaxRayOriginError, Result.MinStitchedRayDistance, Result.MaxStitchedRayDistance, EyeRadius, Result.WrongSideRays);
+        for (int32 Depth = 0; Depth < UE_ARRAY_COUNT(kPanoOdsCheckDepthsCm); ++Depth)
+        {
+            UE_LOG(LogTemp, Display, TEXT("  slit-scan error at %.0f cm: max %.3f deg (%.2f px)"),
+                kPanoOdsCheckDepthsCm[Depth], FMath::RadiansToDegrees(Result.MaxSlitScan[Depth]), Result.MaxSlitScan[Depth] * PixelsPerRadian);
+        }
+    }
+
+    FAutoConsoleCommand GPanoramaOdsCheckCommand(
+        TEXT("Panorama.OdsCheck"),
+        TEXT("Checks the ODS slice layout and stitch mapping against the exact ODS rays on the CPU. Usage: Panorama.OdsCheck [SliceCount] [Width] [PoleMerge 0|1]"),
+        FConsoleCommandWithArgsDelegate::CreateStatic(&RunOdsCheck));
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FPanoOdsLayout;
+
+/** Scene depths the slit-scan error is measured at; the error falls off roughly as 1 / depth. */
+constexpr double kPanoOdsCheckDepthsCm[] = { 100.0, 1000.0 };
+
+/** Worst cases over every equirect pixel, of both eyes, that reads the slices. Angles in radians, distances in world units. */
+struct FPanoOdsCheckResult
+{
+    int64 Pixels = 0;
+    /** Tile UVs closer than half a texel to their tile's edge. */
+    int64 OutsideTile = 0;
+    /** Between Unproject(Project(direction)) and the direction. */
+    double MaxRoundTrip = 0.0;
+    /** Exact rays: distance of the origin from the point on the eye circle a quarter turn to the eye's side of the azimuth. */
+    double MaxRayOriginError = 0.0;
+    /**
+     * Rays the stitch actually reads, from the slice view's origin through the unprojected tile UV. Exact ODS rays pass
+     * the rig axis at the eye radius; the slit-scan rays at the eye radius times the cosine of their yaw off the slice.
+     */
+    double MinStitchedRayDistance = 0.0;
+    double MaxStitchedRayDistance = 0.0;
+    /** Stitched rays whose view origin lies on the other eye's side of the ray. */
+    int64 WrongSideRays = 0;
+    /** Between a point on the exact ray and the same point seen from the slice view's origin, per kPanoOdsCheckDepthsCm. */
+    double MaxSlitScan[UE_ARRAY_COUNT(kPanoOdsCheckDepthsCm)] = {};
+};
+
+namespace PanoramaOdsBenchmark
+{
+    /** Checks the ODS layout the stitch shader samples against the exact ODS rays on the CPU, for a Resolution-sized equirect. */
+    FPanoOdsCheckResult Check(const FPanoOdsLayout& Layout, FIntPoint Resolution);
+}
@@ -0,0 +1,156 @@
+#include "PanoramaOdsProjection.h"
+
+#include "PanoramaCaptureRegion.h"
+
+namespace
+{
+    /** Pitch steps are at most this tall, which keeps texel density within about a third of the centre value. */
+    constexpr float kOdsMaxPitchStepDegrees = 60.f;
+    /** Overlap added to each view beyond its share of the sphere, so bilinear taps at a tile edge stay inside it. */
+    constexpr float kOdsViewMarginTexels = 2.f;
+    constexpr int32 kOdsMinTileSize = 4;
+
+    int32 RoundUpToEven(float Value)
+    {
+        const int32 Size = FMath::Max(kOdsMinTileSize, FMath::CeilToInt32(Value));
+        return Size + (Size & 1);
+    }
+}
+
+namespace PanoramaOds
+{
+    FPanoOdsLayout MakeLayout(const FPanoOdsSettings& Settings, float PixelsPerRadian, float EyeRadius, int32 MaxTextureSize)
+    {
+        FPanoOdsLayout Layout;
+        Layout.SliceCount = FMath::Clamp(Settings.SliceCount, 8, 720);
+        Layout.SliceWidth = UE_TWO_PI / Layout.SliceCount;
+        Layout.EyeRadius = EyeRadius;
+
+        float CoveredDegrees = 90.f;
+        if (Settings.bPoleMerge)
+        {
+            const float MergeEnd = FMath::Clamp(Settings.PoleMergeEndDegrees, 1.f, 90.f);
+            const float MergeStart = FMath::Clamp(Settings.PoleMergeStartDegrees, 0.f, MergeEnd - 0.5f);
+            Layout.PoleMergeStart = FMath::DegreesToRadians(MergeStart);
+            Layout.PoleMergeEnd = FMath::DegreesToRadians(MergeEnd);
+            CoveredDegrees = MergeEnd;
+        }
+        Layout.CoveredLatitude = FMath::DegreesToRadians(CoveredDegrees);
+        Layout.PitchSteps = FMath::Max(1, FMath::CeilToInt32(2.f * CoveredDegrees / kOdsMaxPitchStepDegrees));
+        Layout.PitchStep = 2.f * Layout.CoveredLatitude / Layout.PitchSteps;
+
+        // Away from a view's centre line the forward component shrinks, so each half-extent is widened by the
+        // cosine of the other one to keep the corners of the view's share of the sphere inside it.
+        auto GetTangents = [&Layout](float Margin, float& OutHorizontal, float& OutVertical)
+        {
+            const float HalfHorizontal = 0.5f * Layout.SliceWidth + Margin;
+            const float HalfVertical = 0.5f * Layout.PitchStep + Margin;
+            OutHorizontal = FMath::Tan(HalfHorizontal) / FMath::Cos(HalfVertical);
+            OutVertical = FMath::Tan(HalfVertical) / FMath::Cos(HalfHorizontal);
+        };
+
+        float TanHalfHorizontal = 0.f;
+        float TanHalfVertical = 0.f;
+        GetTangents(0.f, TanHalfHorizontal, TanHalfVertical);
+        const float AtlasWidth = Layout.SliceCount * 2.f * TanHalfHorizontal * PixelsPerRadian;
+        const float AtlasHeight = 2.f * Layout.PitchSteps * 2.f * TanHalfVertical * PixelsPerRadian;
+        float Density = FMath::Max(1.f, PixelsPerRadian * FMath::Min(1.f, MaxTextureSize / FMath::Max(AtlasWidth, AtlasHeight)));
+
+        // Tiles are rounded up to even sizes after adding the margin, then clamped to the texture limit. The density is
+        // then re-fitted to the clamped tiles, and the field of view follows it, so pixels stay square and the
+        // coverage never shrinks.
+        GetTangents(kOdsViewMarginTexels / Density, TanHalfHorizontal, TanHalfVertical);
+        const int32 MaxTileWidth = FMath::Max(kOdsMinTileSize, (MaxTextureSize / Layout.SliceCount) & ~1);
+        const int32 MaxTileHeight = FMath::Max(kOdsMinTileSize, (MaxTextureSize / (2 * Layout.PitchSteps)) & ~1);
+        Layout.TileSize = FIntPoint(
+            FMath::Min(RoundUpToEven(2.f * TanHalfHorizontal * Density), MaxTileWidth),
+            FMath::Min(RoundUpToEven(2.f * TanHalfVertical * Density), MaxTileHeight));
+        Density = FMath::Min(Layout.TileSize.X / (2.f * TanHalfHorizontal), Layout.TileSize.Y / (2.f * TanHalfVertical));
+        Layout.TanHalfHorizontal = Layout.TileSize.X / (2.f * Density);
+        Layout.TanHalfVertical = Layout.TileSize.Y / (2.f * Density);
+        return Layout;
+    }
+
+    void GetRay(float Longitude, float Latitude, int32 EyeIndex, float EyeRadius, FVector3f& OutOrigin, FVector3f& OutDirection)
+    {
+        const float Side = EyeIndex == 0 ? -1.f : 1.f;
+        OutOrigin = FVector3f(-FMath::Sin(Longitude), FMath::Cos(Longitude), 0.f) * (Side * EyeRadius);
+        OutDirection = FVector3f(FMath::Cos(Latitude) * FMath::Cos(Longitude), FMath::Cos(Latitude) * FMath::Sin(Longitude), FMath::Sin(Latitude));
+    }
+
+    FVector3f GetViewOrigin(const FPanoOdsLayout& Layout, int32 EyeIndex, int32 Slice)
+    {
+        FVector3f Origin;
+        FVector3f Direction;
+        GetRay(Layout.GetSliceYaw(Slice), 0.f, EyeIndex, Layout.EyeRadius, Origin, Direction);
+        return Origin;
+    }
+
+    FRotator GetViewRotation(const FPanoOdsLayout& Layout, int32 Slice, int32 Pitch)
+    {
+        return FRotator(FMath::RadiansToDegrees(Layout.GetPitch(Pitch)), FMath::RadiansToDegrees(Layout.GetSliceYaw(Slice)), 0.f);
+    }
+
+    FPanoOdsSample Project(const FPanoOdsLayout& Layout, float Longitude, float Latitude)
+    {
+        FPanoOdsSample Sample;
+        const int32 Nearest = FMath::FloorToInt32(Longitude / Layout.SliceWidth + 0.5f);
+        Sample.Slice = ((Nearest % Layout.SliceCount) + Layout.SliceCount) % Layout.SliceCount;
+        Sample.Pitch = FMath::Clamp(FMath::FloorToInt32((Latitude + Layout.CoveredLatitude) / Layout.PitchStep), 0, Layout.PitchSteps - 1);
+
+        // Direction in the view's frame: forward tilted up by the view's pitch, right along +Y.
+        const float Yaw = Longitude - Nearest * Layout.SliceWidth;
+        const float Pitch = Layout.GetPitch(Sample.Pitch);
+        const FVector3f Direction(FMath::Cos(Latitude) * FMath::Cos(Yaw), FMath::Cos(Latitude) * FMath::Sin(Yaw), FMath::Sin(Latitude));
+        const float Forward = Direction.X * FMath::Cos(Pitch) + Direction.Z * FMath::Sin(Pitch);
+        const float Up = Direction.Z * FMath::Cos(Pitch) - Direction.X * FMath::Sin(Pitch);
+        Sample.TileUv = FVector2f(0.5f + 0.5f * Direction.Y / (Forward * Layout.TanHalfHorizontal), 0.5f - 0.5f * Up / (Forward * Layout.TanHalfVertical));
+        return Sample;
+    }
+
+    FVector3f Unproject(const FPanoOdsLayout& Layout, int32 Slice, int32 Pitch, FVector2f TileUv)
+    {
+        const float Right = (2.f * TileUv.X - 1.f) * Layout.TanHalfHorizontal;
+        const float Up = (1.f - 2.f * TileUv.Y) * Layout.TanHalfVertical;
+        const float PitchAngle = Layout.GetPitch(Pitch);
+        const FVector3f Local(FMath::Cos(PitchAngle) - Up * FMath::Sin(PitchAngle), Right, FMath::Sin(PitchAngle) + Up * FMath::Cos(PitchAngle));
+        const float Yaw = Layout.GetSliceYaw(Slice);
+        return FVector3f(Local.X * FMath::Cos(Yaw) - Local.Y * FMath::Sin(Yaw), Local.X * FMath::Sin(Yaw) + Local.Y * FMath::Cos(Yaw), Local.Z).GetSafeNormal();
+    }
+
+    float GetPoleMergeWeight(const FPanoOdsLayout& Layout, float Latitude)
+    {
+        if (!Layout.HasPoleMerge())
+        {
+            return 0.f;
+        }
+        return FMath::SmoothStep(Layout.PoleMergeStart, Layout.PoleMergeEnd, FMath::Abs(Latitude));
+    }
+
+    bool GetVisibleViews(const FPanoOdsLayout& Layout, const FPanoRegionBounds& Bounds, TBitArray<>& OutSlices, TBitArray<>& OutPitches)
+    {
+        OutSlices.Init(false, Layout.SliceCount);
+        OutPitches.Init(false, Layout.PitchSteps);
+
+        // Slice depends only on longitude and pitch step only on latitude, so columns and rows are walked separately.
+        const FVector2f InvSphere(1.f / Bounds.SphereResolution.X, 1.f / Bounds.SphereResolution.Y);
+        for (int32 X = Bounds.Rect.Min.X; X < Bounds.Rect.Max.X; ++X)
+        {
+            const float Longitude = ((X + 0.5f) * InvSphere.X - 0.5f) * UE_TWO_PI;
+            OutSlices[Project(Layout, Longitude, 0.f).Slice] = true;
+        }
+
+        bool bReadsCentre = false;
+        for (int32 Y = Bounds.Rect.Min.Y; Y < Bounds.Rect.Max.Y; ++Y)
+        {
+            const float Latitude = (0.5f - (Y + 0.5f) * InvSphere.Y) * UE_PI;
+            const float MergeWeight = GetPoleMergeWeight(Layout, Latitude);
+            bReadsCentre |= MergeWeight > 0.f;
+            if (MergeWeight < 1.f)
+            {
+                OutPitches[Project(Layout, 0.f, Latitude).Pitch] = true;
+            }
+        }
+        return bReadsCentre;
+    }
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PanoramaCaptureTypes.h"
+
+struct FPanoRegionBounds;
+
+/**
+ * Slice geometry of an ODS capture, in the rig's frame (X forward, Y right, Z up). Slice K looks along yaw
+ * K * SliceWidth; each slice is split into PitchSteps views stacked between -CoveredLatitude and +CoveredLatitude.
+ * Views land in an atlas tile per (eye, slice, pitch): slices across, eyes then pitch steps down.
+ */
+struct FPanoOdsLayout
+{
+    int32 SliceCount = 0;
+    int32 PitchSteps = 0;
+    /** Radians. */
+    float SliceWidth = 0.f;
+    float PitchStep = 0.f;
+    float CoveredLatitude = 0.f;
+    /** Tangents of the half field of view of every view; square pixels at the view centre. */
+    float TanHalfHorizontal = 0.f;
+    float TanHalfVertical = 0.f;
+    FIntPoint TileSize = FIntPoint::ZeroValue;
+    /** Half the interpupillary distance, in world units. */
+    float EyeRadius = 0.f;
+    /** Radians; both zero when pole merge is off. */
+    float PoleMergeStart = 0.f;
+    float PoleMergeEnd = 0.f;
+
+    bool HasPoleMerge() const { return PoleMergeEnd > PoleMergeStart; }
+    FIntPoint GetAtlasSize() const { return FIntPoint(SliceCount * TileSize.X, 2 * PitchSteps * TileSize.Y); }
+    FIntPoint GetTileOrigin(int32 EyeIndex, int32 Slice, int32 Pitch) const { return FIntPoint(Slice * TileSize.X, (EyeIndex * PitchSteps + Pitch) * TileSize.Y); }
+    float GetSliceYaw(int32 Slice) const { return Slice * SliceWidth; }
+    float GetPitch(int32 Pitch) const { return -CoveredLatitude + (Pitch + 0.5f) * PitchStep; }
+};
+
+/** Where the stitch reads one output direction: a view's tile and the UV inside it. */
+struct FPanoOdsSample
+{
+    int32 Slice = 0;
+    int32 Pitch = 0;
+    FVector2f TileUv = FVector2f::ZeroVector;
+};
+
+/**
+ * ODS ray math and the slit-scan approximation of it. The stitch shader (PanoramaOdsStitch.usf) mirrors Project and
+ * GetPoleMergeWeight; PanoramaOdsBenchmark::Check tests both against the exact rays on the CPU.
+ */
+namespace PanoramaOds
+{
+    /**
+     * Views sized so the view centre has PixelsPerRadian texels per radian, shrunk if the atlas would exceed
+     * MaxTextureSize. EyeRadius is half the interpupillary distance.
+     */
+    FPanoOdsLayout MakeLayout(const FPanoOdsSettings& Settings, float PixelsPerRadian, float EyeRadius, int32 MaxTextureSize);
+
+    /**
+     * Exact ODS ray of an equirect direction: the origin lies on the eye circle, a quarter turn from the viewing
+     * azimuth (left of it for eye 0, right for eye 1), so every ray is tangent to the circle.
+     */
+    void GetRay(float Longitude, float Latitude, int32 EyeIndex, float EyeRadius, FVector3f& OutOrigin, FVector3f& OutDirection);
+
+    /** Rig-frame position and orientation of view (EyeIndex, Slice, Pitch). */
+    FVector3f GetViewOrigin(const FPanoOdsLayout& Layout, int32 EyeIndex, int32 Slice);
+    FRotator GetViewRotation(const FPanoOdsLayout& Layout, int32 Slice, int32 Pitch);
+
+    /** Tile and UV the stitch samples for a direction within the covered latitudes. */
+    FPanoOdsSample Project(const FPanoOdsLayout& Layout, float Longitude, float Latitude);
+
+    /** Rig-frame direction through TileUv of a view; the inverse of Project. */
+    FVector3f Unproject(const FPanoOdsLayout& Layout, int32 Slice, int32 Pitch, FVector2f TileUv);
+
+    /** Share of the centred capture at Latitude: 0 below the merge band, 1 beyond it, smoothstep in between. */
+    float GetPoleMergeWeight(const FPanoOdsLayout& Layout, float Latitude);
+
+    /**
+     * Marks the slices and pitch steps some pixel of Bounds reads; the rest need not be rendered. Views are rig-relative,
+     * so the result does not change while the rig turns. Returns whether any pixel reads the centred capture.
+     */
+    bool GetVisibleViews(const FPanoOdsLayout& Layout, const FPanoRegionBounds& Bounds, TBitArray<>& OutSlices, TBitArray<>& OutPitches);
+}
@@ -0,0 +1,42 @@
+#include "PanoramaOdsStitchCS.h"
+
+#include "PanoramaOdsProjection.h"
+#include "RenderGraphBuilder.h"
+#include "RenderGraphUtils.h"
+#include "RHIStaticStates.h"
+
+IMPLEMENT_GLOBAL_SHADER(FPanoOdsStitchCS, "/PanoramaCapture/PanoramaOdsStitch.usf", "Main", SF_Compute);
+
+void AddPanoOdsStitchPass(FRDGBuilder& GraphBuilder, const FPanoOdsLayout& Layout, const FPanoOdsStitchInputs& Inputs)
+{
+    const FIntPoint OutputResolution = Inputs.Region.Size();
+    const FIntPoint AtlasSize = Inputs.Atlas->Desc.Extent;
+
+    FPanoOdsStitchCS::FParameters* Parameters = GraphBuilder.AllocParameters<FPanoOdsStitchCS::FParameters>();
+    Parameters->RigToWorld = Inputs.RigToWorld;
+    Parameters->OutputResolution = FVector2f(OutputResolution);
+    Parameters->InvSphereResolution = FVector2f(1.0f / Inputs.SphereResolution.X, 1.0f / Inputs.SphereResolution.Y);
+    Parameters->SphereOffset = FVector2f(Inputs.Region.Min);
+    Parameters->FullResolution = FVector2f(Inputs.Output->Desc.Extent);
+    Parameters->OutputOffset = FVector2f(0.f, Inputs.EyeIndex * OutputResolution.Y);
+    Parameters->bLinearColorSpace = Inputs.bLinearColorSpace ? 1.0f : 0.0f;
+    Parameters->InvAtlasSize = FVector2f(1.0f / AtlasSize.X, 1.0f / AtlasSize.Y);
+    Parameters->TileSize = FVector2f(Layout.TileSize);
+    Parameters->TanHalfFov = FVector2f(Layout.TanHalfHorizontal, Layout.TanHalfVertical);
+    Parameters->SliceCount = Layout.SliceCount;
+    Parameters->PitchSteps = Layout.PitchSteps;
+    Parameters->EyeIndex = Inputs.EyeIndex;
+    Parameters->SliceWidth = Layout.SliceWidth;
+    Parameters->PitchStep = Layout.PitchStep;
+    Parameters->CoveredLatitude = Layout.CoveredLatitude;
+    Parameters->PoleMerge = FVector2f(Layout.PoleMergeStart, Layout.PoleMergeEnd);
+    Parameters->SliceAtlas = Inputs.Atlas;
+    Parameters->AtlasSampler = TStaticSamplerState<SF_Bilinear, AM_Clamp, AM_Clamp, AM_Clamp>::GetRHI();
+    Parameters->CentreCube = Inputs.CentreCube;
+    Parameters->CubeSampler = TStaticSamplerState<SF_Bilinear, AM_Clamp, AM_Clamp, AM_Clamp>::GetRHI();
+    Parameters->OutputTexture = GraphBuilder.CreateUAV(Inputs.Output);
+
+    TShaderMapRef<FPanoOdsStitchCS> ComputeShader(GetGlobalShaderMap(GMaxRHIFeatureLevel));
+    FComputeShaderUtils::AddPass(GraphBuilder, RDG_EVENT_NAME("PanoramaOdsStitch"), ComputeShader, Parameters,
+        FComputeShaderUtils::GetGroupCount(OutputResolution, FIntPoint(8, 8)));
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GlobalShader.h"
+#include "ShaderParameterStruct.h"
+#include "RenderGraphResources.h"
+
+class FRDGBuilder;
+struct FPanoOdsLayout;
+
+/** Stitches one eye of an ODS equirect from the slice atlas, fading into the centred cube in the pole merge band. */
+class FPanoOdsStitchCS : public FGlobalShader
+{
+    DECLARE_GLOBAL_SHADER(FPanoOdsStitchCS);
+    SHADER_USE_PARAMETER_STRUCT(FPanoOdsStitchCS, FGlobalShader);
+
+    BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+        SHADER_PARAMETER(FMatrix44f, RigToWorld)
+        SHADER_PARAMETER(FVector2f, OutputResolution)
+        SHADER_PARAMETER(FVector2f, InvSphereResolution)
+        SHADER_PARAMETER(FVector2f, SphereOffset)
+        SHADER_PARAMETER(FVector2f, FullResolution)
+        SHADER_PARAMETER(FVector2f, OutputOffset)
+        SHADER_PARAMETER(float, bLinearColorSpace)
+        SHADER_PARAMETER(FVector2f, InvAtlasSize)
+        SHADER_PARAMETER(FVector2f, TileSize)
+        SHADER_PARAMETER(FVector2f, TanHalfFov)
+        SHADER_PARAMETER(uint32, SliceCount)
+        SHADER_PARAMETER(uint32, PitchSteps)
+        SHADER_PARAMETER(uint32, EyeIndex)
+        SHADER_PARAMETER(float, SliceWidth)
+        SHADER_PARAMETER(float, PitchStep)
+        SHADER_PARAMETER(float, CoveredLatitude)
+        SHADER_PARAMETER(FVector2f, PoleMerge)
+        SHADER_PARAMETER_RDG_TEXTURE(Texture2D, SliceAtlas)
+        SHADER_PARAMETER_SAMPLER(SamplerState, AtlasSampler)
+        SHADER_PARAMETER_RDG_TEXTURE(TextureCube, CentreCube)
+        SHADER_PARAMETER_SAMPLER(SamplerState, CubeSampler)
+        SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D<float4>, OutputTexture)
+    END_SHADER_PARAMETER_STRUCT()
+
+public:
+    static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+    {
+        return Parameters.Platform == SP_PCD3D_SM5 || Parameters.Platform == SP_PCD3D_SM6;
+    }
+};
+
+struct FPanoOdsStitchInputs
+{
+    FRDGTextureRef Atlas = nullptr;
+    /** Mono capture at the rig centre; only sampled in the pole merge band. */
+    FRDGTextureRef CentreCube = nullptr;
+    /** Stacked equirect; the eye's rows start at EyeIndex * Region height. */
+    FRDGTextureRef Output = nullptr;
+    FMatrix44f RigToWorld = FMatrix44f::Identity;
+    FIntPoint SphereResolution = FIntPoint::ZeroValue;
+    FIntRect Region;
+    int32 EyeIndex = 0;
+    bool bLinearColorSpace = false;
+};
+
+void AddPanoOdsStitchPass(FRDGBuilder& GraphBuilder, const FPanoOdsLayout& Layout, const FPanoOdsStitchInputs& Inputs);
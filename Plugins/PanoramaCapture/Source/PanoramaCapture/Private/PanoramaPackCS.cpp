@@ -0,0 +1,51 @@
+#include "PanoramaPackCS.h"
+
+#include "RenderGraphBuilder.h"
+#include "RenderGraphUtils.h"
+#include "RHICommandList.h"
+
+IMPLEMENT_GLOBAL_SHADER(FPanoPackCS, "/PanoramaCapture/PanoramaPack.usf", "Main", SF_Compute);
+
+void AddPanoPackPass(FRDGBuilder& GraphBuilder, EPanoPackFormat Format, FRDGTextureRef Source, FRDGTextureRef Packed)
+{
+    const FIntPoint SourceResolution = Source->Desc.Extent;
+    const FIntPoint TexelExtent = PanoramaPixelPack::GetTexelExtent(Format, SourceResolution);
+
+    FPanoPackCS::FParameters* Parameters = GraphBuilder.AllocParameters<FPanoPackCS::FParameters>();
+    Parameters->SourceResolution = FUintVector2(SourceResolution.X, SourceResolution.Y);
+    Parameters->TexelExtent = FUintVector2(TexelExtent.X, TexelExtent.Y);
+    Parameters->SourceTexture = Source;
+    if (Format == EPanoPackFormat::RGBA16)
+    {
+        Parameters->PackedOutputWide = GraphBuilder.CreateUAV(Packed);
+    }
+    else
+    {
+        Parameters->PackedOutput = GraphBuilder.CreateUAV(Packed);
+    }
+
+    FPanoPackCS::FPermutationDomain PermutationVector;
+    PermutationVector.Set<FPanoPackCS::FPackFormatDim>(static_cast<int32>(Format));
+    TShaderMapRef<FPanoPackCS> ComputeShader(GetGlobalShaderMap(GMaxRHIFeatureLevel), PermutationVector);
+
+    FComputeShaderUtils::AddPass(GraphBuilder, RDG_EVENT_NAME("PanoramaPack"), ComputeShader, Parameters,
+        FComputeShaderUtils::GetGroupCount(TexelExtent, FIntPoint(8, 8)));
+
+    // The readback copies straight out of this texture.
+    GraphBuilder.SetTextureAccessFinal(Packed, ERHIAccess::CopySrc);
+}
+
+FPanoPackTarget::FPanoPackTarget(EPanoPackFormat InFormat, FIntPoint InSourceResolution)
+    : Format(InFormat)
+    , SourceResolution(InSourceResolution)
+    , TexelExtent(PanoramaPixelPack::GetTexelExtent(InFormat, InSourceResolution))
+{
+}
+
+void FPanoPackTarget::InitRHI(FRHICommandListBase& RHICmdList)
+{
+    const FRHITextureCreateDesc Desc = FRHITextureCreateDesc::Create2D(TEXT("PanoramaPacked"), TexelExtent.X, TexelExtent.Y, PanoramaPixelPack::GetTexelPixelFormat(Format))
+        .SetFlags(ETextureCreateFlags::UAV | ETextureCreateFlags::ShaderResource)
+        .SetInitialState(ERHIAccess::CopySrc);
+    TextureRHI = RHICreateTexture(Desc);
+}
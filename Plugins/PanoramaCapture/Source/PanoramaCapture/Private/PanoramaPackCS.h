@@ -0,0 +1,56 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GlobalShader.h"
+#include "RenderResource.h"
+#include "ShaderParameterStruct.h"
+#include "PanoramaPixelPack.h"
+
+class FRDGBuilder;
+
+/** Converts the float equirect into the final wire format so readback moves only the bytes the writer needs. */
+class FPanoPackCS : public FGlobalShader
+{
+    DECLARE_GLOBAL_SHADER(FPanoPackCS);
+    SHADER_USE_PARAMETER_STRUCT(FPanoPackCS, FGlobalShader);
+
+    class FPackFormatDim : SHADER_PERMUTATION_INT("PACK_FORMAT", 4);
+    using FPermutationDomain = TShaderPermutationDomain<FPackFormatDim>;
+
+    BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+        SHADER_PARAMETER(FUintVector2, SourceResolution)
+        SHADER_PARAMETER(FUintVector2, TexelExtent)
+        SHADER_PARAMETER_RDG_TEXTURE(Texture2D<float4>, SourceTexture)
+        SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D<uint>, PackedOutput)
+        SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D<uint2>, PackedOutputWide)
+    END_SHADER_PARAMETER_STRUCT()
+
+public:
+    static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+    {
+        return Parameters.Platform == SP_PCD3D_SM5 || Parameters.Platform == SP_PCD3D_SM6;
+    }
+};
+
+/** Adds the pack pass reading Source (full equirect) and writing Packed (a texture created from a FPanoPackTarget layout). */
+void AddPanoPackPass(FRDGBuilder& GraphBuilder, EPanoPackFormat Format, FRDGTextureRef Source, FRDGTextureRef Packed);
+
+/** Persistent uint texture the pack pass writes and the readback pool copies from. */
+class FPanoPackTarget : public FTexture
+{
+public:
+    FPanoPackTarget(EPanoPackFormat InFormat, FIntPoint InSourceResolution);
+
+    virtual void InitRHI(FRHICommandListBase& RHICmdList) override;
+    virtual uint32 GetSizeX() const override { return TexelExtent.X; }
+    virtual uint32 GetSizeY() const override { return TexelExtent.Y; }
+
+    EPanoPackFormat GetFormat() const { return Format; }
+    FIntPoint GetSourceResolution() const { return SourceResolution; }
+    FIntPoint GetTexelExtent() const { return TexelExtent; }
+
+private:
+    EPanoPackFormat Format;
+    FIntPoint SourceResolution;
+    FIntPoint TexelExtent;
+};
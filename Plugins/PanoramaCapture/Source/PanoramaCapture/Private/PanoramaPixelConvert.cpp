@@ -0,0 +1,206 @@
+#include "PanoramaPixelConvert.h"
+
+#include "Async/ParallelFor.h"
+#include "Math/Float16.h"
+#include "Math/VectorRegister.h"
+
+#if PLATFORM_ENABLE_VECTORINTRINSICS && !PLATFORM_ENABLE_VECTORINTRINSICS_NEON && PLATFORM_ALWAYS_HAS_SSE4_1
+#define PANORAMA_CONVERT_SSE4 1
+#include <smmintrin.h>
+#else
+#define PANORAMA_CONVERT_SSE4 0
+#endif
+
+namespace
+{
+    // Rows are grouped so each task converts at least this many floats; smaller tasks cost more to schedule than to run.
+    constexpr int64 kMinFloatsPerTask = 64 * 1024;
+
+    FORCEINLINE float Saturate(float Value)
+    {
+        return FMath::Clamp(Value, 0.0f, 1.0f);
+    }
+
+    FORCEINLINE float EncodeSRGB(float Value)
+    {
+        return Value <= 0.0031308f ? Value * 12.92f : 1.055f * FMath::Pow(Value, 1.0f / 2.4f) - 0.055f;
+    }
+
+    FORCEINLINE uint32 Quantize(float Value, float Scale)
+    {
+        const float Scaled = Value * Scale;
+        return static_cast<uint32>(Scaled + 0.5f);
+    }
+
+    void ConvertScalar(EPanoConvertKernel Kernel, const float* Src, void* Dst, int64 Begin, int64 End)
+    {
+        switch (Kernel)
+        {
+        case EPanoConvertKernel::Half:
+        {
+            uint16* Out = static_cast<uint16*>(Dst);
+            for (int64 Index = Begin; Index < End; ++Index)
+            {
+                Out[Index] = FFloat16(Src[Index]).Encoded;
+            }
+            break;
+        }
+        case EPanoConvertKernel::Unorm16:
+        case EPanoConvertKernel::Unorm16SRGB:
+        {
+            const bool bSRGB = Kernel == EPanoConvertKernel::Unorm16SRGB;
+            uint16* Out = static_cast<uint16*>(Dst);
+            for (int64 Index = Begin; Index < End; ++Index)
+            {
+                float Value = Saturate(Src[Index]);
+                if (bSRGB && (Index & 3) != 3)
+                {
+                    Value = Saturate(EncodeSRGB(Value));
+                }
+                Out[Index] = static_cast<uint16>(Quantize(Value, 65535.0f));
+            }
+            break;
+        }
+        case EPanoConvertKernel::Unorm8:
+        {
+            uint8* Out = static_cast<uint8*>(Dst);
+            for (int64 Index = Begin; Index < End; ++Index)
+            {
+                Out[Index] = static_cast<uint8>(Quantize(Saturate(Src[Index]), 255.0f));
+            }
+            break;
+        }
+        }
+    }
+
+#if PANORAMA_CONVERT_SSE4
+    FORCEINLINE VectorRegister4Float SaturateVector(const VectorRegister4Float& Value)
+    {
+        return VectorMin(VectorMax(Value, VectorZeroFloat()), VectorOneFloat());
+    }
+
+    /** Same two roundings as Quantize(); multiply and add stay separate so no FMA is formed. */
+    FORCEINLINE VectorRegister4Int QuantizeVector(const VectorRegister4Float& Value, const VectorRegister4Float& Scale)
+    {
+        const VectorRegister4Float Scaled = VectorMultiply(Value, Scale);
+        return VectorFloatToInt(VectorAdd(Scaled, GlobalVectorConstants::FloatOneHalf));
+    }
+
+    const VectorRegister4Float SRGBThreshold = MakeVectorRegisterFloat(0.0031308f, 0.0031308f, 0.0031308f, 0.0031308f);
+    const VectorRegister4Float SRGBLinearScale = MakeVectorRegisterFloat(12.92f, 12.92f, 12.92f, 12.92f);
+    const VectorRegister4Float SRGBExponent = MakeVectorRegisterFloat(1.0f / 2.4f, 1.0f / 2.4f, 1.0f / 2.4f, 1.0f / 2.4f);
+    const VectorRegister4Float SRGBGammaScale = MakeVectorRegisterFloat(1.055f, 1.055f, 1.055f, 1.055f);
+    const VectorRegister4Float SRGBGammaOffset = MakeVectorRegisterFloat(0.055f, 0.055f, 0.055f, 0.055f);
+    const VectorRegister4Float ColorChannelMask = MakeVectorRegisterFloatMask(0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0);
+
+    /** sRGB OETF on lanes 0-2; lane 3 (alpha) passes through. Input must already be saturated. */
+    FORCEINLINE VectorRegister4Float EncodeSRGBVector(const VectorRegister4Float& Value)
+    {
+        const VectorRegister4Float Linear = VectorMultiply(Value, SRGBLinearScale);
+        const VectorRegister4Float Gamma = VectorSubtract(VectorMultiply(SRGBGammaScale, VectorPow(Value, SRGBExponent)), SRGBGammaOffset);
+        const VectorRegister4Float Encoded = SaturateVector(VectorSelect(VectorCompareLE(Value, SRGBThreshold), Linear, Gamma));
+        return VectorSelect(ColorChannelMask, Encoded, Value);
+    }
+
+    /** Converts whole vectors from the start of Src and returns the index the scalar tail should start from. */
+    int64 ConvertSimd(EPanoConvertKernel Kernel, const float* Src, void* Dst, int64 End)
+    {
+        // Vectors start at multiples of four floats, so lane 3 is always alpha for the sRGB mask.
+        int64 Index = 0;
+        switch (Kernel)
+        {
+        case EPanoConvertKernel::Half:
+        {
+            uint16* Out = static_cast<uint16*>(Dst);
+            for (; Index + 4 <= End; Index += 4)
+            {
+                FPlatformMath::WideStoreHalf(Out + Index, VectorLoad(Src + Index));
+            }
+            break;
+        }
+        case EPanoConvertKernel::Unorm16:
+        case EPanoConvertKernel::Unorm16SRGB:
+        {
+            const bool bSRGB = Kernel == EPanoConvertKernel::Unorm16SRGB;
+            const VectorRegister4Float Scale = VectorSetFloat1(65535.0f);
+            uint16* Out = static_cast<uint16*>(Dst);
+            for (; Index + 8 <= End; Index += 8)
+            {
+                VectorRegister4Float A = SaturateVector(VectorLoad(Src + Index));
+                VectorRegister4Float B = SaturateVector(VectorLoad(Src + Index + 4));
+                if (bSRGB)
+                {
+                    A = EncodeSRGBVector(A);
+                    B = EncodeSRGBVector(B);
+                }
+                const __m128i Packed = _mm_packus_epi32(QuantizeVector(A, Scale), QuantizeVector(B, Scale));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(Out + Index), Packed);
+            }
+            break;
+        }
+        case EPanoConvertKernel::Unorm8:
+        {
+            const VectorRegister4Float Scale = VectorSetFloat1(255.0f);
+            uint8* Out = static_cast<uint8*>(Dst);
+            for (; Index + 16 <= End; Index += 16)
+            {
+                const __m128i Low = _mm_packus_epi32(
+                    QuantizeVector(SaturateVector(VectorLoad(Src + Index)), Scale),
+                    QuantizeVector(SaturateVector(VectorLoad(Src + Index + 4)), Scale));
+                const __m128i High = _mm_packus_epi32(
+                    QuantizeVector(SaturateVector(VectorLoad(Src + Index + 8)), Scale),
+                    QuantizeVector(SaturateVector(VectorLoad(Src + Index + 12)), Scale));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(Out + Index), _mm_packus_epi16(Low, High));
+            }
+            break;
+        }
+        }
+        return Index;
+    }
+#endif
+}
+
+namespace PanoramaPixelConvert
+{
+    int32 GetDestBytesPerChannel(EPanoConvertKernel Kernel)
+    {
+        return Kernel == EPanoConvertKernel::Unorm8 ? 1 : 2;
+    }
+
+    bool HasSimd()
+    {
+        return PANORAMA_CONVERT_SSE4 != 0;
+    }
+
+    void Convert(EPanoConvertKernel Kernel, const float* Src, void* Dst, int64 Count, bool bUseSimd)
+    {
+        int64 Index = 0;
+#if PANORAMA_CONVERT_SSE4
+        if (bUseSimd)
+        {
+            Index = ConvertSimd(Kernel, Src, Dst, Count);
+        }
+#endif
+        ConvertScalar(Kernel, Src, Dst, Index, Count);
+    }
+
+    void ConvertRows(EPanoConvertKernel Kernel, const float* Src, void* Dst, int64 FloatsPerRow, int32 NumRows, bool bUseSimd)
+    {
+        if (NumRows <= 0 || FloatsPerRow <= 0)
+        {
+            return;
+        }
+
+        const int32 RowsPerTask = static_cast<int32>(FMath::Clamp<int64>(kMinFloatsPerTask / FloatsPerRow, 1, NumRows));
+        const int32 NumTasks = FMath::DivideAndRoundUp(NumRows, RowsPerTask);
+        const int32 DestBytesPerChannel = GetDestBytesPerChannel(Kernel);
+
+        ParallelFor(NumTasks, [&](int32 TaskIndex)
+        {
+            const int64 FirstRow = static_cast<int64>(TaskIndex) * RowsPerTask;
+            const int64 LastRow = FMath::Min<int64>(FirstRow + RowsPerTask, NumRows);
+            const int64 Offset = FirstRow * FloatsPerRow;
+            Convert(Kernel, Src + Offset, static_cast<uint8*>(Dst) + Offset * DestBytesPerChannel, (LastRow - FirstRow) * FloatsPerRow, bUseSimd);
+        });
+    }
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Per-channel float conversions used when pixels come back from the GPU as floats (synchronous readback). */
+enum class EPanoConvertKernel : uint8
+{
+    /** IEEE half, round to nearest even. 2 bytes per channel. */
+    Half,
+    /** saturate(x) * 65535, rounded. 2 bytes per channel. */
+    Unorm16,
+    /** As Unorm16 with the sRGB OETF applied to RGB (every fourth channel, alpha, stays linear). */
+    Unorm16SRGB,
+    /** saturate(x) * 255, rounded. 1 byte per channel. */
+    Unorm8,
+};
+
+/**
+ * SSE4.1 conversion kernels with a scalar fallback, plus a row-parallel driver.
+ *
+ * The linear Unorm kernels and Half are bit-exact against the scalar versions. Unorm16SRGB uses a vector pow
+ * approximation and stays within one code value of the scalar OETF.
+ */
+namespace PanoramaPixelConvert
+{
+    int32 GetDestBytesPerChannel(EPanoConvertKernel Kernel);
+
+    /** True when the SIMD kernels are compiled in for this platform. */
+    bool HasSimd();
+
+    /** Converts Count floats on the calling thread. Count need not be a multiple of the vector width. */
+    void Convert(EPanoConvertKernel Kernel, const float* Src, void* Dst, int64 Count, bool bUseSimd = true);
+
+    /** Converts NumRows rows of FloatsPerRow floats (a multiple of 4 for Unorm16SRGB), split into row bands on the task graph. */
+    void ConvertRows(EPanoConvertKernel Kernel, const float* Src, void* Dst, int64 FloatsPerRow, int32 NumRows, bool bUseSimd = true);
+}
@@ -0,0 +1,192 @@
+#include "PanoramaPixelPack.h"
+
+#include "Async/ParallelFor.h"
+
+namespace
+{
+    // Keep these in sync with PanoramaPack.usf; both sides parse the same decimal literals.
+    constexpr float kLumaR = 0.2126f;
+    constexpr float kLumaG = 0.7152f;
+    constexpr float kLumaB = 0.0722f;
+    constexpr float kLumaScale8 = 219.0f;
+    constexpr float kCbScale8 = 120.715671f;
+    constexpr float kCrScale8 = 142.240284f;
+    constexpr float kLumaScale10 = 876.0f;
+    constexpr float kCbScale10 = 482.862686f;
+    constexpr float kCrScale10 = 568.961138f;
+
+    FORCEINLINE float Saturate(float Value)
+    {
+        return FMath::Clamp(Value, 0.0f, 1.0f);
+    }
+
+    FORCEINLINE uint32 QuantizeUnorm(float Value, float Scale)
+    {
+        const float Scaled = Saturate(Value) * Scale;
+        return static_cast<uint32>(Scaled + 0.5f);
+    }
+
+    FORCEINLINE uint32 QuantizeClamped(float Value, float MaxValue)
+    {
+        return static_cast<uint32>(FMath::Clamp(Value + 0.5f, 0.0f, MaxValue));
+    }
+
+    FORCEINLINE FVector3f LoadRGB(const FLinearColor* Pixels, int32 Width, int32 X, int32 Y)
+    {
+        const FLinearColor& Pixel = Pixels[static_cast<int64>(Y) * Width + X];
+        return FVector3f(Saturate(Pixel.R), Saturate(Pixel.G), Saturate(Pixel.B));
+    }
+
+    // One operation per statement so the compiler cannot contract into FMA (the shader uses precise for the same reason).
+    FORCEINLINE float Luma(const FVector3f& Color)
+    {
+        const float R = kLumaR * Color.X;
+        const float G = kLumaG * Color.Y;
+        const float B = kLumaB * Color.Z;
+        const float RG = R + G;
+        return RG + B;
+    }
+
+    FORCEINLINE float ScaleOffset(float Value, float Scale, float Offset)
+    {
+        const float Scaled = Value * Scale;
+        return Scaled + Offset;
+    }
+
+    /** Averages the 2x2 block whose top-left pixel is (X, Y) and returns (Cb, Cr) before offset. */
+    FORCEINLINE FVector2f Chroma(const FLinearColor* Pixels, int32 Width, int32 X, int32 Y, float CbScale, float CrScale)
+    {
+        const FVector3f Sum = ((LoadRGB(Pixels, Width, X, Y) + LoadRGB(Pixels, Width, X + 1, Y))
+            + LoadRGB(Pixels, Width, X, Y + 1)) + LoadRGB(Pixels, Width, X + 1, Y + 1);
+        const FVector3f Average = Sum * 0.25f;
+        const float Y709 = Luma(Average);
+        return FVector2f((Average.Z - Y709) * CbScale, (Average.X - Y709) * CrScale);
+    }
+
+    void WriteUint32(uint8* Dest, uint32 Value)
+    {
+        FMemory::Memcpy(Dest, &Value, sizeof(uint32));
+    }
+}
+
+namespace PanoramaPixelPack
+{
+    FIntPoint GetTexelExtent(EPanoPackFormat Format, FIntPoint Resolution)
+    {
+        switch (Format)
+        {
+        case EPanoPackFormat::NV12:
+            return FIntPoint(Resolution.X / 4, Resolution.Y + Resolution.Y / 2);
+        case EPanoPackFormat::P010:
+            return FIntPoint(Resolution.X / 2, Resolution.Y + Resolution.Y / 2);
+        default:
+            return Resolution;
+        }
+    }
+
+    int32 GetBytesPerTexel(EPanoPackFormat Format)
+    {
+        return Format == EPanoPackFormat::RGBA16 ? 8 : 4;
+    }
+
+    EPixelFormat GetTexelPixelFormat(EPanoPackFormat Format)
+    {
+        return Format == EPanoPackFormat::RGBA16 ? PF_R32G32_UINT : PF_R32_UINT;
+    }
+
+    int64 GetPackedBytes(EPanoPackFormat Format, FIntPoint Resolution)
+    {
+        const FIntPoint Extent = GetTexelExtent(Format, Resolution);
+        return static_cast<int64>(Extent.X) * Extent.Y * GetBytesPerTexel(Format);
+    }
+
+    bool IsResolutionSupported(EPanoPackFormat Format, FIntPoint Resolution)
+    {
+        switch (Format)
+        {
+        case EPanoPackFormat::NV12:
+            return Resolution.X % 4 == 0 && Resolution.Y % 2 == 0;
+        case EPanoPackFormat::P010:
+            return Resolution.X % 2 == 0 && Resolution.Y % 2 == 0;
+        default:
+            return Resolution.X > 0 && Resolution.Y > 0;
+        }
+    }
+
+    void PackReference(EPanoPackFormat Format, const FLinearColor* Pixels, FIntPoint Resolution, uint8* OutPacked)
+    {
+        const int32 Width = Resolution.X;
+        const int32 Height = Resolution.Y;
+        const FIntPoint Extent = GetTexelExtent(Format, Resolution);
+        const int64 RowBytes = static_cast<int64>(Extent.X) * GetBytesPerTexel(Format);
+
+        ParallelFor(Extent.Y, [&](int32 TexelY)
+        {
+            uint8* Row = OutPacked + TexelY * RowBytes;
+            for (int32 TexelX = 0; TexelX < Extent.X; ++TexelX)
+            {
+                switch (Format)
+                {
+                case EPanoPackFormat::RGBA8:
+                {
+                    const FLinearColor& Pixel = Pixels[static_cast<int64>(TexelY) * Width + TexelX];
+                    WriteUint32(Row + TexelX * 4,
+                        QuantizeUnorm(Pixel.R, 255.0f) | (QuantizeUnorm(Pixel.G, 255.0f) << 8)
+                        | (QuantizeUnorm(Pixel.B, 255.0f) << 16) | (QuantizeUnorm(Pixel.A, 255.0f) << 24));
+                    break;
+                }
+                case EPanoPackFormat::RGBA16:
+                {
+                    const FLinearColor& Pixel = Pixels[static_cast<int64>(TexelY) * Width + TexelX];
+                    WriteUint32(Row + TexelX * 8, QuantizeUnorm(Pixel.R, 65535.0f) | (QuantizeUnorm(Pixel.G, 65535.0f) << 16));
+                    WriteUint32(Row + TexelX * 8 + 4, QuantizeUnorm(Pixel.B, 65535.0f) | (QuantizeUnorm(Pixel.A, 65535.0f) << 16));
+                    break;
+                }
+                case EPanoPackFormat::NV12:
+                {
+                    uint32 Packed = 0;
+                    if (TexelY < Height)
+                    {
+                        for (int32 Sample = 0; Sample < 4; ++Sample)
+                        {
+                            const float Y709 = Luma(LoadRGB(Pixels, Width, TexelX * 4 + Sample, TexelY));
+                            Packed |= QuantizeClamped(ScaleOffset(Y709, kLumaScale8, 16.0f), 255.0f) << (Sample * 8);
+                        }
+                    }
+                    else
+                    {
+                        const int32 PixelY = (TexelY - Height) * 2;
+                        for (int32 Pair = 0; Pair < 2; ++Pair)
+                        {
+                            const FVector2f CbCr = Chroma(Pixels, Width, TexelX * 4 + Pair * 2, PixelY, kCbScale8, kCrScale8);
+                            Packed |= QuantizeClamped(CbCr.X + 128.0f, 255.0f) << (Pair * 16);
+                            Packed |= QuantizeClamped(CbCr.Y + 128.0f, 255.0f) << (Pair * 16 + 8);
+                        }
+                    }
+                    WriteUint32(Row + TexelX * 4, Packed);
+                    break;
+                }
+                case EPanoPackFormat::P010:
+                {
+                    uint32 Packed = 0;
+                    if (TexelY < Height)
+                    {
+                        for (int32 Sample = 0; Sample < 2; ++Sample)
+                        {
+                            const float Y709 = Luma(LoadRGB(Pixels, Width, TexelX * 2 + Sample, TexelY));
+                            Packed |= (QuantizeClamped(ScaleOffset(Y709, kLumaScale10, 64.0f), 1023.0f) << 6) << (Sample * 16);
+                        }
+                    }
+                    else
+                    {
+                        const FVector2f CbCr = Chroma(Pixels, Width, TexelX * 2, (TexelY - Height) * 2, kCbScale10, kCrScale10);
+                        Packed = (QuantizeClamped(CbCr.X + 512.0f, 1023.0f) << 6) | ((QuantizeClamped(CbCr.Y + 512.0f, 1023.0f) << 6) << 16);
+                    }
+                    WriteUint32(Row + TexelX * 4, Packed);
+                    break;
+                }
+                }
+            }
+        });
+    }
+}
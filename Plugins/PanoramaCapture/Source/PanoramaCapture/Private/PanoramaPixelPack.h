@@ -0,0 +1,42 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PixelFormat.h"
+
+/** Wire formats produced by the GPU pack pass. Values match PACK_FORMAT in PanoramaPack.usf. */
+enum class EPanoPackFormat : uint8
+{
+    /** 8-bit RGBA, 4 bytes per pixel. */
+    RGBA8 = 0,
+    /** 16-bit UNORM RGBA in native (little-endian) uint16 order, 8 bytes per pixel. */
+    RGBA16 = 1,
+    /** BT.709 limited-range 4:2:0: W*H luma bytes followed by W*H/2 interleaved UV bytes. */
+    NV12 = 2,
+    /** As NV12 with 16-bit samples holding 10 significant bits in the high bits. */
+    P010 = 3,
+};
+
+/**
+ * Layout helpers and CPU reference implementations for the pack formats.
+ *
+ * The packed image is stored in a uint texture whose texels are a whole number of bytes, so the readback is a plain
+ * row copy. The reference packers use the same float operation order as the shader and are bit-exact against it
+ * for inputs in [0, 1].
+ */
+namespace PanoramaPixelPack
+{
+    /** Texel grid of the packed texture for a source image of the given resolution. */
+    FIntPoint GetTexelExtent(EPanoPackFormat Format, FIntPoint Resolution);
+
+    int32 GetBytesPerTexel(EPanoPackFormat Format);
+
+    EPixelFormat GetTexelPixelFormat(EPanoPackFormat Format);
+
+    int64 GetPackedBytes(EPanoPackFormat Format, FIntPoint Resolution);
+
+    /** 4:2:0 formats need a width divisible by 4 (NV12) or 2 (P010) and an even height. */
+    bool IsResolutionSupported(EPanoPackFormat Format, FIntPoint Resolution);
+
+    /** Packs Resolution.X * Resolution.Y linear-layout pixels into OutPacked (GetPackedBytes bytes). */
+    void PackReference(EPanoPackFormat Format, const FLinearColor* Pixels, FIntPoint Resolution, uint8* OutPacked);
+}
@@ -0,0 +1,103 @@
+#include "PanoramaPngBenchmark.h"
+
+#include "HAL/IConsoleManager.h"
+#include "Math/RandomStream.h"
+#include "UObject/Class.h"
+#include "PanoramaPngEncoder.h"
+
+void PanoramaPngBenchmark::BuildSyntheticEquirect(int32 Width, int32 Height, int32 BitDepth, TArray64<uint8>& OutPixels)
+{
+    const int32 BytesPerChannel = BitDepth / 8;
+    OutPixels.SetNumUninitialized(static_cast<int64>(Width) * Height * 4 * BytesPerChannel);
+
+    FRandomStream Random(0x50414E4F);
+    TArray<float> SkylineHeights;
+    SkylineHeights.SetNum(64);
+    for (float& SkylineHeight : SkylineHeights)
+    {
+        SkylineHeight = Random.FRandRange(0.0f, 0.15f);
+    }
+
+    for (int32 Y = 0; Y < Height; ++Y)
+    {
+        const float V = (Y + 0.5f) / Height;
+        for (int32 X = 0; X < Width; ++X)
+        {
+            const float U = (X + 0.5f) / Width;
+            const float Skyline = SkylineHeights[FMath::Min(63, static_cast<int32>(U * 64.f))];
+
+            FLinearColor Color;
+            if (V < 0.5f - Skyline)
+            {
+                Color = FMath::Lerp(FLinearColor(0.1f, 0.3f, 0.8f), FLinearColor(0.7f, 0.8f, 0.95f), V * 2.f);
+            }
+            else if (V < 0.5f)
+            {
+                Color = FLinearColor(0.25f, 0.22f, 0.2f) * (0.8f + 0.2f * FMath::Sin(U * 400.f));
+            }
+            else
+            {
+                const float Noise = Random.FRand() * 0.08f;
+                Color = FLinearColor(0.2f + Noise, 0.35f + Noise, 0.15f + Noise);
+            }
+
+            const int64 PixelOffset = (static_cast<int64>(Y) * Width + X) * 4;
+            const float Channels[4] = { Color.R, Color.G, Color.B, 1.f };
+            for (int32 Channel = 0; Channel < 4; ++Channel)
+            {
+                const float Value = FMath::Clamp(Channels[Channel], 0.f, 1.f);
+                if (BytesPerChannel == 2)
+                {
+                    reinterpret_cast<uint16*>(OutPixels.GetData())[PixelOffset + Channel] = static_cast<uint16>(Value * 65535.f + 0.5f);
+                }
+                else
+                {
+                    OutPixels[PixelOffset + Channel] = static_cast<uint8>(Value * 255.f + 0.5f);
+                }
+            }
+        }
+    }
+}
+
+namespace
+{
+    void RunPngBenchmark(const TArray<FString>& Args)
+    {
+        const int32 Width = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 4096;
+        const int32 Height = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : Width / 2;
+        const int32 BitDepth = (Args.Num() > 2 && FCString::Atoi(*Args[2]) == 16) ? 16 : 8;
+
+        TArray64<uint8> Pixels;
+        PanoramaPngBenchmark::BuildSyntheticEquirect(Width, Height, BitDepth, Pixels);
+
+        FPanoPngEncoder Encoder;
+        TArray64<uint8> Png;
+        const EPanoramaPngCompression Presets[] = {
+            EPanoramaPngCompression::Uncompressed,
+            EPanoramaPngCompression::Fastest,
+            EPanoramaPngCompression::Balanced,
+            EPanoramaPngCompression::Smallest
+        };
+
+        UE_LOG(LogTemp, Display, TEXT("Panorama PNG benchmark: %dx%d %d-bit RGBA (%.1f MB raw)"), Width, Height, BitDepth, Pixels.Num() / (1024.0 * 1024.0));
+        for (EPanoramaPngCompression Preset : Presets)
+        {
+            FPanoPngEncodeStats Stats;
+            if (!Encoder.Encode(Pixels.GetData(), Width, Height, BitDepth, FPanoPngEncodeOptions::FromPreset(Preset), Png, &Stats))
+            {
+                continue;
+            }
+
+            const double MegabytesPerSecond = Stats.TotalSeconds > 0.0 ? Stats.RawBytes / (1024.0 * 1024.0) / Stats.TotalSeconds : 0.0;
+            const double Ratio = Stats.CompressedBytes > 0 ? static_cast<double>(Stats.RawBytes) / Stats.CompressedBytes : 0.0;
+            UE_LOG(LogTemp, Display, TEXT("  %-12s %8.1f ms  %8.1f MB/s  ratio %5.2f  (%d bands, filter %.1f ms, deflate %.1f ms)"),
+                *UEnum::GetDisplayValueAsText(Preset).ToString(), Stats.TotalSeconds * 1000.0, MegabytesPerSecond, Ratio,
+                Stats.NumBands, Stats.FilterSeconds * 1000.0, Stats.DeflateSeconds * 1000.0);
+        }
+    }
+
+    FAutoConsoleCommand GPanoramaPngBenchmarkCommand(
+        TEXT("Panorama.PngBenchmark"),
+        TEXT("Encodes a synthetic equirect frame with every PNG compression preset and logs MB/s and compression ratio. Usage: Panorama.PngBenchmark [Width] [Height] [8|16]"),
+        FConsoleCommandWithArgsDelegate::CreateStatic(&RunPngBenchmark));
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+namespace PanoramaPngBenchmark
+{
+    /**
+     * Builds a deterministic equirect-like RGBA frame: latitude sky gradient, noisy ground and hard-edged skyline blocks.
+     * 16-bit samples are native-endian uint16.
+     */
+    void BuildSyntheticEquirect(int32 Width, int32 Height, int32 BitDepth, TArray64<uint8>& OutPixels);
+}
@@ -0,0 +1,521 @@
+#include "PanoramaPngEncoder.h"
+
+#include "Async/ParallelFor.h"
+#include "HAL/PlatformMisc.h"
+
+THIRD_PARTY_INCLUDES_START
+#include "zlib.h"
+THIRD_PARTY_INCLUDES_END
+
+namespace
+{
+    constexpr uint8 kPngSignature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+    constexpr int64 kDeflateWindowBytes = 32 * 1024;
+    constexpr int64 kMinBandBytes = 1024 * 1024;
+
+    void AppendBigEndian32(TArray64<uint8>& Out, uint32 Value)
+    {
+        const uint8 Bytes[4] = {
+            static_cast<uint8>(Value >> 24),
+            static_cast<uint8>(Value >> 16),
+            static_cast<uint8>(Value >> 8),
+            static_cast<uint8>(Value)
+        };
+        Out.Append(Bytes, 4);
+    }
+
+    /** Appends a chunk whose payload is the concatenation of up to three byte ranges. */
+    void AppendChunk(TArray64<uint8>& Out, const char Type[4],
+        const uint8* DataA, int64 SizeA,
+        const uint8* DataB = nullptr, int64 SizeB = 0,
+        const uint8* DataC = nullptr, int64 SizeC = 0)
+    {
+        AppendBigEndian32(Out, static_cast<uint32>(SizeA + SizeB + SizeC));
+
+        uLong Crc = crc32(0L, Z_NULL, 0);
+        Crc = crc32(Crc, reinterpret_cast<const Bytef*>(Type), 4);
+        Out.Append(reinterpret_cast<const uint8*>(Type), 4);
+
+        const uint8* Parts[3] = { DataA, DataB, DataC };
+        const int64 Sizes[3] = { SizeA, SizeB, SizeC };
+        for (int32 Part = 0; Part < 3; ++Part)
+        {
+            if (Sizes[Part] > 0)
+            {
+                Crc = crc32(Crc, Parts[Part], static_cast<uInt>(Sizes[Part]));
+                Out.Append(Parts[Part], Sizes[Part]);
+            }
+        }
+
+        AppendBigEndian32(Out, static_cast<uint32>(Crc));
+    }
+
+    FORCEINLINE uint8 PaethPredictor(int32 A, int32 B, int32 C)
+    {
+        const int32 P = A + B - C;
+        const int32 PA = FMath::Abs(P - A);
+        const int32 PB = FMath::Abs(P - B);
+        const int32 PC = FMath::Abs(P - C);
+        if (PA <= PB && PA <= PC)
+        {
+            return static_cast<uint8>(A);
+        }
+        return static_cast<uint8>(PB <= PC ? B : C);
+    }
+
+    /** Writes the filter type byte followed by the filtered row. PrevRow may be null for the first image row. */
+    void FilterRow(EPanoPngRowFilter Filter, const uint8* Row, const uint8* PrevRow, int64 RowBytes, int32 Bpp, uint8* Out)
+    {
+        Out[0] = static_cast<uint8>(Filter);
+        uint8* Dest = Out + 1;
+
+        switch (Filter)
+        {
+        case EPanoPngRowFilter::Sub:
+            for (int64 Index = 0; Index < RowBytes; ++Index)
+            {
+                const uint8 Left = Index >= Bpp ? Row[Index - Bpp] : 0;
+                Dest[Index] = static_cast<uint8>(Row[Index] - Left);
+            }
+            break;
+        case EPanoPngRowFilter::Up:
+            for (int64 Index = 0; Index < RowBytes; ++Index)
+            {
+                const uint8 Above = PrevRow ? PrevRow[Index] : 0;
+                Dest[Index] = static_cast<uint8>(Row[Index] - Above);
+            }
+            break;
+        case EPanoPngRowFilter::Average:
+            for (int64 Index = 0; Index < RowBytes; ++Index)
+            {
+                const int32 Left = Index >= Bpp ? Row[Index - Bpp] : 0;
+                const int32 Above = PrevRow ? PrevRow[Index] : 0;
+                Dest[Index] = static_cast<uint8>(Row[Index] - ((Left + Above) >> 1));
+            }
+            break;
+        case EPanoPngRowFilter::Paeth:
+            for (int64 Index = 0; Index < RowBytes; ++Index)
+            {
+                const int32 Left = Index >= Bpp ? Row[Index - Bpp] : 0;
+                const int32 Above = PrevRow ? PrevRow[Index] : 0;
+                const int32 UpperLeft = (PrevRow && Index >= Bpp) ? PrevRow[Index - Bpp] : 0;
+                Dest[Index] = static_cast<uint8>(Row[Index] - PaethPredictor(Left, Above, UpperLeft));
+            }
+            break;
+        default:
+            Out[0] = static_cast<uint8>(EPanoPngRowFilter::None);
+            FMemory::Memcpy(Dest, Row, RowBytes);
+            break;
+        }
+    }
+
+    uint64 FilteredRowCost(const uint8* FilteredRow, int64 RowBytes)
+    {
+        uint64 Cost = 0;
+        for (int64 Index = 1; Index <= RowBytes; ++Index)
+        {
+            Cost += FMath::Abs(static_cast<int32>(static_cast<int8>(FilteredRow[Index])));
+        }
+        return Cost;
+    }
+
+    /** Copies a source row into PNG byte order (16-bit samples are big-endian in PNG). */
+    const uint8* GetPngOrderRow(const uint8* SourceRow, int64 RowBytes, int32 BitDepth, bool bPngByteOrder, TArray64<uint8>& Scratch)
+    {
+        if (BitDepth != 16 || bPngByteOrder)
+        {
+            return SourceRow;
+        }
+
+        Scratch.SetNumUninitialized(RowBytes, EAllowShrinking::No);
+        const uint16* Source = reinterpret_cast<const uint16*>(SourceRow);
+        uint8* Dest = Scratch.GetData();
+        for (int64 Sample = 0; Sample < RowBytes / 2; ++Sample)
+        {
+            Dest[Sample * 2] = static_cast<uint8>(Source[Sample] >> 8);
+            Dest[Sample * 2 + 1] = static_cast<uint8>(Source[Sample] & 0xFF);
+        }
+        return Dest;
+    }
+
+    uint8 ZlibHeaderLevelBits(int32 Level)
+    {
+        if (Level <= 1)
+        {
+            return 0;
+        }
+        if (Level <= 5)
+        {
+            return 1;
+        }
+        return Level == 6 ? 2 : 3;
+    }
+
+    uint32 ReadBigEndian32(const uint8* Data)
+    {
+        return (static_cast<uint32>(Data[0]) << 24) | (static_cast<uint32>(Data[1]) << 16) | (static_cast<uint32>(Data[2]) << 8) | Data[3];
+    }
+
+    /** Reverses the PNG filter of one row in place. PrevRow holds the already reconstructed row above, or null. */
+    void UnfilterRow(uint8 Filter, uint8* Row, const uint8* PrevRow, int64 RowBytes, int32 Bpp)
+    {
+        for (int64 Index = 0; Index < RowBytes; ++Index)
+        {
+            const int32 Left = Index >= Bpp ? Row[Index - Bpp] : 0;
+            const int32 Above = PrevRow ? PrevRow[Index] : 0;
+            const int32 UpperLeft = (PrevRow && Index >= Bpp) ? PrevRow[Index - Bpp] : 0;
+            switch (static_cast<EPanoPngRowFilter>(Filter))
+            {
+            case EPanoPngRowFilter::Sub:
+                Row[Index] = static_cast<uint8>(Row[Index] + Left);
+                break;
+            case EPanoPngRowFilter::Up:
+                Row[Index] = static_cast<uint8>(Row[Index] + Above);
+                break;
+            case EPanoPngRowFilter::Average:
+                Row[Index] = static_cast<uint8>(Row[Index] + ((Left + Above) >> 1));
+                break;
+            case EPanoPngRowFilter::Paeth:
+                Row[Index] = static_cast<uint8>(Row[Index] + PaethPredictor(Left, Above, UpperLeft));
+                break;
+            default:
+                break;
+            }
+        }
+    }
+}
+
+FPanoPngEncodeOptions FPanoPngEncodeOptions::FromPreset(EPanoramaPngCompression Preset)
+{
+    FPanoPngEncodeOptions Options;
+    switch (Preset)
+    {
+    case EPanoramaPngCompression::Uncompressed:
+        Options.CompressionLevel = 0;
+        Options.Filter = EPanoPngRowFilter::None;
+        break;
+    case EPanoramaPngCompression::Fastest:
+        Options.CompressionLevel = 1;
+        Options.Filter = EPanoPngRowFilter::Sub;
+        break;
+    case EPanoramaPngCompression::Smallest:
+        Options.CompressionLevel = 9;
+        Options.Filter = EPanoPngRowFilter::Adaptive;
+        break;
+    default:
+        Options.CompressionLevel = 6;
+        Options.Filter = EPanoPngRowFilter::Adaptive;
+        break;
+    }
+    return Options;
+}
+
+bool FPanoPngEncoder::Encode(const uint8* Pixels, int32 Width, int32 Height, int32 BitDepth, const FPanoPngEncodeOptions& Options,
+    TArray64<uint8>& OutPng, FPanoPngEncodeStats* OutStats, const TFunction<void()>& OnInputConsumed)
+{
+    return EncodeInternal(Pixels, Width, Height, BitDepth, false, Options, OutPng, OutStats, OnInputConsumed);
+}
+
+bool FPanoPngEncoder::Recompress(const TArray64<uint8>& InPng, const FPanoPngEncodeOptions& Options, TArray64<uint8>& OutPng, FPanoPngEncodeStats* OutStats)
+{
+    const uint8* Data = InPng.GetData();
+    const int64 Size = InPng.Num();
+    if (Size < static_cast<int64>(sizeof(kPngSignature)) || FMemory::Memcmp(Data, kPngSignature, sizeof(kPngSignature)) != 0)
+    {
+        return false;
+    }
+
+    int32 Width = 0;
+    int32 Height = 0;
+    int32 BitDepth = 0;
+    TArray64<uint8> Compressed;
+
+    int64 Offset = sizeof(kPngSignature);
+    while (Offset + 12 <= Size)
+    {
+        const int64 Length = ReadBigEndian32(Data + Offset);
+        const uint8* Type = Data + Offset + 4;
+        const uint8* Payload = Data + Offset + 8;
+        if (Offset + 12 + Length > Size)
+        {
+            return false;
+        }
+
+        if (FMemory::Memcmp(Type, "IHDR", 4) == 0 && Length == 13)
+        {
+            Width = static_cast<int32>(ReadBigEndian32(Payload));
+            Height = static_cast<int32>(ReadBigEndian32(Payload + 4));
+            BitDepth = Payload[8];
+            const bool bRgba = Payload[9] == 6;
+            const bool bInterlaced = Payload[12] != 0;
+            if (!bRgba || bInterlaced || (BitDepth != 8 && BitDepth != 16))
+            {
+                return false;
+            }
+        }
+        else if (FMemory::Memcmp(Type, "IDAT", 4) == 0)
+        {
+            Compressed.Append(Payload, Length);
+        }
+        else if (FMemory::Memcmp(Type, "IEND", 4) == 0)
+        {
+            break;
+        }
+
+        Offset += 12 + Length;
+    }
+
+    if (Width <= 0 || Height <= 0 || Compressed.Num() == 0)
+    {
+        return false;
+    }
+
+    const int32 Bpp = 4 * BitDepth / 8;
+    const int64 RowBytes = static_cast<int64>(Width) * Bpp;
+    const int64 FilteredBytes = (RowBytes + 1) * Height;
+
+    TArray64<uint8> Filtered;
+    Filtered.SetNumUninitialized(FilteredBytes);
+
+    z_stream Stream;
+    FMemory::Memzero(Stream);
+    if (inflateInit(&Stream) != Z_OK)
+    {
+        return false;
+    }
+    Stream.next_in = Compressed.GetData();
+    Stream.avail_in = static_cast<uInt>(Compressed.Num());
+    Stream.next_out = Filtered.GetData();
+    Stream.avail_out = static_cast<uInt>(Filtered.Num());
+    const int32 Result = inflate(&Stream, Z_FINISH);
+    const bool bInflated = Result == Z_STREAM_END && Stream.total_out == static_cast<uLong>(FilteredBytes);
+    inflateEnd(&Stream);
+    if (!bInflated)
+    {
+        return false;
+    }
+
+    DecodedPixels.SetNumUninitialized(RowBytes * Height, EAllowShrinking::No);
+    for (int32 Row = 0; Row < Height; ++Row)
+    {
+        const uint8* Source = Filtered.GetData() + static_cast<int64>(Row) * (RowBytes + 1);
+        uint8* Dest = DecodedPixels.GetData() + static_cast<int64>(Row) * RowBytes;
+        FMemory::Memcpy(Dest, Source + 1, RowBytes);
+        UnfilterRow(Source[0], Dest, Row > 0 ? Dest - RowBytes : nullptr, RowBytes, Bpp);
+    }
+
+    return EncodeInternal(DecodedPixels.GetData(), Width, Height, BitDepth, true, Options, OutPng, OutStats, TFunction<void()>());
+}
+
+bool FPanoPngEncoder::EncodeInternal(const uint8* Pixels, int32 Width, int32 Height, int32 BitDepth, bool bPngByteOrder, const FPanoPngEncodeOptions& Options,
+    TArray64<uint8>& OutPng, FPanoPngEncodeStats* OutStats, const TFunction<void()>& OnInputConsumed)
+{
+    OutPng.Reset();
+    if (!Pixels || Width <= 0 || Height <= 0 || (BitDepth != 8 && BitDepth != 16))
+    {
+        if (OnInputConsumed)
+        {
+            OnInputConsumed();
+        }
+        return false;
+    }
+
+    const double StartSeconds = FPlatformTime::Seconds();
+
+    const int32 Bpp = 4 * BitDepth / 8;
+    const int64 RowBytes = static_cast<int64>(Width) * Bpp;
+    const int64 FilteredRowBytes = RowBytes + 1;
+    const int32 Level = FMath::Clamp(Options.CompressionLevel, 0, 9);
+
+    int32 NumBands = Options.NumBands;
+    if (NumBands <= 0)
+    {
+        const int64 BandsBySize = (FilteredRowBytes * Height) / kMinBandBytes;
+        NumBands = static_cast<int32>(FMath::Min<int64>(BandsBySize, FPlatformMisc::NumberOfCoresIncludingHyperthreads() * 2));
+    }
+    NumBands = FMath::Clamp(NumBands, 1, Height);
+    const int32 RowsPerBand = FMath::DivideAndRoundUp(Height, NumBands);
+    NumBands = FMath::DivideAndRoundUp(Height, RowsPerBand);
+
+    FilteredBands.SetNum(NumBands);
+    CompressedBands.SetNum(NumBands);
+    BandAdlers.SetNumZeroed(NumBands);
+
+    // Filter pass. Each band reads the source row above its first row, so bands are independent.
+    ParallelFor(NumBands, [&](int32 Band)
+    {
+        const int32 FirstRow = Band * RowsPerBand;
+        const int32 EndRow = FMath::Min(Height, FirstRow + RowsPerBand);
+
+        TArray64<uint8>& Filtered = FilteredBands[Band];
+        Filtered.SetNumUninitialized(FilteredRowBytes * (EndRow - FirstRow), EAllowShrinking::No);
+
+        // Rows alternate between two scratch buffers so the previous row stays valid while filtering.
+        TArray64<uint8> RowScratch[2];
+        TArray64<uint8> Candidates;
+        if (Options.Filter == EPanoPngRowFilter::Adaptive)
+        {
+            Candidates.SetNumUninitialized(FilteredRowBytes * 5);
+        }
+
+        const uint8* PrevRow = nullptr;
+        if (FirstRow > 0)
+        {
+            PrevRow = GetPngOrderRow(Pixels + static_cast<int64>(FirstRow - 1) * RowBytes, RowBytes, BitDepth, bPngByteOrder, RowScratch[(FirstRow - 1) & 1]);
+        }
+
+        for (int32 Row = FirstRow; Row < EndRow; ++Row)
+        {
+            const uint8* CurrentRow = GetPngOrderRow(Pixels + static_cast<int64>(Row) * RowBytes, RowBytes, BitDepth, bPngByteOrder, RowScratch[Row & 1]);
+            uint8* Dest = Filtered.GetData() + (Row - FirstRow) * FilteredRowBytes;
+
+            if (Options.Filter == EPanoPngRowFilter::Adaptive)
+            {
+                int32 BestFilter = 0;
+                uint64 BestCost = MAX_uint64;
+                for (int32 FilterType = 0; FilterType < 5; ++FilterType)
+                {
+                    uint8* Candidate = Candidates.GetData() + FilterType * FilteredRowBytes;
+                    FilterRow(static_cast<EPanoPngRowFilter>(FilterType), CurrentRow, PrevRow, RowBytes, Bpp, Candidate);
+                    const uint64 Cost = FilteredRowCost(Candidate, RowBytes);
+                    if (Cost < BestCost)
+                    {
+                        BestCost = Cost;
+                        BestFilter = FilterType;
+                    }
+                }
+                FMemory::Memcpy(Dest, Candidates.GetData() + BestFilter * FilteredRowBytes, FilteredRowBytes);
+            }
+            else
+            {
+                FilterRow(Options.Filter, CurrentRow, PrevRow, RowBytes, Bpp, Dest);
+            }
+
+            PrevRow = CurrentRow;
+        }
+
+        BandAdlers[Band] = static_cast<uint32>(adler32(adler32(0L, Z_NULL, 0), Filtered.GetData(), static_cast<uInt>(Filtered.Num())));
+    });
+
+    if (OnInputConsumed)
+    {
+        OnInputConsumed();
+    }
+
+    const double FilterEndSeconds = FPlatformTime::Seconds();
+
+    // Deflate pass. Every band but the last ends on a byte-aligned sync flush so the outputs concatenate.
+    TArray<bool> BandSucceeded;
+    BandSucceeded.SetNumZeroed(NumBands);
+    ParallelFor(NumBands, [&](int32 Band)
+    {
+        const TArray64<uint8>& Filtered = FilteredBands[Band];
+        TArray64<uint8>& Compressed = CompressedBands[Band];
+
+        z_stream Stream;
+        FMemory::Memzero(Stream);
+        if (deflateInit2(&Stream, Level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        {
+            return;
+        }
+
+        if (Band > 0)
+        {
+            const TArray64<uint8>& Previous = FilteredBands[Band - 1];
+            const int64 DictionaryBytes = FMath::Min(kDeflateWindowBytes, Previous.Num());
+            deflateSetDictionary(&Stream, Previous.GetData() + Previous.Num() - DictionaryBytes, static_cast<uInt>(DictionaryBytes));
+        }
+
+        // deflateBound covers Z_FINISH; leave room for the empty stored block a sync flush emits.
+        Compressed.SetNumUninitialized(static_cast<int64>(deflateBound(&Stream, static_cast<uLong>(Filtered.Num()))) + 16, EAllowShrinking::No);
+
+        Stream.next_in = const_cast<Bytef*>(Filtered.GetData());
+        Stream.avail_in = static_cast<uInt>(Filtered.Num());
+        Stream.next_out = Compressed.GetData();
+        Stream.avail_out = static_cast<uInt>(Compressed.Num());
+
+        const bool bLastBand = Band == NumBands - 1;
+        const int32 Result = deflate(&Stream, bLastBand ? Z_FINISH : Z_SYNC_FLUSH);
+        const bool bComplete = bLastBand ? Result == Z_STREAM_END : (Result == Z_OK && Stream.avail_in == 0 && Stream.avail_out > 0);
+
+        Compressed.SetNum(static_cast<int64>(Stream.total_out), EAllowShrinking::No);
+        deflateEnd(&Stream);
+        BandSucceeded[Band] = bComplete;
+    });
+
+    for (bool bSucceeded : BandSucceeded)
+    {
+        if (!bSucceeded)
+        {
+            return false;
+        }
+    }
+
+    uLong Adler = adler32(0L, Z_NULL, 0);
+    for (int32 Band = 0; Band < NumBands; ++Band)
+    {
+        Adler = adler32_combine(Adler, BandAdlers[Band], static_cast<z_off_t>(FilteredBands[Band].Num()));
+    }
+
+    const uint8 Cmf = 0x78;
+    uint8 Flg = static_cast<uint8>(ZlibHeaderLevelBits(Level) << 6);
+    Flg = static_cast<uint8>(Flg + (31 - ((Cmf * 256 + Flg) % 31)));
+    const uint8 ZlibHeader[2] = { Cmf, Flg };
+    const uint8 ZlibTrailer[4] = {
+        static_cast<uint8>(Adler >> 24),
+        static_cast<uint8>(Adler >> 16),
+        static_cast<uint8>(Adler >> 8),
+        static_cast<uint8>(Adler)
+    };
+
+    int64 CompressedTotal = 0;
+    for (const TArray64<uint8>& Compressed : CompressedBands)
+    {
+        CompressedTotal += Compressed.Num();
+    }
+    OutPng.Reserve(64 + CompressedTotal + NumBands * 12);
+    OutPng.Append(kPngSignature, sizeof(kPngSignature));
+
+    uint8 Header[13];
+    Header[0] = static_cast<uint8>(Width >> 24);
+    Header[1] = static_cast<uint8>(Width >> 16);
+    Header[2] = static_cast<uint8>(Width >> 8);
+    Header[3] = static_cast<uint8>(Width);
+    Header[4] = static_cast<uint8>(Height >> 24);
+    Header[5] = static_cast<uint8>(Height >> 16);
+    Header[6] = static_cast<uint8>(Height >> 8);
+    Header[7] = static_cast<uint8>(Height);
+    Header[8] = static_cast<uint8>(BitDepth);
+    Header[9] = 6; // RGBA
+    Header[10] = 0;
+    Header[11] = 0;
+    Header[12] = 0;
+    AppendChunk(OutPng, "IHDR", Header, sizeof(Header));
+
+    // One IDAT per band; the zlib header rides on the first and the Adler-32 trailer on the last.
+    for (int32 Band = 0; Band < NumBands; ++Band)
+    {
+        const TArray64<uint8>& Compressed = CompressedBands[Band];
+        const bool bFirst = Band == 0;
+        const bool bLast = Band == NumBands - 1;
+        AppendChunk(OutPng, "IDAT",
+            bFirst ? ZlibHeader : nullptr, bFirst ? sizeof(ZlibHeader) : 0,
+            Compressed.GetData(), Compressed.Num(),
+            bLast ? ZlibTrailer : nullptr, bLast ? sizeof(ZlibTrailer) : 0);
+    }
+
+    AppendChunk(OutPng, "IEND", nullptr, 0);
+
+    if (OutStats)
+    {
+        const double EndSeconds = FPlatformTime::Seconds();
+        OutStats->NumBands = NumBands;
+        OutStats->RawBytes = static_cast<int64>(Height) * RowBytes;
+        OutStats->CompressedBytes = OutPng.Num();
+        OutStats->FilterSeconds = FilterEndSeconds - StartSeconds;
+        OutStats->DeflateSeconds = EndSeconds - FilterEndSeconds;
+        OutStats->TotalSeconds = EndSeconds - StartSeconds;
+    }
+
+    return true;
+}
@@ -1,90 +1,296 @@
 #include "PanoramaPngWriter.h"
 
 #include "Async/Async.h"
+#include "HAL/Event.h"
 #include "HAL/FileManager.h"
+#include "HAL/PlatformMisc.h"
+#include "HAL/PlatformProcess.h"
 #include "Misc/Paths.h"
 #include "Misc/FileHelper.h"
-#include "Modules/ModuleManager.h"
-#include "IImageWrapper.h"
-#include "IImageWrapperModule.h"
+#include "Misc/ScopeLock.h"
+#include "PanoramaLatencyHistogram.h"
 
 FPanoPngWriter::FPanoPngWriter()
-    : bRunning(false)
+    : WorkAvailableEvent(FPlatformProcess::GetSynchEventFromPool(false))
+    , FrameCompletedEvent(FPlatformProcess::GetSynchEventFromPool(false))
+    , bStopping(false)
+    , EncodeLatency(MakeUnique<FPanoLatencyHistogram>())
+    , PendingFrameCount(0)
+    , BytesInFlight(0)
+    , FramesEncoded(0)
+    , RawBytesEncoded(0)
+    , CompressedBytesWritten(0)
+    , FirstEnqueueSeconds(0.0)
+    , LastCompletionSeconds(0.0)
 {
 }
 
+FPanoPngWriter::~FPanoPngWriter()
+{
+    Shutdown();
+    FPlatformProcess::ReturnSynchEventToPool(WorkAvailableEvent);
+    FPlatformProcess::ReturnSynchEventToPool(FrameCompletedEvent);
+    WorkAvailableEvent = nullptr;
+    FrameCompletedEvent = nullptr;
+}
+
 void FPanoPngWriter::Configure(const FPanoPngWriteParams& Params)
 {
+    Flush();
+    StopWorkers();
+
     ActiveParams = Params;
-    GeneratedFiles.Reset();
+    {
+        FScopeLock Lock(&GeneratedFilesGuard);
+        GeneratedFiles.Reset();
+    }
+
+    FramesEncoded = 0;
+    RawBytesEncoded = 0;
+    CompressedBytesWritten = 0;
+    FirstEnqueueSeconds = 0.0;
+    LastCompletionSeconds = 0.0;
+    EncodeLatency->Reset();
+
+    StartWorkers();
 }
 
-void FPanoPngWriter::EnqueueFrame(FPanoPngFrame&& Frame)
+void FPanoPngWriter::StartWorkers()
 {
-    FrameQueue.Enqueue(MoveTemp(Frame));
+    int32 NumWorkers = ActiveParams.NumWorkers;
+    if (NumWorkers <= 0)
+    {
+        NumWorkers = FPlatformMisc::NumberOfCoresIncludingHyperthreads() - FMath::Max(0, ActiveParams.ReservedCoreCount);
+    }
+    NumWorkers = FMath::Max(1, NumWorkers);
 
-    if (!bRunning)
+    bStopping = false;
+    Workers.Reserve(NumWorkers);
+    for (int32 WorkerIndex = 0; WorkerIndex < NumWorkers; ++WorkerIndex)
     {
-        bRunning = true;
-        Async(EAsyncExecution::ThreadPool, [this]()
+        Workers.Add(Async(EAsyncExecution::Thread, [this]()
         {
-            ProcessQueue();
-        });
+            WorkerLoop();
+        }));
+    }
+}
+
+void FPanoPngWriter::StopWorkers()
+{
+    if (Workers.Num() == 0)
+    {
+        return;
+    }
+
+    // Each exiting worker re-triggers the event, so one trigger wakes the whole pool.
+    bStopping = true;
+    WorkAvailableEvent->Trigger();
+    for (TFuture<void>& Worker : Workers)
+    {
+        Worker.Wait();
     }
+    Workers.Reset();
+}
+
+void FPanoPngWriter::EnqueueFrame(FPanoPngFrame&& Frame)
+{
+    if (Workers.Num() == 0)
+    {
+        ReleaseFrame(Frame);
+        return;
+    }
+
+    const int64 FrameBytes = Frame.PixelData.Num();
+    const int64 Budget = FMath::Max<int64>(1, ActiveParams.MaxBytesInFlight);
+
+    // Always admit a frame when nothing is in flight so a single oversized frame cannot deadlock.
+    while (BytesInFlight.load() > 0 && BytesInFlight.load() + FrameBytes > Budget)
+    {
+        FrameCompletedEvent->Wait(10);
+    }
+
+    double Expected = 0.0;
+    FirstEnqueueSeconds.compare_exchange_strong(Expected, FPlatformTime::Seconds());
+
+    BytesInFlight += FrameBytes;
+    ++PendingFrameCount;
+    FrameQueue.Enqueue(MoveTemp(Frame));
+    WorkAvailableEvent->Trigger();
 }
 
 void FPanoPngWriter::Flush()
 {
-    while (!FrameQueue.IsEmpty() || bRunning)
+    while (PendingFrameCount.load() > 0)
     {
-        FPlatformProcess::Sleep(0.01f);
+        FrameCompletedEvent->Wait(10);
     }
-    bRunning = false;
 }
 
 void FPanoPngWriter::Shutdown()
 {
     Flush();
-    FrameQueue.Empty();
+    StopWorkers();
+
+    FPanoPngFrame Frame;
+    while (FrameQueue.Dequeue(Frame))
+    {
+        ReleaseFrame(Frame);
+    }
+
+    FScopeLock Lock(&GeneratedFilesGuard);
     GeneratedFiles.Reset();
 }
 
-void FPanoPngWriter::ProcessQueue()
+void FPanoPngWriter::ReleaseFrame(FPanoPngFrame& Frame)
+{
+    if (Frame.OnReleased)
+    {
+        Frame.OnReleased();
+        Frame.OnReleased = nullptr;
+    }
+}
+
+void FPanoPngWriter::WorkerLoop()
 {
-    IImageWrapperModule& ImageWrapperModule = FModuleManager::LoadModuleChecked<IImageWrapperModule>(TEXT("ImageWrapper"));
+    // One encoder per worker; its band buffers and the output buffer keep their allocations between frames.
+    FPanoPngEncoder Encoder;
+    TArray64<uint8> PngData;
 
-    FPanoPngFrame Frame;
-    while (FrameQueue.Dequeue(Frame))
+    for (;;)
     {
-        TSharedPtr<IImageWrapper> ImageWrapper = ImageWrapperModule.CreateImageWrapper(EImageFormat::PNG);
-        if (!ImageWrapper.IsValid())
+        FPanoPngFrame Frame;
+        bool bHasFrame = false;
+        bool bMoreQueued = false;
         {
-            continue;
+            // IsEmpty reads the consumer end of the queue, so it needs the same guard as Dequeue.
+            FScopeLock Lock(&DequeueGuard);
+            bHasFrame = FrameQueue.Dequeue(Frame);
+            bMoreQueued = bHasFrame && !FrameQueue.IsEmpty();
         }
 
-        const ERGBFormat Format = ERGBFormat::RGBA;
-        const int32 BitDepth = Frame.b16Bit ? 16 : 8;
-        if (!ImageWrapper->SetRaw(Frame.PixelData.GetData(), Frame.PixelData.Num(), Frame.Resolution.X, Frame.Resolution.Y, Format, BitDepth))
+        if (!bHasFrame)
         {
+            if (bStopping)
+            {
+                WorkAvailableEvent->Trigger();
+                break;
+            }
+            WorkAvailableEvent->Wait();
             continue;
         }
 
-        const TArray64<uint8>& PngData = ImageWrapper->GetCompressed(0);
-        TArray<uint8> Compressed;
-        Compressed.Append(PngData.GetData(), PngData.Num());
+        // Auto-reset triggers can coalesce; pass the wake along while work remains.
+        if (bMoreQueued)
+        {
+            WorkAvailableEvent->Trigger();
+        }
 
-        const FString FileName = FString::Printf(TEXT("%s_%06llu.png"), *ActiveParams.BaseFileName, Frame.FrameIndex);
-        const FString FilePath = FPaths::Combine(ActiveParams.OutputDirectory, FileName);
-        if (FFileHelper::SaveArrayToFile(Compressed, *FilePath))
+        const double StartSeconds = FPlatformTime::Seconds();
+        const int64 FrameBytes = Frame.PixelData.Num();
+        const int32 BitDepth = Frame.b16Bit ? 16 : 8;
+        const int64 ExpectedBytes = static_cast<int64>(Frame.Resolution.X) * Frame.Resolution.Y * 4 * (BitDepth / 8);
+        // One filter-type byte per row on top of the pixels.
+        const int64 FilteredBytes = ExpectedBytes + Frame.Resolution.Y;
+
+        // The ring slot is handed back as soon as filtering has copied the pixels, before deflate runs. From then on
+        // the frame's reservation covers its filtered rows, and once deflate finishes its compressed file as well,
+        // until the file has been written.
+        int64 ReservedBytes = FrameBytes;
+        const bool bEncoded = FrameBytes >= ExpectedBytes
+            && Encoder.Encode(Frame.PixelData.GetData(), Frame.Resolution.X, Frame.Resolution.Y, BitDepth, ActiveParams.EncodeOptions, PngData, nullptr,
+                [this, &Frame, &ReservedBytes, FilteredBytes]()
+                {
+                    BytesInFlight += FilteredBytes - ReservedBytes;
+                    ReservedBytes = FilteredBytes;
+                    ReleaseFrame(Frame);
+                });
+        ReleaseFrame(Frame);
+
+        if (bEncoded)
         {
-            GeneratedFiles.Add(FilePath);
+            BytesInFlight += PngData.Num();
+            ReservedBytes += PngData.Num();
+
+            const FString FileName = FString::Printf(TEXT("%s_%06llu.png"), *ActiveParams.BaseFileName, Frame.FrameIndex);
+            const FString FilePath = FPaths::Combine(ActiveParams.OutputDirectory, FileName);
+            if (FFileHelper::SaveArrayToFile(PngData, *FilePath))
+            {
+                FScopeLock Lock(&GeneratedFilesGuard);
+                GeneratedFiles.Add(FilePath);
+            }
+
+            ++FramesEncoded;
+            RawBytesEncoded += FrameBytes;
+            CompressedBytesWritten += PngData.Num();
+            LastCompletionSeconds = FPlatformTime::Seconds();
+            EncodeLatency->Record(LastCompletionSeconds.load() - StartSeconds);
         }
-    }
 
-    bRunning = false;
+        BytesInFlight -= ReservedBytes;
+        --PendingFrameCount;
+        FrameCompletedEvent->Trigger();
+    }
 }
 
 TArray<FString> FPanoPngWriter::GetGeneratedFiles() const
 {
+    FScopeLock Lock(&GeneratedFilesGuard);
     return GeneratedFiles;
 }
+
+void FPanoPngWriter::RecompressGeneratedFiles(const FPanoPngEncodeOptions& Options)
+{
+    const TArray<FString> Files = GetGeneratedFiles();
+    const double StartSeconds = FPlatformTime::Seconds();
+
+    FPanoPngEncoder Encoder;
+    TArray64<uint8> Original;
+    TArray64<uint8> Recompressed;
+    int64 BytesBefore = 0;
+    int64 BytesAfter = 0;
+
+    for (const FString& FilePath : Files)
+    {
+        if (!FFileHelper::LoadFileToArray(Original, *FilePath))
+        {
+            continue;
+        }
+
+        BytesBefore += Original.Num();
+        if (Encoder.Recompress(Original, Options, Recompressed) && Recompressed.Num() < Original.Num()
+            && FFileHelper::SaveArrayToFile(Recompressed, *FilePath))
+        {
+            BytesAfter += Recompressed.Num();
+        }
+        else
+        {
+            BytesAfter += Original.Num();
+        }
+    }
+
+    constexpr double BytesPerMegabyte = 1024.0 * 1024.0;
+    UE_LOG(LogTemp, Log, TEXT("Panorama PNG recompress: %d files, %.1f MB -> %.1f MB in %.1f s"),
+        Files.Num(), BytesBefore / BytesPerMegabyte, BytesAfter / BytesPerMegabyte, FPlatformTime::Seconds() - StartSeconds);
+}
+
+FPanoEncodeThroughput FPanoPngWriter::GetThroughput() const
+{
+    FPanoEncodeThroughput Throughput;
+    Throughput.WorkerCount = Workers.Num();
+    Throughput.FramesEncoded = static_cast<int32>(FramesEncoded.load());
+
+    const double Elapsed = LastCompletionSeconds.load() - FirstEnqueueSeconds.load();
+    if (Throughput.FramesEncoded > 0 && Elapsed > 0.0)
+    {
+        constexpr double BytesPerMegabyte = 1024.0 * 1024.0;
+        Throughput.FramesPerSecond = static_cast<float>(Throughput.FramesEncoded / Elapsed);
+        Throughput.RawMegabytesPerSecond = static_cast<float>(RawBytesEncoded.load() / BytesPerMegabyte / Elapsed);
+        Throughput.CompressedMegabytesPerSecond = static_cast<float>(CompressedBytesWritten.load() / BytesPerMegabyte / Elapsed);
+    }
+    return Throughput;
+}
+
+FPanoLatencyStats FPanoPngWriter::GetEncodeLatency() const
+{
+    return EncodeLatency->Summarize();
+}
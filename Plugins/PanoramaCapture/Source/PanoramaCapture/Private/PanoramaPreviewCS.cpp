@@ -0,0 +1,34 @@
+#include "PanoramaPreviewCS.h"
+
+#include "RenderGraphBuilder.h"
+#include "RenderGraphUtils.h"
+#include "RHIStaticStates.h"
+
+IMPLEMENT_GLOBAL_SHADER(FPanoPreviewCS, "/PanoramaCapture/PanoramaPreview.usf", "Main", SF_Compute);
+
+namespace
+{
+    /** 8x8 bilinear taps cover a 16 texel footprint; smaller previews undersample slightly. */
+    constexpr int32 kPreviewMaxTapsPerAxis = 8;
+}
+
+void AddPanoPreviewPass(FRDGBuilder& GraphBuilder, FRDGTextureRef Source, FRDGTextureRef Preview)
+{
+    const FIntPoint SourceResolution = Source->Desc.Extent;
+    const FIntPoint PreviewResolution = Preview->Desc.Extent;
+    // Source texels under one preview pixel along the axis that shrinks more, two per bilinear tap.
+    const float Footprint = FMath::Max(static_cast<float>(SourceResolution.X) / PreviewResolution.X, static_cast<float>(SourceResolution.Y) / PreviewResolution.Y);
+    const int32 TapsPerAxis = FMath::Clamp(FMath::CeilToInt(Footprint * 0.5f), 1, kPreviewMaxTapsPerAxis);
+
+    FPanoPreviewCS::FParameters* Parameters = GraphBuilder.AllocParameters<FPanoPreviewCS::FParameters>();
+    Parameters->PreviewResolution = FVector2f(PreviewResolution);
+    Parameters->InvPreviewResolution = FVector2f(1.0f / PreviewResolution.X, 1.0f / PreviewResolution.Y);
+    Parameters->TapsPerAxis = TapsPerAxis;
+    Parameters->SourceTexture = Source;
+    Parameters->SourceSampler = TStaticSamplerState<SF_Bilinear, AM_Clamp, AM_Clamp, AM_Clamp>::GetRHI();
+    Parameters->PreviewOutput = GraphBuilder.CreateUAV(Preview);
+
+    TShaderMapRef<FPanoPreviewCS> ComputeShader(GetGlobalShaderMap(GMaxRHIFeatureLevel));
+    FComputeShaderUtils::AddPass(GraphBuilder, RDG_EVENT_NAME("PanoramaPreview"), ComputeShader, Parameters,
+        FComputeShaderUtils::GetGroupCount(PreviewResolution, FIntPoint(8, 8)));
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GlobalShader.h"
+#include "ShaderParameterStruct.h"
+#include "RenderGraphResources.h"
+
+class FRDGBuilder;
+
+/** Downsamples the equirect into the preview target with a box filter over each preview pixel's footprint. */
+class FPanoPreviewCS : public FGlobalShader
+{
+    DECLARE_GLOBAL_SHADER(FPanoPreviewCS);
+    SHADER_USE_PARAMETER_STRUCT(FPanoPreviewCS, FGlobalShader);
+
+    BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+        SHADER_PARAMETER(FVector2f, PreviewResolution)
+        SHADER_PARAMETER(FVector2f, InvPreviewResolution)
+        SHADER_PARAMETER(uint32, TapsPerAxis)
+        SHADER_PARAMETER_RDG_TEXTURE(Texture2D, SourceTexture)
+        SHADER_PARAMETER_SAMPLER(SamplerState, SourceSampler)
+        SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D<float4>, PreviewOutput)
+    END_SHADER_PARAMETER_STRUCT()
+
+public:
+    static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+    {
+        return Parameters.Platform == SP_PCD3D_SM5 || Parameters.Platform == SP_PCD3D_SM6;
+    }
+};
+
+/** Adds the downsample from Source (the stacked equirect) into Preview; the filter width follows their size ratio. */
+void AddPanoPreviewPass(FRDGBuilder& GraphBuilder, FRDGTextureRef Source, FRDGTextureRef Preview);
@@ -0,0 +1,212 @@
+#include "PanoramaReadbackPool.h"
+
+#include "Async/ParallelFor.h"
+#include "HAL/PlatformProcess.h"
+#include "PanoramaFrameRingBuffer.h"
+#include "RHI.h"
+#include "RHIGPUReadback.h"
+#include "RenderGraphBuilder.h"
+#include "RenderResource.h"
+#include "RenderingThread.h"
+
+BEGIN_SHADER_PARAMETER_STRUCT(FPanoReadbackCopyParameters, )
+    RDG_TEXTURE_ACCESS(Source, ERHIAccess::CopySrc)
+END_SHADER_PARAMETER_STRUCT()
+
+FPanoReadbackPool::FPanoReadbackPool(int32 InDepth, FPanoFrameRingBuffer* InRingBuffer, TFunction<void()> InOnFrameCommitted)
+    : RingBuffer(InRingBuffer)
+    , OnFrameCommitted(MoveTemp(InOnFrameCommitted))
+    , bNullRHI(GUsingNullRHI)
+{
+    const int32 Depth = FMath::Max(1, InDepth);
+    Entries.Reserve(Depth);
+    for (int32 Index = 0; Index < Depth; ++Index)
+    {
+        TSharedPtr<FEntry, ESPMode::ThreadSafe> Entry = MakeShared<FEntry, ESPMode::ThreadSafe>();
+        if (!bNullRHI)
+        {
+            Entry->Readback = MakeUnique<FRHIGPUTextureReadback>(TEXT("PanoramaCaptureReadback"));
+        }
+        Entries.Add(Entry);
+    }
+}
+
+FPanoReadbackPool::~FPanoReadbackPool()
+{
+    for (int32 EntryIndex : InFlight)
+    {
+        RingBuffer->CancelWriteSlot(Entries[EntryIndex]->Slot);
+    }
+    InFlight.Reset();
+
+    // Pending render commands hold their own references; release the staging textures on the render thread.
+    ENQUEUE_RENDER_COMMAND(PanoramaCapture_ReleaseReadbacks)(
+        [Entries = MoveTemp(Entries)](FRHICommandListImmediate& RHICmdList) mutable
+        {
+            Entries.Reset();
+        });
+}
+
+FPanoReadbackPool::FGraphCopy FPanoReadbackPool::Enqueue(FPanoCaptureFrame* Slot, FIntPoint TexelExtent, int32 BytesPerTexel)
+{
+    int32 FreeIndex = INDEX_NONE;
+    for (int32 Index = 0; Index < Entries.Num(); ++Index)
+    {
+        if (!Entries[Index]->bInUse)
+        {
+            FreeIndex = Index;
+            break;
+        }
+    }
+
+    if (FreeIndex == INDEX_NONE || !Slot
+        || static_cast<int64>(TexelExtent.X) * TexelExtent.Y * BytesPerTexel > Slot->PixelData.Num())
+    {
+        return FGraphCopy();
+    }
+
+    TSharedPtr<FEntry, ESPMode::ThreadSafe> Entry = Entries[FreeIndex];
+    Entry->Slot = Slot;
+    Entry->TexelExtent = TexelExtent;
+    Entry->BytesPerTexel = BytesPerTexel;
+    Entry->bInUse = true;
+    Entry->bCopySubmitted = bNullRHI;
+    InFlight.Add(FreeIndex);
+
+    if (bNullRHI)
+    {
+        return [](FRDGBuilder& GraphBuilder, FRDGTextureRef Source) {};
+    }
+
+    return [Entry](FRDGBuilder& GraphBuilder, FRDGTextureRef Source)
+    {
+        // RDG moves Source to CopySrc after the pass that wrote it; the staging copy itself is recorded on the pass's command list.
+        FPanoReadbackCopyParameters* Parameters = GraphBuilder.AllocParameters<FPanoReadbackCopyParameters>();
+        Parameters->Source = Source;
+        GraphBuilder.AddPass(RDG_EVENT_NAME("PanoramaReadbackCopy"), Parameters, ERDGPassFlags::Readback,
+            [Entry, Source](FRHICommandList& RHICmdList)
+            {
+                Entry->Readback->EnqueueCopy(RHICmdList, Source->GetRHI());
+                Entry->bCopySubmitted = true;
+            });
+    };
+}
+
+bool FPanoReadbackPool::IsEntryReady(const FEntry& Entry) const
+{
+    if (!Entry.bCopySubmitted)
+    {
+        return false;
+    }
+    return bNullRHI || Entry.Readback->IsReady();
+}
+
+void FPanoReadbackPool::Poll()
+{
+    // Readbacks complete in submission order, and the ring delivers in reservation order, so stop at the first pending one.
+    while (InFlight.Num() > 0)
+    {
+        const int32 EntryIndex = InFlight[0];
+        if (!IsEntryReady(*Entries[EntryIndex]))
+        {
+            break;
+        }
+
+        CompleteEntry(EntryIndex);
+        InFlight.RemoveAt(0, 1, EAllowShrinking::No);
+    }
+}
+
+void FPanoReadbackPool::CompleteEntry(int32 EntryIndex)
+{
+    TSharedPtr<FEntry, ESPMode::ThreadSafe> EntryRef = Entries[EntryIndex];
+    FEntry& Entry = *EntryRef;
+    FPanoCaptureFrame* Slot = Entry.Slot;
+    const FIntPoint TexelExtent = Entry.TexelExtent;
+    const int32 BytesPerTexel = Entry.BytesPerTexel;
+    Entry.Slot = nullptr;
+    Entry.bInUse = false;
+
+    if (bNullRHI)
+    {
+        FMemory::Memzero(Slot->PixelData.GetData(), Slot->NumBytes);
+        RingBuffer->CommitWriteSlot(Slot);
+        if (OnFrameCommitted)
+        {
+            OnFrameCommitted();
+        }
+        return;
+    }
+
+    // Any later EnqueueCopy into this entry is queued behind this command, so reusing it right away is safe.
+    ENQUEUE_RENDER_COMMAND(PanoramaCapture_ResolveReadback)(
+        [EntryRef, Slot, TexelExtent, BytesPerTexel, RingBuffer = RingBuffer, OnFrameCommitted = OnFrameCommitted](FRHICommandListImmediate& RHICmdList)
+        {
+            int32 RowPitchInPixels = 0;
+            int32 BufferHeight = 0;
+            const uint8* Source = static_cast<const uint8*>(EntryRef->Readback->Lock(RowPitchInPixels, &BufferHeight));
+            if (!Source || RowPitchInPixels < TexelExtent.X || BufferHeight < TexelExtent.Y)
+            {
+                if (Source)
+                {
+                    EntryRef->Readback->Unlock();
+                }
+                RingBuffer->CancelWriteSlot(Slot);
+                return;
+            }
+
+            const int64 RowBytes = static_cast<int64>(TexelExtent.X) * BytesPerTexel;
+            const int64 SourcePitch = static_cast<int64>(RowPitchInPixels) * BytesPerTexel;
+            uint8* Dest = Slot->PixelData.GetData();
+            ParallelFor(TexelExtent.Y, [Source, Dest, RowBytes, SourcePitch](int32 Row)
+            {
+                FMemory::Memcpy(Dest + Row * RowBytes, Source + Row * SourcePitch, RowBytes);
+            });
+
+            EntryRef->Readback->Unlock();
+            RingBuffer->CommitWriteSlot(Slot);
+            if (OnFrameCommitted)
+            {
+                OnFrameCommitted();
+            }
+        });
+}
+
+void FPanoReadbackPool::Drain(double TimeoutSeconds)
+{
+    if (InFlight.Num() == 0)
+    {
+        return;
+    }
+
+    FlushRenderingCommands();
+
+    const double Deadline = FPlatformTime::Seconds() + TimeoutSeconds;
+    while (InFlight.Num() > 0)
+    {
+        Poll();
+        if (InFlight.Num() == 0)
+        {
+            break;
+        }
+
+        if (FPlatformTime::Seconds() > Deadline)
+        {
+            UE_LOG(LogTemp, Warning, TEXT("Panorama readback drain timed out; discarding %d frame(s)."), InFlight.Num());
+            for (int32 EntryIndex : InFlight)
+            {
+                FEntry& Entry = *Entries[EntryIndex];
+                RingBuffer->CancelWriteSlot(Entry.Slot);
+                Entry.Slot = nullptr;
+                Entry.bInUse = false;
+            }
+            InFlight.Reset();
+            break;
+        }
+
+        FPlatformProcess::Sleep(0.001f);
+    }
+
+    // Execute the copy-out commands Poll() queued.
+    FlushRenderingCommands();
+}
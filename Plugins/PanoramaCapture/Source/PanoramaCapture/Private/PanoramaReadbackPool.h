@@ -0,0 +1,67 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RHIResources.h"
+#include "RenderGraphFwd.h"
+
+#include <atomic>
+
+class FRHIGPUTextureReadback;
+class FPanoFrameRingBuffer;
+struct FPanoCaptureFrame;
+
+/**
+ * Fixed-depth pool of GPU texture readbacks feeding the capture ring.
+ *
+ * The game thread reserves a ring slot and a readback; the frame's render graph then copies the equirect
+ * target into the staging texture (the packed wire format when a pack pass ran). Poll() runs every tick; once a copy's fence has signalled, the render thread maps the
+ * staging texture, copies the rows into the reserved slab and commits the slot. The game thread
+ * never waits for the GPU. Under the null RHI, requests complete on the next poll with zeroed pixels
+ * so the ring, worker and writer path can run headless.
+ */
+class FPanoReadbackPool
+{
+public:
+    FPanoReadbackPool(int32 InDepth, FPanoFrameRingBuffer* InRingBuffer, TFunction<void()> InOnFrameCommitted);
+    ~FPanoReadbackPool();
+
+    /** Render thread: adds the reserved copy of Source to the frame's graph. Must run exactly once. */
+    using FGraphCopy = TUniqueFunction<void(FRDGBuilder& GraphBuilder, FRDGTextureRef Source)>;
+
+    /**
+     * Game thread: reserves a readback into Slot and returns the callback that records its copy. TexelExtent and
+     * BytesPerTexel describe the source texture (which may be a packed layout rather than Slot->Resolution). Unset
+     * when every readback is in flight.
+     */
+    FGraphCopy Enqueue(FPanoCaptureFrame* Slot, FIntPoint TexelExtent, int32 BytesPerTexel);
+
+    /** Game thread: hands every completed readback (in submission order) to the render thread for copy-out. */
+    void Poll();
+
+    /** Game thread: blocks until every queued readback has been committed to the ring or cancelled after TimeoutSeconds. */
+    void Drain(double TimeoutSeconds = 5.0);
+
+    int32 NumInFlight() const { return InFlight.Num(); }
+    int32 GetDepth() const { return Entries.Num(); }
+
+private:
+    struct FEntry
+    {
+        TUniquePtr<FRHIGPUTextureReadback> Readback;
+        FPanoCaptureFrame* Slot = nullptr;
+        FIntPoint TexelExtent = FIntPoint::ZeroValue;
+        int32 BytesPerTexel = 0;
+        bool bInUse = false;
+        /** Set by the copy pass once EnqueueCopy has run; the fence is meaningless before that. */
+        std::atomic<bool> bCopySubmitted{false};
+    };
+
+    bool IsEntryReady(const FEntry& Entry) const;
+    void CompleteEntry(int32 EntryIndex);
+
+    TArray<TSharedPtr<FEntry, ESPMode::ThreadSafe>> Entries;
+    TArray<int32> InFlight;
+    FPanoFrameRingBuffer* RingBuffer;
+    TFunction<void()> OnFrameCommitted;
+    bool bNullRHI;
+};
@@ -0,0 +1,171 @@
+#include "PanoramaResample.h"
+
+#include "Async/ParallelFor.h"
+
+namespace
+{
+    struct FFaceBasis
+    {
+        int32 FaceIndex;
+        FVector3f Axis;
+        FVector3f TangentU;
+        FVector3f TangentV;
+    };
+
+    /** Same face choice and tangents as SampleCubeFiltered in the shader. */
+    FFaceBasis GetFaceBasis(const FVector3f& Direction)
+    {
+        const FVector3f AbsDirection = Direction.GetAbs();
+        if (AbsDirection.X >= AbsDirection.Y && AbsDirection.X >= AbsDirection.Z)
+        {
+            return { Direction.X >= 0.f ? 0 : 1, FVector3f(Direction.X >= 0.f ? 1.f : -1.f, 0.f, 0.f), FVector3f(0.f, 1.f, 0.f), FVector3f(0.f, 0.f, 1.f) };
+        }
+        if (AbsDirection.Y >= AbsDirection.Z)
+        {
+            return { Direction.Y >= 0.f ? 2 : 3, FVector3f(0.f, Direction.Y >= 0.f ? 1.f : -1.f, 0.f), FVector3f(1.f, 0.f, 0.f), FVector3f(0.f, 0.f, 1.f) };
+        }
+        return { Direction.Z >= 0.f ? 4 : 5, FVector3f(0.f, 0.f, Direction.Z >= 0.f ? 1.f : -1.f), FVector3f(1.f, 0.f, 0.f), FVector3f(0.f, 1.f, 0.f) };
+    }
+
+    FVector2f GetPlaneCoord(const FVector3f& Direction, const FFaceBasis& Basis)
+    {
+        const FVector3f OnPlane = Direction / FVector3f::DotProduct(Direction, Basis.Axis);
+        return FVector2f(FVector3f::DotProduct(OnPlane, Basis.TangentU), FVector3f::DotProduct(OnPlane, Basis.TangentV));
+    }
+
+    float SampleFiltered(const PanoramaResample::FCubeImage& Cube, EPanoramaResampleFilter Filter, const FVector3f& Direction, FIntPoint Resolution)
+    {
+        const bool bBicubic = Filter == EPanoramaResampleFilter::Bicubic;
+        const int32 Radius = bBicubic ? 2 : 3;
+        const FFaceBasis Basis = GetFaceBasis(Direction);
+        const FVector2f PlaneCoord = GetPlaneCoord(Direction, Basis);
+        const float TexelPlaneSize = 2.0f / Cube.FaceSize;
+        const float Footprint = FMath::Max(1.0f, UE_PI / Resolution.Y * (1.0f + PlaneCoord.SizeSquared()) / TexelPlaneSize);
+
+        const FVector2f Texel = ((PlaneCoord + 1.0f) / TexelPlaneSize - 0.5f) / Footprint;
+        const FVector2f BaseTexel(FMath::FloorToFloat(Texel.X), FMath::FloorToFloat(Texel.Y));
+        const FVector2f Fraction = Texel - BaseTexel;
+
+        float Sum = 0.f;
+        float WeightSum = 0.f;
+        for (int32 Y = 1 - Radius; Y <= Radius; ++Y)
+        {
+            const float WeightY = bBicubic ? PanoramaResample::CatmullRomWeight(Y - Fraction.Y) : PanoramaResample::LanczosWeight(Y - Fraction.Y);
+            const float PlaneV = ((BaseTexel.Y + Y) * Footprint + 0.5f) * TexelPlaneSize - 1.0f;
+            for (int32 X = 1 - Radius; X <= Radius; ++X)
+            {
+                const float Weight = (bBicubic ? PanoramaResample::CatmullRomWeight(X - Fraction.X) : PanoramaResample::LanczosWeight(X - Fraction.X)) * WeightY;
+                const float PlaneU = ((BaseTexel.X + X) * Footprint + 0.5f) * TexelPlaneSize - 1.0f;
+                Sum += Weight * Cube.SampleBilinear(Basis.Axis + PlaneU * Basis.TangentU + PlaneV * Basis.TangentV);
+                WeightSum += Weight;
+            }
+        }
+        return FMath::Max(Sum / WeightSum, 0.f);
+    }
+}
+
+namespace PanoramaResample
+{
+    void FCubeImage::Render(int32 InFaceSize, TFunctionRef<float(const FVector3f&)> Scene)
+    {
+        FaceSize = InFaceSize;
+        Texels.SetNumUninitialized(6 * static_cast<int64>(FaceSize) * FaceSize);
+        const float TexelPlaneSize = 2.0f / FaceSize;
+        ParallelFor(6 * FaceSize, [this, &Scene, TexelPlaneSize](int32 FaceRow)
+        {
+            const int32 FaceIndex = FaceRow / FaceSize;
+            const int32 Row = FaceRow % FaceSize;
+            const float Sign = (FaceIndex & 1) ? -1.f : 1.f;
+            const FFaceBasis Basis = GetFaceBasis(FaceIndex < 2 ? FVector3f(Sign, 0.f, 0.f) : FaceIndex < 4 ? FVector3f(0.f, Sign, 0.f) : FVector3f(0.f, 0.f, Sign));
+            const float PlaneV = (Row + 0.5f) * TexelPlaneSize - 1.0f;
+            float* RowTexels = Texels.GetData() + static_cast<int64>(FaceRow) * FaceSize;
+            for (int32 Column = 0; Column < FaceSize; ++Column)
+            {
+                const float PlaneU = (Column + 0.5f) * TexelPlaneSize - 1.0f;
+                RowTexels[Column] = Scene((Basis.Axis + PlaneU * Basis.TangentU + PlaneV * Basis.TangentV).GetSafeNormal());
+            }
+        });
+    }
+
+    float FCubeImage::SampleBilinear(const FVector3f& Direction) const
+    {
+        const FFaceBasis Basis = GetFaceBasis(Direction);
+        const FVector2f PlaneCoord = GetPlaneCoord(Direction, Basis);
+        const float X = FMath::Clamp((PlaneCoord.X + 1.0f) * 0.5f * FaceSize - 0.5f, 0.f, FaceSize - 1.f);
+        const float Y = FMath::Clamp((PlaneCoord.Y + 1.0f) * 0.5f * FaceSize - 0.5f, 0.f, FaceSize - 1.f);
+        const int32 X0 = FMath::FloorToInt32(X);
+        const int32 Y0 = FMath::FloorToInt32(Y);
+        const int32 X1 = FMath::Min(X0 + 1, FaceSize - 1);
+        const int32 Y1 = FMath::Min(Y0 + 1, FaceSize - 1);
+        const float* Face = Texels.GetData() + static_cast<int64>(Basis.FaceIndex) * FaceSize * FaceSize;
+        const float Top = FMath::Lerp(Face[Y0 * FaceSize + X0], Face[Y0 * FaceSize + X1], X - X0);
+        const float Bottom = FMath::Lerp(Face[Y1 * FaceSize + X0], Face[Y1 * FaceSize + X1], X - X0);
+        return FMath::Lerp(Top, Bottom, Y - Y0);
+    }
+
+    float CatmullRomWeight(float X)
+    {
+        X = FMath::Abs(X);
+        if (X < 1.f)
+        {
+            return (1.5f * X - 2.5f) * X * X + 1.f;
+        }
+        if (X < 2.f)
+        {
+            return ((-0.5f * X + 2.5f) * X - 4.f) * X + 2.f;
+        }
+        return 0.f;
+    }
+
+    float LanczosWeight(float X)
+    {
+        X = FMath::Abs(X);
+        if (X < 1.e-5f)
+        {
+            return 1.f;
+        }
+        if (X >= 3.f)
+        {
+            return 0.f;
+        }
+        const float PiX = UE_PI * X;
+        return 3.f * FMath::Sin(PiX) * FMath::Sin(PiX / 3.f) / (PiX * PiX);
+    }
+
+    FVector2f GetSupersampleOffset(int32 Index)
+    {
+        // Mirrored R2 pairs; keep in sync with GetSupersampleOffset in the shader.
+        const int32 Pair = Index / 2 + 1;
+        const FVector2f Offset(FMath::Frac(0.5f + 0.7548776662466927f * Pair) - 0.5f, FMath::Frac(0.5f + 0.5698402909980532f * Pair) - 0.5f);
+        return (Index & 1) ? -Offset : Offset;
+    }
+
+    FVector3f GetDirection(FVector2f PixelPosition, FIntPoint Resolution)
+    {
+        const float Phi = (PixelPosition.X / Resolution.X - 0.5f) * (2.0f * UE_PI);
+        const float Theta = (0.5f - PixelPosition.Y / Resolution.Y) * UE_PI;
+        return FVector3f(FMath::Cos(Theta) * FMath::Cos(Phi), FMath::Cos(Theta) * FMath::Sin(Phi), FMath::Sin(Theta));
+    }
+
+    float Resample(const FCubeImage& Cube, EPanoramaResampleFilter Filter, FIntPoint Pixel, FIntPoint Resolution, int32 SupersampleCount)
+    {
+        const FVector2f Center(Pixel.X + 0.5f, Pixel.Y + 0.5f);
+        switch (Filter)
+        {
+        case EPanoramaResampleFilter::Bicubic:
+        case EPanoramaResampleFilter::Lanczos3:
+            return SampleFiltered(Cube, Filter, GetDirection(Center, Resolution), Resolution);
+        case EPanoramaResampleFilter::Supersampled:
+        {
+            float Sum = 0.f;
+            for (int32 Index = 0; Index < SupersampleCount; ++Index)
+            {
+                Sum += Cube.SampleBilinear(GetDirection(Center + GetSupersampleOffset(Index), Resolution));
+            }
+            return Sum / SupersampleCount;
+        }
+        default:
+            return Cube.SampleBilinear(GetDirection(Center, Resolution));
+        }
+    }
+}
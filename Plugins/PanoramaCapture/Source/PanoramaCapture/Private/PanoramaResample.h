@@ -0,0 +1,35 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PanoramaCaptureTypes.h"
+
+/**
+ * CPU reference of the resampling filters in PanoramaCubemapToEquirect.usf, for an unrotated rig. Kernels, footprint
+ * and tap placement follow the shader; the cube is single-channel and its bilinear fetch clamps at face edges where
+ * the GPU's seamless filtering blends across them.
+ */
+namespace PanoramaResample
+{
+    /** Six FaceSize x FaceSize faces ordered +X, -X, +Y, -Y, +Z, -Z. */
+    struct FCubeImage
+    {
+        int32 FaceSize = 0;
+        TArray64<float> Texels;
+
+        /** Evaluates Scene at every texel centre, as a capture with no anti-aliasing would. */
+        void Render(int32 InFaceSize, TFunctionRef<float(const FVector3f&)> Scene);
+
+        float SampleBilinear(const FVector3f& Direction) const;
+    };
+
+    float CatmullRomWeight(float X);
+    float LanczosWeight(float X);
+
+    /** Sub-pixel offset in [-0.5, 0.5]^2 of supersample Index; consecutive even/odd indices mirror each other. */
+    FVector2f GetSupersampleOffset(int32 Index);
+
+    /** Direction through PixelPosition (in pixels, not pixel centres) of a Resolution-sized equirect. */
+    FVector3f GetDirection(FVector2f PixelPosition, FIntPoint Resolution);
+
+    float Resample(const FCubeImage& Cube, EPanoramaResampleFilter Filter, FIntPoint Pixel, FIntPoint Resolution, int32 SupersampleCount);
+}
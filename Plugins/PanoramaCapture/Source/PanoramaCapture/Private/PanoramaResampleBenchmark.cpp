@@ -0,0 +1,148 @@
+#include "PanoramaResampleBenchmark.h"
+
+#include "HAL/IConsoleManager.h"
+#include "Async/ParallelFor.h"
+#include "PanoramaResample.h"
+
+namespace
+{
+    constexpr int32 kGroundTruthGrid = 8;
+
+    const TCHAR* GetResampleFilterName(EPanoramaResampleFilter Filter)
+    {
+        switch (Filter)
+        {
+        case EPanoramaResampleFilter::Bilinear: return TEXT("Bilinear");
+        case EPanoramaResampleFilter::Bicubic: return TEXT("Bicubic");
+        case EPanoramaResampleFilter::Lanczos3: return TEXT("Lanczos-3");
+        case EPanoramaResampleFilter::Supersampled: return TEXT("Supersampled");
+        }
+        return TEXT("?");
+    }
+
+    double ToPsnr(double MeanSquaredError)
+    {
+        return MeanSquaredError > 0.0 ? 10.0 * FMath::LogX(10.0, 1.0 / MeanSquaredError) : 99.0;
+    }
+
+    /** PSNR of Filter against Reference (or against Flat where Reference is empty), split by latitude band. */
+    FPanoResampleBandPsnr MeasureFilter(const PanoramaResample::FCubeImage& Cube, EPanoramaResampleFilter Filter, FIntPoint Resolution, int32 Supersamples, const TArray<float>& Reference, float Flat, double& OutSeconds)
+    {
+        TArray<double> RowError;
+        RowError.SetNumZeroed(Resolution.Y);
+        const double Start = FPlatformTime::Seconds();
+        ParallelFor(Resolution.Y, [&](int32 Row)
+        {
+            double Error = 0.0;
+            for (int32 X = 0; X < Resolution.X; ++X)
+            {
+                const float Expected = Reference.Num() > 0 ? Reference[Row * Resolution.X + X] : Flat;
+                Error += FMath::Square(static_cast<double>(PanoramaResample::Resample(Cube, Filter, FIntPoint(X, Row), Resolution, Supersamples) - Expected));
+            }
+            RowError[Row] = Error;
+        });
+        OutSeconds = FPlatformTime::Seconds() - Start;
+
+        // Polar: beyond 60 degrees latitude. Equatorial: within 30 degrees.
+        const int32 PolarRows = Resolution.Y / 6;
+        double Total = 0.0;
+        double Polar = 0.0;
+        double Equator = 0.0;
+        for (int32 Row = 0; Row < Resolution.Y; ++Row)
+        {
+            Total += RowError[Row];
+            if (Row < PolarRows || Row >= Resolution.Y - PolarRows)
+            {
+                Polar += RowError[Row];
+            }
+            else if (Row >= Resolution.Y / 3 && Row < Resolution.Y - Resolution.Y / 3)
+            {
+                Equator += RowError[Row];
+            }
+        }
+        const double Width = Resolution.X;
+        FPanoResampleBandPsnr Result;
+        Result.Total = ToPsnr(Total / (Width * Resolution.Y));
+        Result.Polar = ToPsnr(Polar / (Width * PolarRows * 2));
+        Result.Equator = ToPsnr(Equator / (Width * (Resolution.Y - 2 * (Resolution.Y / 3))));
+        return Result;
+    }
+}
+
+TArray<FPanoResampleQuality> PanoramaResampleBenchmark::Measure(int32 Width, int32 FaceSize, int32 Supersamples)
+{
+    const FIntPoint Resolution(Width, Width / 2);
+
+    auto MakeScene = [](float Frequency)
+    {
+        return [Frequency](const FVector3f& Direction)
+        {
+            return 0.5f + 0.25f * FMath::Sin(Frequency * Direction.X) * FMath::Sin(Frequency * Direction.Y) * FMath::Sin(Frequency * Direction.Z);
+        };
+    };
+    const auto SmoothScene = MakeScene(FaceSize / 16.f);
+    const auto FineScene = MakeScene(static_cast<float>(FaceSize));
+
+    PanoramaResample::FCubeImage SmoothCube;
+    SmoothCube.Render(FaceSize, SmoothScene);
+    PanoramaResample::FCubeImage FineCube;
+    FineCube.Render(FaceSize, FineScene);
+
+    TArray<float> GroundTruth;
+    GroundTruth.SetNumUninitialized(Resolution.X * Resolution.Y);
+    ParallelFor(Resolution.Y, [&](int32 Row)
+    {
+        for (int32 X = 0; X < Resolution.X; ++X)
+        {
+            float Sum = 0.f;
+            for (int32 SubY = 0; SubY < kGroundTruthGrid; ++SubY)
+            {
+                for (int32 SubX = 0; SubX < kGroundTruthGrid; ++SubX)
+                {
+                    const FVector2f Position(X + (SubX + 0.5f) / kGroundTruthGrid, Row + (SubY + 0.5f) / kGroundTruthGrid);
+                    Sum += SmoothScene(PanoramaResample::GetDirection(Position, Resolution));
+                }
+            }
+            GroundTruth[Row * Resolution.X + X] = Sum / (kGroundTruthGrid * kGroundTruthGrid);
+        }
+    });
+
+    TArray<FPanoResampleQuality> Results;
+    const TArray<float> NoReference;
+    for (EPanoramaResampleFilter Filter : { EPanoramaResampleFilter::Bilinear, EPanoramaResampleFilter::Bicubic, EPanoramaResampleFilter::Lanczos3, EPanoramaResampleFilter::Supersampled })
+    {
+        FPanoResampleQuality& Quality = Results.AddDefaulted_GetRef();
+        Quality.Filter = Filter;
+        double Unused = 0.0;
+        Quality.Passband = MeasureFilter(SmoothCube, Filter, Resolution, Supersamples, GroundTruth, 0.f, Quality.Seconds);
+        Quality.Aliasing = MeasureFilter(FineCube, Filter, Resolution, Supersamples, NoReference, 0.5f, Unused);
+    }
+    return Results;
+}
+
+namespace
+{
+    /** Logs PanoramaResampleBenchmark::Measure for every filter. GPU timings of each filter are in "stat gpu". */
+    void RunResampleCheck(const TArray<FString>& Args)
+    {
+        const int32 Width = Args.Num() > 0 ? FMath::Max(16, FCString::Atoi(*Args[0])) : 2048;
+        const int32 FaceSize = Args.Num() > 1 ? FMath::Max(8, FCString::Atoi(*Args[1])) : 1024;
+        const int32 RequestedSamples = Args.Num() > 2 ? FCString::Atoi(*Args[2]) : 8;
+        const int32 Supersamples = FMath::Clamp(RequestedSamples + (RequestedSamples & 1), 2, 64);
+
+        UE_LOG(LogTemp, Display, TEXT("Panorama resample check: %dx%d from %d px faces, %d supersamples (PSNR in dB: total / polar / equator)"),
+            Width, Width / 2, FaceSize, Supersamples);
+        for (const FPanoResampleQuality& Quality : PanoramaResampleBenchmark::Measure(Width, FaceSize, Supersamples))
+        {
+            UE_LOG(LogTemp, Display, TEXT("  %-12s CPU %8.1f ms  passband %.1f / %.1f / %.1f  aliasing %.1f / %.1f / %.1f"),
+                GetResampleFilterName(Quality.Filter), Quality.Seconds * 1000.0,
+                Quality.Passband.Total, Quality.Passband.Polar, Quality.Passband.Equator,
+                Quality.Aliasing.Total, Quality.Aliasing.Polar, Quality.Aliasing.Equator);
+        }
+    }
+
+    FAutoConsoleCommand GPanoramaResampleCheckCommand(
+        TEXT("Panorama.ResampleCheck"),
+        TEXT("Measures blur and aliasing of each equirect resampling filter against analytic scenes on the CPU. Usage: Panorama.ResampleCheck [Width] [FaceSize] [Supersamples]"),
+        FConsoleCommandWithArgsDelegate::CreateStatic(&RunResampleCheck));
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PanoramaCaptureTypes.h"
+
+/** PSNR in dB, higher is better: whole image, beyond 60 degrees latitude and within 30 degrees of the equator. */
+struct FPanoResampleBandPsnr
+{
+    double Total = 0.0;
+    double Polar = 0.0;
+    double Equator = 0.0;
+};
+
+struct FPanoResampleQuality
+{
+    EPanoramaResampleFilter Filter = EPanoramaResampleFilter::Bilinear;
+    /** A smooth pattern (about 30 output pixels per period) against the scene box-filtered over each output pixel; shows blur and ringing. */
+    FPanoResampleBandPsnr Passband;
+    /** A pattern the faces resolve but the equirect cannot, whose ideal output is flat grey; whatever survives is moire. */
+    FPanoResampleBandPsnr Aliasing;
+    /** CPU time of the passband resample. */
+    double Seconds = 0.0;
+};
+
+namespace PanoramaResampleBenchmark
+{
+    /**
+     * Renders analytic scenes into FaceSize cube faces without anti-aliasing and resamples them to a Width x Width / 2
+     * equirect with every filter, through the CPU reference.
+     */
+    TArray<FPanoResampleQuality> Measure(int32 Width, int32 FaceSize, int32 Supersamples);
+}
@@ -0,0 +1,165 @@
+#include "PanoramaWavWriter.h"
+
+#include "HAL/PlatformFileManager.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+
+namespace
+{
+    constexpr int32 kBitsPerSample = 16;
+    constexpr uint32 kDs64PayloadBytes = 28;
+    // RIFF/RF64 header (12) + JUNK/ds64 chunk (8 + 28) + fmt chunk (8 + 16) + data chunk header (8).
+    constexpr int64 kHeaderBytes = 12 + 8 + kDs64PayloadBytes + 8 + 16 + 8;
+    constexpr int64 kMaxRiffBytes = 0xFFFFFFFFll;
+    // Samples converted per write call, keeping the scratch buffer small.
+    constexpr int64 kConvertBlockSamples = 64 * 1024;
+
+    void AppendTag(TArray<uint8>& Buffer, const char* Tag)
+    {
+        Buffer.Append(reinterpret_cast<const uint8*>(Tag), 4);
+    }
+
+    template <typename T>
+    void AppendValue(TArray<uint8>& Buffer, T Value)
+    {
+        Buffer.Append(reinterpret_cast<const uint8*>(&Value), sizeof(T));
+    }
+}
+
+FPanoWavWriter::FPanoWavWriter()
+    : DataBytes(0)
+    , SampleRate(48000)
+    , NumChannels(2)
+{
+}
+
+FPanoWavWriter::~FPanoWavWriter()
+{
+    Close();
+}
+
+bool FPanoWavWriter::Open(const FString& InFilePath, int32 InSampleRate, int32 InNumChannels)
+{
+    Close();
+
+    FilePath = InFilePath;
+    SampleRate = FMath::Max(1, InSampleRate);
+    NumChannels = FMath::Max(1, InNumChannels);
+    DataBytes = 0;
+
+    FileHandle.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*FilePath));
+    if (!FileHandle)
+    {
+        UE_LOG(LogTemp, Error, TEXT("Failed to open WAV file for writing: %s"), *FilePath);
+        return false;
+    }
+
+    return WriteHeader(false);
+}
+
+bool FPanoWavWriter::WriteHeader(bool bFinal)
+{
+    const bool bRF64 = bFinal && kHeaderBytes - 8 + DataBytes > kMaxRiffBytes;
+    const uint32 RiffSize = bRF64 ? 0xFFFFFFFFu : static_cast<uint32>(kHeaderBytes - 8 + DataBytes);
+    const uint32 DataSize = bRF64 ? 0xFFFFFFFFu : static_cast<uint32>(DataBytes);
+    const int32 BlockAlign = NumChannels * kBitsPerSample / 8;
+
+    TArray<uint8> Header;
+    Header.Reserve(kHeaderBytes);
+    AppendTag(Header, bRF64 ? "RF64" : "RIFF");
+    AppendValue<uint32>(Header, RiffSize);
+    AppendTag(Header, "WAVE");
+
+    // Readers skip JUNK; at close it becomes ds64 if the 32-bit sizes overflow.
+    AppendTag(Header, bRF64 ? "ds64" : "JUNK");
+    AppendValue<uint32>(Header, kDs64PayloadBytes);
+    if (bRF64)
+    {
+        AppendValue<uint64>(Header, static_cast<uint64>(kHeaderBytes - 8 + DataBytes));
+        AppendValue<uint64>(Header, static_cast<uint64>(DataBytes));
+        AppendValue<uint64>(Header, static_cast<uint64>(GetNumSampleFrames()));
+        AppendValue<uint32>(Header, 0);
+    }
+    else
+    {
+        Header.AddZeroed(kDs64PayloadBytes);
+    }
+
+    AppendTag(Header, "fmt ");
+    AppendValue<uint32>(Header, 16);
+    AppendValue<uint16>(Header, 1);
+    AppendValue<uint16>(Header, static_cast<uint16>(NumChannels));
+    AppendValue<uint32>(Header, static_cast<uint32>(SampleRate));
+    AppendValue<uint32>(Header, static_cast<uint32>(SampleRate * BlockAlign));
+    AppendValue<uint16>(Header, static_cast<uint16>(BlockAlign));
+    AppendValue<uint16>(Header, static_cast<uint16>(kBitsPerSample));
+
+    AppendTag(Header, "data");
+    AppendValue<uint32>(Header, DataSize);
+    check(Header.Num() == kHeaderBytes);
+
+    const int64 ResumePosition = kHeaderBytes + DataBytes;
+    if (!FileHandle->Seek(0) || !FileHandle->Write(Header.GetData(), Header.Num()))
+    {
+        return false;
+    }
+    return FileHandle->Seek(ResumePosition);
+}
+
+bool FPanoWavWriter::WriteSamples(const float* Samples, int64 NumSamples)
+{
+    if (!FileHandle)
+    {
+        return false;
+    }
+
+    for (int64 Offset = 0; Offset < NumSamples; Offset += kConvertBlockSamples)
+    {
+        const int32 BlockSamples = static_cast<int32>(FMath::Min(kConvertBlockSamples, NumSamples - Offset));
+        ConvertScratch.SetNumUninitialized(BlockSamples, EAllowShrinking::No);
+        for (int32 Index = 0; Index < BlockSamples; ++Index)
+        {
+            ConvertScratch[Index] = static_cast<int16>(FMath::Clamp(Samples[Offset + Index], -1.f, 1.f) * 32767.f);
+        }
+
+        if (OnSamplesConverted)
+        {
+            OnSamplesConverted(ConvertScratch.GetData(), BlockSamples);
+        }
+
+        const int64 BlockBytes = static_cast<int64>(BlockSamples) * sizeof(int16);
+        if (!FileHandle->Write(reinterpret_cast<const uint8*>(ConvertScratch.GetData()), BlockBytes))
+        {
+            UE_LOG(LogTemp, Error, TEXT("Failed to write audio samples to %s"), *FilePath);
+            return false;
+        }
+        DataBytes += BlockBytes;
+    }
+
+    return true;
+}
+
+bool FPanoWavWriter::Close()
+{
+    if (!FileHandle)
+    {
+        return false;
+    }
+
+    const bool bPatched = WriteHeader(true) && FileHandle->Flush();
+    FileHandle.Reset();
+    if (!bPatched)
+    {
+        UE_LOG(LogTemp, Error, TEXT("Failed to finalize WAV header: %s"), *FilePath);
+    }
+    return bPatched;
+}
+
+int64 FPanoWavWriter::GetNumSampleFrames() const
+{
+    return DataBytes / (static_cast<int64>(NumChannels) * (kBitsPerSample / 8));
+}
+
+double FPanoWavWriter::GetDurationSeconds() const
+{
+    return static_cast<double>(GetNumSampleFrames()) / SampleRate;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class IFileHandle;
+
+/**
+ * Incremental 16-bit PCM WAV writer.
+ *
+ * The header reserves a JUNK chunk the size of an RF64 ds64 chunk. Close() patches the sizes in place and, when
+ * the file has grown past 4 GB, rewrites the header as RF64 (EBU Tech 3306) so long sessions stay readable.
+ * Not thread-safe; the owner serializes calls.
+ */
+class FPanoWavWriter
+{
+public:
+    FPanoWavWriter();
+    ~FPanoWavWriter();
+
+    bool Open(const FString& InFilePath, int32 InSampleRate, int32 InNumChannels);
+
+    /** Converts interleaved float samples to int16 and appends them to the data chunk. */
+    bool WriteSamples(const float* Samples, int64 NumSamples);
+
+    /** Called with every block of converted samples before it is written, so listeners see exactly what lands on disk. */
+    void SetOnSamplesConverted(TFunction<void(const int16* Samples, int32 NumSamples)> InCallback) { OnSamplesConverted = MoveTemp(InCallback); }
+
+    /** Patches the header and closes the file. Returns false if the file could not be finalized. */
+    bool Close();
+
+    bool IsOpen() const { return FileHandle.IsValid(); }
+    int64 GetNumSampleFrames() const;
+    double GetDurationSeconds() const;
+
+private:
+    bool WriteHeader(bool bFinal);
+
+    TUniquePtr<IFileHandle> FileHandle;
+    FString FilePath;
+    TArray<int16> ConvertScratch;
+    TFunction<void(const int16*, int32)> OnSamplesConverted;
+    int64 DataBytes;
+    int32 SampleRate;
+    int32 NumChannels;
+};
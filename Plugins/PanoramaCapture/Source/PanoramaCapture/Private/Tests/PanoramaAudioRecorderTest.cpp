@@ -0,0 +1,96 @@
+#include "Misc/AutomationTest.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformMemory.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/Paths.h"
+#include "PanoramaAudioRecorder.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    constexpr int32 kLongSessionSampleRate = 48000;
+    constexpr int32 kLongSessionChannels = 2;
+    constexpr int32 kLongSessionCallbackFrames = 480;
+    /** Long enough that buffering the session (about 220 MB of floats) would dwarf the allowed growth. */
+    constexpr double kLongSessionMinutes = 10.0;
+    /** Memory is sampled after this much audio, once the ring, scratch buffers and file handle exist. */
+    constexpr double kLongSessionWarmupSeconds = 30.0;
+    constexpr uint64 kLongSessionAllowedGrowthBytes = 32ull * 1024 * 1024;
+    /** The ring holds two seconds; the feeder stays under that so a slow disk cannot cause overruns. */
+    constexpr double kLongSessionMaxLeadSeconds = 1.0;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPanoAudioRecorderLongSessionTest, "PanoramaCapture.AudioRecorder.LongSessionMemoryIsFlat",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FPanoAudioRecorderLongSessionTest::RunTest(const FString& Parameters)
+{
+    const FString WavPath = FPaths::Combine(FPaths::AutomationTransientDir(), TEXT("PanoramaLongSession.wav"));
+    FPanoAudioRecorder Recorder;
+    if (!TestTrue(TEXT("Streaming starts"), Recorder.StartStreaming(kLongSessionSampleRate, kLongSessionChannels, WavPath)))
+    {
+        return false;
+    }
+
+    // A quiet sine, so the int16 conversion sees real values.
+    TArray<float> Buffer;
+    Buffer.SetNumUninitialized(kLongSessionCallbackFrames * kLongSessionChannels);
+
+    const int64 TotalCallbacks = static_cast<int64>(kLongSessionMinutes * 60.0 * kLongSessionSampleRate / kLongSessionCallbackFrames);
+    const int64 WarmupCallbacks = static_cast<int64>(kLongSessionWarmupSeconds * kLongSessionSampleRate / kLongSessionCallbackFrames);
+    uint64 WarmupUsedPhysical = 0;
+    uint64 PeakUsedPhysical = 0;
+    int64 FramesFed = 0;
+    for (int64 Callback = 0; Callback < TotalCallbacks; ++Callback)
+    {
+        for (int32 Frame = 0; Frame < kLongSessionCallbackFrames; ++Frame)
+        {
+            const float Value = 0.25f * FMath::Sin(2.0f * PI * 440.0f * static_cast<float>((FramesFed + Frame) % kLongSessionSampleRate) / kLongSessionSampleRate);
+            for (int32 Channel = 0; Channel < kLongSessionChannels; ++Channel)
+            {
+                Buffer[Frame * kLongSessionChannels + Channel] = Value;
+            }
+        }
+
+        const double AudioClock = static_cast<double>(FramesFed) / kLongSessionSampleRate;
+        Recorder.OnNewSubmixBuffer(nullptr, Buffer.GetData(), Buffer.Num(), kLongSessionChannels, kLongSessionSampleRate, AudioClock);
+        FramesFed += kLongSessionCallbackFrames;
+
+        // The test runs faster than real time; let the writer keep up rather than measuring overruns.
+        while (static_cast<double>(FramesFed) / kLongSessionSampleRate - Recorder.GetRecordedDurationSeconds() > kLongSessionMaxLeadSeconds)
+        {
+            FPlatformProcess::Sleep(0.001f);
+        }
+
+        if (Callback % 1000 == 0 || Callback == WarmupCallbacks)
+        {
+            const uint64 UsedPhysical = FPlatformMemory::GetStats().UsedPhysical;
+            if (Callback == WarmupCallbacks)
+            {
+                WarmupUsedPhysical = UsedPhysical;
+            }
+            else if (Callback > WarmupCallbacks)
+            {
+                PeakUsedPhysical = FMath::Max(PeakUsedPhysical, UsedPhysical);
+            }
+        }
+    }
+    Recorder.StopRecording();
+
+    const uint64 Growth = PeakUsedPhysical > WarmupUsedPhysical ? PeakUsedPhysical - WarmupUsedPhysical : 0;
+    AddInfo(FString::Printf(TEXT("%.0f minutes of audio, resident memory grew %.1f MB after warm-up"), kLongSessionMinutes, Growth / (1024.0 * 1024.0)));
+    TestTrue(TEXT("Resident memory stays flat over the session"), Growth < kLongSessionAllowedGrowthBytes);
+
+    const FPanoAudioCaptureStats Stats = Recorder.GetCaptureStats();
+    TestEqual(TEXT("No callback overran the ring"), Stats.OverrunCount, 0);
+    TestEqual(TEXT("No samples were dropped"), Stats.DroppedSamples, 0ll);
+    TestEqual(TEXT("Every fed sample reached the file"), Recorder.GetRecordedDurationSeconds(), static_cast<double>(FramesFed) / kLongSessionSampleRate);
+
+    const int64 DataBytes = FramesFed * kLongSessionChannels * static_cast<int64>(sizeof(int16));
+    TestTrue(TEXT("The WAV holds the whole session"), IFileManager::Get().FileSize(*WavPath) >= DataBytes);
+    IFileManager::Get().Delete(*WavPath);
+    return true;
+}
+
+#endif
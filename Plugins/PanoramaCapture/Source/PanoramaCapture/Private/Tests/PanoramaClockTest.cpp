@@ -0,0 +1,79 @@
+#include "Misc/AutomationTest.h"
+#include "PanoramaCaptureClock.h"
+#include "PanoramaClockSimulation.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPanoClockJitterTest, "PanoramaCapture.Clock.JitteryFrames",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FPanoClockJitterTest::RunTest(const FString& Parameters)
+{
+    // An hour at 30 fps with +/-8 ms jitter and 100 ms hitches: frames stay within one audio block and never drift.
+    FPanoClockSimulationParams Params;
+    const FPanoClockSimulationResult Result = PanoramaClockSimulation::Run(Params);
+
+    TestTrue(TEXT("Every frame is stamped after the audio locks"), Result.LockedFrames > Result.FrameCount - 10);
+    TestTrue(TEXT("Session time never decreases"), Result.bMonotonic);
+    TestTrue(FString::Printf(TEXT("Max error %.1f samples is under one block"), Result.MaxErrorSamples), Result.MaxErrorSamples < Result.BlockFrames);
+    TestTrue(FString::Printf(TEXT("Drift %.1f samples is under one block"), Result.DriftSamples), FMath::Abs(Result.DriftSamples) < Result.BlockFrames);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPanoClockMissedBlocksTest, "PanoramaCapture.Clock.MissedAudioBlocks",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FPanoClockMissedBlocksTest::RunTest(const FString& Parameters)
+{
+    // Blocks the device renders without a callback advance the clock through AudioClock. Counting only delivered
+    // frames would fall one block behind per miss, about 12 s over this run.
+    FPanoClockSimulationParams Params;
+    Params.Minutes = 20.0;
+    Params.MissedBlockChance = 0.01;
+    const FPanoClockSimulationResult Result = PanoramaClockSimulation::Run(Params);
+
+    TestTrue(TEXT("Session time never decreases"), Result.bMonotonic);
+    TestTrue(FString::Printf(TEXT("Drift %.1f samples is under one block"), Result.DriftSamples), FMath::Abs(Result.DriftSamples) < Result.BlockFrames);
+    // While a callback is missing, the clock holds after one block of extrapolation.
+    TestTrue(FString::Printf(TEXT("Max error %.1f samples is under two blocks"), Result.MaxErrorSamples), Result.MaxErrorSamples < 2 * Result.BlockFrames);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPanoClockDeviceJumpTest, "PanoramaCapture.Clock.DeviceClockJump",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FPanoClockDeviceJumpTest::RunTest(const FString& Parameters)
+{
+    // A device reset can move AudioClock by minutes; writing that lead as silence would push the rest of the WAV off
+    // the video. The clock re-anchors instead and keeps detecting ordinary missed blocks afterwards.
+    constexpr int32 SampleRate = 48000;
+    constexpr int32 BlockFrames = 1024;
+    const double BlockSeconds = static_cast<double>(BlockFrames) / SampleRate;
+
+    FPanoCaptureClock Clock(SampleRate);
+    Clock.Start(0.0);
+    double AudioClock = 100.0;
+    double Wall = 0.0;
+    for (int32 Block = 0; Block < 8; ++Block, AudioClock += BlockSeconds, Wall += BlockSeconds)
+    {
+        TestEqual(TEXT("Steady blocks miss nothing"), Clock.OnAudioCallback(AudioClock, BlockFrames, Wall), 0ll);
+    }
+
+    AudioClock += 600.0;
+    TestEqual(TEXT("A forward jump is not written as silence"), Clock.OnAudioCallback(AudioClock, BlockFrames, Wall), 0ll);
+    AudioClock += 2 * BlockSeconds;
+    Wall += 2 * BlockSeconds;
+    TestEqual(TEXT("A missed block after the jump is still detected"), Clock.OnAudioCallback(AudioClock, BlockFrames, Wall), static_cast<int64>(BlockFrames));
+
+    AudioClock -= 600.0;
+    Wall += BlockSeconds;
+    TestEqual(TEXT("A backward jump is not written as silence"), Clock.OnAudioCallback(AudioClock, BlockFrames, Wall), 0ll);
+    AudioClock += 2 * BlockSeconds;
+    Wall += 2 * BlockSeconds;
+    TestEqual(TEXT("A missed block after the backward jump is still detected"), Clock.OnAudioCallback(AudioClock, BlockFrames, Wall), static_cast<int64>(BlockFrames));
+
+    TestEqual(TEXT("Both jumps are counted"), Clock.GetAudioClockDiscontinuities(), 2);
+    return true;
+}
+
+#endif
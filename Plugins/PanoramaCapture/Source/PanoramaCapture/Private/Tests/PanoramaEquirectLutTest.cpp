@@ -0,0 +1,69 @@
+#include "Misc/AutomationTest.h"
+#include "PanoramaEquirectLut.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    /** An even size and an odd one, so the pixel centres land on and off the axes. */
+    const FIntPoint kLutTestResolutions[] = { FIntPoint(2048, 1024), FIntPoint(1021, 509) };
+    /** Half a 1/65535-of-range step on each of the three axes, plus single-precision slack. */
+    const double kLutMaxDecodeError = FMath::Sqrt(3.0) / 65535.0 + 1.0e-6;
+    /** Float trig in GetPixelDirection against the double-precision definition. */
+    constexpr double kLutMaxDirectionError = 1.0e-6;
+    /** The default 8K capture's face size; the table must stay well under one of its texels. */
+    constexpr int32 kLutReferenceFaceSize = 4096;
+
+    /** Straight from the equirect definition: longitude 0 at the image centre increasing to the right, latitude up. */
+    FVector3d GetDefinitionDirection(FIntPoint Pixel, FIntPoint Resolution)
+    {
+        const double Longitude = ((Pixel.X + 0.5) / Resolution.X - 0.5) * 2.0 * UE_DOUBLE_PI;
+        const double Latitude = (0.5 - (Pixel.Y + 0.5) / Resolution.Y) * UE_DOUBLE_PI;
+        return FVector3d(FMath::Cos(Latitude) * FMath::Cos(Longitude), FMath::Cos(Latitude) * FMath::Sin(Longitude), FMath::Sin(Latitude));
+    }
+
+    double GetAngle(const FVector3d& A, const FVector3d& B)
+    {
+        return FMath::Atan2(FVector3d::CrossProduct(A, B).Size(), FVector3d::DotProduct(A, B));
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPanoEquirectLutTest, "PanoramaCapture.EquirectLut.DecodeWithinQuantization",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FPanoEquirectLutTest::RunTest(const FString& Parameters)
+{
+    // The axis conventions the header documents: +X at the image centre, +Y a quarter turn right, +Z at the top.
+    const FIntPoint AxisResolution(2048, 1024);
+    TestTrue(TEXT("Image centre looks along +X"), GetAngle(FVector3d(PanoramaEquirectLut::GetPixelDirection(FIntPoint(1024, 512), AxisResolution)), FVector3d(1, 0, 0)) < 0.01);
+    TestTrue(TEXT("Three quarters across looks along +Y"), GetAngle(FVector3d(PanoramaEquirectLut::GetPixelDirection(FIntPoint(1536, 512), AxisResolution)), FVector3d(0, 1, 0)) < 0.01);
+    TestTrue(TEXT("Top row looks along +Z"), GetAngle(FVector3d(PanoramaEquirectLut::GetPixelDirection(FIntPoint(0, 0), AxisResolution)), FVector3d(0, 0, 1)) < 0.01);
+
+    TArray64<uint16> Texels;
+    for (const FIntPoint& Resolution : kLutTestResolutions)
+    {
+        const FString SizeName = FString::Printf(TEXT("%dx%d"), Resolution.X, Resolution.Y);
+
+        double MaxDirectionError = 0.0;
+        for (int32 Y = 0; Y < Resolution.Y; Y += 7)
+        {
+            for (int32 X = 0; X < Resolution.X; ++X)
+            {
+                const FIntPoint Pixel(X, Y);
+                MaxDirectionError = FMath::Max(MaxDirectionError,
+                    GetAngle(FVector3d(PanoramaEquirectLut::GetPixelDirection(Pixel, Resolution)), GetDefinitionDirection(Pixel, Resolution)));
+            }
+        }
+        TestTrue(FString::Printf(TEXT("Pixel directions follow the equirect definition, %s"), *SizeName), MaxDirectionError < kLutMaxDirectionError);
+
+        Texels.SetNumUninitialized(static_cast<int64>(Resolution.X) * Resolution.Y * PanoramaEquirectLut::kTexelChannels);
+        PanoramaEquirectLut::BuildReference(Resolution, Texels.GetData());
+        const double MaxDecodeError = PanoramaEquirectLut::GetMaxDecodeError(Resolution, Texels.GetData());
+        AddInfo(FString::Printf(TEXT("%s: max decode error %.3g rad, %.3f texels of a %d px face"), *SizeName, MaxDecodeError,
+            MaxDecodeError * kLutReferenceFaceSize / (0.5 * UE_DOUBLE_PI), kLutReferenceFaceSize));
+        TestTrue(FString::Printf(TEXT("Decoded directions are within the table's quantization, %s"), *SizeName), MaxDecodeError <= kLutMaxDecodeError);
+    }
+    return true;
+}
+
+#endif
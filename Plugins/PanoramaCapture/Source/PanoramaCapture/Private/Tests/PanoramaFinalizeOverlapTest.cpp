@@ -0,0 +1,95 @@
+#include "Misc/AutomationTest.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "HAL/Event.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/Paths.h"
+#include "PanoramaCaptureComponent.h"
+#include "RenderingThread.h"
+
+#include <atomic>
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    /** Small enough that both takes allocate their targets and encode their frames quickly. */
+    const FPanoCaptureResolution kOverlapTestResolution(512, 256);
+    /** A render-thread flush on the game thread would wait this long for the hold before the test reports it. */
+    constexpr uint32 kOverlapHoldTimeoutMs = 30000;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPanoFinalizeOverlapTest, "PanoramaCapture.Finalize.SecondTakeStartsWhileFirstFinalizes",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FPanoFinalizeOverlapTest::RunTest(const FString& Parameters)
+{
+    if (!TestNotNull(TEXT("Engine is running"), GEngine))
+    {
+        return false;
+    }
+
+    UWorld* World = UWorld::CreateWorld(EWorldType::Game, false);
+    FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+    WorldContext.SetCurrentWorld(World);
+
+    AActor* Rig = World->SpawnActor<AActor>();
+    UPanoramaCaptureComponent* Capture = NewObject<UPanoramaCaptureComponent>(Rig);
+    Capture->CaptureMode = EPanoramaCaptureMode::Mono;
+    Capture->OutputSettings.OutputMode = EPanoramaCaptureOutputMode::PNGSequence;
+    Capture->OutputSettings.Resolution = kOverlapTestResolution;
+    Capture->OutputSettings.bWritePreviewTexture = false;
+    Capture->OutputSettings.TargetDirectory.Path = FPaths::Combine(FPaths::AutomationTransientDir(), TEXT("PanoramaFinalizeOverlap"));
+    Capture->OutputSettings.PngEncoderThreads = 1;
+    Capture->OutputSettings.PngMaxInFlightMB = 64;
+    Rig->SetRootComponent(Capture);
+    Capture->RegisterComponent();
+
+    // The finalize job waits on a fence behind the render commands queued before the stop. Holding the render thread
+    // ahead of that fence keeps the first session finalizing, however fast its drain would otherwise be.
+    FEvent* ReleaseHold = FPlatformProcess::GetSynchEventFromPool(true);
+    std::atomic<bool> bHoldTimedOut(false);
+    if (GIsThreadedRendering)
+    {
+        ENQUEUE_RENDER_COMMAND(PanoramaCaptureTest_HoldFinalize)(
+            [ReleaseHold, &bHoldTimedOut](FRHICommandListImmediate& RHICmdList)
+            {
+                bHoldTimedOut = !ReleaseHold->Wait(kOverlapHoldTimeoutMs);
+            });
+    }
+    else
+    {
+        AddInfo(TEXT("Rendering is not threaded; the first session may finish before the second starts."));
+    }
+
+    Capture->RecordingLabel = TEXT("FirstTake");
+    Capture->StartRecording();
+    TestTrue(TEXT("First take is recording"), Capture->GetCaptureStatus() == EPanoramaCaptureStatus::Recording);
+    Capture->StopRecording();
+    TestTrue(TEXT("Stopping returns to Idle without waiting for finalize"), Capture->GetCaptureStatus() == EPanoramaCaptureStatus::Idle);
+    TestEqual(TEXT("First take is finalizing"), Capture->GetFinalizingSessionCount(), 1);
+
+    Capture->RecordingLabel = TEXT("SecondTake");
+    Capture->StartRecording();
+    TestTrue(TEXT("Second take records while the first finalizes"), Capture->GetCaptureStatus() == EPanoramaCaptureStatus::Recording);
+    TestEqual(TEXT("First take is still finalizing"), Capture->GetFinalizingSessionCount(), 1);
+
+    ReleaseHold->Trigger();
+    TestFalse(TEXT("Starting the second take did not wait on the render thread"), bHoldTimedOut.load());
+
+    Capture->StopRecording();
+    TestEqual(TEXT("Both takes are finalizing"), Capture->GetFinalizingSessionCount(), 2);
+    Capture->WaitForPendingFinalize();
+    TestEqual(TEXT("Both takes finish finalizing"), Capture->GetFinalizingSessionCount(), 0);
+
+    GEngine->DestroyWorldContext(World);
+    World->DestroyWorld(false);
+
+    // The hold command has run by now, but it must not outlive the event it waits on.
+    FlushRenderingCommands();
+    FPlatformProcess::ReturnSynchEventToPool(ReleaseHold);
+    return true;
+}
+
+#endif
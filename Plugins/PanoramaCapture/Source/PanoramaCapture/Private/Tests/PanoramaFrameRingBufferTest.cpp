@@ -0,0 +1,120 @@
+#include "Misc/AutomationTest.h"
+#include "Async/Async.h"
+#include "HAL/PlatformProcess.h"
+#include "PanoramaFrameRingBuffer.h"
+
+#include <atomic>
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    constexpr int64 kRingTestFrames = 200000;
+    constexpr int64 kRingTestSlabBytes = 4096;
+    /** Every Nth reservation is cancelled, as a failed readback would be. */
+    constexpr int64 kRingTestCancelEvery = 7;
+
+    uint8 RingTestPattern(uint64 FrameIndex, int64 Offset)
+    {
+        return static_cast<uint8>((FrameIndex * 131 + Offset) & 0xFF);
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPanoFrameRingBufferStressTest, "PanoramaCapture.FrameRingBuffer.ProducerConsumerStress",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FPanoFrameRingBufferStressTest::RunTest(const FString& Parameters)
+{
+    FPanoFrameRingBuffer Ring(4, kRingTestSlabBytes);
+
+    TArray<const uint8*> Slabs;
+    Slabs.Init(nullptr, Ring.GetCapacity());
+
+    std::atomic<bool> bProducerDone(false);
+    TFuture<void> Producer = Async(EAsyncExecution::Thread, [&Ring, &bProducerDone]()
+    {
+        for (uint64 FrameIndex = 0; FrameIndex < static_cast<uint64>(kRingTestFrames);)
+        {
+            FPanoCaptureFrame* Frame = Ring.AcquireWriteSlot();
+            if (!Frame)
+            {
+                FPlatformProcess::Yield();
+                continue;
+            }
+
+            if (FrameIndex % kRingTestCancelEvery == kRingTestCancelEvery - 1)
+            {
+                Ring.CancelWriteSlot(Frame);
+                ++FrameIndex;
+                continue;
+            }
+
+            Frame->FrameIndex = FrameIndex;
+            // Vary the payload length so a stale NumBytes would show up.
+            Frame->NumBytes = 1 + static_cast<int64>(FrameIndex % kRingTestSlabBytes);
+            for (int64 Offset = 0; Offset < Frame->NumBytes; ++Offset)
+            {
+                Frame->PixelData[Offset] = RingTestPattern(FrameIndex, Offset);
+            }
+            Ring.CommitWriteSlot(Frame);
+            ++FrameIndex;
+        }
+        bProducerDone = true;
+    });
+
+    int64 Received = 0;
+    int64 OutOfOrder = 0;
+    int64 Corrupted = 0;
+    int64 SlabsMoved = 0;
+    int64 ExpectedIndex = 0;
+    for (;;)
+    {
+        const bool bDone = bProducerDone;
+        FPanoCaptureFrame* Frame = Ring.AcquireReadSlot();
+        if (!Frame)
+        {
+            // Every commit happened before the producer flagged itself done.
+            if (bDone && Ring.Num() == 0)
+            {
+                break;
+            }
+            FPlatformProcess::Yield();
+            continue;
+        }
+
+        // Cancelled reservations are skipped; every other frame arrives, in order.
+        while (ExpectedIndex % kRingTestCancelEvery == kRingTestCancelEvery - 1)
+        {
+            ++ExpectedIndex;
+        }
+        OutOfOrder += Frame->FrameIndex != static_cast<uint64>(ExpectedIndex) ? 1 : 0;
+        ExpectedIndex = Frame->FrameIndex + 1;
+
+        const int64 ExpectedBytes = 1 + static_cast<int64>(Frame->FrameIndex % kRingTestSlabBytes);
+        bool bIntact = Frame->NumBytes == ExpectedBytes && Frame->PixelData.Num() == kRingTestSlabBytes;
+        for (int64 Offset = 0; bIntact && Offset < Frame->NumBytes; ++Offset)
+        {
+            bIntact = Frame->PixelData[Offset] == RingTestPattern(Frame->FrameIndex, Offset);
+        }
+        Corrupted += bIntact ? 0 : 1;
+
+        // Slabs are allocated once and recycled, never reallocated.
+        const uint8*& Slab = Slabs[Frame->SlotIndex];
+        SlabsMoved += Slab && Slab != Frame->PixelData.GetData() ? 1 : 0;
+        Slab = Frame->PixelData.GetData();
+
+        ++Received;
+        Ring.ReleaseSlot(Frame);
+    }
+    Producer.Wait();
+
+    const int64 Committed = kRingTestFrames - kRingTestFrames / kRingTestCancelEvery;
+    TestEqual(TEXT("Every committed frame is received"), Received, Committed);
+    TestEqual(TEXT("Frames arrive in commit order"), OutOfOrder, 0ll);
+    TestEqual(TEXT("Payloads arrive intact"), Corrupted, 0ll);
+    TestEqual(TEXT("Slabs are reused in place"), SlabsMoved, 0ll);
+    TestEqual(TEXT("Nothing is left queued"), Ring.Num(), 0);
+    return true;
+}
+
+#endif
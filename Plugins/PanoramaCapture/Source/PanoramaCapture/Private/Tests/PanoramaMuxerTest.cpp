@@ -0,0 +1,775 @@
+#include "Misc/AutomationTest.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "PanoramaAnnexB.h"
+#include "PanoramaMuxer.h"
+#include "PanoramaWavWriter.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    constexpr float kMuxTestFrameRate = 30.f;
+    /** I B B P B B P ... in display order; long enough that the 4-bit pic_order_cnt_lsb wraps inside a GOP. */
+    constexpr int32 kMuxTestGopLength = 13;
+    constexpr int32 kMuxTestGops = 5;
+    constexpr int32 kMuxTestFrames = kMuxTestGopLength * kMuxTestGops;
+    constexpr int32 kMuxTestSampleRate = 48000;
+    constexpr int32 kMuxTestChannels = 2;
+    const FIntPoint kMuxTestResolution(64, 32);
+
+    /** One coded picture of the canned stream, in decode order. */
+    struct FCannedFrame
+    {
+        int32 DisplayIndex = 0;
+        /** Length-prefixed size of the picture once parameter sets and delimiters are stripped. */
+        int32 SampleBytes = 0;
+        bool bKeyframe = false;
+    };
+
+    struct FTestBitWriter
+    {
+        void Bits(uint32 Value, int32 Count)
+        {
+            for (int32 Bit = Count - 1; Bit >= 0; --Bit)
+            {
+                if ((BitCount & 7) == 0)
+                {
+                    Bytes.Add(0);
+                }
+                if ((Value >> Bit) & 1)
+                {
+                    Bytes.Last() |= 0x80 >> (BitCount & 7);
+                }
+                ++BitCount;
+            }
+        }
+
+        void UE(uint32 Value)
+        {
+            const uint32 Code = Value + 1;
+            const int32 Length = FMath::FloorLog2(Code) + 1;
+            Bits(0, Length - 1);
+            Bits(Code, Length);
+        }
+
+        void Trailing()
+        {
+            Bits(1, 1);
+            while (BitCount & 7)
+            {
+                Bits(0, 1);
+            }
+        }
+
+        TArray<uint8> Bytes;
+        int32 BitCount = 0;
+    };
+
+    /** Appends a start code and the NAL with emulation prevention bytes; returns the escaped NAL size. */
+    int32 AppendNal(TArray<uint8>& Stream, const TArray<uint8>& Rbsp)
+    {
+        const int32 Start = Stream.Num();
+        Stream.Append({ 0, 0, 0, 1 });
+        int32 Zeros = 0;
+        for (uint8 Byte : Rbsp)
+        {
+            if (Zeros >= 2 && Byte <= 3)
+            {
+                Stream.Add(3);
+                Zeros = 0;
+            }
+            Stream.Add(Byte);
+            Zeros = Byte == 0 ? Zeros + 1 : 0;
+        }
+        return Stream.Num() - Start - 4;
+    }
+
+    /**
+     * Main-profile H.264 with two B-frames between references and an IDR per GOP. Slices carry a valid header up to
+     * pic_order_cnt_lsb followed by filler whose length encodes the display index, so every picture is identifiable
+     * in the containers by its size.
+     */
+    void BuildCannedH264(TArray<uint8>& OutStream, TArray<FCannedFrame>& OutFrames)
+    {
+        constexpr int32 Log2MaxPocLsb = 4;
+        constexpr int32 Log2MaxFrameNum = 4;
+
+        for (int32 Gop = 0; Gop < kMuxTestGops; ++Gop)
+        {
+            TArray<int32> DecodeOrder = { 0 };
+            for (int32 Anchor = 3; Anchor < kMuxTestGopLength; Anchor += 3)
+            {
+                DecodeOrder.Append({ Anchor, Anchor - 2, Anchor - 1 });
+            }
+
+            int32 FrameNum = 0;
+            for (int32 InGop : DecodeOrder)
+            {
+                const bool bIdr = InGop == 0;
+                const bool bReference = InGop % 3 == 0;
+                const int32 DisplayIndex = Gop * kMuxTestGopLength + InGop;
+
+                FTestBitWriter Aud;
+                Aud.Bits(0x09, 8);
+                Aud.Bits(7, 3);
+                Aud.Trailing();
+                AppendNal(OutStream, Aud.Bytes);
+
+                if (bIdr)
+                {
+                    FTestBitWriter Sps;
+                    Sps.Bits(0x67, 8);
+                    Sps.Bits(77, 8);
+                    Sps.Bits(0, 8);
+                    Sps.Bits(40, 8);
+                    Sps.UE(0);
+                    Sps.UE(Log2MaxFrameNum - 4);
+                    Sps.UE(0);
+                    Sps.UE(Log2MaxPocLsb - 4);
+                    Sps.UE(2);
+                    Sps.Bits(0, 1);
+                    Sps.UE(kMuxTestResolution.X / 16 - 1);
+                    Sps.UE(kMuxTestResolution.Y / 16 - 1);
+                    Sps.Bits(1, 1);
+                    Sps.Bits(1, 1);
+                    Sps.Bits(0, 1);
+                    Sps.Bits(0, 1);
+                    Sps.Trailing();
+                    AppendNal(OutStream, Sps.Bytes);
+
+                    FTestBitWriter Pps;
+                    Pps.Bits(0x68, 8);
+                    Pps.UE(0);
+                    Pps.UE(0);
+                    Pps.Bits(0, 1);
+                    Pps.Bits(0, 1);
+                    Pps.UE(0);
+                    Pps.Trailing();
+                    AppendNal(OutStream, Pps.Bytes);
+                }
+
+                FTestBitWriter Slice;
+                Slice.Bits(bIdr ? 0x65 : bReference ? 0x61 : 0x01, 8);
+                Slice.UE(0);
+                Slice.UE(bIdr ? 7 : bReference ? 5 : 6);
+                Slice.UE(0);
+                Slice.Bits(FrameNum % (1 << Log2MaxFrameNum), Log2MaxFrameNum);
+                if (bIdr)
+                {
+                    Slice.UE(0);
+                }
+                Slice.Bits((InGop * 2) % (1 << Log2MaxPocLsb), Log2MaxPocLsb);
+                for (int32 Filler = 0; Filler < 8 + DisplayIndex; ++Filler)
+                {
+                    Slice.Bits(0x55, 8);
+                }
+                Slice.Trailing();
+
+                FCannedFrame& Frame = OutFrames.AddDefaulted_GetRef();
+                Frame.DisplayIndex = DisplayIndex;
+                Frame.SampleBytes = 4 + AppendNal(OutStream, Slice.Bytes);
+                Frame.bKeyframe = bIdr;
+                FrameNum += bReference ? 1 : 0;
+            }
+        }
+    }
+
+    uint32 ReadBE32(const TArray<uint8>& Data, int64 Offset)
+    {
+        return (static_cast<uint32>(Data[Offset]) << 24) | (Data[Offset + 1] << 16) | (Data[Offset + 2] << 8) | Data[Offset + 3];
+    }
+
+    uint64 ReadBE64(const TArray<uint8>& Data, int64 Offset)
+    {
+        return (static_cast<uint64>(ReadBE32(Data, Offset)) << 32) | ReadBE32(Data, Offset + 4);
+    }
+
+    struct FMp4Box
+    {
+        FString Type;
+        int64 Offset = 0;
+        int64 HeaderBytes = 8;
+        int64 Size = 0;
+
+        int64 PayloadOffset() const { return Offset + HeaderBytes; }
+        int64 End() const { return Offset + Size; }
+    };
+
+    /** Reads the complete boxes in [Begin, End). Returns false if a box header is malformed or a box runs past End. */
+    bool ReadBoxes(const TArray<uint8>& File, int64 Begin, int64 End, TArray<FMp4Box>& OutBoxes)
+    {
+        OutBoxes.Reset();
+        int64 Offset = Begin;
+        while (Offset < End)
+        {
+            if (Offset + 8 > End)
+            {
+                return false;
+            }
+            FMp4Box Box;
+            Box.Offset = Offset;
+            for (int32 Index = 0; Index < 4; ++Index)
+            {
+                Box.Type.AppendChar(static_cast<TCHAR>(File[Offset + 4 + Index]));
+            }
+            Box.Size = ReadBE32(File, Offset);
+            if (Box.Size == 1)
+            {
+                if (Offset + 16 > End)
+                {
+                    return false;
+                }
+                Box.HeaderBytes = 16;
+                Box.Size = static_cast<int64>(ReadBE64(File, Offset + 8));
+            }
+            if (Box.Size < Box.HeaderBytes || Box.End() > End)
+            {
+                return false;
+            }
+            OutBoxes.Add(Box);
+            Offset = Box.End();
+        }
+        return true;
+    }
+
+    const FMp4Box* FindBox(const TArray<FMp4Box>& Boxes, const TCHAR* Type)
+    {
+        return Boxes.FindByPredicate([Type](const FMp4Box& Box) { return Box.Type == Type; });
+    }
+
+    /** Follows a path of nested boxes; Skips[i] is the number of payload bytes before the children of Path[i]. */
+    bool FindNestedBox(const TArray<uint8>& File, const FMp4Box& Root, TArrayView<const TCHAR* const> Path, TArrayView<const int32> Skips, FMp4Box& OutBox)
+    {
+        FMp4Box Parent = Root;
+        int32 Skip = 0;
+        for (int32 Index = 0; Index < Path.Num(); ++Index)
+        {
+            TArray<FMp4Box> Children;
+            if (!ReadBoxes(File, Parent.PayloadOffset() + Skip, Parent.End(), Children))
+            {
+                return false;
+            }
+            const FMp4Box* Child = FindBox(Children, Path[Index]);
+            if (!Child)
+            {
+                return false;
+            }
+            Parent = *Child;
+            Skip = Skips[Index];
+        }
+        OutBox = Parent;
+        return true;
+    }
+
+    /** What the MP4 check found, for comparison with the stream that went in. */
+    struct FMp4Summary
+    {
+        int32 CompleteFragments = 0;
+        /** False when the file ends inside a fragment. */
+        bool bEndsOnBoxBoundary = true;
+        TArray<int32> VideoSampleBytes;
+        TArray<int32> PresentationIndices;
+        TArray<bool> Keyframes;
+        int64 AudioFrames = 0;
+        int32 Errors = 0;
+    };
+
+    /**
+     * Walks ftyp, moov and every complete moof + mdat pair, checking sample entries, sequence numbers, decode times
+     * and that every trun's data lies inside the mdat that follows its moof.
+     */
+    FMp4Summary InspectMp4(FAutomationTestBase& Test, const TArray<uint8>& File, bool bExpectAudio)
+    {
+        FMp4Summary Summary;
+        TArray<FMp4Box> TopLevel;
+        Summary.bEndsOnBoxBoundary = ReadBoxes(File, 0, File.Num(), TopLevel);
+
+        if (!Test.TestTrue(TEXT("MP4 starts with ftyp and moov"), TopLevel.Num() >= 2 && TopLevel[0].Type == TEXT("ftyp") && TopLevel[1].Type == TEXT("moov")))
+        {
+            ++Summary.Errors;
+            return Summary;
+        }
+
+        const FMp4Box& Moov = TopLevel[1];
+        const TCHAR* const VideoEntryPath[] = { TEXT("trak"), TEXT("mdia"), TEXT("minf"), TEXT("stbl"), TEXT("stsd"), TEXT("avc1") };
+        const int32 VideoEntrySkips[] = { 0, 0, 0, 0, 8, 78 };
+        FMp4Box VideoEntry;
+        const bool bHasEntry = FindNestedBox(File, Moov, VideoEntryPath, VideoEntrySkips, VideoEntry);
+        TArray<FMp4Box> EntryChildren;
+        if (bHasEntry)
+        {
+            ReadBoxes(File, VideoEntry.PayloadOffset() + 78, VideoEntry.End(), EntryChildren);
+        }
+        Summary.Errors += Test.TestTrue(TEXT("avc1 entry carries avcC, st3d and sv3d"),
+            bHasEntry && FindBox(EntryChildren, TEXT("avcC")) && FindBox(EntryChildren, TEXT("st3d")) && FindBox(EntryChildren, TEXT("sv3d"))) ? 0 : 1;
+
+        TArray<FMp4Box> MoovChildren;
+        ReadBoxes(File, Moov.PayloadOffset(), Moov.End(), MoovChildren);
+        Summary.Errors += Test.TestTrue(TEXT("moov has mvex for fragments"), FindBox(MoovChildren, TEXT("mvex")) != nullptr) ? 0 : 1;
+        const int32 NumTraks = MoovChildren.FilterByPredicate([](const FMp4Box& Box) { return Box.Type == TEXT("trak"); }).Num();
+        Summary.Errors += Test.TestEqual(TEXT("MP4 track count"), NumTraks, bExpectAudio ? 2 : 1) ? 0 : 1;
+
+        uint64 ExpectedDecodeTime = 0;
+        for (int32 Index = 2; Index + 1 < TopLevel.Num(); Index += 2)
+        {
+            const FMp4Box& Moof = TopLevel[Index];
+            const FMp4Box& Mdat = TopLevel[Index + 1];
+            if (Moof.Type != TEXT("moof") || Mdat.Type != TEXT("mdat"))
+            {
+                Test.AddError(FString::Printf(TEXT("Expected moof + mdat at offset %lld, found %s + %s"), Moof.Offset, *Moof.Type, *Mdat.Type));
+                ++Summary.Errors;
+                break;
+            }
+
+            TArray<FMp4Box> MoofChildren;
+            ReadBoxes(File, Moof.PayloadOffset(), Moof.End(), MoofChildren);
+            const FMp4Box* Mfhd = FindBox(MoofChildren, TEXT("mfhd"));
+            if (!Mfhd || ReadBE32(File, Mfhd->PayloadOffset() + 4) != static_cast<uint32>(Summary.CompleteFragments + 1))
+            {
+                Test.AddError(TEXT("mfhd sequence numbers must count up from 1"));
+                ++Summary.Errors;
+            }
+
+            for (const FMp4Box& Traf : MoofChildren)
+            {
+                if (Traf.Type != TEXT("traf"))
+                {
+                    continue;
+                }
+                TArray<FMp4Box> TrafChildren;
+                ReadBoxes(File, Traf.PayloadOffset(), Traf.End(), TrafChildren);
+                const FMp4Box* Tfhd = FindBox(TrafChildren, TEXT("tfhd"));
+                const FMp4Box* Tfdt = FindBox(TrafChildren, TEXT("tfdt"));
+                const FMp4Box* Trun = FindBox(TrafChildren, TEXT("trun"));
+                if (!Tfhd || !Tfdt || !Trun)
+                {
+                    Test.AddError(TEXT("traf needs tfhd, tfdt and trun"));
+                    ++Summary.Errors;
+                    continue;
+                }
+
+                const uint32 TrackId = ReadBE32(File, Tfhd->PayloadOffset() + 4);
+                const uint64 BaseDecodeTime = ReadBE64(File, Tfdt->PayloadOffset() + 4);
+                const uint8 TrunVersion = File[Trun->PayloadOffset()];
+                const uint32 TrunFlags = ReadBE32(File, Trun->PayloadOffset()) & 0xFFFFFF;
+                const uint32 SampleCount = ReadBE32(File, Trun->PayloadOffset() + 4);
+                const int64 DataStart = Moof.Offset + static_cast<int32>(ReadBE32(File, Trun->PayloadOffset() + 8));
+                int64 Cursor = Trun->PayloadOffset() + 12;
+
+                if (TrackId == 2)
+                {
+                    Summary.AudioFrames += SampleCount;
+                    continue;
+                }
+
+                if (BaseDecodeTime != ExpectedDecodeTime || TrunVersion != 1 || (TrunFlags & 0xF01) != 0xF01)
+                {
+                    Test.AddError(FString::Printf(TEXT("Video traf %d: decode time %llu (expected %llu), trun version %d, flags 0x%06x"),
+                        Summary.CompleteFragments, BaseDecodeTime, ExpectedDecodeTime, TrunVersion, TrunFlags));
+                    ++Summary.Errors;
+                }
+
+                int64 DataOffset = DataStart;
+                for (uint32 Sample = 0; Sample < SampleCount; ++Sample)
+                {
+                    const uint32 Duration = ReadBE32(File, Cursor);
+                    const uint32 Size = ReadBE32(File, Cursor + 4);
+                    const uint32 Flags = ReadBE32(File, Cursor + 8);
+                    const int32 CompositionOffset = static_cast<int32>(ReadBE32(File, Cursor + 12));
+                    Cursor += 16;
+
+                    const bool bInMdat = DataOffset >= Mdat.PayloadOffset() && DataOffset + Size <= Mdat.End();
+                    const bool bLengthPrefixed = bInMdat && Size >= 5 && ReadBE32(File, DataOffset) == Size - 4;
+                    if (!bLengthPrefixed || Duration == 0)
+                    {
+                        Test.AddError(FString::Printf(TEXT("Video sample %d is not a length-prefixed NAL inside its mdat"), Summary.VideoSampleBytes.Num()));
+                        ++Summary.Errors;
+                    }
+
+                    const int64 PresentationTime = static_cast<int64>(ExpectedDecodeTime) + CompositionOffset;
+                    Summary.VideoSampleBytes.Add(static_cast<int32>(Size));
+                    Summary.PresentationIndices.Add(static_cast<int32>(PresentationTime / FMath::Max<uint32>(1, Duration)));
+                    Summary.Keyframes.Add((Flags & 0x00010000) == 0);
+                    ExpectedDecodeTime += Duration;
+                    DataOffset += Size;
+                }
+            }
+            ++Summary.CompleteFragments;
+        }
+        return Summary;
+    }
+
+    struct FEbmlElement
+    {
+        uint32 Id = 0;
+        int64 Offset = 0;
+        int64 DataOffset = 0;
+        int64 Size = 0;
+        bool bUnknownSize = false;
+
+        int64 End() const { return DataOffset + Size; }
+    };
+
+    bool ReadVint(const TArray<uint8>& File, int64& Offset, int64 End, bool bKeepMarker, uint64& OutValue, bool& bOutAllOnes)
+    {
+        if (Offset >= End || File[Offset] == 0)
+        {
+            return false;
+        }
+        const int32 Length = 8 - FMath::FloorLog2(File[Offset]);
+        if (Offset + Length > End)
+        {
+            return false;
+        }
+        uint64 Value = bKeepMarker ? File[Offset] : File[Offset] & (0xFF >> Length);
+        for (int32 Index = 1; Index < Length; ++Index)
+        {
+            Value = (Value << 8) | File[Offset + Index];
+        }
+        bOutAllOnes = !bKeepMarker && Value == (1ull << (7 * Length)) - 1;
+        OutValue = Value;
+        Offset += Length;
+        return true;
+    }
+
+    /**
+     * Reads the complete elements in [Begin, End). An unknown-size element (a Segment that was never closed) runs to
+     * End. Returns false if the last element is cut off.
+     */
+    bool ReadElements(const TArray<uint8>& File, int64 Begin, int64 End, TArray<FEbmlElement>& OutElements)
+    {
+        OutElements.Reset();
+        int64 Offset = Begin;
+        while (Offset < End)
+        {
+            FEbmlElement Element;
+            Element.Offset = Offset;
+            uint64 Id = 0;
+            uint64 Size = 0;
+            bool bIgnored = false;
+            if (!ReadVint(File, Offset, End, true, Id, bIgnored) || !ReadVint(File, Offset, End, false, Size, Element.bUnknownSize))
+            {
+                return false;
+            }
+            Element.Id = static_cast<uint32>(Id);
+            Element.DataOffset = Offset;
+            Element.Size = Element.bUnknownSize ? End - Offset : static_cast<int64>(Size);
+            if (Element.End() > End)
+            {
+                return false;
+            }
+            OutElements.Add(Element);
+            Offset = Element.End();
+        }
+        return true;
+    }
+
+    struct FMkvSummary
+    {
+        int32 CompleteClusters = 0;
+        bool bEndsOnElementBoundary = true;
+        bool bHasCues = false;
+        TArray<int32> VideoSampleBytes;
+        TArray<int64> VideoTimestampsMs;
+        TArray<bool> Keyframes;
+        int64 AudioBytes = 0;
+        int32 Errors = 0;
+    };
+
+    /** Walks the EBML header, the Segment's top-level elements and every complete Cluster's SimpleBlocks. */
+    FMkvSummary InspectMkv(FAutomationTestBase& Test, const TArray<uint8>& File)
+    {
+        FMkvSummary Summary;
+        TArray<FEbmlElement> TopLevel;
+        ReadElements(File, 0, File.Num(), TopLevel);
+        if (!Test.TestTrue(TEXT("MKV has an EBML header and a Segment"), TopLevel.Num() >= 2 && TopLevel[0].Id == 0x1A45DFA3 && TopLevel[1].Id == 0x18538067))
+        {
+            ++Summary.Errors;
+            return Summary;
+        }
+
+        // A Segment whose declared size runs past the file was cut short; read what is there.
+        const FEbmlElement& Segment = TopLevel[1];
+        TArray<FEbmlElement> Children;
+        Summary.bEndsOnElementBoundary = ReadElements(File, Segment.DataOffset, FMath::Min<int64>(Segment.End(), File.Num()), Children);
+
+        const bool bHasTracks = Children.ContainsByPredicate([](const FEbmlElement& Element) { return Element.Id == 0x1654AE6B; });
+        const bool bHasInfo = Children.ContainsByPredicate([](const FEbmlElement& Element) { return Element.Id == 0x1549A966; });
+        Summary.Errors += Test.TestTrue(TEXT("Segment has Info and Tracks"), bHasInfo && bHasTracks) ? 0 : 1;
+        Summary.bHasCues = Children.ContainsByPredicate([](const FEbmlElement& Element) { return Element.Id == 0x1C53BB6B; });
+
+        for (const FEbmlElement& Cluster : Children)
+        {
+            if (Cluster.Id != 0x1F43B675)
+            {
+                continue;
+            }
+
+            TArray<FEbmlElement> Blocks;
+            if (!ReadElements(File, Cluster.DataOffset, Cluster.End(), Blocks) || Blocks.Num() == 0 || Blocks[0].Id != 0xE7)
+            {
+                Test.AddError(TEXT("Cluster must start with its Timestamp and contain only complete elements"));
+                ++Summary.Errors;
+                continue;
+            }
+
+            int64 ClusterTimestamp = 0;
+            for (int64 Index = 0; Index < Blocks[0].Size; ++Index)
+            {
+                ClusterTimestamp = (ClusterTimestamp << 8) | File[Blocks[0].DataOffset + Index];
+            }
+
+            for (int32 Index = 1; Index < Blocks.Num(); ++Index)
+            {
+                const FEbmlElement& Block = Blocks[Index];
+                if (Block.Id != 0xA3 || Block.Size < 4)
+                {
+                    Test.AddError(TEXT("Cluster children after the Timestamp must be SimpleBlocks"));
+                    ++Summary.Errors;
+                    continue;
+                }
+                const uint8 Track = File[Block.DataOffset] & 0x7F;
+                const int16 Relative = static_cast<int16>((File[Block.DataOffset + 1] << 8) | File[Block.DataOffset + 2]);
+                const bool bKeyframe = (File[Block.DataOffset + 3] & 0x80) != 0;
+                const int64 PayloadBytes = Block.Size - 4;
+                if (Track == 1)
+                {
+                    Summary.VideoSampleBytes.Add(static_cast<int32>(PayloadBytes));
+                    Summary.VideoTimestampsMs.Add(ClusterTimestamp + Relative);
+                    Summary.Keyframes.Add(bKeyframe);
+                }
+                else
+                {
+                    Summary.AudioBytes += PayloadBytes;
+                }
+            }
+            ++Summary.CompleteClusters;
+        }
+        return Summary;
+    }
+
+    int64 GetFrameTimestampMs(int32 DisplayIndex)
+    {
+        return FMath::RoundToInt64(DisplayIndex * 1000.0 / kMuxTestFrameRate);
+    }
+
+    /** Compares the video the containers hold, in stored (decode) order, against the canned stream. */
+    void CheckVideoAgainstStream(FAutomationTestBase& Test, const TCHAR* Container, TArrayView<const FCannedFrame> Frames,
+        const TArray<int32>& SampleBytes, const TArray<bool>& Keyframes, TFunctionRef<bool(int32 Index, int32 DisplayIndex)> IsPresentedAt)
+    {
+        Test.TestEqual(FString::Printf(TEXT("%s video sample count"), Container), SampleBytes.Num(), Frames.Num());
+        int32 Mismatches = 0;
+        for (int32 Index = 0; Index < FMath::Min(SampleBytes.Num(), Frames.Num()); ++Index)
+        {
+            const FCannedFrame& Frame = Frames[Index];
+            Mismatches += SampleBytes[Index] != Frame.SampleBytes || Keyframes[Index] != Frame.bKeyframe || !IsPresentedAt(Index, Frame.DisplayIndex) ? 1 : 0;
+        }
+        Test.TestEqual(FString::Printf(TEXT("%s samples are stored in decode order and presented in display order"), Container), Mismatches, 0);
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPanoAnnexBPicOrderTest, "PanoramaCapture.Muxer.AnnexBPictureOrder",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FPanoAnnexBPicOrderTest::RunTest(const FString& Parameters)
+{
+    TArray<uint8> Stream;
+    TArray<FCannedFrame> Frames;
+    BuildCannedH264(Stream, Frames);
+
+    // Odd chunk sizes split start codes and NALs across pushes.
+    FPanoAnnexBParser Parser(EPanoramaCaptureCodec::H264);
+    for (int32 Offset = 0; Offset < Stream.Num(); Offset += 7)
+    {
+        Parser.Push(Stream.GetData() + Offset, FMath::Min(7, Stream.Num() - Offset));
+    }
+    Parser.Finish();
+
+    TArray<FPanoVideoSample> Samples;
+    FPanoVideoSample Sample;
+    while (Parser.Pop(Sample))
+    {
+        Samples.Add(MoveTemp(Sample));
+    }
+    TestTrue(TEXT("SPS and PPS make a codec config"), Parser.HasCodecConfig());
+    if (!TestEqual(TEXT("One sample per coded picture"), Samples.Num(), Frames.Num()))
+    {
+        return false;
+    }
+
+    int32 PocMismatches = 0;
+    int32 SizeMismatches = 0;
+    for (int32 Index = 0; Index < Samples.Num(); ++Index)
+    {
+        // The canned stream codes POC as twice the display index within the GOP; the 4-bit LSB wraps past 16.
+        PocMismatches += Samples[Index].PicOrderCnt != (Frames[Index].DisplayIndex % kMuxTestGopLength) * 2 ? 1 : 0;
+        SizeMismatches += Samples[Index].Data.Num() != Frames[Index].SampleBytes || Samples[Index].bKeyframe != Frames[Index].bKeyframe ? 1 : 0;
+    }
+    TestEqual(TEXT("Picture order counts survive the LSB wrap"), PocMismatches, 0);
+    TestEqual(TEXT("Samples hold exactly the slice NAL, length-prefixed"), SizeMismatches, 0);
+
+    int32 OrderMismatches = 0;
+    for (int32 Gop = 0; Gop < kMuxTestGops; ++Gop)
+    {
+        const int32 First = Gop * kMuxTestGopLength;
+        FPanoAnnexBParser::ResolvePresentationOrder(MakeArrayView(Samples).Slice(First, kMuxTestGopLength));
+        for (int32 Index = First; Index < First + kMuxTestGopLength; ++Index)
+        {
+            OrderMismatches += Index + Samples[Index].CompositionOffset != Frames[Index].DisplayIndex ? 1 : 0;
+        }
+    }
+    TestEqual(TEXT("Composition offsets put every picture at its display index"), OrderMismatches, 0);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPanoMuxerStructureTest, "PanoramaCapture.Muxer.CannedStreamStructure",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FPanoMuxerStructureTest::RunTest(const FString& Parameters)
+{
+    TArray<uint8> Stream;
+    TArray<FCannedFrame> Frames;
+    BuildCannedH264(Stream, Frames);
+
+    const FString Directory = FPaths::Combine(FPaths::AutomationTransientDir(), TEXT("PanoramaMuxer"));
+    IFileManager::Get().MakeDirectory(*Directory, true);
+
+    FPanoMuxJob Job;
+    Job.BitstreamPath = FPaths::Combine(Directory, TEXT("Canned.h264"));
+    Job.AudioWavPath = FPaths::Combine(Directory, TEXT("Canned.wav"));
+    Job.Codec = EPanoramaCaptureCodec::H264;
+    Job.Resolution = kMuxTestResolution;
+    Job.FrameRate = kMuxTestFrameRate;
+    Job.Mp4Path = FPaths::Combine(Directory, TEXT("Canned.mp4"));
+    Job.MkvPath = FPaths::Combine(Directory, TEXT("Canned.mkv"));
+
+    TestTrue(TEXT("Bitstream written"), FFileHelper::SaveArrayToFile(Stream, *Job.BitstreamPath));
+
+    // Exactly as long as the video, so every audio frame lands in a fragment.
+    const int64 AudioFrames = static_cast<int64>(kMuxTestFrames) * kMuxTestSampleRate / static_cast<int64>(kMuxTestFrameRate);
+    {
+        TArray<float> Silence;
+        Silence.SetNumZeroed(static_cast<int32>(AudioFrames * kMuxTestChannels));
+        FPanoWavWriter Wav;
+        TestTrue(TEXT("WAV written"), Wav.Open(Job.AudioWavPath, kMuxTestSampleRate, kMuxTestChannels) && Wav.WriteSamples(Silence.GetData(), Silence.Num()) && Wav.Close());
+    }
+
+    if (!TestTrue(TEXT("Mux succeeds"), PanoramaMuxer::Run(Job)))
+    {
+        return false;
+    }
+
+    TArray<uint8> Mp4;
+    TArray<uint8> Mkv;
+    TestTrue(TEXT("MP4 readable"), FFileHelper::LoadFileToArray(Mp4, *Job.Mp4Path));
+    TestTrue(TEXT("MKV readable"), FFileHelper::LoadFileToArray(Mkv, *Job.MkvPath));
+
+    const FMp4Summary Mp4Summary = InspectMp4(*this, Mp4, true);
+    TestTrue(TEXT("MP4 boxes exactly cover the file"), Mp4Summary.bEndsOnBoxBoundary);
+    TestEqual(TEXT("One MP4 fragment per GOP"), Mp4Summary.CompleteFragments, kMuxTestGops);
+    TestEqual(TEXT("MP4 audio sample frames"), Mp4Summary.AudioFrames, AudioFrames);
+    CheckVideoAgainstStream(*this, TEXT("MP4"), Frames, Mp4Summary.VideoSampleBytes, Mp4Summary.Keyframes,
+        [&Mp4Summary](int32 Index, int32 DisplayIndex) { return Mp4Summary.PresentationIndices[Index] == DisplayIndex; });
+
+    const FMkvSummary MkvSummary = InspectMkv(*this, Mkv);
+    TestTrue(TEXT("MKV elements exactly cover the segment"), MkvSummary.bEndsOnElementBoundary);
+    TestTrue(TEXT("Closed MKV has Cues"), MkvSummary.bHasCues);
+    TestEqual(TEXT("MKV audio bytes"), MkvSummary.AudioBytes, AudioFrames * kMuxTestChannels * static_cast<int64>(sizeof(int16)));
+    CheckVideoAgainstStream(*this, TEXT("MKV"), Frames, MkvSummary.VideoSampleBytes, MkvSummary.Keyframes,
+        [&MkvSummary](int32 Index, int32 DisplayIndex) { return MkvSummary.VideoTimestampsMs[Index] == GetFrameTimestampMs(DisplayIndex); });
+
+    IFileManager::Get().DeleteDirectory(*Directory, false, true);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPanoLiveMuxerCrashRecoveryTest, "PanoramaCapture.Muxer.LiveCrashRecovery",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FPanoLiveMuxerCrashRecoveryTest::RunTest(const FString& Parameters)
+{
+    TArray<uint8> Stream;
+    TArray<FCannedFrame> Frames;
+    BuildCannedH264(Stream, Frames);
+
+    const FString Directory = FPaths::Combine(FPaths::AutomationTransientDir(), TEXT("PanoramaLiveMuxer"));
+    IFileManager::Get().MakeDirectory(*Directory, true);
+
+    FPanoLiveMuxParams Params;
+    Params.Codec = EPanoramaCaptureCodec::H264;
+    Params.Resolution = kMuxTestResolution;
+    Params.FrameRate = kMuxTestFrameRate;
+    Params.Mp4Path = FPaths::Combine(Directory, TEXT("Live.mp4"));
+    Params.MkvPath = FPaths::Combine(Directory, TEXT("Live.mkv"));
+    {
+        // Encoder output arrives in arbitrary pieces.
+        FPanoLiveMuxer Muxer(Params);
+        Muxer.SetVideoStartSeconds(0.0);
+        for (int32 Offset = 0; Offset < Stream.Num(); Offset += 1000)
+        {
+            Muxer.AppendVideo(Stream.GetData() + Offset, FMath::Min(1000, Stream.Num() - Offset));
+        }
+        TestTrue(TEXT("Live mux finishes"), Muxer.Finish());
+        TestEqual(TEXT("One fragment per GOP"), Muxer.GetFragmentsWritten(), kMuxTestGops);
+    }
+
+    TArray<uint8> Mp4;
+    TArray<uint8> Mkv;
+    TestTrue(TEXT("MP4 readable"), FFileHelper::LoadFileToArray(Mp4, *Params.Mp4Path));
+    TestTrue(TEXT("MKV readable"), FFileHelper::LoadFileToArray(Mkv, *Params.MkvPath));
+    IFileManager::Get().DeleteDirectory(*Directory, false, true);
+
+    // Everything before the last GOP must survive a cut inside it.
+    const int32 SurvivingFrames = (kMuxTestGops - 1) * kMuxTestGopLength;
+    const TArrayView<const FCannedFrame> SurvivingStream = MakeArrayView(Frames).Left(SurvivingFrames);
+
+    TArray<FMp4Box> TopLevel;
+    ReadBoxes(Mp4, 0, Mp4.Num(), TopLevel);
+    if (!TestTrue(TEXT("Finished MP4 ends with a moof + mdat"), TopLevel.Num() >= 4 && TopLevel.Last(1).Type == TEXT("moof") && TopLevel.Last().Type == TEXT("mdat")))
+    {
+        return false;
+    }
+    const FMp4Box& LastMoof = TopLevel.Last(1);
+    Mp4.SetNum(static_cast<int32>(LastMoof.Offset + (LastMoof.Size + TopLevel.Last().Size) / 2));
+
+    const FMp4Summary Mp4Summary = InspectMp4(*this, Mp4, false);
+    TestFalse(TEXT("Truncated MP4 ends inside a fragment"), Mp4Summary.bEndsOnBoxBoundary);
+    TestEqual(TEXT("Truncated MP4 keeps every complete fragment"), Mp4Summary.CompleteFragments, kMuxTestGops - 1);
+    CheckVideoAgainstStream(*this, TEXT("Truncated MP4"), SurvivingStream, Mp4Summary.VideoSampleBytes, Mp4Summary.Keyframes,
+        [&Mp4Summary](int32 Index, int32 DisplayIndex) { return Mp4Summary.PresentationIndices[Index] == DisplayIndex; });
+
+    // Close only patches the segment size, SeekHead and duration; an unknown segment size is what a crashed session
+    // leaves on disk.
+    TArray<FEbmlElement> MkvTopLevel;
+    ReadElements(Mkv, 0, Mkv.Num(), MkvTopLevel);
+    if (!TestTrue(TEXT("Finished MKV has a Segment"), MkvTopLevel.Num() == 2 && MkvTopLevel[1].Id == 0x18538067))
+    {
+        return false;
+    }
+    const FEbmlElement Segment = MkvTopLevel[1];
+    Mkv[Segment.DataOffset - 8] = 0x01;
+    FMemory::Memset(Mkv.GetData() + Segment.DataOffset - 7, 0xFF, 7);
+
+    TArray<FEbmlElement> SegmentChildren;
+    ReadElements(Mkv, Segment.DataOffset, Segment.End(), SegmentChildren);
+    const FEbmlElement* LastCluster = nullptr;
+    for (const FEbmlElement& Element : SegmentChildren)
+    {
+        LastCluster = Element.Id == 0x1F43B675 ? &Element : LastCluster;
+    }
+    if (!TestNotNull(TEXT("Finished MKV has clusters"), LastCluster))
+    {
+        return false;
+    }
+    Mkv.SetNum(static_cast<int32>(LastCluster->DataOffset + LastCluster->Size / 2));
+
+    const FMkvSummary MkvSummary = InspectMkv(*this, Mkv);
+    TestFalse(TEXT("Truncated MKV ends inside a cluster"), MkvSummary.bEndsOnElementBoundary);
+    TestEqual(TEXT("Truncated MKV keeps every complete cluster"), MkvSummary.CompleteClusters, kMuxTestGops - 1);
+    CheckVideoAgainstStream(*this, TEXT("Truncated MKV"), SurvivingStream, MkvSummary.VideoSampleBytes, MkvSummary.Keyframes,
+        [&MkvSummary](int32 Index, int32 DisplayIndex) { return MkvSummary.VideoTimestampsMs[Index] == GetFrameTimestampMs(DisplayIndex); });
+    return true;
+}
+
+#endif
@@ -0,0 +1,54 @@
+#include "Misc/AutomationTest.h"
+#include "PanoramaOdsBenchmark.h"
+#include "PanoramaOdsProjection.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    constexpr int32 kOdsTestWidth = 2048;
+    /** Half the default 6.4 cm interpupillary distance. */
+    constexpr float kOdsTestEyeRadius = 3.2f;
+    constexpr double kOdsMaxRoundTripDegrees = 0.01;
+    /** Single-precision slack on distances, relative to the eye radius. */
+    constexpr double kOdsDistanceTolerance = 1.0e-4;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPanoOdsStitchGeometryTest, "PanoramaCapture.Ods.StitchGeometry",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FPanoOdsStitchGeometryTest::RunTest(const FString& Parameters)
+{
+    const FIntPoint Resolution(kOdsTestWidth, kOdsTestWidth / 2);
+    for (const int32 SliceCount : { 8, 72 })
+    {
+        for (const bool bPoleMerge : { false, true })
+        {
+            FPanoOdsSettings Settings;
+            Settings.SliceCount = SliceCount;
+            Settings.bPoleMerge = bPoleMerge;
+            // Sized as the component does: faces are a quarter of the equirect width.
+            const FPanoOdsLayout Layout = PanoramaOds::MakeLayout(Settings, kOdsTestWidth * 0.125f, kOdsTestEyeRadius, 16384);
+            const FPanoOdsCheckResult Result = PanoramaOdsBenchmark::Check(Layout, Resolution);
+            const FString Case = FString::Printf(TEXT("%d slices, pole merge %s"), SliceCount, bPoleMerge ? TEXT("on") : TEXT("off"));
+
+            TestTrue(FString::Printf(TEXT("Pixels read the slices, %s"), *Case), Result.Pixels > 0);
+            TestEqual(FString::Printf(TEXT("Every tile UV stays half a texel inside its tile, %s"), *Case), Result.OutsideTile, 0ll);
+            TestTrue(FString::Printf(TEXT("Unproject inverts Project, %s"), *Case), FMath::RadiansToDegrees(Result.MaxRoundTrip) < kOdsMaxRoundTripDegrees);
+
+            // Against the definition: a quarter turn from the azimuth, on the eye's side, at the eye radius.
+            const double Tolerance = kOdsDistanceTolerance * kOdsTestEyeRadius;
+            TestTrue(FString::Printf(TEXT("Exact ray origins sit on the eye's side of the circle, %s"), *Case), Result.MaxRayOriginError < Tolerance);
+
+            // The rays the stitch reads come from the nearest slice, at most half a slice off in yaw, so they pass the
+            // rig axis between R cos(SliceWidth / 2) and R. A wrong slice, pitch or view origin falls outside that.
+            const double MinDistance = kOdsTestEyeRadius * FMath::Cos(0.5 * Layout.SliceWidth) - Tolerance;
+            TestTrue(FString::Printf(TEXT("Stitched rays stay tangent to the eye circle within the slit-scan bound, %s"), *Case),
+                Result.MinStitchedRayDistance >= MinDistance && Result.MaxStitchedRayDistance <= kOdsTestEyeRadius + Tolerance);
+            TestEqual(FString::Printf(TEXT("Stitched rays start on their own eye's side, %s"), *Case), Result.WrongSideRays, 0ll);
+        }
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,128 @@
+#include "Misc/AutomationTest.h"
+#include "Math/RandomStream.h"
+#include "PanoramaPixelConvert.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    /** Odd width so the row bands and the vector tail both see ragged lengths. */
+    constexpr int32 kConvertTestWidth = 1021;
+    constexpr int32 kConvertTestHeight = 67;
+
+    const EPanoConvertKernel kConvertTestKernels[] = { EPanoConvertKernel::Half, EPanoConvertKernel::Unorm16, EPanoConvertKernel::Unorm16SRGB, EPanoConvertKernel::Unorm8 };
+
+    /** The documented SIMD tolerance: exact, except the sRGB pow approximation. */
+    int32 GetAllowedDifference(EPanoConvertKernel Kernel)
+    {
+        return Kernel == EPanoConvertKernel::Unorm16SRGB ? 1 : 0;
+    }
+
+    int32 ReadCode(EPanoConvertKernel Kernel, const TArray64<uint8>& Buffer, int64 Index)
+    {
+        return PanoramaPixelConvert::GetDestBytesPerChannel(Kernel) == 2
+            ? reinterpret_cast<const uint16*>(Buffer.GetData())[Index]
+            : Buffer[Index];
+    }
+
+    int32 MaxCodeDifference(EPanoConvertKernel Kernel, const TArray64<uint8>& A, const TArray64<uint8>& B, int64 Count)
+    {
+        int32 MaxDifference = 0;
+        for (int64 Index = 0; Index < Count; ++Index)
+        {
+            MaxDifference = FMath::Max(MaxDifference, FMath::Abs(ReadCode(Kernel, A, Index) - ReadCode(Kernel, B, Index)));
+        }
+        return MaxDifference;
+    }
+
+    /** Independent double-precision expectation for the Unorm kernels, straight from the enum's definition. */
+    int32 ReferenceCode(EPanoConvertKernel Kernel, float Value, int64 Index)
+    {
+        double Linear = FMath::Clamp(static_cast<double>(Value), 0.0, 1.0);
+        if (Kernel == EPanoConvertKernel::Unorm16SRGB && Index % 4 != 3)
+        {
+            Linear = Linear <= 0.0031308 ? Linear * 12.92 : 1.055 * FMath::Pow(Linear, 1.0 / 2.4) - 0.055;
+        }
+        const double Scale = Kernel == EPanoConvertKernel::Unorm8 ? 255.0 : 65535.0;
+        return static_cast<int32>(FMath::FloorToDouble(Linear * Scale + 0.5));
+    }
+
+    void BuildConvertSource(TArray64<float>& OutSource)
+    {
+        const int64 Count = static_cast<int64>(kConvertTestWidth) * kConvertTestHeight * 4;
+        OutSource.Reset(Count);
+
+        // Every 8-bit code centre and rounding boundary, then half-float edge cases, then noise slightly out of [0, 1].
+        for (int32 Code = 0; Code <= 255; ++Code)
+        {
+            OutSource.Add(Code / 255.0f);
+            OutSource.Add((Code + 0.5f) / 255.0f);
+        }
+        const float Edges[] = { 0.0f, -0.0f, 1.0f, -1.0f, 1.0e-7f, 6.1e-5f, 0.0031308f, 2048.0f, 65504.0f, -65504.0f };
+        OutSource.Append(Edges, UE_ARRAY_COUNT(Edges));
+
+        FRandomStream Random(0x50414E4F);
+        while (OutSource.Num() < Count)
+        {
+            OutSource.Add(Random.FRandRange(-0.05f, 1.05f));
+        }
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPanoPixelConvertSimdTest, "PanoramaCapture.PixelConvert.SimdMatchesScalar",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FPanoPixelConvertSimdTest::RunTest(const FString& Parameters)
+{
+    if (!PanoramaPixelConvert::HasSimd())
+    {
+        AddInfo(TEXT("SIMD kernels are not compiled in on this platform; only the scalar path runs."));
+    }
+
+    TArray64<float> Source;
+    BuildConvertSource(Source);
+    const int64 FloatsPerRow = static_cast<int64>(kConvertTestWidth) * 4;
+    const int64 Count = Source.Num();
+
+    TArray64<uint8> Reference;
+    TArray64<uint8> Output;
+    for (EPanoConvertKernel Kernel : kConvertTestKernels)
+    {
+        const int64 OutputBytes = Count * PanoramaPixelConvert::GetDestBytesPerChannel(Kernel);
+        Reference.SetNumZeroed(OutputBytes);
+        Output.SetNumZeroed(OutputBytes);
+        const int32 Allowed = GetAllowedDifference(Kernel);
+        const FString KernelName = FString::Printf(TEXT("kernel %d"), static_cast<int32>(Kernel));
+
+        PanoramaPixelConvert::Convert(Kernel, Source.GetData(), Reference.GetData(), Count, false);
+
+        // A count that is not a multiple of the vector width leaves a scalar tail.
+        const int64 RaggedCount = Count - 3;
+        PanoramaPixelConvert::Convert(Kernel, Source.GetData(), Output.GetData(), RaggedCount, true);
+        TestTrue(FString::Printf(TEXT("SIMD matches scalar within %d code(s), %s"), Allowed, *KernelName),
+            MaxCodeDifference(Kernel, Reference, Output, RaggedCount) <= Allowed);
+
+        FMemory::Memzero(Output.GetData(), OutputBytes);
+        PanoramaPixelConvert::ConvertRows(Kernel, Source.GetData(), Output.GetData(), FloatsPerRow, kConvertTestHeight, true);
+        TestTrue(FString::Printf(TEXT("Row-parallel SIMD matches scalar within %d code(s), %s"), Allowed, *KernelName),
+            MaxCodeDifference(Kernel, Reference, Output, Count) <= Allowed);
+
+        if (Kernel == EPanoConvertKernel::Half)
+        {
+            continue;
+        }
+
+        // The scalar path itself is checked against the definition, so SIMD and scalar cannot be wrong together. One code
+        // of slack covers single-precision rounding on the exact half-code boundaries above.
+        int32 MaxReferenceDifference = 0;
+        for (int64 Index = 0; Index < Count; ++Index)
+        {
+            MaxReferenceDifference = FMath::Max(MaxReferenceDifference, FMath::Abs(ReadCode(Kernel, Reference, Index) - ReferenceCode(Kernel, Source[Index], Index)));
+        }
+        TestTrue(FString::Printf(TEXT("Scalar matches the double-precision definition, %s"), *KernelName),
+            MaxReferenceDifference <= 1);
+    }
+    return true;
+}
+
+#endif
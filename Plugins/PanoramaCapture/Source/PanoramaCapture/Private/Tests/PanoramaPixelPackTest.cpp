@@ -0,0 +1,131 @@
+#include "Misc/AutomationTest.h"
+#include "PanoramaPixelPack.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    const FLinearColor kPackRed(1.0f, 0.0f, 0.0f, 1.0f);
+    const FLinearColor kPackBlack(0.0f, 0.0f, 0.0f, 1.0f);
+    const FLinearColor kPackWhite(1.0f, 1.0f, 1.0f, 1.0f);
+
+    /**
+     * 4x2 image for the 4:2:0 formats. The left 2x2 block is a red column beside a black one, so centred chroma (the
+     * average of the block) differs from chroma sited on the left column; the right block averages to 75% grey.
+     */
+    const FLinearColor kPackChromaImage[] = {
+        kPackRed, kPackBlack, kPackWhite, kPackBlack,
+        kPackRed, kPackBlack, kPackWhite, kPackWhite,
+    };
+    const FIntPoint kPackChromaResolution(4, 2);
+
+    /** Odd in both directions, so a padded or 4:2:0-style row stride would show up. */
+    const FIntPoint kPackOddResolution(3, 3);
+
+    TArray<FLinearColor> BuildOddImage()
+    {
+        // R steps across, G steps down: 0, 0.5, 1.
+        TArray<FLinearColor> Pixels;
+        for (int32 Y = 0; Y < kPackOddResolution.Y; ++Y)
+        {
+            for (int32 X = 0; X < kPackOddResolution.X; ++X)
+            {
+                Pixels.Add(FLinearColor(X * 0.5f, Y * 0.5f, 0.25f, 1.0f));
+            }
+        }
+        return Pixels;
+    }
+
+    TArray<uint8> Pack(EPanoPackFormat Format, const FLinearColor* Pixels, FIntPoint Resolution)
+    {
+        TArray<uint8> Packed;
+        Packed.SetNumUninitialized(PanoramaPixelPack::GetPackedBytes(Format, Resolution));
+        PanoramaPixelPack::PackReference(Format, Pixels, Resolution, Packed.GetData());
+        return Packed;
+    }
+
+    /** Expected value for the 0, 0.5, 1 steps of the odd image: 0.5 rounds up at both depths. */
+    uint32 StepCode(int32 Step, uint32 MaxCode)
+    {
+        return Step == 0 ? 0 : (Step == 1 ? (MaxCode + 1) / 2 : MaxCode);
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPanoPixelPackReferenceTest, "PanoramaCapture.PixelPack.ReferenceBytes",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FPanoPixelPackReferenceTest::RunTest(const FString& Parameters)
+{
+    auto TestBytes = [this](const TCHAR* What, const TArray<uint8>& Actual, const TArray<uint8>& Expected)
+    {
+        if (!TestEqual(FString::Printf(TEXT("%s size"), What), Actual.Num(), Expected.Num()))
+        {
+            return;
+        }
+        for (int32 Index = 0; Index < Expected.Num(); ++Index)
+        {
+            if (Actual[Index] != Expected[Index])
+            {
+                AddError(FString::Printf(TEXT("%s: byte %d is 0x%02X, expected 0x%02X"), What, Index, Actual[Index], Expected[Index]));
+                return;
+            }
+        }
+    };
+
+    // RGBA8: R, G, B, A bytes; out-of-range values clamp, 0.5 rounds to 128 and 0.25 to 64.
+    {
+        const FLinearColor Pixels[] = { FLinearColor(1.0f, 0.0f, 0.5f, 0.25f), FLinearColor(-0.5f, 2.0f, 0.0f, 1.0f) };
+        TestBytes(TEXT("RGBA8"), Pack(EPanoPackFormat::RGBA8, Pixels, FIntPoint(2, 1)),
+            { 0xFF, 0x00, 0x80, 0x40,  0x00, 0xFF, 0x00, 0xFF });
+    }
+
+    // RGBA16: four little-endian UNORM16 channels; 0.5 is 32768 (0x8000) and 0.25 is 16384 (0x4000).
+    {
+        const FLinearColor Pixels[] = { FLinearColor(1.0f, 0.5f, 0.0f, 0.25f) };
+        TestBytes(TEXT("RGBA16"), Pack(EPanoPackFormat::RGBA16, Pixels, FIntPoint(1, 1)),
+            { 0xFF, 0xFF, 0x00, 0x80, 0x00, 0x00, 0x00, 0x40 });
+    }
+
+    // NV12: two rows of 8-bit limited-range luma (black 16, white 235, red 63), then one row of interleaved UV, one
+    // pair per 2x2 block. The red/black block averages to (0.5, 0, 0): U 115, V 184. Left-sited chroma would give the
+    // pure red pair (102, 240) instead. The grey block is neutral: 128, 128.
+    TestBytes(TEXT("NV12"), Pack(EPanoPackFormat::NV12, kPackChromaImage, kPackChromaResolution), {
+        63, 16, 235, 16,
+        63, 16, 235, 235,
+        115, 184, 128, 128 });
+
+    // P010: the same planes with 16-bit little-endian samples holding 10 bits in the high bits. Luma black 64 (0x1000),
+    // white 940 (0xEB00), red 250 (0x3E80); chroma U 461 (0x7340), V 736 (0xB800), neutral 512 (0x8000).
+    TestBytes(TEXT("P010"), Pack(EPanoPackFormat::P010, kPackChromaImage, kPackChromaResolution), {
+        0x80, 0x3E, 0x00, 0x10, 0x00, 0xEB, 0x00, 0x10,
+        0x80, 0x3E, 0x00, 0x10, 0x00, 0xEB, 0x00, 0xEB,
+        0x40, 0x73, 0x00, 0xB8, 0x00, 0x80, 0x00, 0x80 });
+
+    // Odd sizes: the RGBA formats pack them tightly, one texel per pixel; the 4:2:0 formats refuse them.
+    const TArray<FLinearColor> OddPixels = BuildOddImage();
+    TArray<uint8> ExpectedRgba8;
+    TArray<uint8> ExpectedRgba16;
+    for (int32 Y = 0; Y < kPackOddResolution.Y; ++Y)
+    {
+        for (int32 X = 0; X < kPackOddResolution.X; ++X)
+        {
+            ExpectedRgba8.Append({ static_cast<uint8>(StepCode(X, 255)), static_cast<uint8>(StepCode(Y, 255)), 0x40, 0xFF });
+            const uint32 R16 = StepCode(X, 65535);
+            const uint32 G16 = StepCode(Y, 65535);
+            ExpectedRgba16.Append({ static_cast<uint8>(R16 & 0xFF), static_cast<uint8>(R16 >> 8), static_cast<uint8>(G16 & 0xFF), static_cast<uint8>(G16 >> 8),
+                0x00, 0x40, 0xFF, 0xFF });
+        }
+    }
+    TestTrue(TEXT("RGBA8 accepts odd sizes"), PanoramaPixelPack::IsResolutionSupported(EPanoPackFormat::RGBA8, kPackOddResolution));
+    TestTrue(TEXT("RGBA16 accepts odd sizes"), PanoramaPixelPack::IsResolutionSupported(EPanoPackFormat::RGBA16, kPackOddResolution));
+    TestBytes(TEXT("RGBA8 3x3"), Pack(EPanoPackFormat::RGBA8, OddPixels.GetData(), kPackOddResolution), ExpectedRgba8);
+    TestBytes(TEXT("RGBA16 3x3"), Pack(EPanoPackFormat::RGBA16, OddPixels.GetData(), kPackOddResolution), ExpectedRgba16);
+
+    TestFalse(TEXT("NV12 refuses an odd height"), PanoramaPixelPack::IsResolutionSupported(EPanoPackFormat::NV12, FIntPoint(8, 3)));
+    TestFalse(TEXT("NV12 refuses a width not divisible by 4"), PanoramaPixelPack::IsResolutionSupported(EPanoPackFormat::NV12, FIntPoint(6, 2)));
+    TestFalse(TEXT("P010 refuses an odd width"), PanoramaPixelPack::IsResolutionSupported(EPanoPackFormat::P010, FIntPoint(5, 2)));
+    TestFalse(TEXT("P010 refuses an odd height"), PanoramaPixelPack::IsResolutionSupported(EPanoPackFormat::P010, FIntPoint(4, 3)));
+    return true;
+}
+
+#endif
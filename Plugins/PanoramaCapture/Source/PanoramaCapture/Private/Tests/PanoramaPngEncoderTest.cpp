@@ -0,0 +1,124 @@
+#include "Misc/AutomationTest.h"
+#include "IImageWrapper.h"
+#include "IImageWrapperModule.h"
+#include "Modules/ModuleManager.h"
+#include "PanoramaPngBenchmark.h"
+#include "PanoramaPngEncoder.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    /** Decodes Png with the engine's libpng wrapper, the reference decoder. 16-bit samples come back native-endian. */
+    bool DecodeReferencePng(const TArray64<uint8>& Png, int32 BitDepth, int32& OutWidth, int32& OutHeight, TArray64<uint8>& OutPixels)
+    {
+        IImageWrapperModule& ImageWrapperModule = FModuleManager::LoadModuleChecked<IImageWrapperModule>(TEXT("ImageWrapper"));
+        TSharedPtr<IImageWrapper> Wrapper = ImageWrapperModule.CreateImageWrapper(EImageFormat::PNG);
+        if (!Wrapper.IsValid() || !Wrapper->SetCompressed(Png.GetData(), Png.Num()))
+        {
+            return false;
+        }
+        OutWidth = Wrapper->GetWidth();
+        OutHeight = Wrapper->GetHeight();
+        return Wrapper->GetBitDepth() == BitDepth && Wrapper->GetRaw(ERGBFormat::RGBA, BitDepth, OutPixels);
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPanoPngRoundTripTest, "PanoramaCapture.Png.BandedEncodeRoundTrip",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FPanoPngRoundTripTest::RunTest(const FString& Parameters)
+{
+    // Odd sizes put band edges mid-image and leave a short last band.
+    const FIntPoint Sizes[] = { FIntPoint(1024, 512), FIntPoint(257, 131) };
+    const int32 BandCounts[] = { 1, 3, 8 };
+    const EPanoPngRowFilter Filters[] = { EPanoPngRowFilter::None, EPanoPngRowFilter::Sub, EPanoPngRowFilter::Up,
+        EPanoPngRowFilter::Average, EPanoPngRowFilter::Paeth, EPanoPngRowFilter::Adaptive };
+
+    FPanoPngEncoder Encoder;
+    TArray64<uint8> Pixels;
+    TArray64<uint8> Png;
+    TArray64<uint8> Decoded;
+    for (const FIntPoint& Size : Sizes)
+    {
+        for (int32 BitDepth : { 8, 16 })
+        {
+            PanoramaPngBenchmark::BuildSyntheticEquirect(Size.X, Size.Y, BitDepth, Pixels);
+            for (int32 NumBands : BandCounts)
+            {
+                for (EPanoPngRowFilter Filter : Filters)
+                {
+                    FPanoPngEncodeOptions Options;
+                    Options.NumBands = NumBands;
+                    Options.Filter = Filter;
+                    const FString Case = FString::Printf(TEXT("%dx%d %d-bit, %d bands, filter %d"), Size.X, Size.Y, BitDepth, NumBands, static_cast<int32>(Filter));
+
+                    FPanoPngEncodeStats Stats;
+                    if (!TestTrue(Case + TEXT(" encodes"), Encoder.Encode(Pixels.GetData(), Size.X, Size.Y, BitDepth, Options, Png, &Stats)))
+                    {
+                        continue;
+                    }
+                    TestEqual(Case + TEXT(" uses the requested bands"), Stats.NumBands, FMath::Min(NumBands, Size.Y));
+
+                    int32 Width = 0;
+                    int32 Height = 0;
+                    if (!TestTrue(Case + TEXT(" decodes"), DecodeReferencePng(Png, BitDepth, Width, Height, Decoded)))
+                    {
+                        continue;
+                    }
+                    TestEqual(Case + TEXT(" width"), Width, Size.X);
+                    TestEqual(Case + TEXT(" height"), Height, Size.Y);
+                    TestTrue(Case + TEXT(" pixels match"), Decoded.Num() == Pixels.Num() && FMemory::Memcmp(Decoded.GetData(), Pixels.GetData(), Pixels.Num()) == 0);
+                }
+            }
+        }
+    }
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPanoPngPresetTest, "PanoramaCapture.Png.CompressionPresets",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FPanoPngPresetTest::RunTest(const FString& Parameters)
+{
+    const FIntPoint Size(2048, 1024);
+    FPanoPngEncoder Encoder;
+    TArray64<uint8> Pixels;
+    PanoramaPngBenchmark::BuildSyntheticEquirect(Size.X, Size.Y, 8, Pixels);
+
+    const EPanoramaPngCompression Presets[] = { EPanoramaPngCompression::Uncompressed, EPanoramaPngCompression::Fastest,
+        EPanoramaPngCompression::Balanced, EPanoramaPngCompression::Smallest };
+    int64 CompressedBytes[UE_ARRAY_COUNT(Presets)] = {};
+    TArray64<uint8> FastestPng;
+    for (int32 Index = 0; Index < UE_ARRAY_COUNT(Presets); ++Index)
+    {
+        TArray64<uint8> Png;
+        FPanoPngEncodeStats Stats;
+        TestTrue(FString::Printf(TEXT("Preset %d encodes"), Index), Encoder.Encode(Pixels.GetData(), Size.X, Size.Y, 8, FPanoPngEncodeOptions::FromPreset(Presets[Index]), Png, &Stats));
+        CompressedBytes[Index] = Stats.CompressedBytes;
+        if (Presets[Index] == EPanoramaPngCompression::Fastest)
+        {
+            FastestPng = MoveTemp(Png);
+        }
+    }
+
+    // Stored blocks cost a few bytes per 64 KB block and per row filter byte, nothing more.
+    TestTrue(TEXT("Uncompressed stays within 1% of the raw size"), FMath::Abs(CompressedBytes[0] - Pixels.Num()) < Pixels.Num() / 100);
+    TestTrue(TEXT("Fastest is smaller than Uncompressed"), CompressedBytes[1] < CompressedBytes[0]);
+    TestTrue(TEXT("Balanced is smaller than Fastest"), CompressedBytes[2] < CompressedBytes[1]);
+    TestTrue(TEXT("Smallest is no larger than Balanced"), CompressedBytes[3] <= CompressedBytes[2]);
+
+    // The offline pass re-deflates a live capture at the Smallest preset without touching the pixels.
+    TArray64<uint8> Recompressed;
+    TestTrue(TEXT("Recompress succeeds"), Encoder.Recompress(FastestPng, FPanoPngEncodeOptions::FromPreset(EPanoramaPngCompression::Smallest), Recompressed));
+    TestTrue(TEXT("Recompressed file is smaller"), Recompressed.Num() < FastestPng.Num());
+
+    int32 Width = 0;
+    int32 Height = 0;
+    TArray64<uint8> Decoded;
+    TestTrue(TEXT("Recompressed file decodes"), DecodeReferencePng(Recompressed, 8, Width, Height, Decoded));
+    TestTrue(TEXT("Recompressed pixels match"), Decoded.Num() == Pixels.Num() && FMemory::Memcmp(Decoded.GetData(), Pixels.GetData(), Pixels.Num()) == 0);
+    return true;
+}
+
+#endif
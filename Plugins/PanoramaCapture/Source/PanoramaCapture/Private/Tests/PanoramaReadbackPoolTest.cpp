@@ -0,0 +1,119 @@
+#include "Misc/AutomationTest.h"
+#include "PanoramaFrameRingBuffer.h"
+#include "PanoramaReadbackPool.h"
+#include "RHI.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    constexpr int32 kReadbackTestFrames = 64;
+    constexpr int32 kReadbackTestDepth = 3;
+    const FIntPoint kReadbackTestExtent(32, 16);
+    constexpr int32 kReadbackTestBytesPerTexel = 4;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPanoReadbackPoolNullRhiTest, "PanoramaCapture.ReadbackPool.NullRhi",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FPanoReadbackPoolNullRhiTest::RunTest(const FString& Parameters)
+{
+    if (!GUsingNullRHI)
+    {
+        AddInfo(TEXT("Needs -nullrhi; the GPU path is exercised by real captures."));
+        return true;
+    }
+
+    const int64 FrameBytes = static_cast<int64>(kReadbackTestExtent.X) * kReadbackTestExtent.Y * kReadbackTestBytesPerTexel;
+    FPanoFrameRingBuffer Ring(kReadbackTestDepth + 2, FrameBytes);
+
+    int32 CommitCallbacks = 0;
+    FPanoReadbackPool Pool(kReadbackTestDepth, &Ring, [&CommitCallbacks]()
+    {
+        ++CommitCallbacks;
+    });
+    TestEqual(TEXT("Pool has the requested depth"), Pool.GetDepth(), kReadbackTestDepth);
+
+    // Under the null RHI the copy callback records nothing, so the tests never build a graph to run it.
+    FPanoCaptureFrame* Oversized = Ring.AcquireWriteSlot();
+    TestFalse(TEXT("A source larger than the slab is refused"),
+        static_cast<bool>(Pool.Enqueue(Oversized, kReadbackTestExtent * 2, kReadbackTestBytesPerTexel)));
+    TestEqual(TEXT("A refused request reserves nothing"), Pool.NumInFlight(), 0);
+    Ring.CancelWriteSlot(Oversized);
+
+    uint64 NextFrameIndex = 0;
+    int32 Received = 0;
+    int32 OutOfOrder = 0;
+    int32 NotZeroed = 0;
+    int32 FullRefusals = 0;
+    uint64 ExpectedIndex = 0;
+    while (Received < kReadbackTestFrames)
+    {
+        // Fill every readback, then confirm one more is refused until the next poll frees them.
+        while (NextFrameIndex < static_cast<uint64>(kReadbackTestFrames) && Pool.NumInFlight() < Pool.GetDepth())
+        {
+            FPanoCaptureFrame* Slot = Ring.AcquireWriteSlot();
+            if (!TestNotNull(TEXT("Ring has a free slot"), Slot))
+            {
+                return false;
+            }
+
+            Slot->FrameIndex = NextFrameIndex++;
+            Slot->NumBytes = FrameBytes;
+            FMemory::Memset(Slot->PixelData.GetData(), 0xAB, FrameBytes);
+            TestTrue(TEXT("A free readback is reserved"), static_cast<bool>(Pool.Enqueue(Slot, kReadbackTestExtent, kReadbackTestBytesPerTexel)));
+        }
+
+        if (Pool.NumInFlight() == Pool.GetDepth())
+        {
+            FPanoCaptureFrame* Extra = Ring.AcquireWriteSlot();
+            FullRefusals += Extra && !Pool.Enqueue(Extra, kReadbackTestExtent, kReadbackTestBytesPerTexel) ? 1 : 0;
+            if (Extra)
+            {
+                Ring.CancelWriteSlot(Extra);
+            }
+        }
+
+        Pool.Poll();
+        TestEqual(TEXT("Null RHI readbacks complete on the next poll"), Pool.NumInFlight(), 0);
+
+        while (FPanoCaptureFrame* Frame = Ring.AcquireReadSlot())
+        {
+            OutOfOrder += Frame->FrameIndex != ExpectedIndex ? 1 : 0;
+            ExpectedIndex = Frame->FrameIndex + 1;
+
+            bool bZeroed = true;
+            for (int64 Offset = 0; bZeroed && Offset < FrameBytes; ++Offset)
+            {
+                bZeroed = Frame->PixelData[Offset] == 0;
+            }
+            NotZeroed += bZeroed ? 0 : 1;
+
+            ++Received;
+            Ring.ReleaseSlot(Frame);
+        }
+    }
+
+    TestEqual(TEXT("Every frame reaches the ring"), Received, kReadbackTestFrames);
+    TestEqual(TEXT("Frames arrive in submission order"), OutOfOrder, 0);
+    TestEqual(TEXT("Null RHI frames are zeroed"), NotZeroed, 0);
+    TestEqual(TEXT("The commit callback runs once per frame"), CommitCallbacks, kReadbackTestFrames);
+    TestTrue(TEXT("A full pool refuses further requests"), FullRefusals > 0);
+
+    // Drain commits whatever is still queued at the end of a capture.
+    FPanoCaptureFrame* Last = Ring.AcquireWriteSlot();
+    Last->FrameIndex = NextFrameIndex;
+    Last->NumBytes = FrameBytes;
+    TestTrue(TEXT("The final readback is reserved"), static_cast<bool>(Pool.Enqueue(Last, kReadbackTestExtent, kReadbackTestBytesPerTexel)));
+    Pool.Drain();
+    TestEqual(TEXT("Drain leaves nothing in flight"), Pool.NumInFlight(), 0);
+    TestEqual(TEXT("Drain commits the pending frame"), Ring.Num(), 1);
+    if (FPanoCaptureFrame* Frame = Ring.AcquireReadSlot())
+    {
+        TestEqual(TEXT("Drained frame is the last one submitted"), Frame->FrameIndex, NextFrameIndex);
+        Ring.ReleaseSlot(Frame);
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,54 @@
+#include "Misc/AutomationTest.h"
+#include "PanoramaResampleBenchmark.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    /** The sizes the filters were tuned at: two output pixels per period of the fine pattern. */
+    constexpr int32 kResampleTestWidth = 512;
+    constexpr int32 kResampleTestFaceSize = 256;
+    constexpr int32 kResampleTestSupersamples = 8;
+    /** Every filter was measured at 68.9 dB or better; lower means visible blur or ringing. */
+    constexpr double kResampleMinPassbandPsnr = 66.0;
+    /** The wider filters measured 2.2 to 4.6 dB less aliasing than bilinear. */
+    constexpr double kResampleMinAliasingGain = 1.5;
+
+    const FPanoResampleQuality* FindQuality(const TArray<FPanoResampleQuality>& Results, EPanoramaResampleFilter Filter)
+    {
+        return Results.FindByPredicate([Filter](const FPanoResampleQuality& Quality)
+        {
+            return Quality.Filter == Filter;
+        });
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPanoResampleQualityTest, "PanoramaCapture.Resample.FilterQualityOrdering",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FPanoResampleQualityTest::RunTest(const FString& Parameters)
+{
+    const TArray<FPanoResampleQuality> Results = PanoramaResampleBenchmark::Measure(kResampleTestWidth, kResampleTestFaceSize, kResampleTestSupersamples);
+    const FPanoResampleQuality* Bilinear = FindQuality(Results, EPanoramaResampleFilter::Bilinear);
+    const FPanoResampleQuality* Bicubic = FindQuality(Results, EPanoramaResampleFilter::Bicubic);
+    const FPanoResampleQuality* Lanczos = FindQuality(Results, EPanoramaResampleFilter::Lanczos3);
+    const FPanoResampleQuality* Supersampled = FindQuality(Results, EPanoramaResampleFilter::Supersampled);
+    if (!TestTrue(TEXT("Every filter was measured"), Bilinear && Bicubic && Lanczos && Supersampled))
+    {
+        return false;
+    }
+
+    for (const FPanoResampleQuality& Quality : Results)
+    {
+        AddInfo(FString::Printf(TEXT("Filter %d: passband %.1f dB, aliasing %.1f dB"), static_cast<int32>(Quality.Filter), Quality.Passband.Total, Quality.Aliasing.Total));
+        TestTrue(FString::Printf(TEXT("Filter %d keeps the passband"), static_cast<int32>(Quality.Filter)), Quality.Passband.Total > kResampleMinPassbandPsnr);
+    }
+
+    // Measured aliasing PSNR: bilinear 23.8 dB, Lanczos-3 26.0 dB, bicubic 27.0 dB, 8x supersampled 28.4 dB.
+    TestTrue(TEXT("Lanczos-3 aliases less than bilinear"), Lanczos->Aliasing.Total > Bilinear->Aliasing.Total + kResampleMinAliasingGain);
+    TestTrue(TEXT("Bicubic aliases less than Lanczos-3"), Bicubic->Aliasing.Total > Lanczos->Aliasing.Total);
+    TestTrue(TEXT("Supersampling aliases least"), Supersampled->Aliasing.Total > Bicubic->Aliasing.Total);
+    return true;
+}
+
+#endif
@@ -3,38 +3,99 @@
 #include "CoreMinimal.h"
 #include "AudioMixerDevice.h"
 #include "Sound/AudioBus.h"
+#include "Async/Future.h"
+#include "PanoramaCaptureTypes.h"
+
+#include <atomic>
 
 class USoundSubmixBase;
+class FEvent;
+class FPanoWavWriter;
+class FPanoAudioBlockRing;
+class FPanoCaptureClock;
 
 namespace Audio
 {
     class ISubmixBufferListener;
 }
 
+/**
+ * Records a submix straight to a WAV file. The audio callback copies samples into a preallocated lock-free block
+ * ring and returns; a writer thread drains the ring to disk, so memory stays flat for any session length, the
+ * audio render thread never waits, and StopRecording only patches the header.
+ */
 class FPanoAudioRecorder : public Audio::ISubmixBufferListener
 {
 public:
     FPanoAudioRecorder();
     virtual ~FPanoAudioRecorder();
 
-    bool StartRecording(USoundSubmixBase* Submix, int32 InSampleRate, int32 InNumChannels);
+    /**
+     * Registers with the submix and starts streaming to WavFilePath. When CaptureClock is given, every callback
+     * advances it so video frames can be stamped against the recorded sample count.
+     */
+    bool StartRecording(USoundSubmixBase* Submix, int32 InSampleRate, int32 InNumChannels, const FString& WavFilePath, FPanoCaptureClock* InCaptureClock = nullptr);
+
+    /** Starts the writer without registering with a submix; the caller feeds OnNewSubmixBuffer itself. */
+    bool StartStreaming(int32 InSampleRate, int32 InNumChannels, const FString& WavFilePath, FPanoCaptureClock* InCaptureClock = nullptr);
+
+    /** Receives the int16 samples written to the WAV, on the writer thread. Set before StartRecording. */
+    void SetPcmListener(TFunction<void(const int16* Samples, int32 NumSamples)> InListener) { PcmListener = MoveTemp(InListener); }
+
+    /** Game thread: stops the submix callbacks. StopRecording may then run on any thread. */
+    void DetachFromSubmix();
+
+    /** Unregisters, drains the queued samples and finalizes the WAV file. */
     void StopRecording();
-    void Reset();
 
-    /** Writes recorded PCM data to a WAV file located at the provided path. */
-    bool WriteToWav(const FString& FilePath, double& OutDurationSeconds);
+    /** Path of the file written by the last session, or empty if nothing was recorded. */
+    FString GetWavFilePath() const;
+
+    /** Duration of audio written to disk so far. */
+    double GetRecordedDurationSeconds() const;
 
-    /** Returns the timestamp (in seconds) relative to StartRecording for the most recent audio buffer. */
-    double GetCurrentTimestampSeconds() const;
+    /** Overruns, dropped samples and worst callback time for the current (or last) session. */
+    FPanoAudioCaptureStats GetCaptureStats() const;
 
     virtual void OnNewSubmixBuffer(const USoundSubmix* OwningSubmix, float* AudioData, int32 NumSamples, int32 NumChannels, const int32 SampleRate, double AudioClock) override;
 
 private:
-    FCriticalSection BufferGuard;
-    TArray<float> AccumulatedPCM;
-    TArray<uint8> WavDataCache;
-    double StartTime;
+    void WriterLoop();
+
+    /** Writer thread: each returns false once a write has failed, and nothing more is written after that. */
+    bool WriteDrainedSamples();
+    bool WriteSilence(int64 NumSamples);
+    bool WriteToWav(const float* Samples, int64 NumSamples);
+
+    TUniquePtr<FPanoAudioBlockRing> BlockRing;
+    /** Writer-thread scratch the drained blocks are concatenated into; keeps its allocation between drains. */
+    TArray<float> DrainPCM;
+    /** One block of zeros; overrun gaps are written from it chunk by chunk. */
+    TArray<float> SilencePCM;
+
+    TUniquePtr<FPanoWavWriter> WavWriter;
+    TFunction<void(const int16*, int32)> PcmListener;
+    TFuture<void> WriterThread;
+    FEvent* WriterWakeEvent;
+    FThreadSafeBool bStopWriter;
+    /** Set by the writer when the WAV cannot be written; the callback stops queueing audio. */
+    std::atomic<bool> bWriteFailed;
+    std::atomic<int64> SamplesWritten;
+
+    std::atomic<int32> OverrunCount;
+    std::atomic<int64> DroppedSamples;
+    /** Submix buffers whose channel count differed from NumChannels; their samples count as dropped. */
+    std::atomic<int32> ChannelMismatchCount;
+    /** Written only by the audio render thread. */
+    std::atomic<double> MaxCallbackSeconds;
+    /** Audio-thread only: samples dropped since the last block that made it into the ring. */
+    int64 PendingGapSamples;
+
+    FPanoCaptureClock* CaptureClock;
+
+    FString WavPath;
     int32 SampleRate;
     int32 NumChannels;
     bool bRecording;
+    bool bListening;
 };
@@ -5,12 +5,19 @@
 #include "PanoramaCaptureTypes.h"
 #include "PanoramaCaptureComponent.generated.h"
 
+class USceneCaptureComponentCube;
 class USceneCaptureComponent2D;
 class UTextureRenderTarget2D;
+class UTextureRenderTargetCube;
 class UMaterialInterface;
 class UMaterialInstanceDynamic;
 class USoundSubmixBase;
 struct FPanoramaEncodedFrame;
+struct FPanoRegionBounds;
+enum class EPanoPackFormat : uint8;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FPanoFinalizeProgressSignature, const FString&, SessionName, EPanoramaFinalizeStage, Stage, float, Progress);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FPanoFinalizeCompleteSignature, const FPanoFinalizeResult&, Result);
 
 UCLASS(ClassGroup = (PanoramaCapture), BlueprintType, Blueprintable, meta = (BlueprintSpawnableComponent))
 class PANORAMACAPTURE_API UPanoramaCaptureComponent : public USceneComponent
@@ -23,9 +30,18 @@ public:
     UFUNCTION(BlueprintCallable, Category = "Panorama")
     void StartRecording();
 
+    /** Hands the session to a background finalize job and returns to Idle; a new take can start right away. */
     UFUNCTION(BlueprintCallable, Category = "Panorama")
     void StopRecording();
 
+    /** Blocks until every stopped session has finished finalizing, then reports their completion. */
+    UFUNCTION(BlueprintCallable, Category = "Panorama")
+    void WaitForPendingFinalize();
+
+    /** Stopped sessions whose files are still being written. */
+    UFUNCTION(BlueprintPure, Category = "Panorama")
+    int32 GetFinalizingSessionCount() const { return FinalizeJobs.Num(); }
+
     UFUNCTION(BlueprintCallable, Category = "Panorama")
     void TogglePreview(bool bEnable);
 
@@ -38,6 +54,30 @@ public:
     UFUNCTION(BlueprintPure, Category = "Panorama")
     uint32 GetDroppedFrameCount() const { return DroppedFrameCount; }
 
+    /** Ring enqueue-to-dequeue latency for the current (or most recent) PNG session. */
+    UFUNCTION(BlueprintPure, Category = "Panorama")
+    FPanoLatencyStats GetQueueLatencyStats() const;
+
+    /** PNG encode throughput for the current (or most recent) PNG session. */
+    UFUNCTION(BlueprintPure, Category = "Panorama")
+    FPanoEncodeThroughput GetPngEncodeThroughput() const;
+
+    /** Per-frame PNG encode latency for the current (or most recent) PNG session. */
+    UFUNCTION(BlueprintPure, Category = "Panorama")
+    FPanoLatencyStats GetPngEncodeLatencyStats() const;
+
+    /** Game-thread time spent handing each PNG frame to the readback path (sync ReadPixels or async enqueue). */
+    UFUNCTION(BlueprintPure, Category = "Panorama")
+    FPanoLatencyStats GetReadbackStallStats() const;
+
+    /** Audio callback overruns and worst-case callback time for the current (or most recent) session. */
+    UFUNCTION(BlueprintPure, Category = "Panorama")
+    FPanoAudioCaptureStats GetAudioCaptureStats() const;
+
+    /** Render-thread and GPU cost of the last few seconds of captured frames; also logged while recording. */
+    UFUNCTION(BlueprintPure, Category = "Panorama")
+    FPanoCaptureRenderCost GetCaptureRenderCost() const { return LastCaptureRenderCost; }
+
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Panorama")
     EPanoramaCaptureMode CaptureMode;
 
@@ -47,15 +87,24 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Panorama")
     float CaptureFrameRate;
 
+    /** LockedTimestep drives the engine's fixed delta time for the length of the take and records no audio. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Panorama")
+    EPanoramaCaptureTiming CaptureTiming;
+
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Panorama")
     bool bRecordOnBeginPlay;
 
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Panorama")
     bool bEnablePreview;
 
-    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Panorama")
+    /** Preview size relative to the equirect; the preview is box-filtered down from it rather than copied. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Panorama", meta = (ClampMin = "0.05", ClampMax = "1.0"))
     float PreviewScale;
 
+    /** Preview refreshes per second, at most one per captured frame; 0 refreshes on every captured frame. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Panorama", meta = (ClampMin = "0.0"))
+    float PreviewFrameRate;
+
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Panorama")
     int32 RingBufferSize;
 
@@ -68,9 +117,55 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Panorama")
     bool bUse16BitPng;
 
+    /** Read PNG frames back through a pool of GPU fences instead of a blocking ReadPixels on the game thread. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Panorama")
+    bool bUseAsyncReadback;
+
+    /** Number of readbacks that may be in flight; frames are dropped when every one is still pending. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Panorama", meta = (ClampMin = "1", ClampMax = "8", EditCondition = "bUseAsyncReadback"))
+    int32 ReadbackPoolDepth;
+
+    /**
+     * Frames whose cube, equirect and pack targets may be in flight at once. Frame N+1 renders and converts into its
+     * own targets while frame N is still being read back or encoded; each extra frame costs one more set of targets.
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Panorama", meta = (ClampMin = "1", ClampMax = "3"))
+    int32 PipelineDepth;
+
+    /** LookupTable trades a small per-resolution table for the per-pixel trig of the analytic mapping. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Panorama")
+    EPanoramaEquirectMapping EquirectMapping;
+
+    /** Bilinear for live capture; the wider filters cost more GPU time per frame and suit delivery masters. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Panorama")
+    EPanoramaResampleFilter ResampleFilter;
+
+    /** Samples per output pixel for EPanoramaResampleFilter::Supersampled; odd counts round up. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Panorama", meta = (ClampMin = "2", ClampMax = "64", EditCondition = "ResampleFilter == EPanoramaResampleFilter::Supersampled"))
+    int32 SupersampleCount;
+
+    /** Stereo only. Batched shares the scene renderer's per-frame work between the eyes; faces are capped so both eyes fit one atlas. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Panorama", meta = (EditCondition = "CaptureMode == EPanoramaCaptureMode::Stereo"))
+    EPanoramaStereoRendering StereoRendering;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Panorama", meta = (EditCondition = "CaptureMode == EPanoramaCaptureMode::Stereo && StereoRendering == EPanoramaStereoRendering::Ods"))
+    FPanoOdsSettings OdsSettings;
+
+    /** NVENC only: write MP4/MKV fragments during capture instead of muxing a raw bitstream after StopRecording. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Panorama")
+    bool bLiveContainerWriting;
+
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Panorama")
     FString RecordingLabel;
 
+    /** Broadcast on the game thread as a stopped session moves through its finalize stages. */
+    UPROPERTY(BlueprintAssignable, Category = "Panorama")
+    FPanoFinalizeProgressSignature OnFinalizeProgress;
+
+    /** Broadcast on the game thread once a stopped session's files are complete. */
+    UPROPERTY(BlueprintAssignable, Category = "Panorama")
+    FPanoFinalizeCompleteSignature OnFinalizeComplete;
+
 protected:
     virtual void OnRegister() override;
     virtual void BeginPlay() override;
@@ -78,47 +173,186 @@ protected:
     virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 
 private:
-    void InitializeCaptureFaces();
-    void ReleaseResources();
+    void InitializeCubeCapture();
+    void InitializeFaceCaptures();
     void AllocateRenderTargets();
+    void AllocateCubeTarget(int32 FaceSize);
+    /** Releases the per-face and atlas targets that feed the cube when the cube capture does not. */
+    void ReleaseFaceTargets();
+    bool UsesBatchedStereo() const { return CaptureMode == EPanoramaCaptureMode::Stereo && StereoRendering == EPanoramaStereoRendering::Batched; }
+    bool UsesOds() const { return CaptureMode == EPanoramaCaptureMode::Stereo && StereoRendering == EPanoramaStereoRendering::Ods; }
+    bool UsesSerialStereo() const { return CaptureMode == EPanoramaCaptureMode::Stereo && StereoRendering == EPanoramaStereoRendering::Serial; }
+    /** Sizes the slice views from FaceSize's texel density and allocates their atlas. */
+    void AllocateOdsTargets(int32 FaceSize, bool bHalfFloat);
+    /** Game thread, while capturing: shrinks the cube faces when the GPU frame time stays over OutputSettings.CaptureGpuBudgetMs. */
+    void UpdateFaceBudget(float DeltaTime);
+    /** Game thread, while capturing: publishes and logs the capture cost every few seconds. */
+    void UpdateCaptureCost(float DeltaTime);
     void DestroyRenderTargets();
+    void ReleaseEquirectLut();
     void EnqueueFrameCapture(float DeltaTime);
-    void ProcessPendingFrames();
-    void DispatchCubemapToEquirect(int32 EyeIndex, int32 EyeCount);
+    /** Game thread, once per captured frame: points the current cube, equirect and pack targets at the next slot. */
+    void AdvancePipelineSlot();
+    class FPanoPackTarget* GetPackTarget() const { return PackTargets.IsValidIndex(PipelineSlot) ? PackTargets[PipelineSlot].Get() : nullptr; }
+    /** The cube the given eye's capture renders into in the current pipeline slot. */
+    UTextureRenderTargetCube* GetEyeCubeTarget(int32 EyeIndex) const
+    {
+        return EyeIndex == 1 && RightEyeCubeTargets.IsValidIndex(PipelineSlot) ? RightEyeCubeTargets[PipelineSlot].Get() : CubeRenderTarget.Get();
+    }
+    /**
+     * Records one eye's conversion into FrameGraph. FaceMask: faces rendered by the per-face captures or into the stereo
+     * atlas, copied into the cube before the pass samples it.
+     */
+    void DispatchCubemapToEquirect(int32 EyeIndex, int32 EyeCount, uint8 FaceMask);
+    /** Game thread: renders the visible slice views of both eyes, SlicesPerPass slices per view family. */
+    void RenderOdsSlices();
+    void DispatchOdsStitch(int32 EyeIndex);
+    FPanoRegionBounds GetRegionBounds() const;
+    /** Records the pack pass into FrameGraph, like the preview downsample below. */
+    void DispatchPack();
     void OnCaptureComplete();
     void UpdatePreview();
     bool ResolveOutputDirectory(FString& OutDirectory) const;
     FString GenerateOutputFileName(const FString& Extension) const;
-    void FinalizeRecording();
+    /** Game thread: reports progress of running finalize jobs and retires the finished ones. */
+    void PollFinalizeJobs();
+    bool IsCapturing() const { return CaptureStatus == EPanoramaCaptureStatus::Recording || CaptureStatus == EPanoramaCaptureStatus::DroppedFrames; }
+    bool UsesLockedTimestep() const { return CaptureTiming == EPanoramaCaptureTiming::LockedTimestep; }
+    /** Locked timestep only: sets the engine's fixed delta time for the take, and restores the previous one. */
+    void BeginLockedTimestep();
+    void EndLockedTimestep();
+    /** Reserves a ring slot for the next PNG frame; under a locked timestep, waits for one instead of failing. */
+    struct FPanoCaptureFrame* AcquireFrameSlot();
 
     void HandleDroppedFrame();
-    void FlushRingBuffer();
-
-    void BuildStereoViewMatrices(TArray<FMatrix>& OutLeft, TArray<FMatrix>& OutRight) const;
 
     EPanoramaCaptureStatus CaptureStatus;
-    float TimeSinceLastCapture;
+    /** Real-time pacing: game time not yet consumed by a captured frame, carried across captures. */
+    double CaptureTimeAccumulator;
+    /** Engine fixed-timestep state to restore once a locked take stops. */
+    bool bLockedTimestepActive;
+    bool bPreviousUseFixedTimeStep;
+    double PreviousFixedDeltaTime;
     double RecordingStartTime;
     FString ActiveOutputDirectory;
     FString ActiveSessionName;
 
+    /** World-aligned cube capture; all six faces land in one texture the equirect pass samples by direction. */
+    UPROPERTY(Transient)
+    TObjectPtr<USceneCaptureComponentCube> CubeCapture;
+
+    /** The current pipeline slot's entry of CubeTargets. */
+    UPROPERTY(Transient)
+    TObjectPtr<UTextureRenderTargetCube> CubeRenderTarget;
+    int32 ActiveFaceSize;
+
+    /**
+     * Per-frame targets, one per pipeline slot; every captured frame moves to the next slot. Face and atlas targets
+     * are not rotated: only the face copies at the start of the same frame's conversion read them.
+     */
+    UPROPERTY(Transient)
+    TArray<TObjectPtr<UTextureRenderTargetCube>> CubeTargets;
+
+    /**
+     * Full-sphere serial stereo only: the right eye's cube for each pipeline slot, so both eyes render before a single
+     * frame graph converts them.
+     */
+    UPROPERTY(Transient)
+    TArray<TObjectPtr<UTextureRenderTargetCube>> RightEyeCubeTargets;
+
+    UPROPERTY(Transient)
+    TArray<TObjectPtr<UTextureRenderTarget2D>> EquirectTargets;
+    /** Pipeline depth the rings were allocated with; PipelineDepth may change during a take. */
+    int32 ActivePipelineDepth;
+    int32 PipelineSlot;
+
+    /**
+     * Partial regions only: one 90 degree capture per cube face, indexed like the cube's faces, so faces the region
+     * cannot see are never rendered. The cube capture has no per-face mask.
+     */
+    UPROPERTY(Transient)
     TArray<TObjectPtr<USceneCaptureComponent2D>> FaceCaptures;
+
+    /** Indexed like FaceCaptures; serial stereo holds the left eye's six faces, then the right eye's. */
+    UPROPERTY(Transient)
     TArray<TObjectPtr<UTextureRenderTarget2D>> FaceRenderTargets;
+
+    /** Batched stereo only: every face of both eyes, rendered as one view family. */
+    UPROPERTY(Transient)
+    TObjectPtr<UTextureRenderTarget2D> StereoAtlasTarget;
+
+    /** ODS only: one tile per eye, slice and pitch step; see FPanoOdsLayout. */
+    UPROPERTY(Transient)
+    TObjectPtr<UTextureRenderTarget2D> OdsAtlasTarget;
+    TUniquePtr<struct FPanoOdsLayout> OdsLayout;
+    /** Views the region reads, and whether it reaches the pole merge band the centred cube capture fills. */
+    TBitArray<> OdsVisibleSlices;
+    TBitArray<> OdsVisiblePitches;
+    bool bOdsNeedsCentre;
+
+    /** Full-sphere equirect size and the crop of it the equirect target holds; set by AllocateRenderTargets. */
+    FIntPoint ActiveSphereResolution;
+    FIntRect ActiveRegion;
+
+    /** GPU frame time accumulated over the current budget window. */
+    double FaceBudgetGpuMs;
+    int32 FaceBudgetFrames;
+    float FaceBudgetElapsed;
+
+    /** The current pipeline slot's entry of EquirectTargets. */
     TObjectPtr<UTextureRenderTarget2D> EquirectRenderTarget;
 
     UPROPERTY(Transient)
     TObjectPtr<UTextureRenderTarget2D> PreviewRenderTarget;
 
-    TArray<FMatrix> MonoViewMatrices;
+    /** Lookup table for EPanoramaEquirectMapping::LookupTable. Depends only on resolution, so it is built once. */
+    TUniquePtr<class FPanoEquirectLutTexture> EquirectLut;
+    bool bEquirectLutBuilt;
+    /** Region offset the table was built for. */
+    FIntPoint EquirectLutOffset;
+
+    /** RDG wrappers of the cube, equirect and LUT textures; replaced whenever the render targets are. One per pipeline slot. */
+    TSharedPtr<struct FPanoEquirectTextureCache, ESPMode::ThreadSafe> EquirectTextureCache;
+    TArray<TSharedPtr<struct FPanoEquirectTextureCache, ESPMode::ThreadSafe>> EquirectTextureCaches;
+
+    /** Reused readback buffer for the synchronous 16-bit path so the game thread does not allocate per frame. */
+    TArray<FLinearColor> ReadbackScratch;
 
     class FPanoFrameRingBuffer* FrameRingBuffer;
     TUniquePtr<class FPanoCaptureWorker> CaptureWorker;
     TUniquePtr<class FPanoAudioRecorder> AudioRecorder;
+    TUniquePtr<class FPanoCaptureClock> CaptureClock;
+    /** Capture-clock timestamp of every frame index, including dropped ones. */
+    TArray<double> FramePresentationSeconds;
     TUniquePtr<class FPanoNvencEncoder> NvencEncoder;
+    TUniquePtr<class FPanoLiveMuxer> LiveMuxer;
+    /** Stopped sessions, oldest first; each owns its writers, encoder and audio recorder. */
+    TArray<TUniquePtr<class FPanoFinalizeJob>> FinalizeJobs;
     TUniquePtr<class FPanoPngWriter> PngWriter;
+    TUniquePtr<class FPanoLatencyHistogram> QueueLatencyHistogram;
+    TUniquePtr<class FPanoReadbackPool> ReadbackPool;
+    /** One per pipeline slot. */
+    TArray<TUniquePtr<class FPanoPackTarget>> PackTargets;
+    /** Byte layout of PNG frames in the ring; chosen at StartRecording. */
+    EPanoPackFormat PackFormat;
+    TUniquePtr<class FPanoLatencyHistogram> ReadbackStallHistogram;
+    TUniquePtr<class FPanoCaptureCostTimer> CaptureCostTimer;
+    /** GPU work of the frame being captured, submitted as one render graph. */
+    TUniquePtr<class FPanoFrameGraph> FrameGraph;
+    float CaptureCostElapsed;
+    /** Wall-clock start of the cost window and frames captured in it, for ThroughputFps. */
+    double CaptureCostWindowStart;
+    int32 CaptureCostWindowFrames;
+    FPanoCaptureRenderCost LastCaptureRenderCost;
+    /** Wall-clock time of the last preview refresh, for PreviewFrameRate. */
+    double LastPreviewSeconds;
 
     uint64 FrameIndex;
     uint32 DroppedFrameCount;
+    FPanoEncodeThroughput LastPngThroughput;
+    FPanoLatencyStats LastPngEncodeLatency;
+    FPanoLatencyStats LastQueueLatency;
+    FPanoAudioCaptureStats LastAudioStats;
 
     FDelegateHandle OnBeginFrameHandle;
     FDelegateHandle OnEndFrameHandle;
@@ -24,6 +24,80 @@ enum class EPanoramaCaptureCodec : uint8
     HEVC
 };
 
+UENUM(BlueprintType)
+enum class EPanoramaPngCompression : uint8
+{
+    /** Stored deflate blocks, no filtering. Largest files, almost no CPU. */
+    Uncompressed,
+    /** Sub filter with zlib level 1. Intended for live capture. */
+    Fastest,
+    /** Adaptive filtering with zlib level 6. */
+    Balanced,
+    /** Adaptive filtering with zlib level 9. Intended for offline recompression. */
+    Smallest
+};
+
+/** How the equirect pass finds the sampling direction of each output pixel. */
+UENUM(BlueprintType)
+enum class EPanoramaEquirectMapping : uint8
+{
+    /** Recomputed per pixel every frame. */
+    Analytic,
+    /** Read from a table built once per resolution; one fetch per pixel. */
+    LookupTable
+};
+
+/** Filter the equirect pass resamples the capture cube with. Values match RESAMPLE_FILTER in the shader. */
+UENUM(BlueprintType)
+enum class EPanoramaResampleFilter : uint8
+{
+    /** One hardware bilinear fetch; the fastest, but aliases where the panorama minifies the faces. */
+    Bilinear,
+    /** 4x4 Catmull-Rom kernel on the face texel grid, widened to the pixel footprint. */
+    Bicubic,
+    /** 6x6 Lanczos-3 kernel on the face texel grid, widened to the pixel footprint. Sharpest; may ring at hard edges. */
+    Lanczos3,
+    /** Averages SupersampleCount bilinear fetches spread over the pixel. Always uses the analytic mapping. */
+    Supersampled
+};
+
+/** How captured frames are paced against the game's clock. */
+UENUM(BlueprintType)
+enum class EPanoramaCaptureTiming : uint8
+{
+    /** Follows the game's real-time tick; a tick longer than a frame interval cannot be made up and skips frames. */
+    RealTime,
+    /** Offline: the engine steps the world exactly 1 / CaptureFrameRate per tick and every tick is one output frame.
+     *  Runs slower than real time when it has to and waits for the encoder rather than dropping frames. */
+    LockedTimestep
+};
+
+/** How a stereo take renders its two eyes' cube faces. */
+UENUM(BlueprintType)
+enum class EPanoramaStereoRendering : uint8
+{
+    /** One cube capture per eye, moved between renders; each eye repeats the scene renderer's per-frame setup. */
+    Serial,
+    /** Every visible face of both eyes as views of a single view family, so culling setup, GPU scene upload and
+     *  view-independent shadows are done once per frame. */
+    Batched,
+    /** Omni-directional stereo: narrow vertical slices rendered from eye positions on the interpupillary circle and
+     *  stitched per column, so parallax is correct in every horizontal direction. See FPanoOdsSettings. */
+    Ods
+};
+
+/** Part of the sphere a take covers. */
+UENUM(BlueprintType)
+enum class EPanoramaCaptureRegionPreset : uint8
+{
+    /** Full 360 x 180 sphere. */
+    Full,
+    /** Front hemisphere: 180 degrees wide, pole to pole. */
+    VR180,
+    /** HorizontalFovDegrees around the rig's forward axis, between MinLatitudeDegrees and MaxLatitudeDegrees. */
+    Custom
+};
+
 UENUM(BlueprintType)
 enum class EPanoramaCaptureStatus : uint8
 {
@@ -33,6 +107,21 @@ enum class EPanoramaCaptureStatus : uint8
     DroppedFrames
 };
 
+/** Steps a stopped session goes through on its finalize thread. */
+UENUM(BlueprintType)
+enum class EPanoramaFinalizeStage : uint8
+{
+    /** Queued frames are still being encoded and written. */
+    Draining,
+    /** Closing the WAV file and writing the timing sidecar. */
+    Audio,
+    /** Re-deflating the PNG sequence. */
+    Recompressing,
+    /** Writing the MP4/MKV containers. */
+    Packaging,
+    Complete
+};
+
 USTRUCT(BlueprintType)
 struct FPanoCaptureResolution
 {
@@ -57,6 +146,187 @@ struct FPanoCaptureResolution
     int32 Height;
 };
 
+USTRUCT(BlueprintType)
+struct FPanoLatencyStats
+{
+    GENERATED_BODY()
+
+    FPanoLatencyStats()
+        : SampleCount(0)
+        , MeanMs(0.f)
+        , P50Ms(0.f)
+        , P95Ms(0.f)
+        , P99Ms(0.f)
+        , MaxMs(0.f)
+    {
+    }
+
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Panorama")
+    int32 SampleCount;
+
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Panorama")
+    float MeanMs;
+
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Panorama")
+    float P50Ms;
+
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Panorama")
+    float P95Ms;
+
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Panorama")
+    float P99Ms;
+
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Panorama")
+    float MaxMs;
+};
+
+USTRUCT(BlueprintType)
+struct FPanoEncodeThroughput
+{
+    GENERATED_BODY()
+
+    FPanoEncodeThroughput()
+        : WorkerCount(0)
+        , FramesEncoded(0)
+        , FramesPerSecond(0.f)
+        , RawMegabytesPerSecond(0.f)
+        , CompressedMegabytesPerSecond(0.f)
+    {
+    }
+
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Panorama")
+    int32 WorkerCount;
+
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Panorama")
+    int32 FramesEncoded;
+
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Panorama")
+    float FramesPerSecond;
+
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Panorama")
+    float RawMegabytesPerSecond;
+
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Panorama")
+    float CompressedMegabytesPerSecond;
+};
+
+/** Health of the audio capture callback for one session. */
+USTRUCT(BlueprintType)
+struct FPanoAudioCaptureStats
+{
+    GENERATED_BODY()
+
+    FPanoAudioCaptureStats()
+        : OverrunCount(0)
+        , DroppedSamples(0)
+        , MaxCallbackMs(0.f)
+        , RecordedSeconds(0.f)
+    {
+    }
+
+    /** Callbacks that found the block ring full and dropped samples. */
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Panorama")
+    int32 OverrunCount;
+
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Panorama")
+    int64 DroppedSamples;
+
+    /** Longest time spent inside OnNewSubmixBuffer. */
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Panorama")
+    float MaxCallbackMs;
+
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Panorama")
+    float RecordedSeconds;
+};
+
+/**
+ * Cost of one captured frame, averaged over a few seconds: scene render, the frame's render graph (conversion to the
+ * equirect, preview, pack and readback copy), and output (encode submission or synchronous readback). The stage times
+ * add up to less than the frame totals when other work runs in between.
+ */
+USTRUCT(BlueprintType)
+struct FPanoCaptureRenderCost
+{
+    GENERATED_BODY()
+
+    FPanoCaptureRenderCost()
+        : RenderThreadMs(0.f)
+        , GpuMs(0.f)
+        , SceneRenderThreadMs(0.f)
+        , SceneGpuMs(0.f)
+        , ConvertRenderThreadMs(0.f)
+        , ConvertGpuMs(0.f)
+        , OutputRenderThreadMs(0.f)
+        , OutputGpuMs(0.f)
+        , ThroughputFps(0.f)
+        , SampledFrames(0)
+    {
+    }
+
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Panorama")
+    float RenderThreadMs;
+
+    /** Timestamp difference on the GPU; includes any unrelated work the GPU interleaves. */
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Panorama")
+    float GpuMs;
+
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Panorama")
+    float SceneRenderThreadMs;
+
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Panorama")
+    float SceneGpuMs;
+
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Panorama")
+    float ConvertRenderThreadMs;
+
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Panorama")
+    float ConvertGpuMs;
+
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Panorama")
+    float OutputRenderThreadMs;
+
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Panorama")
+    float OutputGpuMs;
+
+    /** Frames captured per wall-clock second over the same window. */
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Panorama")
+    float ThroughputFps;
+
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Panorama")
+    int32 SampledFrames;
+};
+
+/** Outcome of one stopped session, reported once its files are complete. */
+USTRUCT(BlueprintType)
+struct FPanoFinalizeResult
+{
+    GENERATED_BODY()
+
+    FPanoFinalizeResult()
+        : bSucceeded(false)
+        , FinalizeSeconds(0.f)
+    {
+    }
+
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Panorama")
+    FString SessionName;
+
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Panorama")
+    FString OutputDirectory;
+
+    /** MP4/MKV files written for the session. */
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Panorama")
+    TArray<FString> ContainerFiles;
+
+    /** False when a requested container could not be written. */
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Panorama")
+    bool bSucceeded;
+
+    /** Time from StopRecording until the files were complete. */
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Panorama")
+    float FinalizeSeconds;
+};
+
 USTRUCT(BlueprintType)
 struct FPanoNvencRateControl
 {
@@ -83,6 +353,73 @@ struct FPanoNvencRateControl
     int32 NumBFrames;
 };
 
+/** Slit-scan settings for EPanoramaStereoRendering::Ods. */
+USTRUCT(BlueprintType)
+struct FPanoOdsSettings
+{
+    GENERATED_BODY()
+
+    FPanoOdsSettings()
+        : SliceCount(72)
+        , SlicesPerPass(24)
+        , bPoleMerge(true)
+        , PoleMergeStartDegrees(60.f)
+        , PoleMergeEndDegrees(80.f)
+    {
+    }
+
+    /** Slices around the circle. More slices shorten the eye-position steps between columns (fewer seams on near
+     *  objects) at the cost of more views per frame. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Panorama", meta = (ClampMin = "8", ClampMax = "720"))
+    int32 SliceCount;
+
+    /** Slices submitted together as one view family; larger batches share more per-pass work but need more memory. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Panorama", meta = (ClampMin = "1", ClampMax = "720"))
+    int32 SlicesPerPass;
+
+    /** Fades both eyes into one centred capture towards the poles, where ODS parallax swirls and the eyes swap. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Panorama")
+    bool bPoleMerge;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Panorama", meta = (ClampMin = "0.0", ClampMax = "89.0", Units = "Degrees", EditCondition = "bPoleMerge"))
+    float PoleMergeStartDegrees;
+
+    /** Latitude from which only the centred capture is used; slices are not rendered beyond it. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Panorama", meta = (ClampMin = "1.0", ClampMax = "90.0", Units = "Degrees", EditCondition = "bPoleMerge"))
+    float PoleMergeEndDegrees;
+};
+
+/**
+ * Region of the equirect a take keeps. The output is the matching crop of the full equirect at Resolution, so pixel
+ * density does not change; only faces the region can see are rendered, and containers carry the crop as projection
+ * bounds.
+ */
+USTRUCT(BlueprintType)
+struct FPanoCaptureRegion
+{
+    GENERATED_BODY()
+
+    FPanoCaptureRegion()
+        : Preset(EPanoramaCaptureRegionPreset::Full)
+        , HorizontalFovDegrees(360.f)
+        , MinLatitudeDegrees(-90.f)
+        , MaxLatitudeDegrees(90.f)
+    {
+    }
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Panorama")
+    EPanoramaCaptureRegionPreset Preset;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Panorama", meta = (ClampMin = "1.0", ClampMax = "360.0", Units = "Degrees", EditCondition = "Preset == EPanoramaCaptureRegionPreset::Custom"))
+    float HorizontalFovDegrees;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Panorama", meta = (ClampMin = "-90.0", ClampMax = "90.0", Units = "Degrees", EditCondition = "Preset == EPanoramaCaptureRegionPreset::Custom"))
+    float MinLatitudeDegrees;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Panorama", meta = (ClampMin = "-90.0", ClampMax = "90.0", Units = "Degrees", EditCondition = "Preset == EPanoramaCaptureRegionPreset::Custom"))
+    float MaxLatitudeDegrees;
+};
+
 USTRUCT(BlueprintType)
 struct FPanoCaptureOutputSettings
 {
@@ -91,12 +428,21 @@ struct FPanoCaptureOutputSettings
     FPanoCaptureOutputSettings()
         : Resolution(4096, 2048)
         , bUse8k(false)
+        , FaceResolutionScale(1.3f)
+        , MaxFaceResolution(0)
+        , CaptureGpuBudgetMs(0.f)
+        , Region()
         , bLinearColorSpace(false)
         , OutputMode(EPanoramaCaptureOutputMode::PNGSequence)
         , Codec(EPanoramaCaptureCodec::HEVC)
         , NvencRateControl()
         , TargetDirectory(FDirectoryPath{TEXT("/Game")})
         , bWritePreviewTexture(true)
+        , PngEncoderThreads(0)
+        , PngReservedCores(2)
+        , PngMaxInFlightMB(2048)
+        , PngCompression(EPanoramaPngCompression::Balanced)
+        , bRecompressPngAfterCapture(false)
     {
     }
 
@@ -106,6 +452,25 @@ struct FPanoCaptureOutputSettings
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Panorama")
     bool bUse8k;
 
+    /**
+     * Cube face edge as a multiple of a quarter of the equirect width. 1.0 gives each face's 90 degrees as many texels
+     * as equirect pixels; about 1.27 is needed to match the equirect's density at the face centres as well.
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Panorama", meta = (ClampMin = "0.25", ClampMax = "4.0"))
+    float FaceResolutionScale;
+
+    /** Upper bound on the face edge in pixels; zero leaves only the RHI limit. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Panorama", meta = (ClampMin = "0"))
+    int32 MaxFaceResolution;
+
+    /** While recording, steps the face size down whenever the GPU frame time averaged over a second exceeds this. Zero disables. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Panorama", meta = (ClampMin = "0.0", Units = "Milliseconds"))
+    float CaptureGpuBudgetMs;
+
+    /** Resolution describes the full sphere; the region crops it. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Panorama")
+    FPanoCaptureRegion Region;
+
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Panorama")
     bool bLinearColorSpace;
 
@@ -123,4 +488,26 @@ struct FPanoCaptureOutputSettings
 
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Panorama")
     bool bWritePreviewTexture;
+
+    /** PNG encoder thread count. Zero uses the logical core count minus PngReservedCores. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Panorama", meta = (ClampMin = "0", EditCondition = "OutputMode == EPanoramaCaptureOutputMode::PNGSequence"))
+    int32 PngEncoderThreads;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Panorama", meta = (ClampMin = "0", EditCondition = "OutputMode == EPanoramaCaptureOutputMode::PNGSequence"))
+    int32 PngReservedCores;
+
+    /**
+     * Cap on frame memory held by the PNG writer, from queued raw pixels to filtered and compressed data awaiting its
+     * file write. When reached, capture backs up into the frame ring.
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Panorama", meta = (ClampMin = "64", EditCondition = "OutputMode == EPanoramaCaptureOutputMode::PNGSequence"))
+    int32 PngMaxInFlightMB;
+
+    /** Compression used while recording. Fastest keeps up with 8K capture at the cost of file size. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Panorama", meta = (EditCondition = "OutputMode == EPanoramaCaptureOutputMode::PNGSequence"))
+    EPanoramaPngCompression PngCompression;
+
+    /** Re-deflates the finished sequence with the Smallest preset when the session is finalized. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Panorama", meta = (EditCondition = "OutputMode == EPanoramaCaptureOutputMode::PNGSequence"))
+    bool bRecompressPngAfterCapture;
 };
@@ -18,7 +18,10 @@ struct FPanoramaNvencEncodeParams
     FPanoNvencRateControl RateControl;
     bool bUseLinear;
     float FrameRate = 0.f;
+    /** Raw Annex-B dump; optional when OnBitstream is bound. */
     FString OutputBitstreamPath;
+    /** Receives every encoded access unit, in output order, on the encoder's callback thread. */
+    TFunction<void(const uint8* Data, int64 NumBytes)> OnBitstream;
 };
 
 struct FPanoramaEncodedFrame
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PanoramaCaptureTypes.h"
+
+/** PNG scanline filter applied to every row. Adaptive picks the cheapest filter per row (minimum sum of absolute differences). */
+enum class EPanoPngRowFilter : uint8
+{
+    None = 0,
+    Sub = 1,
+    Up = 2,
+    Average = 3,
+    Paeth = 4,
+    Adaptive = 5
+};
+
+struct FPanoPngEncodeOptions
+{
+    /** zlib level, 0 (stored) to 9. */
+    int32 CompressionLevel = 6;
+    EPanoPngRowFilter Filter = EPanoPngRowFilter::Adaptive;
+    /** Number of horizontal bands filtered and deflated in parallel. Zero picks a count from image size and core count. */
+    int32 NumBands = 0;
+
+    static FPanoPngEncodeOptions FromPreset(EPanoramaPngCompression Preset);
+};
+
+struct FPanoPngEncodeStats
+{
+    int32 NumBands = 0;
+    int64 RawBytes = 0;
+    int64 CompressedBytes = 0;
+    double FilterSeconds = 0.0;
+    double DeflateSeconds = 0.0;
+    double TotalSeconds = 0.0;
+};
+
+/**
+ * RGBA PNG encoder that splits the image into horizontal bands and filters and deflates them on
+ * separate task graph workers. Each band is an independent raw deflate run primed with the previous
+ * band's last 32 KB and terminated with a sync flush, so the bands concatenate into one valid zlib
+ * stream (with combined Adler-32) that any standard decoder reads.
+ *
+ * Instances keep their band buffers between calls; use one instance per thread.
+ */
+class FPanoPngEncoder
+{
+public:
+    /**
+     * Encodes RGBA pixels to a complete PNG file. 16-bit samples are native-endian uint16.
+     * OnInputConsumed, when set, runs as soon as Pixels is no longer referenced (before deflate starts).
+     */
+    bool Encode(const uint8* Pixels, int32 Width, int32 Height, int32 BitDepth, const FPanoPngEncodeOptions& Options,
+        TArray64<uint8>& OutPng, FPanoPngEncodeStats* OutStats = nullptr, const TFunction<void()>& OnInputConsumed = TFunction<void()>());
+
+    /**
+     * Decodes an 8- or 16-bit RGBA, non-interlaced PNG and re-encodes it with new options.
+     * Ancillary chunks are not preserved. Returns false for any other PNG layout.
+     */
+    bool Recompress(const TArray64<uint8>& InPng, const FPanoPngEncodeOptions& Options, TArray64<uint8>& OutPng, FPanoPngEncodeStats* OutStats = nullptr);
+
+private:
+    bool EncodeInternal(const uint8* Pixels, int32 Width, int32 Height, int32 BitDepth, bool bPngByteOrder, const FPanoPngEncodeOptions& Options,
+        TArray64<uint8>& OutPng, FPanoPngEncodeStats* OutStats, const TFunction<void()>& OnInputConsumed);
+
+    TArray64<uint8> DecodedPixels;
+
+    TArray<TArray64<uint8>> FilteredBands;
+    TArray<TArray64<uint8>> CompressedBands;
+    TArray<uint32> BandAdlers;
+};
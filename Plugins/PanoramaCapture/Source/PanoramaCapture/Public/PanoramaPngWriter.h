@@ -1,6 +1,13 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "PanoramaCaptureTypes.h"
+#include "PanoramaPngEncoder.h"
+#include "Async/Future.h"
+
+#include <atomic>
+
+class FEvent;
 
 struct FPanoPngWriteParams
 {
@@ -8,6 +15,15 @@ struct FPanoPngWriteParams
     FString BaseFileName;
     bool bUse16Bit;
     bool bLinear;
+    /** Number of encoder threads. Zero picks the core count minus ReservedCoreCount. */
+    int32 NumWorkers = 0;
+    int32 ReservedCoreCount = 2;
+    /**
+     * Upper bound on frame memory held by the writer: raw pixels while queued, then filtered rows and the compressed
+     * file until the file is written. EnqueueFrame blocks while the budget is exhausted.
+     */
+    int64 MaxBytesInFlight = 2048ll * 1024 * 1024;
+    FPanoPngEncodeOptions EncodeOptions;
 };
 
 struct FPanoPngFrame
@@ -15,15 +31,20 @@ struct FPanoPngFrame
     uint64 FrameIndex;
     FIntPoint Resolution;
     double Timecode;
-    TArray<uint8> PixelData;
+    /** Pixels borrowed from the capture ring; valid until OnReleased is invoked. */
+    TArrayView64<const uint8> PixelData;
     bool b16Bit;
+    /** Invoked by the writer once PixelData is no longer referenced. */
+    TFunction<void()> OnReleased;
 };
 
 class FPanoPngWriter
 {
 public:
     FPanoPngWriter();
+    ~FPanoPngWriter();
 
+    /** Queues a frame for encoding. Blocks while MaxBytesInFlight is exhausted so backpressure reaches the caller. */
     void EnqueueFrame(FPanoPngFrame&& Frame);
     void Flush();
     void Shutdown();
@@ -31,11 +52,43 @@ public:
 
     TArray<FString> GetGeneratedFiles() const;
 
+    /**
+     * Re-deflates every file written this session with the given options, keeping a file only when it shrinks.
+     * Runs on the calling thread (band-parallel per file); call after Flush.
+     */
+    void RecompressGeneratedFiles(const FPanoPngEncodeOptions& Options);
+
+    /** Measured wall-clock throughput since Configure. */
+    FPanoEncodeThroughput GetThroughput() const;
+
+    /** Per-frame encode latency (filter + deflate + write) since Configure. */
+    FPanoLatencyStats GetEncodeLatency() const;
+
 private:
-    void ProcessQueue();
+    void StartWorkers();
+    void StopWorkers();
+    void WorkerLoop();
+    void ReleaseFrame(FPanoPngFrame& Frame);
 
     FPanoPngWriteParams ActiveParams;
     TQueue<FPanoPngFrame, EQueueMode::Mpsc> FrameQueue;
+    FCriticalSection DequeueGuard;
     TArray<FString> GeneratedFiles;
-    FThreadSafeBool bRunning;
+    mutable FCriticalSection GeneratedFilesGuard;
+
+    TArray<TFuture<void>> Workers;
+    FEvent* WorkAvailableEvent;
+    FEvent* FrameCompletedEvent;
+    FThreadSafeBool bStopping;
+
+    TUniquePtr<class FPanoLatencyHistogram> EncodeLatency;
+
+    std::atomic<int32> PendingFrameCount;
+    std::atomic<int64> BytesInFlight;
+
+    std::atomic<int64> FramesEncoded;
+    std::atomic<int64> RawBytesEncoded;
+    std::atomic<int64> CompressedBytesWritten;
+    std::atomic<double> FirstEnqueueSeconds;
+    std::atomic<double> LastCompletionSeconds;
 };